@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <filesystem>
 
 namespace Config
@@ -46,6 +47,174 @@ namespace Config
 
     } // namespace SceneAssets
 
+    namespace Threading
+    {
+        // asset decode workers, 0 = one per hardware thread minus the main thread
+        static constexpr size_t ASSET_WORKER_COUNT = 0;
+        // helpers for sorting the render queue, only used by large queues
+        static constexpr size_t RENDER_WORKER_COUNT = 2;
+    } // namespace Threading
+
+    namespace Streaming
+    {
+        // main thread time per frame spent creating gpu resources for finished decodes
+        static constexpr double UPLOAD_BUDGET_MS = 4.0;
+    } // namespace Streaming
+
+    namespace HotReload
+    {
+        // watched relative to the working directory, which is where assets and
+        // shaders are loaded from (the build copies them next to the exe)
+        static constexpr bool ENABLE = true;
+        static constexpr std::array<const char *, 2> WATCH_DIRS = {"assets", "shaders"};
+        // quiet time before a changed file is picked up, editors often save in steps
+        static constexpr double SETTLE_MS = 200.0;
+    } // namespace HotReload
+
+    namespace Residency
+    {
+        // gpu memory for models and textures before unreferenced ones get
+        // evicted, least recently used first. 0 = never evict
+        static constexpr uint64_t BUDGET_MB = 1024;
+    } // namespace Residency
+
+    namespace Geometry
+    {
+        // static meshes are sub-allocated from shared buffers of this size.
+        // a mesh larger than a page gets a buffer of its own
+        static constexpr uint32_t VERTEX_PAGE_MB = 64;
+        static constexpr uint32_t INDEX_PAGE_MB = 32;
+        static constexpr bool USE_16BIT_INDICES = true;
+    } // namespace Geometry
+
+    namespace TextureStreaming
+    {
+        // cached textures load with their top level at most START_SIZE and
+        // stream finer mips in as on screen surfaces resolve them. textures
+        // without a cooked file load whole
+        static constexpr bool ENABLE = true;
+        static constexpr int START_SIZE = 128;
+        // streamed texture memory, past it levels nothing needs are dropped
+        static constexpr uint64_t POOL_MB = 512;
+        // level data read and uploaded per frame, a single larger level still goes through
+        static constexpr uint64_t UPLOAD_KB_PER_FRAME = 4096;
+    } // namespace TextureStreaming
+
+    namespace AssetCooking
+    {
+        // content addressed cache of cooked meshes and textures, filled by
+        // graphite_cook and, when enabled, by imports at runtime
+        static const std::filesystem::path CACHE_DIR = "cache";
+        static constexpr bool WRITE_ON_IMPORT = true;
+        // store cooked mesh streams MeshCodec encoded when that is smaller,
+        // they then decode at load instead of mapping straight from the file
+        static constexpr bool ENCODE_MESHES = true;
+    } // namespace AssetCooking
+
+    namespace AssetPacks
+    {
+        // mounted at startup when present, relative to the working directory.
+        // packed files shadow loose files of the same path, later packs win
+        // (build them with graphite_pack)
+        static constexpr std::array<const char *, 1> FILES = {"assets.gpak"};
+        // graphite_pack chunk size, chunks decompress independently
+        static constexpr uint32_t CHUNK_KB = 64;
+    } // namespace AssetPacks
+
+    namespace MeshImport
+    {
+        // import post processes that run as our own parallel pass
+        // (MeshProcessing) instead of assimp's single threaded one
+        enum Stage : uint32_t
+        {
+            WELD = 1,
+            NORMALS = 2,
+            TANGENTS = 4,
+        };
+        static constexpr uint32_t PARALLEL_STAGES = WELD | NORMALS | TANGENTS;
+
+        // per asset exceptions, by source path. NORMALS needs TANGENTS as
+        // well (assimp's tangents would come before our normals), which
+        // MeshProcessing checks at compile time
+        struct Override
+        {
+            const char *source;
+            uint32_t parallelStages;
+        };
+        static constexpr std::array<Override, 0> OVERRIDES = {{
+            // {"assets/models/boulder/boulder_01_8k.gltf", WELD | NORMALS | TANGENTS},
+        }};
+    } // namespace MeshImport
+
+    namespace MeshOptimization
+    {
+        // reorder imported meshes for vertex cache, overdraw and vertex fetch
+        static constexpr bool OPTIMIZE_ON_IMPORT = true;
+        static constexpr unsigned CACHE_SIZE = 16;
+        // allowed acmr increase when splitting clusters for overdraw
+        static constexpr float OVERDRAW_THRESHOLD = 1.05f;
+    } // namespace MeshOptimization
+
+    namespace Lod
+    {
+        // quadric simplified levels per submesh, level 0 included
+        static constexpr bool GENERATE_ON_IMPORT = true;
+        static constexpr unsigned MAX_LEVELS = 6;
+        static constexpr float REDUCTION_PER_LEVEL = 0.5f;
+        static constexpr unsigned MIN_TRIANGLES = 64;
+        // stop once a level keeps more than this fraction of the previous one
+        static constexpr float MIN_LEVEL_REDUCTION = 0.85f;
+        // largest simplification error, relative to the submesh bounds diagonal
+        static constexpr float MAX_RELATIVE_ERROR = 0.05f;
+
+        // the coarsest level whose error projects below this many pixels is drawn
+        static constexpr float PIXEL_ERROR_THRESHOLD = 1.0f;
+        // coarser levels only kick in below threshold * (1 - hysteresis)
+        static constexpr float HYSTERESIS = 0.25f;
+    } // namespace Lod
+
+    namespace Meshlets
+    {
+        // clusters built per lod when a model is decoded, culled per frame
+        static constexpr bool ENABLE = true;
+        static constexpr size_t MAX_VERTICES = 64;
+        static constexpr size_t MAX_TRIANGLES = 124;
+        static constexpr bool CONE_CULLING = true;
+    } // namespace Meshlets
+
+    namespace Instancing
+    {
+        // copies of one mesh level with one material drawn together need at
+        // least this many instances, smaller groups draw alone and keep their
+        // per meshlet culling
+        static constexpr size_t MIN_INSTANCES = 2;
+        static constexpr uint32_t INITIAL_CAPACITY = 1024; // instance buffer, doubles when a frame needs more
+    } // namespace Instancing
+
+    namespace VertexCompression
+    {
+        // upload PackedVertex (20 bytes) instead of Vertex (44 bytes).
+        // quantization is per submesh, so precision scales with mesh size
+        static constexpr bool USE_PACKED_VERTICES = true;
+    } // namespace VertexCompression
+
+    namespace Textures
+    {
+        // full mip chains built on the cpu when a texture is decoded
+        static constexpr bool GENERATE_MIPS = true;
+        // kaiser windowed sinc, box filter otherwise
+        static constexpr bool KAISER_MIP_FILTER = true;
+
+        // bc encode on decode: bc7 (bc1 if disabled) albedo, bc5 normals, bc1 orm.
+        // base levels that aren't a multiple of 4 stay rgba8
+        static constexpr bool BLOCK_COMPRESSION = true;
+        static constexpr bool ALBEDO_BC7 = true;
+
+        // 8 and 16 bit non-palette pngs skip stb_image for PngDecoder
+        // (same pixels, faster inflate and simd unfiltering)
+        static constexpr bool FAST_PNG_DECODE = true;
+    } // namespace Textures
+
     namespace ClearColors
     {
         inline constexpr std::array<float, 4> GBUFFER_ALBEDO = {0.2f, 0.2f, 0.2f, 1.0f};
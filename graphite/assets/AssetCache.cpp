@@ -0,0 +1,340 @@
+#include "AssetCache.h"
+#include "assets/AssetFiles.h"
+#include "assets/CookedMesh.h"
+#include "assets/CookedTexture.h"
+#include "assets/MeshProcessing.h"
+#include "utils/Hash.h"
+#include "utils/Logger.h"
+#include "cfg/Config.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+
+namespace
+{
+    // bump when import code changes its output without a settings or format change
+    constexpr uint32_t IMPORT_REVISION = 1;
+
+    constexpr const char *MANIFEST_NAME = "manifest.txt";
+
+    struct Entry
+    {
+        uint64_t key = 0;
+        uint64_t settings = 0;
+        uint64_t size = 0;
+        int64_t writeTime = 0;
+    };
+
+    struct Manifest
+    {
+        std::mutex mutex;
+        bool loaded = false;
+        std::unordered_map<std::string, Entry> entries;
+    };
+
+    Manifest &GetManifest()
+    {
+        static Manifest manifest;
+        return manifest;
+    }
+
+    std::filesystem::path ManifestPath()
+    {
+        return Config::AssetCooking::CACHE_DIR / MANIFEST_NAME;
+    }
+
+    std::string ManifestKey(const AssetID &source)
+    {
+        return source.lexically_normal().generic_string();
+    }
+
+    // one line per record: key settings size writeTime path. later lines win
+    std::string FormatLine(const std::string &path, const Entry &e)
+    {
+        char prefix[96];
+        std::snprintf(prefix, sizeof(prefix), "%016" PRIx64 " %016" PRIx64 " %" PRIu64 " %" PRId64 " ",
+                      e.key, e.settings, e.size, e.writeTime);
+        return prefix + path;
+    }
+
+    void ParseManifest(std::istream &in, Manifest &manifest)
+    {
+        std::string line;
+        while (std::getline(in, line))
+        {
+            Entry e;
+            int consumed = 0;
+            if (std::sscanf(line.c_str(), "%" SCNx64 " %" SCNx64 " %" SCNu64 " %" SCNd64 " %n",
+                            &e.key, &e.settings, &e.size, &e.writeTime, &consumed) != 4 ||
+                consumed <= 0 || size_t(consumed) >= line.size())
+                continue;
+            manifest.entries[line.substr(consumed)] = e;
+        }
+    }
+
+    // caller holds the mutex. a packed manifest comes first, records made
+    // since on disk win over it
+    void LoadManifest(Manifest &manifest)
+    {
+        if (manifest.loaded)
+            return;
+        manifest.loaded = true;
+
+        std::vector<unsigned char> packed;
+        if (AssetFiles::IsPacked(ManifestPath()) && AssetFiles::Read(ManifestPath(), packed))
+        {
+            std::istringstream in(std::string(packed.begin(), packed.end()));
+            ParseManifest(in, manifest);
+        }
+
+        std::ifstream in(ManifestPath());
+        ParseManifest(in, manifest);
+    }
+
+    uint64_t ImportSettingsHash(const AssetID &source, AssetCache::Kind kind, TextureRole role)
+    {
+        Hash64 h;
+        h.UpdateValue(IMPORT_REVISION);
+        h.UpdateValue(static_cast<uint32_t>(kind));
+        if (kind == AssetCache::Kind::Model)
+        {
+            namespace MO = Config::MeshOptimization;
+            namespace L = Config::Lod;
+            h.UpdateValue(CookedMesh::VERSION);
+            h.UpdateValue(static_cast<uint32_t>(sizeof(Vertex)));
+            h.UpdateValue(MeshProcessing::GetParallelStages(source));
+            h.UpdateValue(MO::OPTIMIZE_ON_IMPORT);
+            h.UpdateValue(MO::CACHE_SIZE);
+            h.UpdateValue(MO::OVERDRAW_THRESHOLD);
+            h.UpdateValue(L::GENERATE_ON_IMPORT);
+            h.UpdateValue(L::MAX_LEVELS);
+            h.UpdateValue(L::REDUCTION_PER_LEVEL);
+            h.UpdateValue(L::MIN_TRIANGLES);
+            h.UpdateValue(L::MIN_LEVEL_REDUCTION);
+            h.UpdateValue(L::MAX_RELATIVE_ERROR);
+        }
+        else
+        {
+            namespace T = Config::Textures;
+            h.UpdateValue(CookedTexture::VERSION);
+            h.UpdateValue(static_cast<uint32_t>(role));
+            h.UpdateValue(T::GENERATE_MIPS);
+            h.UpdateValue(T::KAISER_MIP_FILTER);
+            h.UpdateValue(T::BLOCK_COMPRESSION);
+            h.UpdateValue(T::ALBEDO_BC7);
+        }
+        return h.Finish();
+    }
+
+    bool HashFile(const std::filesystem::path &path, Hash64 &h)
+    {
+        if (AssetFiles::IsPacked(path))
+        {
+            std::vector<unsigned char> data;
+            if (!AssetFiles::Read(path, data))
+                return false;
+            h.Update(data.data(), data.size());
+            return true;
+        }
+
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            return false;
+
+        std::vector<char> chunk(1 << 20);
+        while (in)
+        {
+            in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            h.Update(chunk.data(), static_cast<size_t>(in.gcount()));
+        }
+        return in.eof();
+    }
+
+    bool IsImage(const std::filesystem::path &path)
+    {
+        auto ext = path.extension();
+        return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".ktx2" || ext == ".webp";
+    }
+
+    // buffers referenced by a .gltf, which hold its geometry. images are cooked
+    // on their own and left out. a plain scan for "uri" strings is enough here,
+    // percent escapes in uris are not handled
+    bool GltfExternalFiles(const AssetID &source, std::vector<std::filesystem::path> &outFiles)
+    {
+        std::vector<unsigned char> data;
+        if (!AssetFiles::Read(source, data))
+            return false;
+        const std::string text(data.begin(), data.end());
+
+        size_t pos = 0;
+        while ((pos = text.find("\"uri\"", pos)) != std::string::npos)
+        {
+            pos = text.find_first_not_of(" \t\r\n:", pos + 5);
+            if (pos == std::string::npos || text[pos] != '"')
+                continue;
+            size_t end = text.find('"', pos + 1);
+            if (end == std::string::npos)
+                break;
+            const std::string uri = text.substr(pos + 1, end - pos - 1);
+            pos = end + 1;
+
+            if (uri.rfind("data:", 0) == 0)
+                continue; // embedded, already part of the json
+            auto file = (source.parent_path() / std::filesystem::u8path(uri)).lexically_normal();
+            if (!IsImage(file))
+                outFiles.push_back(std::move(file));
+        }
+        return true;
+    }
+
+    bool StatSource(const AssetID &source, uint64_t &size, int64_t &writeTime)
+    {
+        std::error_code ec;
+        size = std::filesystem::file_size(source, ec);
+        if (ec)
+            return false;
+        auto time = std::filesystem::last_write_time(source, ec);
+        if (ec)
+            return false;
+        writeTime = static_cast<int64_t>(time.time_since_epoch().count());
+        return true;
+    }
+}
+
+namespace AssetCache
+{
+    bool ComputeKey(const AssetID &source, Kind kind, TextureRole role, uint64_t &outKey)
+    {
+        Hash64 h(ImportSettingsHash(source, kind, role));
+        if (!HashFile(source, h))
+            return false;
+
+        std::vector<std::filesystem::path> external;
+        if (kind == Kind::Model && source.extension() == ".gltf")
+        {
+            bool read = GltfExternalFiles(source, external);
+            for (size_t i = 0; read && i < external.size(); ++i)
+                read = HashFile(external[i], h);
+            if (!read)
+            {
+                LOG_WARN("AssetCache: could not read the buffers of {}", source.string());
+                return false;
+            }
+        }
+
+        outKey = h.Finish();
+        return true;
+    }
+
+    std::vector<std::filesystem::path> GetSourceFiles(const AssetID &source, Kind kind)
+    {
+        std::vector<std::filesystem::path> files{source.lexically_normal()};
+        if (kind == Kind::Model && source.extension() == ".gltf")
+            GltfExternalFiles(source, files);
+        return files;
+    }
+
+    std::filesystem::path GetPath(uint64_t key, Kind kind)
+    {
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016" PRIx64, key);
+        std::filesystem::path path = Config::AssetCooking::CACHE_DIR / name;
+        path += kind == Kind::Model ? CookedMesh::EXTENSION : CookedTexture::EXTENSION;
+        return path;
+    }
+
+    std::filesystem::path Find(const AssetID &source, Kind kind, TextureRole role, uint64_t *outKey)
+    {
+        const std::string name = ManifestKey(source);
+        const uint64_t settings = ImportSettingsHash(source, kind, role);
+
+        Entry recorded;
+        bool hasEntry = false;
+        {
+            auto &manifest = GetManifest();
+            std::lock_guard<std::mutex> lock(manifest.mutex);
+            LoadManifest(manifest);
+            auto it = manifest.entries.find(name);
+            if (it != manifest.entries.end())
+                recorded = it->second, hasEntry = true;
+        }
+
+        uint64_t size = 0;
+        int64_t writeTime = 0;
+        const bool hasSource = StatSource(source, size, writeTime);
+
+        // a cooked file whose source is gone, or only packed, is still usable
+        if (hasEntry && recorded.settings == settings &&
+            (!hasSource || (recorded.size == size && recorded.writeTime == writeTime)))
+        {
+            auto path = GetPath(recorded.key, kind);
+            if (AssetFiles::Exists(path))
+                return path;
+        }
+
+        uint64_t key = 0;
+        if ((!hasSource && !AssetFiles::IsPacked(source)) || !ComputeKey(source, kind, role, key))
+            return {};
+        if (outKey)
+            *outKey = key;
+
+        // same content cooked before, possibly under another path
+        auto path = GetPath(key, kind);
+        if (!AssetFiles::Exists(path))
+            return {};
+
+        Record(source, kind, role, key);
+        return path;
+    }
+
+    void Record(const AssetID &source, Kind kind, TextureRole role, uint64_t key)
+    {
+        Entry e;
+        e.key = key;
+        e.settings = ImportSettingsHash(source, kind, role);
+        StatSource(source, e.size, e.writeTime);
+
+        const std::string name = ManifestKey(source);
+        auto &manifest = GetManifest();
+        std::lock_guard<std::mutex> lock(manifest.mutex);
+        LoadManifest(manifest);
+        manifest.entries[name] = e;
+
+        std::error_code ec;
+        std::filesystem::create_directories(Config::AssetCooking::CACHE_DIR, ec);
+        std::ofstream out(ManifestPath(), std::ios::app);
+        if (out)
+            out << FormatLine(name, e) << '\n';
+        else
+            LOG_WARN("AssetCache: failed to append to {}", ManifestPath().string());
+    }
+
+    bool CompactManifest()
+    {
+        auto &manifest = GetManifest();
+        std::lock_guard<std::mutex> lock(manifest.mutex);
+        LoadManifest(manifest);
+
+        std::error_code ec;
+        std::filesystem::create_directories(Config::AssetCooking::CACHE_DIR, ec);
+
+        std::filesystem::path tempPath = ManifestPath();
+        tempPath += ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::trunc);
+            for (const auto &[name, e] : manifest.entries)
+                out << FormatLine(name, e) << '\n';
+            if (!out)
+                return false;
+        }
+
+        std::filesystem::rename(tempPath, ManifestPath(), ec);
+        return !ec;
+    }
+}
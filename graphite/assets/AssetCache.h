@@ -0,0 +1,41 @@
+#pragma once
+
+#include "core/CommonTypes.h"
+#include "rendering/Material.h"
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// content addressed store of cooked assets under Config::AssetCooking::CACHE_DIR.
+// outputs are named by a hash of their source bytes and import settings, so
+// identical sources share one file and a settings change misses cleanly.
+// a manifest maps source paths to keys, letting unchanged sources skip hashing
+namespace AssetCache
+{
+    enum class Kind
+    {
+        Model,   // .gmesh
+        Texture, // .gtex
+    };
+
+    // role only matters for textures
+    bool ComputeKey(const AssetID &source, Kind kind, TextureRole role, uint64_t &outKey);
+
+    // every file the cooked output depends on, source first. for a .gltf
+    // that includes its buffers
+    std::vector<std::filesystem::path> GetSourceFiles(const AssetID &source, Kind kind);
+
+    std::filesystem::path GetPath(uint64_t key, Kind kind);
+
+    // cooked file for source, or an empty path. the manifest entry is trusted
+    // while the source size and write time are unchanged, otherwise the source
+    // is hashed and any existing output with that key is reused (and recorded).
+    // outKey receives the key whenever it had to be computed
+    std::filesystem::path Find(const AssetID &source, Kind kind, TextureRole role, uint64_t *outKey = nullptr);
+
+    // remembers source -> key in memory and appends it to the manifest
+    void Record(const AssetID &source, Kind kind, TextureRole role, uint64_t key);
+
+    // rewrites the manifest with a single line per source
+    bool CompactManifest();
+}
@@ -0,0 +1,682 @@
+#include "AssetDecoder.h"
+#include "assets/AssetCache.h"
+#include "assets/AssetFiles.h"
+#include "assets/CookedTexture.h"
+#include "assets/MeshOptimizer.h"
+#include "assets/MeshProcessing.h"
+#include "assets/MeshSimplifier.h"
+#include "assets/MeshletBuilder.h"
+#include "assets/MipGenerator.h"
+#include "assets/MipStreamer.h"
+#include "assets/PngDecoder.h"
+#include "assets/VertexPacking.h"
+#include "core/ThreadPool.h"
+#include "utils/Logger.h"
+#include "cfg/Config.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/Importer.hpp>
+#include <assimp/MemoryIOWrapper.h>
+#include <assimp/mesh.h>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+    // vertices or faces per import task. 8k scans are often a single aiMesh
+    // with millions of vertices, so one mesh is split across the pool
+    constexpr size_t IMPORT_GRAIN = 64 * 1024;
+
+    // source arrays of one aiMesh, null for attributes it doesn't have
+    struct MeshAttributes
+    {
+        const aiVector3D *positions;
+        const aiVector3D *normals;
+        const aiVector3D *texCoords;
+        const aiVector3D *tangents;
+    };
+
+    // plain field copies, the compiler already moves them as vectors and the
+    // loop is bound by memory bandwidth rather than instructions
+    void ConvertVertices(const MeshAttributes &a, size_t begin, size_t end, Vertex *out)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            Vertex &v = out[i];
+            v.Position = {a.positions[i].x, a.positions[i].y, a.positions[i].z};
+            v.Normal = a.normals ? glm::vec3(a.normals[i].x, a.normals[i].y, a.normals[i].z) : glm::vec3(0.0f);
+            v.TexCoord = a.texCoords ? glm::vec2(a.texCoords[i].x, a.texCoords[i].y) : glm::vec2(0.0f);
+            v.Tangent = a.tangents ? glm::vec3(a.tangents[i].x, a.tangents[i].y, a.tangents[i].z) : glm::vec3(0.0f);
+        }
+    }
+
+    bool MapCachedModel(const AssetID &path, AssetDecoder::DecodedModel &outModel, ThreadPool *pool)
+    {
+        auto cookedPath = AssetCache::Find(path, AssetCache::Kind::Model, TextureRole::Albedo);
+        if (cookedPath.empty())
+            return false;
+
+        // a packed file is decompressed into memory, a loose one mapped as is
+        const unsigned char *data = nullptr;
+        size_t size = 0;
+        if (AssetFiles::IsPacked(cookedPath))
+        {
+            if (!AssetFiles::Read(cookedPath, outModel.packedFile, pool))
+            {
+                LOG_WARN("Failed to read packed cooked mesh, falling back to import: {}", cookedPath.string());
+                return false;
+            }
+            data = outModel.packedFile.data();
+            size = outModel.packedFile.size();
+        }
+        else
+        {
+            if (!outModel.cookedFile.Open(cookedPath))
+            {
+                LOG_WARN("Failed to map cooked mesh, falling back to import: {}", cookedPath.string());
+                return false;
+            }
+            data = outModel.cookedFile.GetData();
+            size = outModel.cookedFile.GetSize();
+        }
+
+        if (!CookedMesh::Read(data, size, outModel.submeshes, outModel.decoded, pool) || outModel.submeshes.empty())
+        {
+            LOG_WARN("Cooked mesh is invalid or out of date, falling back to import: {}", cookedPath.string());
+            outModel.cookedFile.Close();
+            outModel.packedFile = {};
+            outModel.decoded = {};
+            outModel.submeshes.clear();
+            return false;
+        }
+
+        outModel.fromCooked = true;
+        return true;
+    }
+
+    // lets assimp open files from mounted packs, a .gltf finds its buffers
+    // the same way. anything else goes to the file system as before
+    class PackedIOSystem : public Assimp::DefaultIOSystem
+    {
+    public:
+        bool Exists(const char *file) const override
+        {
+            return AssetFiles::IsPacked(file) || Assimp::DefaultIOSystem::Exists(file);
+        }
+
+        Assimp::IOStream *Open(const char *file, const char *mode = "rb") override
+        {
+            if (std::strchr(mode, 'w') || !AssetFiles::IsPacked(file))
+                return Assimp::DefaultIOSystem::Open(file, mode);
+
+            std::vector<unsigned char> data;
+            if (!AssetFiles::Read(file, data))
+                return nullptr;
+            auto *buffer = new uint8_t[data.size()];
+            std::memcpy(buffer, data.data(), data.size());
+            return new Assimp::MemoryIOStream(buffer, data.size(), true);
+        }
+    };
+
+    bool ImportModel(const AssetID &path, AssetDecoder::DecodedModel &outModel, ThreadPool *pool)
+    {
+        const uint32_t stages = MeshProcessing::GetParallelStages(path);
+        if (!AssetDecoder::ImportMeshes(path, stages, outModel.imported, pool))
+            return false;
+
+        if (Config::MeshOptimization::OPTIMIZE_ON_IMPORT)
+            MeshOptimizer::OptimizeSubmeshes(outModel.imported, pool);
+
+        for (auto &sm : outModel.imported)
+            sm.uvDensity = AssetDecoder::ComputeUvDensity(sm.vertices.data(), sm.indices.data(), sm.indices.size());
+
+        // lods are built from the optimized level 0 and share its vertices
+        if (Config::Lod::GENERATE_ON_IMPORT)
+            MeshSimplifier::GenerateLods(outModel.imported, pool);
+
+        outModel.submeshes.clear();
+        outModel.submeshes.reserve(outModel.imported.size());
+        for (auto &sm : outModel.imported)
+        {
+            if (sm.lods.empty())
+                sm.lods.push_back({0, static_cast<uint32_t>(sm.indices.size()), 0.0f, 0});
+
+            CookedMesh::SubmeshView view;
+            view.vertices = sm.vertices.data();
+            view.vertexCount = static_cast<uint32_t>(sm.vertices.size());
+            view.indices = sm.indices.data();
+            view.indexCount = static_cast<uint32_t>(sm.indices.size());
+            view.lods = sm.lods.data();
+            view.lodCount = static_cast<uint32_t>(sm.lods.size());
+            view.uvDensity = sm.uvDensity;
+            outModel.submeshes.push_back(view);
+        }
+        outModel.fromCooked = false;
+        return true;
+    }
+
+    bool StoreModel(const AssetID &path, uint64_t key, const AssetDecoder::DecodedModel &model, ThreadPool *pool)
+    {
+        auto cookedPath = AssetCache::GetPath(key, AssetCache::Kind::Model);
+        std::error_code ec;
+        std::filesystem::create_directories(cookedPath.parent_path(), ec);
+        if (!CookedMesh::Write(cookedPath, model.imported, pool))
+        {
+            LOG_WARN("Failed to write cooked mesh: {}", cookedPath.string());
+            return false;
+        }
+
+        AssetCache::Record(path, AssetCache::Kind::Model, TextureRole::Albedo, key);
+        LOG_INFO("Cooked {} to {}", path.string(), cookedPath.string());
+        return true;
+    }
+
+    // meshes imported without uvs come out with zero tangents, nothing reads them
+    bool HasTangents(const Vertex *vertices, size_t count)
+    {
+        return std::any_of(vertices, vertices + count, [](const Vertex &v)
+                           { return v.Tangent != glm::vec3(0.0f); });
+    }
+
+    void PackSubmesh(AssetDecoder::DecodedModel &model, size_t i)
+    {
+        const auto &sm = model.submeshes[i];
+        model.quantization[i] = VertexPacking::ComputeQuantization(sm.vertices, sm.vertexCount);
+        model.packedVertices[i].resize(sm.vertexCount);
+        VertexPacking::Pack(sm.vertices, sm.vertexCount, model.quantization[i], model.packedVertices[i].data());
+    }
+
+    void BuildMeshlets(AssetDecoder::DecodedModel &model, ThreadPool *pool)
+    {
+        model.meshlets.resize(model.submeshes.size());
+
+        auto run = [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                MeshletBuilder::Build(
+                    model.submeshes[i],
+                    Config::Meshlets::MAX_VERTICES,
+                    Config::Meshlets::MAX_TRIANGLES,
+                    model.meshlets[i]);
+            }
+        };
+
+        if (pool)
+            pool->ParallelFor(model.submeshes.size(), 1, run);
+        else
+            run(0, model.submeshes.size());
+    }
+
+    TextureFormat ChooseTextureFormat(TextureRole role, int width, int height)
+    {
+        // d3d11 wants bc base levels in whole blocks
+        if (!Config::Textures::BLOCK_COMPRESSION || width % 4 != 0 || height % 4 != 0)
+            return TextureFormat::RGBA8;
+
+        switch (role)
+        {
+        case TextureRole::Albedo:
+            return Config::Textures::ALBEDO_BC7 ? TextureFormat::BC7 : TextureFormat::BC1;
+        case TextureRole::Normal:
+            return TextureFormat::BC5; // z is rebuilt in GeometryPS
+        default:
+            return TextureFormat::BC1;
+        }
+    }
+
+    void CompressTexture(AssetDecoder::DecodedTexture &texture, TextureFormat format, ThreadPool *pool)
+    {
+        size_t total = 0;
+        for (int l = 0; l < texture.mipLevels; ++l)
+            total += BlockCompression::LevelBytes(format, MipGenerator::LevelSize(texture.width, l), MipGenerator::LevelSize(texture.height, l));
+        texture.levelData.reserve(total);
+
+        const unsigned char *level = texture.pixels.get();
+        for (int l = 0; l < texture.mipLevels; ++l)
+        {
+            int w = MipGenerator::LevelSize(texture.width, l), h = MipGenerator::LevelSize(texture.height, l);
+            BlockCompression::EncodeImage(level, w, h, format, texture.levelData, pool);
+            level = (l == 0 ? texture.mipChain.data() : level + size_t(w) * h * 4);
+        }
+
+        texture.format = format;
+        texture.pixels.reset();
+        texture.mipChain = {};
+    }
+
+    bool ReadCachedTexture(const AssetID &path, TextureRole role, AssetDecoder::DecodedTexture &outTexture)
+    {
+        auto cookedPath = AssetCache::Find(path, AssetCache::Kind::Texture, role);
+        if (cookedPath.empty())
+            return false;
+
+        // a loose file is used where it lies, the device reads the levels
+        // straight from the mapping. streaming picks its start level later
+        CookedTexture::TextureData data;
+        if (CookedTexture::Map(cookedPath, outTexture.cookedFile, data, outTexture.mappedLevels))
+        {
+            outTexture.width = data.width;
+            outTexture.height = data.height;
+            outTexture.mipLevels = data.mipLevels;
+            outTexture.format = data.format;
+            outTexture.firstLevel = 0;
+            outTexture.cookedPath = std::move(cookedPath);
+            return true;
+        }
+
+        // packed ones are read, and streamed textures leave their finer
+        // levels in the pack until needed
+        int firstLevel = 0;
+        if (Config::TextureStreaming::ENABLE && CookedTexture::ReadInfo(cookedPath, data))
+            firstLevel = MipStreamer::StartMip(data.format, data.width, data.height, data.mipLevels,
+                                               Config::TextureStreaming::START_SIZE);
+
+        if (!CookedTexture::Read(cookedPath, data, firstLevel))
+        {
+            LOG_WARN("Cooked texture is invalid or out of date, falling back to decode: {}", cookedPath.string());
+            return false;
+        }
+
+        outTexture.width = data.width;
+        outTexture.height = data.height;
+        outTexture.mipLevels = data.mipLevels;
+        outTexture.format = data.format;
+        outTexture.firstLevel = data.firstLevel;
+        outTexture.levelData = std::move(data.levels);
+        outTexture.cookedPath = std::move(cookedPath);
+        return true;
+    }
+
+    // rgba8 pixels, freed through PixelDeleter. pngs the fast decoder
+    // handles skip stb_image, everything else goes through it
+    unsigned char *LoadPixels(const AssetID &path, int &w, int &h, int &c, ThreadPool *pool)
+    {
+        std::vector<unsigned char> file;
+        if (!AssetFiles::Read(path, file, pool) || file.size() > size_t(std::numeric_limits<int>::max()))
+            return nullptr;
+
+        PngDecoder::Info info;
+        if (Config::Textures::FAST_PNG_DECODE && PngDecoder::ReadInfo(file.data(), file.size(), info))
+        {
+            // stbi_image_free is plain free, so these pixels share the deleter
+            const size_t stride = size_t(info.width) * 4;
+            auto *pixels = static_cast<unsigned char *>(std::malloc(stride * size_t(info.height)));
+            if (pixels && PngDecoder::Decode(file.data(), file.size(), info, pixels, stride))
+            {
+                w = info.width;
+                h = info.height;
+                c = info.channels;
+                return pixels;
+            }
+            std::free(pixels);
+            LOG_WARN("Fast png decode failed for {}, retrying with stb_image", path.string());
+        }
+        return stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &w, &h, &c, 4);
+    }
+
+    // decode, mips and block compression
+    bool DecodeTextureSource(const AssetID &path, TextureRole role, AssetDecoder::DecodedTexture &outTexture, ThreadPool *pool)
+    {
+        int w, h, c;
+        unsigned char *data = LoadPixels(path, w, h, c, pool);
+        if (!data)
+        {
+            LOG_ERROR("Failed to load image data from file: {}", path.string());
+            return false;
+        }
+
+        outTexture.pixels.reset(data);
+        outTexture.width = w;
+        outTexture.height = h;
+        outTexture.sourceChannels = c;
+
+        if (Config::Textures::GENERATE_MIPS)
+        {
+            auto start = std::chrono::steady_clock::now();
+            MipGenerator::Generate(
+                data, w, h, role,
+                Config::Textures::KAISER_MIP_FILTER ? MipGenerator::Filter::Kaiser : MipGenerator::Filter::Box,
+                outTexture.mipChain,
+                pool);
+            outTexture.mipLevels = MipGenerator::CountLevels(w, h);
+
+            LOG_DEBUG("Generated {} mip levels for {} in {:.1f} ms", outTexture.mipLevels, path.string(),
+                      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        TextureFormat format = ChooseTextureFormat(role, w, h);
+        if (BlockCompression::IsCompressed(format))
+        {
+            auto start = std::chrono::steady_clock::now();
+            CompressTexture(outTexture, format, pool);
+
+            LOG_DEBUG("Block compressed {} ({} KB) in {:.1f} ms", path.string(), outTexture.levelData.size() / 1024,
+                      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return true;
+    }
+
+    bool StoreTexture(const AssetID &path, TextureRole role, uint64_t key, const AssetDecoder::DecodedTexture &texture)
+    {
+        auto cookedPath = AssetCache::GetPath(key, AssetCache::Kind::Texture);
+        std::error_code ec;
+        std::filesystem::create_directories(cookedPath.parent_path(), ec);
+
+        auto levels = AssetDecoder::GetLevels(texture);
+        if (!CookedTexture::Write(cookedPath, texture.format, texture.width, texture.height, texture.mipLevels, levels.data()))
+        {
+            LOG_WARN("Failed to write cooked texture: {}", cookedPath.string());
+            return false;
+        }
+
+        AssetCache::Record(path, AssetCache::Kind::Texture, role, key);
+        LOG_INFO("Cooked {} to {}", path.string(), cookedPath.string());
+        return true;
+    }
+
+    void PackModel(AssetDecoder::DecodedModel &model, ThreadPool *pool)
+    {
+        model.packedVertices.resize(model.submeshes.size());
+        model.quantization.resize(model.submeshes.size());
+
+        auto run = [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                PackSubmesh(model, i);
+        };
+
+        if (pool)
+            pool->ParallelFor(model.submeshes.size(), 1, run);
+        else
+            run(0, model.submeshes.size());
+    }
+}
+
+namespace AssetDecoder
+{
+    void PixelDeleter::operator()(unsigned char *pixels) const
+    {
+        stbi_image_free(pixels);
+    }
+
+    bool DecodeModel(const AssetID &path, DecodedModel &outModel, ThreadPool *pool)
+    {
+        // cooked geometry skips assimp entirely
+        if (!MapCachedModel(path, outModel, pool))
+        {
+            if (!ImportModel(path, outModel, pool))
+                return false;
+
+            // cook so the next run can map the result directly
+            uint64_t key = 0;
+            if (Config::AssetCooking::WRITE_ON_IMPORT &&
+                AssetCache::ComputeKey(path, AssetCache::Kind::Model, TextureRole::Albedo, key))
+                StoreModel(path, key, outModel, pool);
+        }
+
+        outModel.bounds.clear();
+        outModel.bounds.reserve(outModel.submeshes.size());
+        outModel.hasTangents.clear();
+        outModel.hasTangents.reserve(outModel.submeshes.size());
+        for (const auto &sm : outModel.submeshes)
+        {
+            outModel.bounds.push_back(ComputeBounds(sm.vertices, sm.vertexCount));
+            outModel.hasTangents.push_back(HasTangents(sm.vertices, sm.vertexCount) ? 1 : 0);
+        }
+
+        if (Config::Meshlets::ENABLE)
+            BuildMeshlets(outModel, pool);
+
+        if (Config::VertexCompression::USE_PACKED_VERTICES)
+            PackModel(outModel, pool);
+
+        return true;
+    }
+
+    bool DecodeTexture(const AssetID &path, TextureRole role, DecodedTexture &outTexture, ThreadPool *pool)
+    {
+        if (ReadCachedTexture(path, role, outTexture))
+            return true;
+
+        if (!DecodeTextureSource(path, role, outTexture, pool))
+            return false;
+
+        uint64_t key = 0;
+        if (Config::AssetCooking::WRITE_ON_IMPORT &&
+            AssetCache::ComputeKey(path, AssetCache::Kind::Texture, role, key) &&
+            StoreTexture(path, role, key, outTexture))
+            outTexture.cookedPath = AssetCache::GetPath(key, AssetCache::Kind::Texture);
+        return true;
+    }
+
+    bool CookModel(const AssetID &path, uint64_t key, ThreadPool *pool)
+    {
+        DecodedModel model;
+        return ImportModel(path, model, pool) && StoreModel(path, key, model, pool);
+    }
+
+    bool CookTexture(const AssetID &path, TextureRole role, uint64_t key, ThreadPool *pool)
+    {
+        DecodedTexture texture;
+        return DecodeTextureSource(path, role, texture, pool) && StoreTexture(path, role, key, texture);
+    }
+
+    std::vector<const unsigned char *> GetLevels(const DecodedTexture &texture)
+    {
+        if (!texture.mappedLevels.empty())
+            return texture.mappedLevels;
+
+        // level data holds everything once compressed or cooked. otherwise
+        // level 0 stays in the stb allocation and the rest follow in mipChain.
+        // levels before firstLevel were never read and stay null
+        std::vector<const unsigned char *> levels(texture.mipLevels);
+        const bool packed = !texture.levelData.empty();
+        size_t offset = 0;
+        for (int l = texture.firstLevel; l < texture.mipLevels; ++l)
+        {
+            if (!packed && l == 0)
+            {
+                levels[0] = texture.pixels.get();
+                continue;
+            }
+            levels[l] = (packed ? texture.levelData.data() : texture.mipChain.data()) + offset;
+            offset += BlockCompression::LevelBytes(
+                texture.format,
+                MipGenerator::LevelSize(texture.width, l),
+                MipGenerator::LevelSize(texture.height, l));
+        }
+        return levels;
+    }
+
+    MeshBounds ComputeBounds(const Vertex *vertices, size_t vertexCount)
+    {
+        MeshBounds bounds;
+        if (vertexCount == 0)
+            return bounds;
+
+        bounds.min = bounds.max = vertices[0].Position;
+        for (size_t i = 1; i < vertexCount; ++i)
+        {
+            bounds.min = glm::min(bounds.min, vertices[i].Position);
+            bounds.max = glm::max(bounds.max, vertices[i].Position);
+        }
+
+        bounds.center = (bounds.min + bounds.max) * 0.5f;
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            glm::vec3 d = vertices[i].Position - bounds.center;
+            bounds.radius = std::max(bounds.radius, glm::dot(d, d));
+        }
+        bounds.radius = std::sqrt(bounds.radius);
+        return bounds;
+    }
+
+    float ComputeUvDensity(const Vertex *vertices, const uint32_t *indices, size_t indexCount)
+    {
+        // area weighted over the whole surface, so a few stretched triangles
+        // don't decide the mip for everything else
+        double uvArea = 0.0, surfaceArea = 0.0;
+        for (size_t i = 0; i + 2 < indexCount; i += 3)
+        {
+            const Vertex &a = vertices[indices[i]], &b = vertices[indices[i + 1]], &c = vertices[indices[i + 2]];
+            surfaceArea += glm::length(glm::cross(b.Position - a.Position, c.Position - a.Position));
+            const glm::vec2 e1 = b.TexCoord - a.TexCoord, e2 = c.TexCoord - a.TexCoord;
+            uvArea += std::abs(e1.x * e2.y - e1.y * e2.x);
+        }
+        return surfaceArea > 0.0 ? float(std::sqrt(uvArea / surfaceArea)) : 0.0f;
+    }
+
+    bool ImportMeshes(const AssetID &path, uint32_t parallelStages, std::vector<CookedMesh::SubmeshData> &outSubmeshes, ThreadPool *pool)
+    {
+        namespace MI = Config::MeshImport;
+
+        // importer instances are not shared, so concurrent imports are fine
+        Assimp::Importer importer;
+        if (AssetFiles::HasPacks())
+            importer.SetIOHandler(new PackedIOSystem); // the importer owns it
+        unsigned flags =
+            aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_ValidateDataStructure | aiProcess_FlipWindingOrder;
+        if (!(parallelStages & MI::WELD))
+            flags |= aiProcess_JoinIdenticalVertices;
+        if (!(parallelStages & MI::NORMALS))
+            flags |= aiProcess_GenSmoothNormals;
+        if (!(parallelStages & MI::TANGENTS))
+            flags |= aiProcess_CalcTangentSpace;
+
+        auto start = std::chrono::steady_clock::now();
+        const aiScene *scene = importer.ReadFile(
+            path.string(),
+            flags);
+
+        if (!scene || !scene->HasMeshes())
+        {
+            LOG_ERROR("Assimp failed to load model: {}", path.string());
+            return false;
+        }
+        const double readMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        outSubmeshes.resize(scene->mNumMeshes);
+        for (unsigned i = 0; i < scene->mNumMeshes; ++i)
+        {
+            const aiMesh *mesh = scene->mMeshes[i];
+            auto &sm = outSubmeshes[i];
+            if (!ProcessAssimpMesh(mesh, sm.vertices, sm.indices, pool))
+            {
+                LOG_ERROR("Failed to process mesh {} of model: {}", i, path.string());
+                return false;
+            }
+
+            // same order and the same conditions as assimp's steps: only
+            // missing attributes are generated, and tangents need uvs
+            if ((parallelStages & MI::NORMALS) && !mesh->HasNormals())
+                MeshProcessing::GenerateNormals(sm.vertices.data(), sm.vertices.size(), sm.indices.data(), sm.indices.size(), pool);
+            if ((parallelStages & MI::TANGENTS) && !mesh->HasTangentsAndBitangents() && mesh->HasTextureCoords(0))
+                MeshProcessing::GenerateTangents(sm.vertices.data(), sm.vertices.size(), sm.indices.data(), sm.indices.size(), pool);
+            if (parallelStages & MI::WELD)
+                MeshProcessing::WeldVertices(sm.vertices, sm.indices, pool);
+        }
+
+        LOG_DEBUG("Imported {}: assimp {:.1f} ms, conversion and post process {:.1f} ms",
+                  path.string(), readMs,
+                  std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        return true;
+    }
+
+    bool ProcessAssimpMesh(
+        const aiMesh *mesh,
+        UninitVector<Vertex> &outVertices,
+        UninitVector<uint32_t> &outIndices,
+        ThreadPool *pool)
+    {
+        if (!mesh->HasPositions())
+            return false;
+
+        const MeshAttributes attributes{
+            mesh->mVertices,
+            mesh->HasNormals() ? mesh->mNormals : nullptr,
+            mesh->HasTextureCoords(0) ? mesh->mTextureCoords[0] : nullptr,
+            mesh->HasTangentsAndBitangents() ? mesh->mTangents : nullptr};
+
+        // every chunk writes its own slice of the output, so any split gives
+        // the same bytes as a single pass. the arrays aren't zeroed first, each
+        // page is first touched by the worker that fills it
+        outVertices.resize(mesh->mNumVertices);
+        auto convert = [&](size_t begin, size_t end)
+        {
+            ConvertVertices(attributes, begin, end, outVertices.data());
+        };
+
+        // each chunk needs to know where its indices start. a triangle only
+        // mesh has three per face, otherwise the points and lines left over
+        // by triangulation are counted per chunk first and skipped
+        const bool trianglesOnly = mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE;
+        const size_t faceChunks = (size_t(mesh->mNumFaces) + IMPORT_GRAIN - 1) / IMPORT_GRAIN;
+        std::vector<size_t> chunkStart(faceChunks + 1, 0);
+        auto count = [&](size_t begin, size_t end)
+        {
+            for (size_t c = begin; c < end; ++c)
+            {
+                const size_t first = c * IMPORT_GRAIN;
+                const size_t last = std::min(size_t(mesh->mNumFaces), first + IMPORT_GRAIN);
+                size_t triangles = last - first;
+                if (!trianglesOnly)
+                {
+                    triangles = 0;
+                    for (size_t f = first; f < last; ++f)
+                        triangles += mesh->mFaces[f].mNumIndices == 3;
+                }
+                chunkStart[c + 1] = triangles * 3;
+            }
+        };
+        auto extract = [&](size_t begin, size_t end)
+        {
+            for (size_t c = begin; c < end; ++c)
+            {
+                const size_t last = std::min(size_t(mesh->mNumFaces), (c + 1) * IMPORT_GRAIN);
+                uint32_t *dst = outIndices.data() + chunkStart[c];
+                for (size_t f = c * IMPORT_GRAIN; f < last; ++f)
+                {
+                    const aiFace &face = mesh->mFaces[f];
+                    if (face.mNumIndices != 3)
+                        continue;
+                    dst[0] = face.mIndices[0];
+                    dst[1] = face.mIndices[1];
+                    dst[2] = face.mIndices[2];
+                    dst += 3;
+                }
+            }
+        };
+
+        if (pool)
+        {
+            pool->ParallelFor(outVertices.size(), IMPORT_GRAIN, convert);
+            pool->ParallelFor(faceChunks, 1, count);
+        }
+        else
+        {
+            convert(0, outVertices.size());
+            count(0, faceChunks);
+        }
+
+        std::partial_sum(chunkStart.begin(), chunkStart.end(), chunkStart.begin());
+        outIndices.resize(chunkStart.back());
+        if (pool)
+            pool->ParallelFor(faceChunks, 1, extract);
+        else
+            extract(0, faceChunks);
+
+        return true;
+    }
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "assets/BlockCompression.h"
+#include "assets/CookedMesh.h"
+#include "core/CommonTypes.h"
+#include "platform/MappedFile.h"
+#include "rendering/Material.h"
+#include "rendering/MeshBounds.h"
+#include "rendering/Meshlet.h"
+#include "rendering/PackedVertex.h"
+#include <memory>
+#include <vector>
+
+struct aiMesh;
+class ThreadPool;
+
+// cpu side decode stage for models and textures
+// nothing here touches the device, so every function is safe to run on a worker thread
+namespace AssetDecoder
+{
+    struct DecodedModel
+    {
+        // backing storage, only one of these is used
+        MappedFile cookedFile;
+        std::vector<unsigned char> packedFile; // cooked file read from a pack
+        std::vector<CookedMesh::SubmeshData> imported;
+        // streams of the cooked file that were stored encoded, decoded here
+        std::vector<CookedMesh::SubmeshData> decoded;
+
+        // views into the backing storage, one per submesh
+        std::vector<CookedMesh::SubmeshView> submeshes;
+        std::vector<MeshBounds> bounds;
+        std::vector<MeshletData> meshlets; // empty unless Config::Meshlets::ENABLE
+        // per submesh, 0 when every tangent is zero (imported without uvs),
+        // the tangent stream is then left out of the upload
+        std::vector<uint8_t> hasTangents;
+        bool fromCooked = false;
+
+        // packed copies of each submesh, only filled when
+        // Config::VertexCompression::USE_PACKED_VERTICES is set
+        std::vector<std::vector<PackedVertex>> packedVertices;
+        std::vector<VertexQuantization> quantization;
+
+        // vertices split into the streams of VertexLayout::Full or Packed,
+        // streams back to back, one buffer per submesh. the split needs the
+        // device side layouts, so AssetManager fills this on the decode worker
+        // after DecodeModel and the packed copies are dropped once split
+        std::vector<std::vector<unsigned char>> vertexStreams;
+    };
+
+    struct PixelDeleter
+    {
+        void operator()(unsigned char *pixels) const;
+    };
+
+    struct DecodedTexture
+    {
+        std::unique_ptr<unsigned char, PixelDeleter> pixels; // tightly packed rgba8
+        int width = 0;
+        int height = 0;
+        int sourceChannels = 0;
+
+        // rgba8 levels after the first, back to back (see MipGenerator)
+        int mipLevels = 1;
+        std::vector<unsigned char> mipChain;
+
+        // every level back to back in format. used instead of pixels and
+        // mipChain once the texture is block compressed or read from the cache
+        TextureFormat format = TextureFormat::RGBA8;
+        std::vector<unsigned char> levelData;
+
+        // a loose cooked texture is mapped instead, mappedLevels then points
+        // at every level in place and levelData stays empty
+        MappedFile cookedFile;
+        std::vector<const unsigned char *> mappedLevels;
+
+        // cooked copy the finer levels can be streamed from later, empty when
+        // the texture isn't cached. levels before firstLevel were left there
+        std::filesystem::path cookedPath;
+        int firstLevel = 0;
+    };
+
+    // maps the cached .gmesh if there is one, otherwise imports with assimp
+    // (and cooks the result when enabled in Config). pool is optional and used
+    // for per-submesh work during import and packing
+    bool DecodeModel(const AssetID &path, DecodedModel &outModel, ThreadPool *pool = nullptr);
+
+    // role picks the mip filtering (srgb albedo, renormalized normals) and
+    // the block compression format
+    bool DecodeTexture(const AssetID &path, TextureRole role, DecodedTexture &outTexture, ThreadPool *pool = nullptr);
+
+    // import from source and write the result to the asset cache under key
+    // (see AssetCache::ComputeKey), regardless of Config. used by graphite_cook
+    bool CookModel(const AssetID &path, uint64_t key, ThreadPool *pool = nullptr);
+    bool CookTexture(const AssetID &path, TextureRole role, uint64_t key, ThreadPool *pool = nullptr);
+
+    // start of every mip level, whichever storage the texture uses. null
+    // for levels before firstLevel
+    std::vector<const unsigned char *> GetLevels(const DecodedTexture &texture);
+
+    MeshBounds ComputeBounds(const Vertex *vertices, size_t vertexCount);
+
+    // sqrt(uv area / surface area): texels per object space unit for a 1x1 texture
+    float ComputeUvDensity(const Vertex *vertices, const uint32_t *indices, size_t indexCount);
+
+    // assimp import plus our own post processes for the stages set in
+    // parallelStages (see Config::MeshImport), without optimization or lods.
+    // graphite_cook calls it directly to compare both sides
+    bool ImportMeshes(
+        const AssetID &path,
+        uint32_t parallelStages,
+        std::vector<CookedMesh::SubmeshData> &outSubmeshes,
+        ThreadPool *pool = nullptr);
+
+    // pool splits the vertices and faces of the one mesh into chunks, the
+    // output is the same with or without it
+    bool ProcessAssimpMesh(
+        const aiMesh *mesh,
+        UninitVector<Vertex> &outVertices,
+        UninitVector<uint32_t> &outIndices,
+        ThreadPool *pool = nullptr);
+}
@@ -0,0 +1,139 @@
+#include "AssetFiles.h"
+#include "assets/AssetPack.h"
+#include "utils/Logger.h"
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <system_error>
+
+namespace
+{
+    struct Mounts
+    {
+        std::shared_mutex mutex;
+        std::vector<std::unique_ptr<AssetPack>> packs;
+    };
+
+    Mounts &GetMounts()
+    {
+        static Mounts mounts;
+        return mounts;
+    }
+
+    // caller holds the mutex
+    const AssetPack::Entry *FindPacked(const Mounts &mounts, const std::filesystem::path &path, const AssetPack *&outPack)
+    {
+        for (auto it = mounts.packs.rbegin(); it != mounts.packs.rend(); ++it)
+        {
+            if (const AssetPack::Entry *entry = (*it)->Find(path))
+            {
+                outPack = it->get();
+                return entry;
+            }
+        }
+        return nullptr;
+    }
+}
+
+namespace AssetFiles
+{
+    bool Mount(const std::filesystem::path &packPath)
+    {
+        auto pack = std::make_unique<AssetPack>();
+        if (!pack->Open(packPath))
+        {
+            LOG_ERROR("AssetFiles: failed to mount {}", packPath.string());
+            return false;
+        }
+
+        LOG_INFO("AssetFiles: mounted {} ({} files)", packPath.string(), pack->GetEntryCount());
+        auto &mounts = GetMounts();
+        std::unique_lock<std::shared_mutex> lock(mounts.mutex);
+        mounts.packs.push_back(std::move(pack));
+        return true;
+    }
+
+    void UnmountAll()
+    {
+        auto &mounts = GetMounts();
+        std::unique_lock<std::shared_mutex> lock(mounts.mutex);
+        mounts.packs.clear();
+    }
+
+    bool HasPacks()
+    {
+        auto &mounts = GetMounts();
+        std::shared_lock<std::shared_mutex> lock(mounts.mutex);
+        return !mounts.packs.empty();
+    }
+
+    bool IsPacked(const std::filesystem::path &path)
+    {
+        auto &mounts = GetMounts();
+        std::shared_lock<std::shared_mutex> lock(mounts.mutex);
+        const AssetPack *pack = nullptr;
+        return FindPacked(mounts, path, pack) != nullptr;
+    }
+
+    bool Exists(const std::filesystem::path &path)
+    {
+        if (IsPacked(path))
+            return true;
+        std::error_code ec;
+        return std::filesystem::is_regular_file(path, ec);
+    }
+
+    bool GetSize(const std::filesystem::path &path, uint64_t &outSize)
+    {
+        {
+            auto &mounts = GetMounts();
+            std::shared_lock<std::shared_mutex> lock(mounts.mutex);
+            const AssetPack *pack = nullptr;
+            if (const AssetPack::Entry *entry = FindPacked(mounts, path, pack))
+            {
+                outSize = entry->size;
+                return true;
+            }
+        }
+
+        std::error_code ec;
+        outSize = std::filesystem::file_size(path, ec);
+        return !ec;
+    }
+
+    bool Read(const std::filesystem::path &path, std::vector<unsigned char> &out, ThreadPool *pool)
+    {
+        {
+            auto &mounts = GetMounts();
+            std::shared_lock<std::shared_mutex> lock(mounts.mutex);
+            const AssetPack *pack = nullptr;
+            if (const AssetPack::Entry *entry = FindPacked(mounts, path, pack))
+                return pack->Read(*entry, out, pool);
+        }
+
+        uint64_t size = 0;
+        if (!GetSize(path, size))
+            return false;
+        out.resize(static_cast<size_t>(size));
+        return ReadRange(path, 0, size, out.data(), pool);
+    }
+
+    bool ReadRange(const std::filesystem::path &path, uint64_t offset, uint64_t size, void *out, ThreadPool *pool)
+    {
+        {
+            auto &mounts = GetMounts();
+            std::shared_lock<std::shared_mutex> lock(mounts.mutex);
+            const AssetPack *pack = nullptr;
+            if (const AssetPack::Entry *entry = FindPacked(mounts, path, pack))
+                return pack->ReadRange(*entry, offset, size, out, pool);
+        }
+
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            return false;
+        in.seekg(static_cast<std::streamoff>(offset));
+        in.read(static_cast<char *>(out), static_cast<std::streamsize>(size));
+        return static_cast<bool>(in);
+    }
+}
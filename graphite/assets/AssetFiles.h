@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+class ThreadPool;
+
+// file access for asset sources and cooked files. mounted packs (AssetPack)
+// are searched first, the last one mounted winning, then the file system, so
+// a shipped build reads everything from a few mapped files while loose files
+// keep working during development. safe to call from any thread
+namespace AssetFiles
+{
+    // packs stay mapped until UnmountAll
+    bool Mount(const std::filesystem::path &packPath);
+    void UnmountAll();
+    bool HasPacks();
+
+    bool IsPacked(const std::filesystem::path &path);
+    bool Exists(const std::filesystem::path &path);
+    bool GetSize(const std::filesystem::path &path, uint64_t &outSize);
+
+    // pool spreads the decompression of packed files over its workers
+    bool Read(const std::filesystem::path &path, std::vector<unsigned char> &out, ThreadPool *pool = nullptr);
+
+    // out must hold size bytes, fails if the range runs past the end
+    bool ReadRange(const std::filesystem::path &path, uint64_t offset, uint64_t size, void *out, ThreadPool *pool = nullptr);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+
+enum class AssetState : uint8_t
+{
+    Pending,
+    Ready,
+    Failed,
+    Evicted // released under the residency budget, reloads when referenced again
+};
+
+// request state changes shared by models and textures, apart from the
+// AssetManager so they can be checked without a device
+namespace AssetStates
+{
+    // while a decode runs. a reload keeps drawing the current version until
+    // the new one is finalized
+    inline AssetState Decoding(AssetState state)
+    {
+        return state == AssetState::Ready ? AssetState::Ready : AssetState::Pending;
+    }
+
+    // whether a finished decode is finalized. an asset evicted while its
+    // reload ran drops the result, finalizing would make it resident again
+    // behind the budget's back. the next reference decodes it afresh
+    inline bool KeepsResult(AssetState state)
+    {
+        return state != AssetState::Evicted;
+    }
+
+    // after a kept result. a failed reload leaves the previous version in place
+    inline AssetState Completed(AssetState state, bool succeeded)
+    {
+        return succeeded || state == AssetState::Ready ? AssetState::Ready : AssetState::Failed;
+    }
+}
+
+// 32-bit generational handle returned by the AssetManager. the low bits index
+// a slot in a HandleTable, the high bits hold the slot's generation when the
+// handle was issued, so a handle to a released slot never aliases its reuse
+template <typename Tag>
+struct AssetHandle
+{
+    static constexpr uint32_t INDEX_BITS = 20;
+    static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static constexpr uint32_t GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+    static constexpr uint32_t MAX_SLOTS = INDEX_MASK; // the all ones index is never issued
+    static constexpr uint32_t INVALID = 0xFFFFFFFFu;
+
+    uint32_t id = INVALID;
+
+    static AssetHandle Make(uint32_t index, uint32_t generation)
+    {
+        return AssetHandle{(generation << INDEX_BITS) | (index & INDEX_MASK)};
+    }
+
+    uint32_t Index() const { return id & INDEX_MASK; }
+    uint32_t Generation() const { return id >> INDEX_BITS; }
+
+    bool IsValid() const { return id != INVALID; }
+    bool operator==(const AssetHandle &other) const { return id == other.id; }
+    bool operator!=(const AssetHandle &other) const { return id != other.id; }
+};
+
+using ModelHandle = AssetHandle<struct ModelHandleTag>;
+using TextureHandle = AssetHandle<struct TextureHandleTag>;
+using MaterialHandle = AssetHandle<struct MaterialHandleTag>;
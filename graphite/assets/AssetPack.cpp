@@ -0,0 +1,411 @@
+#include "AssetPack.h"
+#include "core/ThreadPool.h"
+#include "utils/Hash.h"
+#include "utils/Logger.h"
+#include "utils/Lz.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <system_error>
+
+namespace
+{
+    // raw bytes gathered before a batch of chunks is compressed and written
+    constexpr uint64_t WRITE_BATCH_BYTES = 64ull * 1024 * 1024;
+
+    bool IsRangeValid(uint64_t offset, uint64_t size, uint64_t fileSize)
+    {
+        return offset <= fileSize && size <= fileSize - offset;
+    }
+
+    uint64_t HashPath(const std::string &normalized)
+    {
+        Hash64 h;
+        h.Update(normalized.data(), normalized.size());
+        return h.Finish();
+    }
+
+    uint32_t ChunkCount(uint64_t size, uint32_t chunkSize)
+    {
+        return static_cast<uint32_t>((size + chunkSize - 1) / chunkSize);
+    }
+
+    bool ReadWholeFile(const std::filesystem::path &path, uint64_t expectedSize, std::vector<unsigned char> &out)
+    {
+        std::ifstream in(path, std::ios::binary);
+        out.resize(static_cast<size_t>(expectedSize));
+        in.read(reinterpret_cast<char *>(out.data()), static_cast<std::streamsize>(out.size()));
+        return in && in.peek() == std::ifstream::traits_type::eof();
+    }
+}
+
+bool AssetPack::Open(const std::filesystem::path &path)
+{
+    Close();
+    if (!m_File.Open(path))
+        return false;
+
+    const unsigned char *base = m_File.GetData();
+    const uint64_t fileSize = m_File.GetSize();
+    auto fail = [&](const char *why)
+    {
+        LOG_ERROR("AssetPack: {} is invalid ({})", path.string(), why);
+        Close();
+        return false;
+    };
+
+    if (fileSize < sizeof(FileHeader))
+        return fail("truncated header");
+    const auto *header = reinterpret_cast<const FileHeader *>(base);
+    if (header->magic != MAGIC || header->version != VERSION)
+        return fail("wrong magic or version");
+    if (header->chunkSize == 0)
+        return fail("zero chunk size");
+
+    const uint64_t entryBytes = sizeof(Entry) * uint64_t(header->entryCount);
+    const uint64_t chunkBytes = sizeof(Chunk) * uint64_t(header->chunkCount);
+    const uint64_t stringOffset = sizeof(FileHeader) + entryBytes + chunkBytes;
+    if (!IsRangeValid(sizeof(FileHeader), entryBytes + chunkBytes, fileSize) ||
+        !IsRangeValid(stringOffset, header->stringBytes, fileSize))
+        return fail("tables out of range");
+
+    const auto *entries = reinterpret_cast<const Entry *>(base + sizeof(FileHeader));
+    const auto *chunks = reinterpret_cast<const Chunk *>(base + sizeof(FileHeader) + entryBytes);
+
+    // every chunk must lie in the file and each entry's chunks must add up to
+    // its size, so reads only have to check the codec's output
+    for (uint32_t c = 0; c < header->chunkCount; ++c)
+    {
+        if (!IsRangeValid(chunks[c].offset, chunks[c].storedSize, fileSize) ||
+            chunks[c].rawSize > header->chunkSize || chunks[c].storedSize > chunks[c].rawSize)
+            return fail("chunk out of range");
+    }
+    for (uint32_t i = 0; i < header->entryCount; ++i)
+    {
+        const Entry &e = entries[i];
+        if (i > 0 && entries[i - 1].pathHash > e.pathHash)
+            return fail("entries not sorted");
+        if (e.chunkCount != ChunkCount(e.size, header->chunkSize) ||
+            uint64_t(e.firstChunk) + e.chunkCount > header->chunkCount ||
+            uint64_t(e.pathOffset) + e.pathLength > header->stringBytes)
+            return fail("entry out of range");
+        for (uint32_t c = 0; c < e.chunkCount; ++c)
+        {
+            const uint64_t expected = std::min<uint64_t>(header->chunkSize, e.size - uint64_t(c) * header->chunkSize);
+            if (chunks[e.firstChunk + c].rawSize != expected)
+                return fail("chunk sizes don't match the entry");
+        }
+    }
+
+    m_Header = header;
+    m_Entries = entries;
+    m_Chunks = chunks;
+    m_Strings = reinterpret_cast<const char *>(base + stringOffset);
+    m_EntryCount = header->entryCount;
+    return true;
+}
+
+void AssetPack::Close()
+{
+    m_File.Close();
+    m_Header = nullptr;
+    m_Entries = nullptr;
+    m_Chunks = nullptr;
+    m_Strings = nullptr;
+    m_EntryCount = 0;
+}
+
+const AssetPack::Entry *AssetPack::Find(const std::filesystem::path &path) const
+{
+    if (!IsOpen())
+        return nullptr;
+
+    const std::string name = NormalizePath(path);
+    const uint64_t hash = HashPath(name);
+    const Entry *end = m_Entries + m_EntryCount;
+    const Entry *it = std::lower_bound(m_Entries, end, hash, [](const Entry &e, uint64_t h)
+                                       { return e.pathHash < h; });
+
+    // the stored path settles hash collisions
+    for (; it != end && it->pathHash == hash; ++it)
+    {
+        if (it->pathLength == name.size() && std::memcmp(m_Strings + it->pathOffset, name.data(), name.size()) == 0)
+            return it;
+    }
+    return nullptr;
+}
+
+std::string AssetPack::GetPath(const Entry &entry) const
+{
+    return std::string(m_Strings + entry.pathOffset, entry.pathLength);
+}
+
+uint64_t AssetPack::GetStoredBytes(const Entry &entry) const
+{
+    uint64_t bytes = 0;
+    for (uint32_t c = 0; c < entry.chunkCount; ++c)
+        bytes += m_Chunks[entry.firstChunk + c].storedSize;
+    return bytes;
+}
+
+bool AssetPack::ReadRange(const Entry &entry, uint64_t offset, uint64_t size, void *out, ThreadPool *pool) const
+{
+    if (!IsOpen() || offset > entry.size || size > entry.size - offset)
+        return false;
+    if (size == 0)
+        return true;
+
+    const uint64_t chunkSize = m_Header->chunkSize;
+    const uint64_t firstChunk = offset / chunkSize;
+    const size_t count = static_cast<size_t>((offset + size - 1) / chunkSize - firstChunk + 1);
+    auto *dst = static_cast<unsigned char *>(out);
+    const unsigned char *base = m_File.GetData();
+
+    std::atomic<bool> ok{true};
+    auto run = [&](size_t begin, size_t end)
+    {
+        std::vector<unsigned char> scratch;
+        for (size_t i = begin; i < end && ok.load(std::memory_order_relaxed); ++i)
+        {
+            const Chunk &chunk = m_Chunks[entry.firstChunk + firstChunk + i];
+            const uint64_t chunkStart = (firstChunk + i) * chunkSize;
+            const uint64_t from = std::max(offset, chunkStart);
+            const uint64_t to = std::min(offset + size, chunkStart + chunk.rawSize);
+            unsigned char *target = dst + (from - offset);
+
+            if (from == chunkStart && to == chunkStart + chunk.rawSize)
+            {
+                if (!ReadChunk(chunk, target))
+                    ok = false;
+                continue;
+            }
+
+            // the ends of the range only want part of their chunk
+            const unsigned char *source = base + chunk.offset;
+            if (chunk.storedSize != chunk.rawSize)
+            {
+                scratch.resize(chunk.rawSize);
+                if (!ReadChunk(chunk, scratch.data()))
+                {
+                    ok = false;
+                    continue;
+                }
+                source = scratch.data();
+            }
+            std::memcpy(target, source + (from - chunkStart), static_cast<size_t>(to - from));
+        }
+    };
+
+    if (pool && count > 1)
+        pool->ParallelFor(count, 1, run);
+    else
+        run(0, count);
+    return ok;
+}
+
+bool AssetPack::Read(const Entry &entry, std::vector<unsigned char> &out, ThreadPool *pool) const
+{
+    out.resize(static_cast<size_t>(entry.size));
+    return ReadRange(entry, 0, entry.size, out.data(), pool);
+}
+
+std::string AssetPack::NormalizePath(const std::filesystem::path &path)
+{
+    return path.lexically_normal().generic_string();
+}
+
+bool AssetPack::ReadChunk(const Chunk &chunk, unsigned char *out) const
+{
+    const unsigned char *source = m_File.GetData() + chunk.offset;
+    if (chunk.storedSize == chunk.rawSize)
+    {
+        std::memcpy(out, source, chunk.rawSize);
+        return true;
+    }
+    return Lz::Decompress(source, chunk.storedSize, out, chunk.rawSize);
+}
+
+bool AssetPack::Write(
+    const std::filesystem::path &path,
+    const std::vector<std::string> &names,
+    const std::vector<std::filesystem::path> &files,
+    uint32_t chunkSize,
+    ThreadPool *pool)
+{
+    if (names.size() != files.size() || chunkSize == 0 || files.size() > std::numeric_limits<uint32_t>::max())
+        return false;
+
+    // the layout up to the chunk data only depends on names and sizes
+    std::vector<Entry> entries(files.size());
+    std::string strings;
+    uint64_t chunkCount = 0;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        std::error_code ec;
+        const uint64_t size = std::filesystem::file_size(files[i], ec);
+        if (ec)
+        {
+            LOG_ERROR("AssetPack: can't read {}", files[i].string());
+            return false;
+        }
+
+        const std::string name = NormalizePath(names[i]);
+        Entry &e = entries[i];
+        e.pathHash = HashPath(name);
+        e.size = size;
+        e.firstChunk = static_cast<uint32_t>(chunkCount);
+        e.chunkCount = ChunkCount(size, chunkSize);
+        e.pathOffset = static_cast<uint32_t>(strings.size());
+        e.pathLength = static_cast<uint32_t>(name.size());
+        strings += name;
+        chunkCount += e.chunkCount;
+    }
+    if (chunkCount > std::numeric_limits<uint32_t>::max() || strings.size() > std::numeric_limits<uint32_t>::max())
+    {
+        LOG_ERROR("AssetPack: too many files for one pack");
+        return false;
+    }
+
+    FileHeader header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.chunkSize = chunkSize;
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.chunkCount = static_cast<uint32_t>(chunkCount);
+    header.stringBytes = static_cast<uint32_t>(strings.size());
+
+    std::vector<Chunk> chunks(chunkCount);
+    uint64_t cursor = sizeof(FileHeader) + sizeof(Entry) * entries.size() + sizeof(Chunk) * chunks.size() + strings.size();
+
+    // write to a temp file first so a failed pack never replaces a good one
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            LOG_ERROR("AssetPack: failed to open {} for writing", tempPath.string());
+            return false;
+        }
+
+        // tables are written once every chunk's place is known
+        out.seekp(static_cast<std::streamoff>(cursor - strings.size()));
+        out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+
+        // files are gathered into batches so small ones still compress in parallel
+        std::vector<std::vector<unsigned char>> batch;
+        std::vector<uint32_t> batchChunks; // first chunk of each file in the batch
+        std::vector<std::vector<unsigned char>> compressed;
+        uint64_t batchBytes = 0;
+        size_t next = 0;
+        while (next < files.size() || !batch.empty())
+        {
+            if (next < files.size() && batchBytes < WRITE_BATCH_BYTES)
+            {
+                batch.emplace_back();
+                if (!ReadWholeFile(files[next], entries[next].size, batch.back()))
+                {
+                    LOG_ERROR("AssetPack: {} changed while packing", files[next].string());
+                    return false;
+                }
+                batchChunks.push_back(entries[next].firstChunk);
+                batchBytes += entries[next].size;
+                ++next;
+                continue;
+            }
+
+            // (file, chunk within it) for every chunk of the batch
+            std::vector<std::pair<size_t, uint32_t>> work;
+            for (size_t f = 0; f < batch.size(); ++f)
+            {
+                for (uint32_t c = 0; c < ChunkCount(batch[f].size(), chunkSize); ++c)
+                    work.emplace_back(f, c);
+            }
+            compressed.resize(work.size());
+
+            auto run = [&](size_t begin, size_t end)
+            {
+                for (size_t w = begin; w < end; ++w)
+                {
+                    const auto &data = batch[work[w].first];
+                    const uint64_t start = uint64_t(work[w].second) * chunkSize;
+                    const size_t rawSize = static_cast<size_t>(std::min<uint64_t>(chunkSize, data.size() - start));
+
+                    auto &packed = compressed[w];
+                    packed.resize(Lz::CompressBound(rawSize));
+                    const size_t storedSize = Lz::Compress(data.data() + start, rawSize, packed.data(), packed.size());
+                    if (storedSize == 0 || storedSize >= rawSize)
+                        packed.assign(data.begin() + start, data.begin() + start + rawSize);
+                    else
+                        packed.resize(storedSize);
+                }
+            };
+            if (pool)
+                pool->ParallelFor(work.size(), 4, run);
+            else
+                run(0, work.size());
+
+            for (size_t w = 0; w < work.size(); ++w)
+            {
+                Chunk &chunk = chunks[batchChunks[work[w].first] + work[w].second];
+                chunk.offset = cursor;
+                chunk.storedSize = static_cast<uint32_t>(compressed[w].size());
+                chunk.rawSize = static_cast<uint32_t>(std::min<uint64_t>(
+                    chunkSize, batch[work[w].first].size() - uint64_t(work[w].second) * chunkSize));
+                out.write(reinterpret_cast<const char *>(compressed[w].data()), static_cast<std::streamsize>(compressed[w].size()));
+                cursor += compressed[w].size();
+            }
+
+            batch.clear();
+            batchChunks.clear();
+            batchBytes = 0;
+        }
+
+        // sorted for lookup, the string of each entry settles equal hashes
+        std::vector<size_t> order(entries.size());
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                  {
+                      const Entry &ea = entries[a], &eb = entries[b];
+                      if (ea.pathHash != eb.pathHash)
+                          return ea.pathHash < eb.pathHash;
+                      return strings.compare(ea.pathOffset, ea.pathLength, strings, eb.pathOffset, eb.pathLength) < 0;
+                  });
+        std::vector<Entry> sorted(entries.size());
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            sorted[i] = entries[order[i]];
+            if (i > 0 && sorted[i].pathHash == sorted[i - 1].pathHash &&
+                strings.compare(sorted[i].pathOffset, sorted[i].pathLength, strings, sorted[i - 1].pathOffset, sorted[i - 1].pathLength) == 0)
+            {
+                LOG_ERROR("AssetPack: {} is listed twice", strings.substr(sorted[i].pathOffset, sorted[i].pathLength));
+                return false;
+            }
+        }
+
+        out.seekp(0);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(sorted.data()), static_cast<std::streamsize>(sizeof(Entry) * sorted.size()));
+        out.write(reinterpret_cast<const char *>(chunks.data()), static_cast<std::streamsize>(sizeof(Chunk) * chunks.size()));
+
+        if (!out)
+        {
+            LOG_ERROR("AssetPack: write failed for {}", tempPath.string());
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec)
+    {
+        LOG_ERROR("AssetPack: failed to move {} into place", path.string());
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "platform/MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// .gpak: many asset files in one mapped file, so loading an asset is a table
+// lookup instead of an open and a seek per file
+//
+//   FileHeader
+//   Entry[entryCount]  sorted by pathHash
+//   Chunk[chunkCount]  each entry's chunks are consecutive
+//   path strings
+//   chunk data
+//
+// files are split into chunkSize pieces compressed on their own (Lz), so a
+// file decompresses in parallel and a range of it without touching the rest.
+// a chunk that doesn't shrink is stored as is. offsets are absolute
+class AssetPack
+{
+public:
+    static constexpr uint32_t MAGIC = 0x4B415047; // "GPAK"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr const char *EXTENSION = ".gpak";
+
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t chunkSize;
+        uint32_t entryCount;
+        uint32_t chunkCount;
+        uint32_t stringBytes;
+        uint64_t reserved;
+    };
+    static_assert(sizeof(FileHeader) == 32, "FileHeader layout is part of the file format.");
+
+    struct Entry
+    {
+        uint64_t pathHash; // Hash64 of NormalizePath
+        uint64_t size;
+        uint32_t firstChunk;
+        uint32_t chunkCount;
+        uint32_t pathOffset; // into the path strings
+        uint32_t pathLength;
+    };
+    static_assert(sizeof(Entry) == 32, "Entry layout is part of the file format.");
+
+    struct Chunk
+    {
+        uint64_t offset;
+        uint32_t storedSize; // equal to the raw size when stored uncompressed
+        uint32_t rawSize;
+    };
+    static_assert(sizeof(Chunk) == 16, "Chunk layout is part of the file format.");
+
+    // validates the header and tables, chunk data is checked as it's read
+    bool Open(const std::filesystem::path &path);
+    void Close();
+    bool IsOpen() const { return m_File.IsOpen(); }
+
+    // null when path isn't in the pack
+    const Entry *Find(const std::filesystem::path &path) const;
+
+    size_t GetEntryCount() const { return m_EntryCount; }
+    const Entry &GetEntry(size_t index) const { return m_Entries[index]; }
+    std::string GetPath(const Entry &entry) const;
+    uint64_t GetStoredBytes(const Entry &entry) const;
+
+    // out must hold size bytes. only the chunks overlapping the range are
+    // decompressed, spread over pool when there is more than one
+    bool ReadRange(const Entry &entry, uint64_t offset, uint64_t size, void *out, ThreadPool *pool = nullptr) const;
+    bool Read(const Entry &entry, std::vector<unsigned char> &out, ThreadPool *pool = nullptr) const;
+
+    // paths are looked up as relative generic strings, "a/./b\\c" finds "a/b/c"
+    static std::string NormalizePath(const std::filesystem::path &path);
+
+    // files[i] is stored under names[i]. chunks are compressed on pool,
+    // written to a temp file and moved into place
+    static bool Write(
+        const std::filesystem::path &path,
+        const std::vector<std::string> &names,
+        const std::vector<std::filesystem::path> &files,
+        uint32_t chunkSize,
+        ThreadPool *pool = nullptr);
+
+private:
+    bool ReadChunk(const Chunk &chunk, unsigned char *out) const;
+
+    MappedFile m_File;
+    const FileHeader *m_Header = nullptr;
+    const Entry *m_Entries = nullptr;
+    const Chunk *m_Chunks = nullptr;
+    const char *m_Strings = nullptr;
+    size_t m_EntryCount = 0;
+};
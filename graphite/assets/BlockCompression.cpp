@@ -0,0 +1,627 @@
+#include "BlockCompression.h"
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+    // block rows per pool task
+    constexpr size_t ROWS_PER_TASK = 4;
+
+    float Dot(const float *a, const float *b, int channels)
+    {
+        float d = 0.0f;
+        for (int c = 0; c < channels; ++c)
+            d += a[c] * b[c];
+        return d;
+    }
+
+    // mean and dominant direction of the first `channels` components
+    void PrincipalAxis(const unsigned char *tile, int channels, float *mean, float *axis)
+    {
+        for (int c = 0; c < channels; ++c)
+        {
+            mean[c] = 0.0f;
+            for (int i = 0; i < 16; ++i)
+                mean[c] += tile[i * 4 + c];
+            mean[c] /= 16.0f;
+        }
+
+        float cov[4][4] = {};
+        for (int i = 0; i < 16; ++i)
+        {
+            float d[4];
+            for (int c = 0; c < channels; ++c)
+                d[c] = tile[i * 4 + c] - mean[c];
+            for (int a = 0; a < channels; ++a)
+                for (int b = 0; b < channels; ++b)
+                    cov[a][b] += d[a] * d[b];
+        }
+
+        // power iteration, started from the largest diagonal so the
+        // start vector is never orthogonal to the answer
+        int start = 0;
+        for (int c = 1; c < channels; ++c)
+            start = cov[c][c] > cov[start][start] ? c : start;
+        for (int c = 0; c < channels; ++c)
+            axis[c] = cov[start][c];
+
+        for (int iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[4] = {};
+            for (int a = 0; a < channels; ++a)
+                for (int b = 0; b < channels; ++b)
+                    next[a] += cov[a][b] * axis[b];
+
+            float length = std::sqrt(Dot(next, next, channels));
+            if (length < 1e-6f)
+                break;
+            for (int c = 0; c < channels; ++c)
+                axis[c] = next[c] / length;
+        }
+
+        float length = std::sqrt(Dot(axis, axis, channels));
+        if (length < 1e-6f)
+        {
+            for (int c = 0; c < channels; ++c)
+                axis[c] = 0.0f;
+            return;
+        }
+        for (int c = 0; c < channels; ++c)
+            axis[c] /= length;
+    }
+
+    // endpoints at the extreme projections onto the principal axis
+    void AxisEndpoints(const unsigned char *tile, int channels, float *e0, float *e1)
+    {
+        float mean[4], axis[4];
+        PrincipalAxis(tile, channels, mean, axis);
+
+        float minT = 0.0f, maxT = 0.0f;
+        for (int i = 0; i < 16; ++i)
+        {
+            float d[4];
+            for (int c = 0; c < channels; ++c)
+                d[c] = tile[i * 4 + c] - mean[c];
+            float t = Dot(d, axis, channels);
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+        for (int c = 0; c < channels; ++c)
+        {
+            e0[c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+            e1[c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+        }
+    }
+
+    // least squares endpoints for fixed interpolation weights (0..1 per texel)
+    bool RefitEndpoints(const unsigned char *tile, int channels, const float *weights, float *e0, float *e1)
+    {
+        // minimize sum |(1-w) e0 + w e1 - p|^2
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ap[4] = {}, bp[4] = {};
+        for (int i = 0; i < 16; ++i)
+        {
+            float b = weights[i], a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (int c = 0; c < channels; ++c)
+            {
+                ap[c] += a * tile[i * 4 + c];
+                bp[c] += b * tile[i * 4 + c];
+            }
+        }
+
+        float det = aa * bb - ab * ab;
+        if (std::abs(det) < 1e-6f)
+            return false;
+
+        for (int c = 0; c < channels; ++c)
+        {
+            e0[c] = std::clamp((bb * ap[c] - ab * bp[c]) / det, 0.0f, 255.0f);
+            e1[c] = std::clamp((aa * bp[c] - ab * ap[c]) / det, 0.0f, 255.0f);
+        }
+        return true;
+    }
+
+    // --- bc1 ---
+
+    uint16_t PackRgb565(const float *rgb)
+    {
+        int r = int(rgb[0] * 31.0f / 255.0f + 0.5f);
+        int g = int(rgb[1] * 63.0f / 255.0f + 0.5f);
+        int b = int(rgb[2] * 31.0f / 255.0f + 0.5f);
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    void UnpackRgb565(uint16_t c, int *rgb)
+    {
+        int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    // picks the nearest of the four palette entries per texel, returns the
+    // squared error and writes 2 bit indices in palette order (0, 1, 1/3, 2/3)
+    int Bc1Indices(const unsigned char *tile, uint16_t c0, uint16_t c1, uint32_t &outIndices)
+    {
+        int palette[4][3];
+        UnpackRgb565(c0, palette[0]);
+        UnpackRgb565(c1, palette[1]);
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        int total = 0;
+        outIndices = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0, bestError = INT32_MAX;
+            for (int p = 0; p < 4; ++p)
+            {
+                int error = 0;
+                for (int c = 0; c < 3; ++c)
+                {
+                    int d = tile[i * 4 + c] - palette[p][c];
+                    error += d * d;
+                }
+                if (error < bestError)
+                    bestError = error, best = p;
+            }
+            total += bestError;
+            outIndices |= uint32_t(best) << (2 * i);
+        }
+        return total;
+    }
+
+    void WriteBc1(uint16_t c0, uint16_t c1, uint32_t indices, unsigned char *block)
+    {
+        block[0] = c0 & 0xFF;
+        block[1] = c0 >> 8;
+        block[2] = c1 & 0xFF;
+        block[3] = c1 >> 8;
+        std::memcpy(block + 4, &indices, 4); // little endian, like the format
+    }
+
+    // --- bc4 ---
+
+    // 8 value mode between the channel min and max
+    void Bc4Block(const unsigned char *tile, int channel, unsigned char *block)
+    {
+        int lo = 255, hi = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            lo = std::min(lo, int(tile[i * 4 + channel]));
+            hi = std::max(hi, int(tile[i * 4 + channel]));
+        }
+
+        block[0] = static_cast<unsigned char>(hi);
+        block[1] = static_cast<unsigned char>(lo);
+
+        uint64_t bits = 0;
+        if (hi > lo)
+        {
+            // palette order is hi, lo, then six steps from hi towards lo
+            static constexpr int ORDER[8] = {1, 7, 6, 5, 4, 3, 2, 0};
+            const int range = hi - lo;
+            for (int i = 0; i < 16; ++i)
+            {
+                int step = ((tile[i * 4 + channel] - lo) * 14 + range) / (2 * range); // round to 0..7
+                bits |= uint64_t(ORDER[step]) << (3 * i);
+            }
+        }
+        for (int b = 0; b < 6; ++b)
+            block[2 + b] = static_cast<unsigned char>(bits >> (8 * b));
+    }
+
+    // --- bc7 ---
+
+    // index interpolation weights, out of 64
+    constexpr int BC7_WEIGHTS2[4] = {0, 21, 43, 64};
+    constexpr int BC7_WEIGHTS4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    class BitWriter
+    {
+    public:
+        explicit BitWriter(unsigned char *out) : m_Out(out) { std::memset(out, 0, 16); }
+
+        void Write(uint32_t value, int bits)
+        {
+            for (int b = 0; b < bits; ++b, ++m_Position)
+            {
+                if (value & (1u << b))
+                    m_Out[m_Position >> 3] |= static_cast<unsigned char>(1u << (m_Position & 7));
+            }
+        }
+
+    private:
+        unsigned char *m_Out;
+        int m_Position = 0;
+    };
+
+    // nearest interpolated entry per texel over channels [first, first + channels).
+    // the palette lies on a line, so projecting onto it finds the answer up
+    // to one neighbour. returns the squared error
+    int AssignIndices(
+        const unsigned char *tile,
+        int first,
+        int channels,
+        const int *c0,
+        const int *c1,
+        const int *weights,
+        int count,
+        uint8_t *indices)
+    {
+        int palette[16][4];
+        for (int p = 0; p < count; ++p)
+            for (int c = 0; c < channels; ++c)
+                palette[p][c] = (c0[c] * (64 - weights[p]) + c1[c] * weights[p] + 32) >> 6;
+
+        int dir[4], lengthSq = 0;
+        for (int c = 0; c < channels; ++c)
+        {
+            dir[c] = c1[c] - c0[c];
+            lengthSq += dir[c] * dir[c];
+        }
+
+        int total = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            const unsigned char *texel = tile + i * 4 + first;
+            int guess = 0;
+            if (lengthSq > 0)
+            {
+                int t = 0;
+                for (int c = 0; c < channels; ++c)
+                    t += (texel[c] - c0[c]) * dir[c];
+                guess = std::clamp(int(float(t) / lengthSq * (count - 1) + 0.5f), 0, count - 1);
+            }
+
+            int best = guess, bestError = INT32_MAX;
+            for (int p = std::max(guess - 1, 0); p <= std::min(guess + 1, count - 1); ++p)
+            {
+                int error = 0;
+                for (int c = 0; c < channels; ++c)
+                {
+                    int d = texel[c] - palette[p][c];
+                    error += d * d;
+                }
+                if (error < bestError)
+                    bestError = error, best = p;
+            }
+            indices[i] = static_cast<uint8_t>(best);
+            total += bestError;
+        }
+        return total;
+    }
+
+    // the anchor (first) index has an implicit zero msb, flip the endpoints if not
+    void FixAnchor(int *e0, int *e1, int channels, uint8_t *indices, int count)
+    {
+        if (indices[0] < count / 2)
+            return;
+        for (int c = 0; c < channels; ++c)
+            std::swap(e0[c], e1[c]);
+        for (int i = 0; i < 16; ++i)
+            indices[i] = static_cast<uint8_t>(count - 1 - indices[i]);
+    }
+
+    // mode 6: one subset, rgba 7 bit endpoints plus a p bit each, 4 bit indices
+    struct Mode6
+    {
+        int endpoints[2][4]; // 7 bit
+        int pbits[2];
+        uint8_t indices[16];
+        int error = INT32_MAX;
+    };
+
+    // tries every p bit pair for a float endpoint pair, keeps the best
+    void QuantizeMode6(const unsigned char *tile, const float *e0, const float *e1, Mode6 &best)
+    {
+        const float *ends[2] = {e0, e1};
+        for (int p = 0; p < 4; ++p)
+        {
+            Mode6 cand;
+            cand.pbits[0] = p & 1;
+            cand.pbits[1] = p >> 1;
+
+            int colors[2][4];
+            for (int e = 0; e < 2; ++e)
+            {
+                for (int c = 0; c < 4; ++c)
+                {
+                    cand.endpoints[e][c] = std::clamp(int((ends[e][c] - cand.pbits[e]) / 2.0f + 0.5f), 0, 127);
+                    colors[e][c] = (cand.endpoints[e][c] << 1) | cand.pbits[e];
+                }
+            }
+
+            cand.error = AssignIndices(tile, 0, 4, colors[0], colors[1], BC7_WEIGHTS4, 16, cand.indices);
+            if (cand.error < best.error)
+                best = cand;
+        }
+    }
+
+    int EncodeMode6(const unsigned char *tile, unsigned char *block)
+    {
+        float e0[4], e1[4];
+        AxisEndpoints(tile, 4, e0, e1);
+
+        Mode6 best;
+        QuantizeMode6(tile, e0, e1, best);
+
+        float weights[16];
+        for (int i = 0; i < 16; ++i)
+            weights[i] = BC7_WEIGHTS4[best.indices[i]] / 64.0f;
+        if (RefitEndpoints(tile, 4, weights, e0, e1))
+            QuantizeMode6(tile, e0, e1, best);
+
+        if (best.indices[0] >= 8)
+            std::swap(best.pbits[0], best.pbits[1]); // they move with their endpoints
+        FixAnchor(best.endpoints[0], best.endpoints[1], 4, best.indices, 16);
+
+        BitWriter writer(block);
+        writer.Write(1u << 6, 7);
+        for (int c = 0; c < 4; ++c)
+        {
+            writer.Write(best.endpoints[0][c], 7);
+            writer.Write(best.endpoints[1][c], 7);
+        }
+        writer.Write(best.pbits[0], 1);
+        writer.Write(best.pbits[1], 1);
+        writer.Write(best.indices[0], 3);
+        for (int i = 1; i < 16; ++i)
+            writer.Write(best.indices[i], 4);
+        return best.error;
+    }
+
+    // mode 5: rgb 7 bit and alpha 8 bit endpoints with separate 2 bit indices,
+    // for blocks where alpha doesn't follow the color
+    int EncodeMode5(const unsigned char *tile, unsigned char *block)
+    {
+        float e0[4], e1[4];
+        AxisEndpoints(tile, 3, e0, e1);
+
+        int color[2][3], colorExpanded[2][3];
+        uint8_t colorIndices[16];
+        auto quantize = [&]
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                color[0][c] = std::clamp(int(e0[c] * 127.0f / 255.0f + 0.5f), 0, 127);
+                color[1][c] = std::clamp(int(e1[c] * 127.0f / 255.0f + 0.5f), 0, 127);
+                colorExpanded[0][c] = (color[0][c] << 1) | (color[0][c] >> 6);
+                colorExpanded[1][c] = (color[1][c] << 1) | (color[1][c] >> 6);
+            }
+            return AssignIndices(tile, 0, 3, colorExpanded[0], colorExpanded[1], BC7_WEIGHTS2, 4, colorIndices);
+        };
+        int colorError = quantize();
+
+        float weights[16];
+        for (int i = 0; i < 16; ++i)
+            weights[i] = BC7_WEIGHTS2[colorIndices[i]] / 64.0f;
+        int saved[2][3];
+        uint8_t savedIndices[16];
+        std::memcpy(saved, color, sizeof(saved));
+        std::memcpy(savedIndices, colorIndices, sizeof(savedIndices));
+        if (RefitEndpoints(tile, 3, weights, e0, e1))
+        {
+            int refitError = quantize();
+            if (refitError > colorError)
+            {
+                std::memcpy(color, saved, sizeof(saved));
+                std::memcpy(colorIndices, savedIndices, sizeof(savedIndices));
+            }
+            else
+            {
+                colorError = refitError;
+            }
+        }
+
+        int alpha[2] = {255, 0};
+        for (int i = 0; i < 16; ++i)
+        {
+            alpha[0] = std::min(alpha[0], int(tile[i * 4 + 3]));
+            alpha[1] = std::max(alpha[1], int(tile[i * 4 + 3]));
+        }
+        uint8_t alphaIndices[16];
+        int alphaError = AssignIndices(tile, 3, 1, &alpha[0], &alpha[1], BC7_WEIGHTS2, 4, alphaIndices);
+
+        FixAnchor(color[0], color[1], 3, colorIndices, 4);
+        FixAnchor(&alpha[0], &alpha[1], 1, alphaIndices, 4);
+
+        BitWriter writer(block);
+        writer.Write(1u << 5, 6);
+        writer.Write(0, 2); // no channel rotation
+        for (int c = 0; c < 3; ++c)
+        {
+            writer.Write(color[0][c], 7);
+            writer.Write(color[1][c], 7);
+        }
+        writer.Write(alpha[0], 8);
+        writer.Write(alpha[1], 8);
+        writer.Write(colorIndices[0], 1);
+        for (int i = 1; i < 16; ++i)
+            writer.Write(colorIndices[i], 2);
+        writer.Write(alphaIndices[0], 1);
+        for (int i = 1; i < 16; ++i)
+            writer.Write(alphaIndices[i], 2);
+        return colorError + alphaError;
+    }
+
+    // 4x4 tile at block (bx, by), edge texels repeated
+    void LoadTile(const unsigned char *pixels, int width, int height, int bx, int by, unsigned char *tile)
+    {
+        for (int y = 0; y < 4; ++y)
+        {
+            int sy = std::min(by * 4 + y, height - 1);
+            for (int x = 0; x < 4; ++x)
+            {
+                int sx = std::min(bx * 4 + x, width - 1);
+                std::memcpy(tile + (y * 4 + x) * 4, pixels + (size_t(sy) * width + sx) * 4, 4);
+            }
+        }
+    }
+}
+
+namespace BlockCompression
+{
+    bool IsCompressed(TextureFormat format)
+    {
+        return format != TextureFormat::RGBA8;
+    }
+
+    size_t BlockBytes(TextureFormat format)
+    {
+        switch (format)
+        {
+        case TextureFormat::BC1:
+        case TextureFormat::BC4:
+            return 8;
+        case TextureFormat::BC5:
+        case TextureFormat::BC7:
+            return 16;
+        default:
+            return 0;
+        }
+    }
+
+    size_t RowPitch(TextureFormat format, int width)
+    {
+        if (!IsCompressed(format))
+            return size_t(width) * 4;
+        return size_t((width + 3) / 4) * BlockBytes(format);
+    }
+
+    size_t LevelBytes(TextureFormat format, int width, int height)
+    {
+        size_t rows = IsCompressed(format) ? size_t((height + 3) / 4) : size_t(height);
+        return RowPitch(format, width) * rows;
+    }
+
+    void EncodeBC1(const unsigned char *tile, unsigned char *block)
+    {
+        float e0[4], e1[4];
+        AxisEndpoints(tile, 3, e0, e1);
+
+        uint16_t c0 = PackRgb565(e0), c1 = PackRgb565(e1);
+        uint32_t indices = 0;
+        int error = Bc1Indices(tile, c0, c1, indices);
+
+        // one refit against the chosen palette positions
+        static constexpr float WEIGHTS[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+        float weights[16];
+        for (int i = 0; i < 16; ++i)
+            weights[i] = WEIGHTS[(indices >> (2 * i)) & 3];
+        if (RefitEndpoints(tile, 3, weights, e0, e1))
+        {
+            uint16_t r0 = PackRgb565(e0), r1 = PackRgb565(e1);
+            uint32_t refitIndices = 0;
+            int refitError = Bc1Indices(tile, r0, r1, refitIndices);
+            if (refitError < error)
+                c0 = r0, c1 = r1, indices = refitIndices;
+        }
+
+        // c0 > c1 selects the 4 color mode; swapping endpoints swaps 0/1 and 2/3
+        if (c0 < c1)
+        {
+            std::swap(c0, c1);
+            indices ^= 0x55555555u;
+        }
+        else if (c0 == c1)
+        {
+            indices = 0;
+        }
+        WriteBc1(c0, c1, indices, block);
+    }
+
+    void EncodeBC4(const unsigned char *tile, int channel, unsigned char *block)
+    {
+        Bc4Block(tile, channel, block);
+    }
+
+    void EncodeBC5(const unsigned char *tile, unsigned char *block)
+    {
+        Bc4Block(tile, 0, block);
+        Bc4Block(tile, 1, block + 8);
+    }
+
+    void EncodeBC7(const unsigned char *tile, unsigned char *block)
+    {
+        int error = EncodeMode6(tile, block);
+
+        bool alphaVaries = false;
+        for (int i = 1; i < 16 && !alphaVaries; ++i)
+            alphaVaries = tile[i * 4 + 3] != tile[3];
+
+        if (alphaVaries && error > 0)
+        {
+            unsigned char candidate[16];
+            if (EncodeMode5(tile, candidate) < error)
+                std::memcpy(block, candidate, 16);
+        }
+    }
+
+    void EncodeImage(
+        const unsigned char *pixels,
+        int width,
+        int height,
+        TextureFormat format,
+        std::vector<unsigned char> &out,
+        ThreadPool *pool)
+    {
+        const size_t offset = out.size();
+        out.resize(offset + LevelBytes(format, width, height));
+
+        if (!IsCompressed(format))
+        {
+            std::memcpy(out.data() + offset, pixels, size_t(width) * height * 4);
+            return;
+        }
+
+        const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+        const size_t blockBytes = BlockBytes(format);
+        unsigned char *dst = out.data() + offset;
+
+        auto run = [&](size_t begin, size_t end)
+        {
+            unsigned char tile[64];
+            for (size_t by = begin; by < end; ++by)
+            {
+                for (int bx = 0; bx < blocksX; ++bx)
+                {
+                    LoadTile(pixels, width, height, bx, int(by), tile);
+                    unsigned char *block = dst + (by * blocksX + bx) * blockBytes;
+                    switch (format)
+                    {
+                    case TextureFormat::BC1:
+                        EncodeBC1(tile, block);
+                        break;
+                    case TextureFormat::BC4:
+                        EncodeBC4(tile, 0, block);
+                        break;
+                    case TextureFormat::BC5:
+                        EncodeBC5(tile, block);
+                        break;
+                    case TextureFormat::BC7:
+                        EncodeBC7(tile, block);
+                        break;
+                    default:
+                        break;
+                    }
+                }
+            }
+        };
+
+        if (pool)
+            pool->ParallelFor(size_t(blocksY), ROWS_PER_TASK, run);
+        else
+            run(0, size_t(blocksY));
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+class ThreadPool;
+
+// cpu side texel formats a decoded texture can end up in
+enum class TextureFormat
+{
+    RGBA8,
+    BC1, // rgb, 4 bits per texel
+    BC4, // r, 4 bits per texel
+    BC5, // rg, 8 bits per texel
+    BC7, // rgba, 8 bits per texel
+};
+
+// bc block encoders for 4x4 rgba8 tiles. quality targets import time rather
+// than offline cooking: endpoints come from the principal axis of the block
+// followed by one least squares refit. bc7 only uses mode 6 (one subset,
+// rgba endpoints, 4 bit indices)
+namespace BlockCompression
+{
+    bool IsCompressed(TextureFormat format);
+
+    // 8 for bc1/bc4, 16 for bc5/bc7, 0 for rgba8
+    size_t BlockBytes(TextureFormat format);
+
+    // bytes per row of texels (rgba8) or of blocks
+    size_t RowPitch(TextureFormat format, int width);
+    size_t LevelBytes(TextureFormat format, int width, int height);
+
+    // tile is 16 rgba8 texels, row major
+    void EncodeBC1(const unsigned char *tile, unsigned char *block);
+    void EncodeBC4(const unsigned char *tile, int channel, unsigned char *block);
+    void EncodeBC5(const unsigned char *tile, unsigned char *block);
+    void EncodeBC7(const unsigned char *tile, unsigned char *block);
+
+    // appends one encoded rgba8 image to out. partial edge blocks repeat the
+    // last row/column. rows of blocks are split across the pool
+    void EncodeImage(
+        const unsigned char *pixels,
+        int width,
+        int height,
+        TextureFormat format,
+        std::vector<unsigned char> &out,
+        ThreadPool *pool = nullptr);
+}
@@ -0,0 +1,245 @@
+#include "CookedMesh.h"
+#include "assets/MeshCodec.h"
+#include "utils/Logger.h"
+#include "cfg/Config.h"
+#include <fstream>
+#include <system_error>
+
+namespace
+{
+    inline constexpr uint64_t DATA_ALIGNMENT = 16;
+
+    uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    bool IsRangeValid(uint64_t offset, uint64_t bytes, size_t fileSize)
+    {
+        return offset <= fileSize && bytes <= fileSize - offset;
+    }
+
+    // submeshes cooked without lods still get a single full level
+    CookedMesh::LodLevel FullLevel(const CookedMesh::SubmeshData &sm)
+    {
+        return {0, static_cast<uint32_t>(sm.indices.size()), 0.0f, 0};
+    }
+
+    // MeshCodec output of a submesh, each stream left empty when it is
+    // stored as is
+    struct EncodedStreams
+    {
+        std::vector<unsigned char> vertices;
+        std::vector<unsigned char> indices;
+    };
+
+    EncodedStreams Encode(const CookedMesh::SubmeshData &sm, ThreadPool *pool)
+    {
+        EncodedStreams streams;
+        if (!MeshCodec::EncodeVertices(sm.vertices.data(), sm.vertices.size(), sizeof(Vertex), streams.vertices, pool) ||
+            streams.vertices.size() >= sizeof(Vertex) * sm.vertices.size())
+            streams.vertices.clear();
+        if (!MeshCodec::EncodeIndices(sm.indices.data(), sm.indices.size(), streams.indices, pool) ||
+            streams.indices.size() >= sizeof(uint32_t) * sm.indices.size())
+            streams.indices.clear();
+        return streams;
+    }
+}
+
+namespace CookedMesh
+{
+    bool Write(const std::filesystem::path &path, const std::vector<SubmeshData> &submeshes, ThreadPool *pool)
+    {
+        std::vector<EncodedStreams> encoded(submeshes.size());
+        if (Config::AssetCooking::ENCODE_MESHES)
+        {
+            for (size_t i = 0; i < submeshes.size(); ++i)
+                encoded[i] = Encode(submeshes[i], pool);
+        }
+
+        FileHeader header{};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.vertexStride = sizeof(Vertex);
+        header.submeshCount = static_cast<uint32_t>(submeshes.size());
+
+        // lay out the data blocks after the table
+        std::vector<SubmeshEntry> table(submeshes.size());
+        uint64_t cursor = sizeof(FileHeader) + sizeof(SubmeshEntry) * table.size();
+        for (size_t i = 0; i < submeshes.size(); ++i)
+        {
+            const auto &sm = submeshes[i];
+            auto &entry = table[i];
+
+            cursor = AlignUp(cursor, DATA_ALIGNMENT);
+            entry.vertexOffset = cursor;
+            entry.vertexCount = static_cast<uint32_t>(sm.vertices.size());
+            entry.vertexBytes = encoded[i].vertices.empty() ? sizeof(Vertex) * sm.vertices.size() : encoded[i].vertices.size();
+            cursor += entry.vertexBytes;
+
+            cursor = AlignUp(cursor, DATA_ALIGNMENT);
+            entry.indexOffset = cursor;
+            entry.indexCount = static_cast<uint32_t>(sm.indices.size());
+            entry.indexBytes = encoded[i].indices.empty() ? sizeof(uint32_t) * sm.indices.size() : encoded[i].indices.size();
+            cursor += entry.indexBytes;
+
+            cursor = AlignUp(cursor, DATA_ALIGNMENT);
+            entry.lodOffset = cursor;
+            entry.lodCount = sm.lods.empty() ? 1u : static_cast<uint32_t>(sm.lods.size());
+            cursor += sizeof(LodLevel) * entry.lodCount;
+            entry.uvDensity = sm.uvDensity;
+        }
+
+        // write to a temp file first so a failed cook never leaves a truncated .gmesh behind
+        std::filesystem::path tempPath = path;
+        tempPath += ".tmp";
+
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out)
+            {
+                LOG_ERROR("CookedMesh: failed to open {} for writing", tempPath.string());
+                return false;
+            }
+
+            static const char padding[DATA_ALIGNMENT] = {};
+            auto pad = [&](uint64_t target)
+            {
+                uint64_t pos = static_cast<uint64_t>(out.tellp());
+                if (target > pos)
+                    out.write(padding, static_cast<std::streamsize>(target - pos));
+            };
+
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char *>(table.data()),
+                      static_cast<std::streamsize>(sizeof(SubmeshEntry) * table.size()));
+
+            auto writeStream = [&](const void *raw, const std::vector<unsigned char> &stream, uint64_t bytes)
+            {
+                out.write(static_cast<const char *>(stream.empty() ? raw : stream.data()), static_cast<std::streamsize>(bytes));
+            };
+
+            for (size_t i = 0; i < submeshes.size(); ++i)
+            {
+                pad(table[i].vertexOffset);
+                writeStream(submeshes[i].vertices.data(), encoded[i].vertices, table[i].vertexBytes);
+                pad(table[i].indexOffset);
+                writeStream(submeshes[i].indices.data(), encoded[i].indices, table[i].indexBytes);
+                pad(table[i].lodOffset);
+                if (submeshes[i].lods.empty())
+                {
+                    LodLevel full = FullLevel(submeshes[i]);
+                    out.write(reinterpret_cast<const char *>(&full), sizeof(full));
+                }
+                else
+                {
+                    out.write(reinterpret_cast<const char *>(submeshes[i].lods.data()),
+                              static_cast<std::streamsize>(sizeof(LodLevel) * submeshes[i].lods.size()));
+                }
+            }
+
+            if (!out)
+            {
+                LOG_ERROR("CookedMesh: write failed for {}", tempPath.string());
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tempPath, path, ec);
+        if (ec)
+        {
+            LOG_ERROR("CookedMesh: failed to move {} into place", path.string());
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool Read(const unsigned char *data, size_t size, std::vector<SubmeshView> &outSubmeshes,
+              std::vector<SubmeshData> &outDecoded, ThreadPool *pool)
+    {
+        const unsigned char *base = data;
+
+        if (!base || size < sizeof(FileHeader))
+            return false;
+
+        const auto *header = reinterpret_cast<const FileHeader *>(base);
+        if (header->magic != MAGIC || header->version != VERSION)
+            return false;
+
+        // a different stride means the Vertex struct changed since cooking
+        if (header->vertexStride != sizeof(Vertex))
+            return false;
+
+        const uint64_t tableBytes = sizeof(SubmeshEntry) * uint64_t(header->submeshCount);
+        if (!IsRangeValid(sizeof(FileHeader), tableBytes, size))
+            return false;
+
+        const auto *table = reinterpret_cast<const SubmeshEntry *>(base + sizeof(FileHeader));
+
+        outSubmeshes.clear();
+        outSubmeshes.reserve(header->submeshCount);
+        outDecoded.clear();
+        outDecoded.resize(header->submeshCount);
+        for (uint32_t i = 0; i < header->submeshCount; ++i)
+        {
+            const auto &entry = table[i];
+            const uint64_t lodBytes = sizeof(LodLevel) * uint64_t(entry.lodCount);
+
+            if (entry.vertexOffset % DATA_ALIGNMENT || entry.indexOffset % DATA_ALIGNMENT ||
+                entry.lodOffset % DATA_ALIGNMENT || entry.lodCount == 0 ||
+                !IsRangeValid(entry.vertexOffset, entry.vertexBytes, size) ||
+                !IsRangeValid(entry.indexOffset, entry.indexBytes, size) ||
+                !IsRangeValid(entry.lodOffset, lodBytes, size))
+                return false;
+
+            const auto *lods = reinterpret_cast<const LodLevel *>(base + entry.lodOffset);
+            for (uint32_t l = 0; l < entry.lodCount; ++l)
+            {
+                if (lods[l].indexOffset > entry.indexCount ||
+                    lods[l].indexCount > entry.indexCount - lods[l].indexOffset)
+                    return false;
+            }
+
+            SubmeshView view;
+            view.vertexCount = entry.vertexCount;
+            view.indexCount = entry.indexCount;
+
+            auto &decoded = outDecoded[i];
+            if (entry.vertexBytes == sizeof(Vertex) * uint64_t(entry.vertexCount))
+            {
+                view.vertices = reinterpret_cast<const Vertex *>(base + entry.vertexOffset);
+            }
+            else
+            {
+                decoded.vertices.resize(entry.vertexCount);
+                if (!MeshCodec::DecodeVertices(base + entry.vertexOffset, entry.vertexBytes, decoded.vertices.data(),
+                                               entry.vertexCount, sizeof(Vertex), pool))
+                    return false;
+                view.vertices = decoded.vertices.data();
+            }
+
+            if (entry.indexBytes == sizeof(uint32_t) * uint64_t(entry.indexCount))
+            {
+                view.indices = reinterpret_cast<const uint32_t *>(base + entry.indexOffset);
+            }
+            else
+            {
+                decoded.indices.resize(entry.indexCount);
+                if (!MeshCodec::DecodeIndices(base + entry.indexOffset, entry.indexBytes, decoded.indices.data(),
+                                              entry.indexCount, entry.vertexCount, pool))
+                    return false;
+                view.indices = decoded.indices.data();
+            }
+
+            view.lods = lods;
+            view.lodCount = entry.lodCount;
+            view.uvDensity = entry.uvDensity;
+            outSubmeshes.push_back(view);
+        }
+
+        return true;
+    }
+}
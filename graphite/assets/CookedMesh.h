@@ -0,0 +1,98 @@
+#pragma once
+
+#include "core/CommonTypes.h"
+#include "rendering/Vertex.h"
+#include "utils/DefaultInitAllocator.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+class ThreadPool;
+
+// .gmesh: pre-imported geometry
+//
+//   FileHeader
+//   SubmeshEntry[submeshCount]
+//   per submesh: vertex stream, index stream, LodLevel[lodCount]
+//   (each 16-byte aligned)
+//
+// all lod levels of a submesh share its vertices, their index ranges are
+// stored back to back with level 0 first
+//
+// a stream is either laid out exactly as it is uploaded (Vertex[vertexCount],
+// uint32_t[indexCount]) or, when its stored size differs from that, MeshCodec
+// encoded. offsets are absolute from the start of the file, so raw streams of
+// a mapped file go to the gpu without any parsing or copying
+namespace CookedMesh
+{
+    inline constexpr uint32_t MAGIC = 0x48534D47; // "GMSH"
+    inline constexpr uint32_t VERSION = 4;
+    inline constexpr const char *EXTENSION = ".gmesh";
+
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vertexStride; // sizeof(Vertex) at cook time
+        uint32_t submeshCount;
+    };
+    static_assert(sizeof(FileHeader) == 16, "FileHeader layout is part of the file format.");
+
+    struct SubmeshEntry
+    {
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+        uint64_t lodOffset;
+        uint64_t vertexBytes; // stored sizes, see above
+        uint64_t indexBytes;
+        uint32_t vertexCount;
+        uint32_t indexCount; // all levels
+        uint32_t lodCount;
+        float uvDensity; // see SubmeshData
+    };
+    static_assert(sizeof(SubmeshEntry) == 56, "SubmeshEntry layout is part of the file format.");
+
+    // range of a submesh's index buffer drawn for one level of detail
+    struct LodLevel
+    {
+        uint32_t indexOffset;
+        uint32_t indexCount;
+        float error; // object space distance from the full resolution surface
+        uint32_t reserved;
+    };
+    static_assert(sizeof(LodLevel) == 16, "LodLevel layout is part of the file format.");
+
+    // cpu side geometry for a single submesh, used when cooking. the arrays
+    // skip zeroing on resize, importers fill them in parallel
+    struct SubmeshData
+    {
+        UninitVector<Vertex> vertices;
+        UninitVector<uint32_t> indices;
+        std::vector<LodLevel> lods; // empty means one level covering all indices
+        float uvDensity = 0.0f;     // uv units per object space unit, drives texture streaming
+    };
+
+    // non-owning view into a mapped .gmesh
+    struct SubmeshView
+    {
+        const Vertex *vertices = nullptr;
+        uint32_t vertexCount = 0;
+        const uint32_t *indices = nullptr;
+        uint32_t indexCount = 0;
+        const LodLevel *lods = nullptr;
+        uint32_t lodCount = 0;
+        float uvDensity = 0.0f;
+    };
+
+    // streams are encoded when Config::AssetCooking::ENCODE_MESHES is set
+    // and that makes them smaller. pool spreads the encoding over its workers
+    bool Write(const std::filesystem::path &path, const std::vector<SubmeshData> &submeshes, ThreadPool *pool = nullptr);
+
+    // validates the header and submesh table, then points views into data,
+    // a mapping of the file or a copy of it read from a pack (16 byte aligned).
+    // encoded streams are decoded into outDecoded, one entry per submesh, and
+    // their views point there instead
+    bool Read(const unsigned char *data, size_t size, std::vector<SubmeshView> &outSubmeshes,
+              std::vector<SubmeshData> &outDecoded, ThreadPool *pool = nullptr);
+}
@@ -0,0 +1,220 @@
+#include "CookedTexture.h"
+#include "assets/AssetFiles.h"
+#include "assets/MipGenerator.h"
+#include "platform/MappedFile.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+namespace
+{
+    // level data starts on a cache line so a mapped level goes to the driver as is
+    inline constexpr uint64_t LEVEL_ALIGNMENT = 64;
+
+    uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    uint64_t LevelBytes(TextureFormat format, int width, int height, int level)
+    {
+        return BlockCompression::LevelBytes(
+            format,
+            MipGenerator::LevelSize(width, level),
+            MipGenerator::LevelSize(height, level));
+    }
+
+    // no texture has more levels than this, the header and table are read in one go
+    constexpr uint64_t MAX_TABLE_LEVELS = 32;
+
+    // validates the header and level table in head, the first bytes of a
+    // file of fileSize bytes
+    bool ParseHeader(const unsigned char *head, size_t headSize, uint64_t fileSize,
+                     CookedTexture::TextureData &outInfo, std::vector<CookedTexture::LevelEntry> &outTable)
+    {
+        using namespace CookedTexture;
+        if (headSize < sizeof(FileHeader))
+            return false;
+
+        FileHeader header{};
+        std::memcpy(&header, head, sizeof(header));
+        if (header.magic != MAGIC || header.version != VERSION)
+            return false;
+
+        const auto format = static_cast<TextureFormat>(header.format);
+        const int width = static_cast<int>(header.width), height = static_cast<int>(header.height);
+        const int mipLevels = static_cast<int>(header.mipLevels);
+        if (header.format > static_cast<uint32_t>(TextureFormat::BC7) || width <= 0 || height <= 0 ||
+            mipLevels <= 0 || mipLevels > MipGenerator::CountLevels(width, height) ||
+            sizeof(FileHeader) + sizeof(LevelEntry) * uint64_t(mipLevels) > headSize)
+            return false;
+
+        // levels must be in order, aligned, and exactly the size their dimensions imply
+        outTable.resize(mipLevels);
+        std::memcpy(outTable.data(), head + sizeof(FileHeader), sizeof(LevelEntry) * outTable.size());
+
+        uint64_t cursor = sizeof(FileHeader) + sizeof(LevelEntry) * outTable.size();
+        for (int l = 0; l < mipLevels; ++l)
+        {
+            cursor = AlignUp(cursor, LEVEL_ALIGNMENT);
+            if (outTable[l].offset != cursor || outTable[l].size != LevelBytes(format, width, height, l))
+                return false;
+            cursor += outTable[l].size;
+        }
+        if (cursor > fileSize)
+            return false;
+
+        outInfo = {};
+        outInfo.format = format;
+        outInfo.width = width;
+        outInfo.height = height;
+        outInfo.mipLevels = mipLevels;
+        return true;
+    }
+
+    bool ReadHeader(const std::filesystem::path &path, CookedTexture::TextureData &outInfo, std::vector<CookedTexture::LevelEntry> &outTable)
+    {
+        using namespace CookedTexture;
+        uint64_t fileSize = 0;
+        if (!AssetFiles::GetSize(path, fileSize) || fileSize < sizeof(FileHeader))
+            return false;
+
+        std::vector<unsigned char> head(static_cast<size_t>(
+            std::min<uint64_t>(fileSize, sizeof(FileHeader) + sizeof(LevelEntry) * MAX_TABLE_LEVELS)));
+        if (!AssetFiles::ReadRange(path, 0, head.size(), head.data()))
+            return false;
+
+        return ParseHeader(head.data(), head.size(), fileSize, outInfo, outTable);
+    }
+}
+
+namespace CookedTexture
+{
+    bool Write(
+        const std::filesystem::path &path,
+        TextureFormat format,
+        int width,
+        int height,
+        int mipLevels,
+        const unsigned char *const *levels)
+    {
+        FileHeader header{};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.format = static_cast<uint32_t>(format);
+        header.width = static_cast<uint32_t>(width);
+        header.height = static_cast<uint32_t>(height);
+        header.mipLevels = static_cast<uint32_t>(mipLevels);
+
+        std::vector<LevelEntry> table(mipLevels);
+        uint64_t cursor = sizeof(FileHeader) + sizeof(LevelEntry) * table.size();
+        for (int l = 0; l < mipLevels; ++l)
+        {
+            cursor = AlignUp(cursor, LEVEL_ALIGNMENT);
+            table[l].offset = cursor;
+            table[l].size = LevelBytes(format, width, height, l);
+            cursor += table[l].size;
+        }
+
+        // write to a temp file first so a failed cook never leaves a truncated .gtex behind
+        std::filesystem::path tempPath = path;
+        tempPath += ".tmp";
+
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out)
+            {
+                LOG_ERROR("CookedTexture: failed to open {} for writing", tempPath.string());
+                return false;
+            }
+
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char *>(table.data()),
+                      static_cast<std::streamsize>(sizeof(LevelEntry) * table.size()));
+            uint64_t written = sizeof(FileHeader) + sizeof(LevelEntry) * table.size();
+            for (int l = 0; l < mipLevels; ++l)
+            {
+                static const char padding[LEVEL_ALIGNMENT] = {};
+                out.write(padding, static_cast<std::streamsize>(table[l].offset - written));
+                out.write(reinterpret_cast<const char *>(levels[l]), static_cast<std::streamsize>(table[l].size));
+                written = table[l].offset + table[l].size;
+            }
+
+            if (!out)
+            {
+                LOG_ERROR("CookedTexture: write failed for {}", tempPath.string());
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tempPath, path, ec);
+        if (ec)
+        {
+            LOG_ERROR("CookedTexture: failed to move {} into place", path.string());
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool Read(const std::filesystem::path &path, TextureData &outTexture, int firstLevel, int levelCount)
+    {
+        std::vector<LevelEntry> table;
+        TextureData info;
+        if (!ReadHeader(path, info, table))
+            return false;
+
+        if (levelCount < 0)
+            levelCount = info.mipLevels - firstLevel;
+        if (firstLevel < 0 || levelCount <= 0 || firstLevel + levelCount > info.mipLevels)
+            return false;
+
+        // one ranged read over the requested levels, then the alignment
+        // padding between them is squeezed out
+        const uint64_t begin = table[firstLevel].offset;
+        const uint64_t end = table[firstLevel + levelCount - 1].offset + table[firstLevel + levelCount - 1].size;
+        info.levels.resize(static_cast<size_t>(end - begin));
+        if (!AssetFiles::ReadRange(path, begin, info.levels.size(), info.levels.data()))
+            return false;
+
+        uint64_t packed = 0;
+        for (int l = firstLevel; l < firstLevel + levelCount; ++l)
+        {
+            std::memmove(info.levels.data() + packed, info.levels.data() + (table[l].offset - begin), table[l].size);
+            packed += table[l].size;
+        }
+        info.levels.resize(static_cast<size_t>(packed));
+
+        info.firstLevel = firstLevel;
+        outTexture = std::move(info);
+        return true;
+    }
+
+    bool Map(const std::filesystem::path &path, MappedFile &outFile, TextureData &outInfo, std::vector<const unsigned char *> &outLevels)
+    {
+        if (AssetFiles::IsPacked(path) || !outFile.Open(path))
+            return false;
+
+        std::vector<LevelEntry> table;
+        if (!ParseHeader(outFile.GetData(), outFile.GetSize(), outFile.GetSize(), outInfo, table))
+        {
+            outFile.Close();
+            return false;
+        }
+
+        outLevels.resize(table.size());
+        for (size_t l = 0; l < table.size(); ++l)
+            outLevels[l] = outFile.GetData() + table[l].offset;
+        return true;
+    }
+
+    bool ReadInfo(const std::filesystem::path &path, TextureData &outInfo)
+    {
+        std::vector<LevelEntry> table;
+        return ReadHeader(path, outInfo, table);
+    }
+}
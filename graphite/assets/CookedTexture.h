@@ -0,0 +1,75 @@
+#pragma once
+
+#include "assets/BlockCompression.h"
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+class MappedFile;
+
+// .gtex: a texture after mip generation and block compression
+//
+//   FileHeader
+//   LevelEntry[mipLevels]
+//   level data, finest first
+//
+// offsets are absolute from the start of the file. each level starts on a
+// 64 byte boundary with its rows tightly packed, the layout the device takes
+// as initial data, so a mapped file uploads without a copy
+namespace CookedTexture
+{
+    inline constexpr uint32_t MAGIC = 0x58455447; // "GTEX"
+    inline constexpr uint32_t VERSION = 2;
+    inline constexpr const char *EXTENSION = ".gtex";
+
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t format; // TextureFormat
+        uint32_t width;
+        uint32_t height;
+        uint32_t mipLevels;
+        uint32_t reserved[2];
+    };
+    static_assert(sizeof(FileHeader) == 32, "FileHeader layout is part of the file format.");
+
+    struct LevelEntry
+    {
+        uint64_t offset;
+        uint64_t size;
+    };
+    static_assert(sizeof(LevelEntry) == 16, "LevelEntry layout is part of the file format.");
+
+    struct TextureData
+    {
+        TextureFormat format = TextureFormat::RGBA8;
+        int width = 0;
+        int height = 0;
+        int mipLevels = 0;
+        int firstLevel = 0;                // finer levels were left on disk
+        std::vector<unsigned char> levels; // levels firstLevel.. back to back
+    };
+
+    // levels[i] points at the data of mip i, sized by BlockCompression::LevelBytes
+    bool Write(
+        const std::filesystem::path &path,
+        TextureFormat format,
+        int width,
+        int height,
+        int mipLevels,
+        const unsigned char *const *levels);
+
+    // validates the header and level table before reading the data, through
+    // AssetFiles so the file may sit in a mounted pack. levelCount < 0 reads through the last level. texture streaming starts
+    // from a coarse level and reads finer ones one at a time
+    bool Read(const std::filesystem::path &path, TextureData &outTexture, int firstLevel = 0, int levelCount = -1);
+
+    // maps a loose .gtex instead of reading it. outInfo.levels stays empty,
+    // outLevels gets every mip as a pointer into outFile. fails for files in a
+    // pack, those are compressed and go through Read
+    bool Map(const std::filesystem::path &path, MappedFile &outFile, TextureData &outInfo, std::vector<const unsigned char *> &outLevels);
+
+    // header only, levels stays empty
+    bool ReadInfo(const std::filesystem::path &path, TextureData &outInfo);
+}
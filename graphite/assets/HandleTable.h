@@ -0,0 +1,81 @@
+#pragma once
+
+#include "assets/AssetHandle.h"
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// dense slot array addressed by generational handles. lookups are an index
+// and a generation compare, no hashing or string work. removed slots are
+// reset, their generation bumped and the index reused by later inserts
+template <typename T, typename Handle>
+class HandleTable
+{
+public:
+    Handle Insert(T value)
+    {
+        uint32_t index;
+        if (!m_FreeList.empty())
+        {
+            index = m_FreeList.back();
+            m_FreeList.pop_back();
+            m_Slots[index] = std::move(value);
+        }
+        else
+        {
+            if (m_Slots.size() >= Handle::MAX_SLOTS)
+                throw std::length_error("HandleTable is full");
+            index = static_cast<uint32_t>(m_Slots.size());
+            m_Slots.push_back(std::move(value));
+            m_Generations.push_back(0);
+        }
+        ++m_Count;
+        return Handle::Make(index, m_Generations[index]);
+    }
+
+    // null for invalid, stale or removed handles
+    T *Get(Handle handle)
+    {
+        const uint32_t index = handle.Index();
+        if (index >= m_Slots.size() || m_Generations[index] != handle.Generation())
+            return nullptr;
+        return &m_Slots[index];
+    }
+
+    const T *Get(Handle handle) const
+    {
+        return const_cast<HandleTable *>(this)->Get(handle);
+    }
+
+    bool Contains(Handle handle) const { return Get(handle) != nullptr; }
+
+    bool Remove(Handle handle)
+    {
+        if (!Contains(handle))
+            return false;
+
+        const uint32_t index = handle.Index();
+        m_Slots[index] = T{};
+        m_Generations[index] = (m_Generations[index] + 1) & Handle::GENERATION_MASK;
+        m_FreeList.push_back(index);
+        --m_Count;
+        return true;
+    }
+
+    size_t Size() const { return m_Count; }
+
+    void Clear()
+    {
+        m_Slots.clear();
+        m_Generations.clear();
+        m_FreeList.clear();
+        m_Count = 0;
+    }
+
+private:
+    std::vector<T> m_Slots;
+    std::vector<uint32_t> m_Generations;
+    std::vector<uint32_t> m_FreeList;
+    size_t m_Count = 0;
+};
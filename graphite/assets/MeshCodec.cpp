@@ -0,0 +1,753 @@
+#include "MeshCodec.h"
+#include "core/ThreadPool.h"
+#include "utils/DefaultInitAllocator.h"
+#include "utils/Lz.h"
+#include "utils/Simd.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+    using MeshCodec::ChunkEntry;
+    using MeshCodec::MAX_VERTEX_STRIDE;
+    using MeshCodec::StreamHeader;
+
+    constexpr size_t VERTEX_BLOCK = 256;
+    constexpr size_t GROUP = 16;
+    constexpr size_t VERTEX_CHUNK = 64 * VERTEX_BLOCK;
+    constexpr size_t INDEX_CHUNK = 3 * 16384;
+
+    // bytes of packed data behind a group, by its 2 bit header code (0, 2, 4, 8 bits a byte)
+    constexpr size_t GROUP_BYTES[4] = {0, 4, 8, 16};
+
+    // index codes: the high nibble picks a recent edge, NO_EDGE means all
+    // three vertices follow. a vertex nibble is 0 for the next unused index,
+    // 1..14 for a recent vertex or EXPLICIT for a varint delta
+    constexpr size_t FIFO_SIZE = 16;
+    constexpr uint8_t NO_EDGE = 15;
+    constexpr uint8_t EXPLICIT = 15;
+
+    uint8_t ZigZag8(uint8_t v)
+    {
+        return static_cast<uint8_t>((v << 1) ^ static_cast<uint8_t>(static_cast<int8_t>(v) >> 7));
+    }
+
+    uint8_t UnZigZag8(uint8_t v)
+    {
+        return static_cast<uint8_t>((v >> 1) ^ (0u - (v & 1u)));
+    }
+
+    uint32_t ZigZag32(uint32_t v)
+    {
+        return (v << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(v) >> 31);
+    }
+
+    uint32_t UnZigZag32(uint32_t v)
+    {
+        return (v >> 1) ^ (0u - (v & 1u));
+    }
+
+    uint32_t Read32(const uint8_t *p)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    void Append32(std::vector<uint8_t> &out, uint32_t v)
+    {
+        const size_t at = out.size();
+        out.resize(at + sizeof(v));
+        std::memcpy(out.data() + at, &v, sizeof(v));
+    }
+
+    void AppendVarint(std::vector<uint8_t> &out, uint32_t v)
+    {
+        for (; v >= 0x80; v >>= 7)
+            out.push_back(static_cast<uint8_t>(v | 0x80));
+        out.push_back(static_cast<uint8_t>(v));
+    }
+
+    bool ReadVarint(const uint8_t *&p, const uint8_t *end, uint32_t &v)
+    {
+        v = 0;
+        for (unsigned shift = 0; shift < 35; shift += 7)
+        {
+            if (p == end)
+                return false;
+            const uint8_t b = *p++;
+            v |= uint32_t(b & 0x7F) << shift;
+            if (b < 0x80)
+                return true;
+        }
+        return false;
+    }
+
+    // chunks are encoded into buffers of their own, in parallel, then laid
+    // out behind the table. encode(first, count, out) appends one chunk
+    template <typename EncodeChunk>
+    void WriteStream(uint32_t magic, size_t count, size_t stride, size_t chunkItems, std::vector<unsigned char> &out,
+                     ThreadPool *pool, EncodeChunk &&encode)
+    {
+        const size_t chunkCount = (count + chunkItems - 1) / chunkItems;
+        std::vector<std::vector<uint8_t>> chunks(chunkCount);
+        std::vector<uint32_t> encodedSizes(chunkCount);
+
+        auto run = [&](size_t begin, size_t end)
+        {
+            std::vector<uint8_t> encoded, compressed;
+            for (size_t c = begin; c < end; ++c)
+            {
+                const size_t first = c * chunkItems;
+                encoded.clear();
+                encode(first, std::min(chunkItems, count - first), encoded);
+                encodedSizes[c] = static_cast<uint32_t>(encoded.size());
+
+                // lz finds the repeats a delta can't, like the same uv seam in every block
+                compressed.resize(Lz::CompressBound(encoded.size()));
+                const size_t size = Lz::Compress(encoded.data(), encoded.size(), compressed.data(), compressed.size());
+                if (size != 0 && size < encoded.size())
+                    chunks[c].assign(compressed.begin(), compressed.begin() + static_cast<std::ptrdiff_t>(size));
+                else
+                    chunks[c] = encoded;
+            }
+        };
+
+        if (pool)
+            pool->ParallelFor(chunkCount, 1, run);
+        else
+            run(0, chunkCount);
+
+        const StreamHeader header{magic, static_cast<uint32_t>(count), static_cast<uint32_t>(stride),
+                                  static_cast<uint32_t>(chunkCount)};
+        std::vector<ChunkEntry> table(chunkCount);
+        uint64_t cursor = sizeof(StreamHeader) + sizeof(ChunkEntry) * chunkCount;
+        for (size_t c = 0; c < chunkCount; ++c)
+        {
+            table[c] = {cursor, static_cast<uint32_t>(chunks[c].size()), encodedSizes[c]};
+            cursor += chunks[c].size();
+        }
+
+        out.resize(cursor);
+        std::memcpy(out.data(), &header, sizeof(header));
+        if (chunkCount)
+            std::memcpy(out.data() + sizeof(header), table.data(), sizeof(ChunkEntry) * chunkCount);
+        for (size_t c = 0; c < chunkCount; ++c)
+        {
+            if (!chunks[c].empty())
+                std::memcpy(out.data() + table[c].offset, chunks[c].data(), chunks[c].size());
+        }
+    }
+
+    // validates the header and table, then decode(data, size, first, count)
+    // runs per chunk on whichever thread picks it up
+    template <typename DecodeChunk>
+    bool ReadStream(const void *src, size_t srcSize, uint32_t magic, size_t count, size_t stride, size_t chunkItems,
+                    ThreadPool *pool, DecodeChunk &&decode)
+    {
+        const auto *base = static_cast<const uint8_t *>(src);
+        if (!base || srcSize < sizeof(StreamHeader))
+            return false;
+
+        StreamHeader header;
+        std::memcpy(&header, base, sizeof(header));
+        const size_t chunkCount = (count + chunkItems - 1) / chunkItems;
+        if (header.magic != magic || header.count != count || header.stride != stride || header.chunkCount != chunkCount)
+            return false;
+        if ((srcSize - sizeof(StreamHeader)) / sizeof(ChunkEntry) < chunkCount)
+            return false;
+
+        std::vector<ChunkEntry> table(chunkCount);
+        if (chunkCount)
+            std::memcpy(table.data(), base + sizeof(StreamHeader), sizeof(ChunkEntry) * chunkCount);
+        for (const ChunkEntry &chunk : table)
+        {
+            if (chunk.offset > srcSize || chunk.storedSize > srcSize - chunk.offset)
+                return false;
+        }
+
+        std::atomic<bool> ok = true;
+        auto run = [&](size_t begin, size_t end)
+        {
+            UninitVector<uint8_t> scratch;
+            for (size_t c = begin; c < end && ok.load(std::memory_order_relaxed); ++c)
+            {
+                const ChunkEntry &chunk = table[c];
+                const uint8_t *data = base + chunk.offset;
+                if (chunk.storedSize != chunk.encodedSize)
+                {
+                    scratch.resize(chunk.encodedSize);
+                    if (!Lz::Decompress(data, chunk.storedSize, scratch.data(), chunk.encodedSize))
+                    {
+                        ok = false;
+                        return;
+                    }
+                    data = scratch.data();
+                }
+
+                const size_t first = c * chunkItems;
+                if (!decode(data, size_t(chunk.encodedSize), first, std::min(chunkItems, count - first)))
+                    ok = false;
+            }
+        };
+
+        if (pool)
+            pool->ParallelFor(chunkCount, 1, run);
+        else
+            run(0, chunkCount);
+        return ok;
+    }
+
+    // -- vertices --
+
+    void PackGroup(const uint8_t *values, unsigned code, std::vector<uint8_t> &out)
+    {
+        if (code == 3)
+        {
+            out.insert(out.end(), values, values + GROUP);
+            return;
+        }
+        const unsigned bits = code == 1 ? 2 : 4;
+        const unsigned perByte = 8 / bits;
+        for (size_t i = 0; i < GROUP; i += perByte)
+        {
+            uint8_t b = 0;
+            for (unsigned j = 0; j < perByte; ++j)
+                b = static_cast<uint8_t>(b | values[i + j] << (j * bits));
+            out.push_back(b);
+        }
+    }
+
+    void EncodeVertexChunk(const uint8_t *vertices, size_t count, size_t stride, std::vector<uint8_t> &out)
+    {
+        uint8_t last[MAX_VERTEX_STRIDE] = {};
+        uint8_t deltas[VERTEX_BLOCK];
+        for (size_t block = 0; block < count; block += VERTEX_BLOCK)
+        {
+            const size_t n = std::min(VERTEX_BLOCK, count - block);
+            const size_t groups = (n + GROUP - 1) / GROUP;
+            std::memset(deltas + n, 0, groups * GROUP - n); // the last group is padded with zero deltas
+
+            for (size_t k = 0; k < stride; ++k)
+            {
+                uint8_t previous = last[k];
+                for (size_t i = 0; i < n; ++i)
+                {
+                    const uint8_t v = vertices[(block + i) * stride + k];
+                    deltas[i] = ZigZag8(static_cast<uint8_t>(v - previous));
+                    previous = v;
+                }
+                last[k] = previous;
+
+                // 2 bit codes for 4 groups a byte, then the groups
+                const size_t header = out.size();
+                out.resize(header + (groups + 3) / 4, 0);
+                for (size_t g = 0; g < groups; ++g)
+                {
+                    const uint8_t *values = deltas + g * GROUP;
+                    const uint8_t largest = *std::max_element(values, values + GROUP);
+                    const unsigned code = largest == 0 ? 0 : largest < 4 ? 1 : largest < 16 ? 2 : 3;
+                    out[header + g / 4] = static_cast<uint8_t>(out[header + g / 4] | code << (g % 4 * 2));
+                    if (code != 0)
+                        PackGroup(values, code, out);
+                }
+            }
+        }
+    }
+
+#if defined(GRAPHITE_SSE41)
+    // any group unpacks with one shuffle and four shift and mask steps, the
+    // tables pick which. byte j of a 2 bit group is bits 2 * (j % 4) of source
+    // byte j / 4, of a 4 bit group the low or high nibble of source byte j / 2
+    struct UnpackTables
+    {
+        alignas(16) int8_t shuffle[4][16];
+        alignas(16) uint8_t masks[4][4][16]; // code, shift / 2, byte
+
+        UnpackTables()
+        {
+            for (unsigned code = 0; code < 4; ++code)
+            {
+                for (unsigned j = 0; j < 16; ++j)
+                {
+                    const unsigned perByte = code == 1 ? 4 : code == 2 ? 2 : 1;
+                    shuffle[code][j] = static_cast<int8_t>(j / perByte);
+                    for (unsigned shift = 0; shift < 4; ++shift)
+                    {
+                        uint8_t mask = 0;
+                        if (code == 1 && j % 4 == shift)
+                            mask = 0x03;
+                        else if (code == 2 && shift == (j % 2) * 2)
+                            mask = 0x0F;
+                        else if (code == 3 && shift == 0)
+                            mask = 0xFF;
+                        masks[code][shift][j] = mask;
+                    }
+                }
+            }
+        }
+    };
+
+    // p has at least 16 readable bytes
+    __m128i UnpackGroup(const uint8_t *&p, unsigned code)
+    {
+        static const UnpackTables tables;
+        const __m128i x = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)),
+                                           _mm_load_si128(reinterpret_cast<const __m128i *>(tables.shuffle[code])));
+        const auto mask = [&](unsigned shift)
+        { return _mm_load_si128(reinterpret_cast<const __m128i *>(tables.masks[code][shift])); };
+        // 16 bit shifts, the bits that cross into a byte from its neighbour are masked off
+        __m128i v = _mm_and_si128(x, mask(0));
+        v = _mm_or_si128(v, _mm_and_si128(_mm_srli_epi16(x, 2), mask(1)));
+        v = _mm_or_si128(v, _mm_and_si128(_mm_srli_epi16(x, 4), mask(2)));
+        v = _mm_or_si128(v, _mm_and_si128(_mm_srli_epi16(x, 6), mask(3)));
+        p += GROUP_BYTES[code];
+        return v;
+    }
+#endif
+
+    void UnpackGroup(const uint8_t *&p, unsigned code, uint8_t *values)
+    {
+        if (code == 0)
+        {
+            std::memset(values, 0, GROUP);
+            return;
+        }
+        if (code == 3)
+        {
+            std::memcpy(values, p, GROUP);
+            p += GROUP;
+            return;
+        }
+        const unsigned bits = code == 1 ? 2 : 4;
+        const unsigned perByte = 8 / bits;
+        for (size_t i = 0; i < GROUP; i += perByte, ++p)
+        {
+            for (unsigned j = 0; j < perByte; ++j)
+                values[i + j] = static_cast<uint8_t>((*p >> (j * bits)) & ((1u << bits) - 1));
+        }
+    }
+
+    // packed bytes behind the 4 groups a header byte describes
+    struct HeaderSizes
+    {
+        uint8_t bytes[256];
+
+        HeaderSizes()
+        {
+            for (unsigned h = 0; h < 256; ++h)
+                bytes[h] = static_cast<uint8_t>(GROUP_BYTES[h & 3] + GROUP_BYTES[h >> 2 & 3] + GROUP_BYTES[h >> 4 & 3] + GROUP_BYTES[h >> 6]);
+        }
+    };
+
+    // one byte plane of a block, unpacked and with the zigzag undone. the
+    // deltas are summed up per vertex once the planes are interleaved, 4
+    // vertices a register. nullptr when the input runs out
+    const uint8_t *DecodePlane(const uint8_t *p, const uint8_t *end, size_t groups, uint8_t *plane)
+    {
+        static const HeaderSizes sizes;
+        const size_t headerBytes = (groups + 3) / 4;
+        const uint8_t *header = p;
+        if (size_t(end - p) < headerBytes)
+            return nullptr;
+        p += headerBytes;
+        size_t bytes = 0;
+        for (size_t h = 0; h < headerBytes; ++h)
+            bytes += sizes.bytes[header[h]];
+        if (size_t(end - p) < bytes)
+            return nullptr;
+
+#if defined(GRAPHITE_SSE41)
+        // groups load 16 bytes whatever their size, near the end of the
+        // input they go through the exact scalar unpack instead
+        if (size_t(end - p) >= bytes + GROUP)
+        {
+            const __m128i one = _mm_set1_epi8(1);
+            const __m128i low7 = _mm_set1_epi8(0x7F);
+            for (size_t g = 0; g < groups; ++g)
+            {
+                // constant bytes (exponents, high position bytes) leave whole
+                // groups at zero and noisy ones store them raw, both skip the unpack
+                const unsigned code = (header[g / 4] >> (g % 4 * 2)) & 3;
+                __m128i *dst = reinterpret_cast<__m128i *>(plane + g * GROUP);
+                if (code == 0)
+                {
+                    _mm_storeu_si128(dst, _mm_setzero_si128());
+                    continue;
+                }
+                __m128i z;
+                if (code == 3)
+                {
+                    z = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+                    p += GROUP;
+                }
+                else
+                {
+                    z = UnpackGroup(p, code);
+                }
+                _mm_storeu_si128(dst, _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(z, 1), low7),
+                                                    _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(z, one))));
+            }
+            return p;
+        }
+#endif
+        for (size_t g = 0; g < groups; ++g)
+        {
+            uint8_t *values = plane + g * GROUP;
+            UnpackGroup(p, (header[g / 4] >> (g % 4 * 2)) & 3, values);
+            for (size_t i = 0; i < GROUP; ++i)
+                values[i] = UnZigZag8(values[i]);
+        }
+        return p;
+    }
+
+    // delta planes back to interleaved vertices. last holds the previous
+    // vertex and is left at the last one of the block
+    void InterleavePlanes(const uint8_t *planes, size_t n, size_t stride, uint8_t *last, uint8_t *out)
+    {
+        size_t i = 0;
+#if defined(GRAPHITE_SSE41)
+        // padding deltas past n are zero, so whole groups are summed and only
+        // the vertices that exist stored. 4 planes at a time become one 32 bit
+        // lane per vertex, then 4 of those are transposed so each vertex is
+        // written 16 bytes at a time. the last 16 bytes of a vertex may
+        // overlap the ones before, they are written twice with the same value
+        const size_t quads = stride / 4;
+        __m128i words[MAX_VERTEX_STRIDE / 4][4];
+        for (; i < n; i += GROUP)
+        {
+            const size_t valid = std::min(GROUP, n - i);
+            for (size_t q = 0; q < quads; ++q)
+            {
+                const size_t k = q * 4;
+                const uint8_t *p = planes + k * VERTEX_BLOCK + i;
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + VERTEX_BLOCK));
+                const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 2 * VERTEX_BLOCK));
+                const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 3 * VERTEX_BLOCK));
+                const __m128i abLow = _mm_unpacklo_epi8(a, b), abHigh = _mm_unpackhi_epi8(a, b);
+                const __m128i cdLow = _mm_unpacklo_epi8(c, d), cdHigh = _mm_unpackhi_epi8(c, d);
+                __m128i *w = words[q];
+                w[0] = _mm_unpacklo_epi16(abLow, cdLow);
+                w[1] = _mm_unpackhi_epi16(abLow, cdLow);
+                w[2] = _mm_unpacklo_epi16(abHigh, cdHigh);
+                w[3] = _mm_unpackhi_epi16(abHigh, cdHigh);
+
+                // each 32 bit lane is one vertex's 4 bytes
+                uint32_t previous;
+                std::memcpy(&previous, last + k, 4);
+                __m128i carry = _mm_set1_epi32(static_cast<int>(previous));
+                for (size_t v = 0; v < 4; ++v)
+                {
+                    w[v] = _mm_add_epi8(w[v], _mm_slli_si128(w[v], 4));
+                    w[v] = _mm_add_epi8(w[v], _mm_slli_si128(w[v], 8));
+                    w[v] = _mm_add_epi8(w[v], carry);
+                    carry = _mm_shuffle_epi32(w[v], 0xFF);
+                }
+                previous = static_cast<uint32_t>(_mm_cvtsi128_si32(carry));
+                std::memcpy(last + k, &previous, 4);
+            }
+
+            uint8_t *dst = out + i * stride;
+            if (quads < 4)
+            {
+                alignas(16) uint32_t values[GROUP];
+                for (size_t q = 0; q < quads; ++q)
+                {
+                    for (size_t v = 0; v < 4; ++v)
+                        _mm_store_si128(reinterpret_cast<__m128i *>(values + 4 * v), words[q][v]);
+                    for (size_t v = 0; v < valid; ++v)
+                        std::memcpy(dst + v * stride + q * 4, values + v, 4);
+                }
+                continue;
+            }
+            for (size_t q = 0; q < quads; q += 4)
+            {
+                const size_t first = std::min(q, quads - 4);
+                for (size_t v = 0; v < 4 && v * 4 < valid; ++v)
+                {
+                    // rows are quads, lanes vertices. transposed, row r is vertex 4v + r
+                    const __m128i r01Low = _mm_unpacklo_epi32(words[first][v], words[first + 1][v]);
+                    const __m128i r01High = _mm_unpackhi_epi32(words[first][v], words[first + 1][v]);
+                    const __m128i r23Low = _mm_unpacklo_epi32(words[first + 2][v], words[first + 3][v]);
+                    const __m128i r23High = _mm_unpackhi_epi32(words[first + 2][v], words[first + 3][v]);
+                    const __m128i rows[4] = {_mm_unpacklo_epi64(r01Low, r23Low), _mm_unpackhi_epi64(r01Low, r23Low),
+                                             _mm_unpacklo_epi64(r01High, r23High), _mm_unpackhi_epi64(r01High, r23High)};
+                    const size_t rowCount = std::min<size_t>(4, valid - v * 4);
+                    for (size_t r = 0; r < rowCount; ++r)
+                        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + (v * 4 + r) * stride + first * 4), rows[r]);
+                }
+            }
+        }
+#else
+        for (; i < n; ++i)
+        {
+            for (size_t k = 0; k < stride; ++k)
+            {
+                last[k] = static_cast<uint8_t>(last[k] + planes[k * VERTEX_BLOCK + i]);
+                out[i * stride + k] = last[k];
+            }
+        }
+#endif
+    }
+
+    bool DecodeVertexChunk(const uint8_t *p, size_t size, uint8_t *out, size_t count, size_t stride)
+    {
+        const uint8_t *const end = p + size;
+        alignas(16) uint8_t planes[MAX_VERTEX_STRIDE * VERTEX_BLOCK];
+        uint8_t last[MAX_VERTEX_STRIDE] = {};
+        for (size_t block = 0; block < count; block += VERTEX_BLOCK)
+        {
+            const size_t n = std::min(VERTEX_BLOCK, count - block);
+            const size_t groups = (n + GROUP - 1) / GROUP;
+            for (size_t k = 0; k < stride; ++k)
+            {
+                p = DecodePlane(p, end, groups, planes + k * VERTEX_BLOCK);
+                if (!p)
+                    return false;
+            }
+            InterleavePlanes(planes, n, stride, last, out + block * stride);
+        }
+        return p == end;
+    }
+
+    // -- indices --
+
+    // recently seen edges and vertices, mirrored exactly by the decoder
+    struct IndexFifos
+    {
+        uint32_t edges[FIFO_SIZE][2];
+        uint32_t vertices[FIFO_SIZE];
+        size_t edgeCursor = 0;
+        size_t vertexCursor = 0;
+
+        IndexFifos()
+        {
+            std::fill(&edges[0][0], &edges[0][0] + 2 * FIFO_SIZE, ~0u);
+            std::fill(vertices, vertices + FIFO_SIZE, ~0u);
+        }
+
+        // 0 is the most recent
+        const uint32_t *RecentEdge(size_t i) const { return edges[(edgeCursor - 1 - i) % FIFO_SIZE]; }
+        uint32_t RecentVertex(size_t i) const { return vertices[(vertexCursor - 1 - i) % FIFO_SIZE]; }
+
+        void PushEdge(uint32_t a, uint32_t b)
+        {
+            uint32_t *e = edges[edgeCursor++ % FIFO_SIZE];
+            e[0] = a;
+            e[1] = b;
+        }
+        void PushVertex(uint32_t v) { vertices[vertexCursor++ % FIFO_SIZE] = v; }
+    };
+
+    // next is one past the largest index seen, which after vertex fetch
+    // optimization is almost always the next new vertex
+    struct IndexState
+    {
+        IndexFifos fifos;
+        uint32_t next = 0;
+        uint32_t last = 0; // previous explicit index
+    };
+
+    uint8_t EncodeVertex(uint32_t v, IndexState &state, std::vector<uint8_t> &data)
+    {
+        if (v == state.next)
+        {
+            ++state.next;
+            state.fifos.PushVertex(v);
+            return 0;
+        }
+        for (size_t i = 0; i < EXPLICIT - 1; ++i)
+        {
+            if (state.fifos.RecentVertex(i) == v)
+                return static_cast<uint8_t>(1 + i);
+        }
+        AppendVarint(data, ZigZag32(v - state.last));
+        state.last = v;
+        state.next = std::max(state.next, v + 1);
+        state.fifos.PushVertex(v);
+        return EXPLICIT;
+    }
+
+    bool DecodeVertex(unsigned code, IndexState &state, const uint8_t *&data, const uint8_t *end, uint32_t &v)
+    {
+        if (code == 0)
+        {
+            v = state.next++;
+            state.fifos.PushVertex(v);
+        }
+        else if (code < EXPLICIT)
+        {
+            v = state.fifos.RecentVertex(code - 1);
+        }
+        else
+        {
+            uint32_t delta;
+            if (!ReadVarint(data, end, delta))
+                return false;
+            v = state.last + UnZigZag32(delta);
+            state.last = v;
+            state.next = std::max(state.next, v + 1);
+            state.fifos.PushVertex(v);
+        }
+        return true;
+    }
+
+    // next, code byte count, code bytes, then the varints
+    void EncodeIndexChunk(const uint32_t *indices, size_t count, uint32_t next, std::vector<uint8_t> &out)
+    {
+        IndexState state;
+        state.next = state.last = next;
+        std::vector<uint8_t> codes, data;
+        codes.reserve(count / 3 + 16);
+
+        for (size_t t = 0; t < count; t += 3)
+        {
+            // a rotation of the triangle that has an edge of a recent one.
+            // the fifo holds edges reversed, the way a neighbour walks them
+            uint32_t tri[3] = {indices[t], indices[t + 1], indices[t + 2]};
+            size_t edge = NO_EDGE;
+            for (size_t e = 0; e < NO_EDGE && edge == NO_EDGE; ++e)
+            {
+                const uint32_t *recent = state.fifos.RecentEdge(e);
+                for (size_t r = 0; r < 3; ++r)
+                {
+                    if (recent[0] == tri[r] && recent[1] == tri[(r + 1) % 3])
+                    {
+                        std::rotate(tri, tri + r, tri + 3);
+                        edge = e;
+                        break;
+                    }
+                }
+            }
+
+            const uint32_t a = tri[0], b = tri[1], c = tri[2];
+            if (edge != NO_EDGE)
+            {
+                codes.push_back(static_cast<uint8_t>(edge << 4 | EncodeVertex(c, state, data)));
+                state.fifos.PushEdge(c, b);
+                state.fifos.PushEdge(a, c);
+            }
+            else
+            {
+                const uint8_t codeA = EncodeVertex(a, state, data);
+                const uint8_t codeB = EncodeVertex(b, state, data);
+                const uint8_t codeC = EncodeVertex(c, state, data);
+                codes.push_back(static_cast<uint8_t>(NO_EDGE << 4 | codeA));
+                codes.push_back(static_cast<uint8_t>(codeB << 4 | codeC));
+                state.fifos.PushEdge(b, a);
+                state.fifos.PushEdge(c, b);
+                state.fifos.PushEdge(a, c);
+            }
+        }
+
+        Append32(out, next);
+        Append32(out, static_cast<uint32_t>(codes.size()));
+        out.insert(out.end(), codes.begin(), codes.end());
+        out.insert(out.end(), data.begin(), data.end());
+    }
+
+    bool DecodeIndexChunk(const uint8_t *p, size_t size, uint32_t *out, size_t count, size_t vertexCount)
+    {
+        if (size < 8)
+            return false;
+        IndexState state;
+        state.next = state.last = Read32(p);
+        const uint32_t codeBytes = Read32(p + 4);
+        if (codeBytes > size - 8)
+            return false;
+        const uint8_t *codes = p + 8;
+        const uint8_t *const codesEnd = codes + codeBytes;
+        const uint8_t *data = codesEnd;
+        const uint8_t *const end = p + size;
+
+        for (size_t t = 0; t < count; t += 3)
+        {
+            if (codes == codesEnd)
+                return false;
+            const uint8_t code = *codes++;
+            uint32_t a, b, c;
+            if (code >> 4 != NO_EDGE)
+            {
+                const uint32_t *recent = state.fifos.RecentEdge(code >> 4);
+                a = recent[0];
+                b = recent[1];
+                if (!DecodeVertex(code & 15, state, data, end, c))
+                    return false;
+                state.fifos.PushEdge(c, b);
+                state.fifos.PushEdge(a, c);
+            }
+            else
+            {
+                if (codes == codesEnd)
+                    return false;
+                const uint8_t second = *codes++;
+                if (!DecodeVertex(code & 15, state, data, end, a) || !DecodeVertex(second >> 4, state, data, end, b) ||
+                    !DecodeVertex(second & 15, state, data, end, c))
+                    return false;
+                state.fifos.PushEdge(b, a);
+                state.fifos.PushEdge(c, b);
+                state.fifos.PushEdge(a, c);
+            }
+
+            if (a >= vertexCount || b >= vertexCount || c >= vertexCount)
+                return false;
+            out[t] = a;
+            out[t + 1] = b;
+            out[t + 2] = c;
+        }
+        return codes == codesEnd && data == end;
+    }
+}
+
+namespace MeshCodec
+{
+    bool EncodeVertices(const void *vertices, size_t count, size_t stride, std::vector<unsigned char> &out, ThreadPool *pool)
+    {
+        if (stride == 0 || stride % 4 != 0 || stride > MAX_VERTEX_STRIDE || count > UINT32_MAX)
+            return false;
+        const auto *bytes = static_cast<const uint8_t *>(vertices);
+        WriteStream(VERTEX_MAGIC, count, stride, VERTEX_CHUNK, out, pool, [&](size_t first, size_t n, std::vector<uint8_t> &encoded)
+                    { EncodeVertexChunk(bytes + first * stride, n, stride, encoded); });
+        return true;
+    }
+
+    bool DecodeVertices(const void *src, size_t srcSize, void *vertices, size_t count, size_t stride, ThreadPool *pool)
+    {
+        if (stride == 0 || stride % 4 != 0 || stride > MAX_VERTEX_STRIDE)
+            return false;
+        auto *bytes = static_cast<uint8_t *>(vertices);
+        return ReadStream(src, srcSize, VERTEX_MAGIC, count, stride, VERTEX_CHUNK, pool, [&](const uint8_t *data, size_t size, size_t first, size_t n)
+                          { return DecodeVertexChunk(data, size, bytes + first * stride, n, stride); });
+    }
+
+    bool EncodeIndices(const uint32_t *indices, size_t count, std::vector<unsigned char> &out, ThreadPool *pool)
+    {
+        if (count % 3 != 0 || count > UINT32_MAX)
+            return false;
+
+        // every chunk starts from the largest index before it
+        std::vector<uint32_t> starts((count + INDEX_CHUNK - 1) / INDEX_CHUNK);
+        uint32_t next = 0;
+        for (size_t c = 0; c < starts.size(); ++c)
+        {
+            starts[c] = next;
+            const size_t end = std::min(count, (c + 1) * INDEX_CHUNK);
+            for (size_t i = c * INDEX_CHUNK; i < end; ++i)
+                next = std::max(next, indices[i] + 1);
+        }
+
+        WriteStream(INDEX_MAGIC, count, sizeof(uint32_t), INDEX_CHUNK, out, pool, [&](size_t first, size_t n, std::vector<uint8_t> &encoded)
+                    { EncodeIndexChunk(indices + first, n, starts[first / INDEX_CHUNK], encoded); });
+        return true;
+    }
+
+    bool DecodeIndices(const void *src, size_t srcSize, uint32_t *indices, size_t count, size_t vertexCount, ThreadPool *pool)
+    {
+        if (count % 3 != 0)
+            return false;
+        return ReadStream(src, srcSize, INDEX_MAGIC, count, sizeof(uint32_t), INDEX_CHUNK, pool, [&](const uint8_t *data, size_t size, size_t first, size_t n)
+                          { return DecodeIndexChunk(data, size, indices + first, n, vertexCount); });
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// compressed vertex and index streams for cooked meshes. both are cut into
+// chunks that encode and decode on their own, so a pool spreads the work
+//
+//   StreamHeader
+//   ChunkEntry[chunkCount]
+//   chunk data
+//
+// vertices: blocks of up to 256 vertices stored as byte planes (byte k of
+// every vertex), each byte the zigzagged difference to the same byte of the
+// vertex before. planes are packed in groups of 16 at 0, 2, 4 or 8 bits
+//
+// indices: one code byte per triangle naming an edge of a recent triangle and
+// where the third vertex comes from (the next unused index, a recent vertex or
+// a varint delta). triangles may come back rotated, their winding is kept
+//
+// a chunk is then run through Lz when that makes it smaller
+namespace MeshCodec
+{
+    inline constexpr uint32_t VERTEX_MAGIC = 0x58544D47; // "GMTX"
+    inline constexpr uint32_t INDEX_MAGIC = 0x58444D47;  // "GMDX"
+
+    // strides must be a multiple of 4
+    inline constexpr size_t MAX_VERTEX_STRIDE = 64;
+
+    struct StreamHeader
+    {
+        uint32_t magic;
+        uint32_t count;  // vertices or indices
+        uint32_t stride; // vertex size, 4 for indices
+        uint32_t chunkCount;
+    };
+    static_assert(sizeof(StreamHeader) == 16, "StreamHeader layout is part of the file format.");
+
+    struct ChunkEntry
+    {
+        uint64_t offset;      // from the start of the stream
+        uint32_t storedSize;  // equal to encodedSize when Lz didn't help
+        uint32_t encodedSize; // before Lz
+    };
+    static_assert(sizeof(ChunkEntry) == 16, "ChunkEntry layout is part of the file format.");
+
+    // false when the stride isn't supported
+    bool EncodeVertices(const void *vertices, size_t count, size_t stride, std::vector<unsigned char> &out, ThreadPool *pool = nullptr);
+
+    // vertices must hold count * stride bytes. false for malformed input or
+    // a stream of a different count or stride
+    bool DecodeVertices(const void *src, size_t srcSize, void *vertices, size_t count, size_t stride, ThreadPool *pool = nullptr);
+
+    // false when count isn't a multiple of 3
+    bool EncodeIndices(const uint32_t *indices, size_t count, std::vector<unsigned char> &out, ThreadPool *pool = nullptr);
+
+    // also fails when an index isn't below vertexCount, so a bad stream
+    // can't send the gpu past the end of the vertex buffer
+    bool DecodeIndices(const void *src, size_t srcSize, uint32_t *indices, size_t count, size_t vertexCount, ThreadPool *pool = nullptr);
+}
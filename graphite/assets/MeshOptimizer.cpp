@@ -0,0 +1,419 @@
+#include "MeshOptimizer.h"
+#include "core/ThreadPool.h"
+#include "utils/Logger.h"
+#include "cfg/Config.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+    // vertex -> triangles adjacency in compressed row form
+    struct TriangleAdjacency
+    {
+        std::vector<uint32_t> offsets; // vertexCount + 1
+        std::vector<uint32_t> triangles;
+    };
+
+    void BuildAdjacency(const uint32_t *indices, size_t indexCount, size_t vertexCount, TriangleAdjacency &out)
+    {
+        out.offsets.assign(vertexCount + 1, 0);
+        for (size_t i = 0; i < indexCount; ++i)
+            out.offsets[indices[i] + 1]++;
+        for (size_t v = 0; v < vertexCount; ++v)
+            out.offsets[v + 1] += out.offsets[v];
+
+        out.triangles.resize(indexCount);
+        std::vector<uint32_t> cursor(out.offsets.begin(), out.offsets.end() - 1);
+        for (size_t i = 0; i < indexCount; ++i)
+            out.triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    // fifo cache modeled with timestamps, a vertex is a hit if it entered the
+    // cache less than cacheSize insertions ago
+    struct FifoCache
+    {
+        std::vector<uint32_t> timestamps;
+        uint32_t time;
+        unsigned size;
+
+        FifoCache(size_t vertexCount, unsigned cacheSize)
+            : timestamps(vertexCount, 0), time(cacheSize + 1), size(cacheSize)
+        {
+        }
+
+        void Reset()
+        {
+            // pushing time forward invalidates every entry without touching the array
+            time += size + 1;
+        }
+
+        unsigned Access(uint32_t v)
+        {
+            if (time - timestamps[v] > size)
+            {
+                timestamps[v] = time++;
+                return 1;
+            }
+            return 0;
+        }
+
+        unsigned AccessTriangle(const uint32_t *tri)
+        {
+            return Access(tri[0]) + Access(tri[1]) + Access(tri[2]);
+        }
+    };
+
+    glm::vec3 TriangleNormal(const Vertex *vertices, const uint32_t *tri)
+    {
+        glm::vec3 e0 = vertices[tri[1]].Position - vertices[tri[0]].Position;
+        glm::vec3 e1 = vertices[tri[2]].Position - vertices[tri[0]].Position;
+        return glm::cross(e0, e1); // length is twice the area, used as weight
+    }
+
+    void LogStats(const char *step, const MeshOptimizer::CacheStats &before, const MeshOptimizer::CacheStats &after)
+    {
+        LOG_DEBUG("MeshOptimizer {}: ACMR {} -> {}, ATVR {} -> {}",
+                  step, before.acmr, after.acmr, before.atvr, after.atvr);
+    }
+}
+
+namespace MeshOptimizer
+{
+    CacheStats AnalyzeVertexCache(
+        const uint32_t *indices,
+        size_t indexCount,
+        size_t vertexCount,
+        unsigned cacheSize)
+    {
+        CacheStats stats;
+        if (indexCount < 3 || vertexCount == 0)
+            return stats;
+
+        FifoCache cache(vertexCount, cacheSize);
+        std::vector<uint8_t> referenced(vertexCount, 0);
+        size_t misses = 0;
+        size_t unique = 0;
+
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            uint32_t v = indices[i];
+            misses += cache.Access(v);
+            if (!referenced[v])
+            {
+                referenced[v] = 1;
+                ++unique;
+            }
+        }
+
+        stats.acmr = float(misses) / float(indexCount / 3);
+        stats.atvr = unique ? float(misses) / float(unique) : 0.0f;
+        return stats;
+    }
+
+    void OptimizeVertexCache(
+        uint32_t *destination,
+        const uint32_t *indices,
+        size_t indexCount,
+        size_t vertexCount,
+        unsigned cacheSize)
+    {
+        const size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0 || vertexCount == 0)
+            return;
+
+        // tolerate destination == indices
+        std::vector<uint32_t> source(indices, indices + indexCount);
+
+        TriangleAdjacency adjacency;
+        BuildAdjacency(source.data(), indexCount, vertexCount, adjacency);
+
+        std::vector<uint32_t> liveTriangles(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v)
+            liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+        std::vector<uint32_t> timestamps(vertexCount, 0);
+        std::vector<uint8_t> emitted(triangleCount, 0);
+        std::vector<uint32_t> deadEnd;
+        std::vector<uint32_t> candidates;
+        deadEnd.reserve(indexCount);
+
+        uint32_t time = cacheSize + 1;
+        size_t cursor = 0;
+        size_t written = 0;
+
+        // start at the first referenced vertex
+        int64_t fan = -1;
+        for (; cursor < vertexCount; ++cursor)
+        {
+            if (liveTriangles[cursor] > 0)
+            {
+                fan = int64_t(cursor);
+                break;
+            }
+        }
+
+        while (fan >= 0)
+        {
+            uint32_t f = uint32_t(fan);
+            candidates.clear();
+
+            // emit every remaining triangle around the fan vertex
+            for (uint32_t k = adjacency.offsets[f]; k < adjacency.offsets[f + 1]; ++k)
+            {
+                uint32_t t = adjacency.triangles[k];
+                if (emitted[t])
+                    continue;
+
+                const uint32_t *tri = &source[t * 3];
+                for (int c = 0; c < 3; ++c)
+                {
+                    uint32_t v = tri[c];
+                    destination[written++] = v;
+                    deadEnd.push_back(v);
+                    candidates.push_back(v);
+                    liveTriangles[v]--;
+
+                    if (time - timestamps[v] > cacheSize)
+                        timestamps[v] = time++;
+                }
+                emitted[t] = 1;
+            }
+
+            // next fan: the candidate that stays in cache longest, favouring
+            // vertices with few triangles left
+            fan = -1;
+            int64_t bestPriority = -1;
+            for (uint32_t v : candidates)
+            {
+                if (liveTriangles[v] == 0)
+                    continue;
+
+                int64_t priority = 0;
+                if (time - timestamps[v] + 2 * liveTriangles[v] <= cacheSize)
+                    priority = time - timestamps[v];
+
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    fan = v;
+                }
+            }
+
+            if (fan >= 0)
+                continue;
+
+            // dead end: back up through recently emitted vertices, then scan
+            while (!deadEnd.empty())
+            {
+                uint32_t v = deadEnd.back();
+                deadEnd.pop_back();
+                if (liveTriangles[v] > 0)
+                {
+                    fan = v;
+                    break;
+                }
+            }
+
+            while (fan < 0 && cursor < vertexCount)
+            {
+                if (liveTriangles[cursor] > 0)
+                    fan = int64_t(cursor);
+                ++cursor;
+            }
+        }
+    }
+
+    void OptimizeOverdraw(
+        uint32_t *destination,
+        const uint32_t *indices,
+        size_t indexCount,
+        const Vertex *vertices,
+        size_t vertexCount,
+        unsigned cacheSize,
+        float threshold)
+    {
+        const size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0 || vertexCount == 0)
+            return;
+
+        std::vector<uint32_t> source(indices, indices + indexCount);
+
+        // hard boundaries: a triangle missing on all three vertices starts a
+        // new strip, so splitting there costs nothing
+        std::vector<uint32_t> hard;
+        {
+            FifoCache cache(vertexCount, cacheSize);
+            for (size_t t = 0; t < triangleCount; ++t)
+            {
+                if (cache.AccessTriangle(&source[t * 3]) == 3)
+                    hard.push_back(uint32_t(t));
+            }
+            if (hard.empty() || hard.front() != 0)
+                hard.insert(hard.begin(), 0);
+        }
+
+        // soft boundaries: split a hard cluster further wherever the running
+        // acmr from the last split is already within threshold of the cluster's
+        std::vector<uint32_t> clusters;
+        {
+            FifoCache cache(vertexCount, cacheSize);
+            for (size_t c = 0; c < hard.size(); ++c)
+            {
+                size_t start = hard[c];
+                size_t end = c + 1 < hard.size() ? hard[c + 1] : triangleCount;
+
+                cache.Reset();
+                size_t clusterMisses = 0;
+                for (size_t t = start; t < end; ++t)
+                    clusterMisses += cache.AccessTriangle(&source[t * 3]);
+                float clusterThreshold = threshold * float(clusterMisses) / float(end - start);
+
+                cache.Reset();
+                size_t splitStart = start;
+                size_t misses = 0;
+                clusters.push_back(uint32_t(start));
+                for (size_t t = start; t < end; ++t)
+                {
+                    misses += cache.AccessTriangle(&source[t * 3]);
+                    size_t count = t + 1 - splitStart;
+                    if (t + 1 < end && float(misses) / float(count) <= clusterThreshold)
+                    {
+                        clusters.push_back(uint32_t(t + 1));
+                        cache.Reset();
+                        splitStart = t + 1;
+                        misses = 0;
+                    }
+                }
+            }
+        }
+
+        // mesh centroid weighted by triangle area
+        glm::vec3 meshCenter(0.0f);
+        float meshArea = 0.0f;
+        for (size_t t = 0; t < triangleCount; ++t)
+        {
+            const uint32_t *tri = &source[t * 3];
+            float area = glm::length(TriangleNormal(vertices, tri));
+            meshCenter += (vertices[tri[0]].Position + vertices[tri[1]].Position + vertices[tri[2]].Position) * (area / 3.0f);
+            meshArea += area;
+        }
+        if (meshArea > 0.0f)
+            meshCenter = meshCenter / meshArea;
+
+        // sort key: how far the cluster faces away from the centre. clusters on
+        // the outside are likely to occlude the ones behind them
+        struct ClusterKey
+        {
+            float key;
+            uint32_t cluster;
+        };
+        std::vector<ClusterKey> keys(clusters.size());
+        for (size_t c = 0; c < clusters.size(); ++c)
+        {
+            size_t start = clusters[c];
+            size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+            glm::vec3 center(0.0f);
+            glm::vec3 normal(0.0f);
+            float area = 0.0f;
+            for (size_t t = start; t < end; ++t)
+            {
+                const uint32_t *tri = &source[t * 3];
+                glm::vec3 n = TriangleNormal(vertices, tri);
+                float a = glm::length(n);
+                center += (vertices[tri[0]].Position + vertices[tri[1]].Position + vertices[tri[2]].Position) * (a / 3.0f);
+                normal += n;
+                area += a;
+            }
+
+            float key = 0.0f;
+            float normalLength = glm::length(normal);
+            if (area > 0.0f && normalLength > 0.0f)
+                key = glm::dot(center / area - meshCenter, normal / normalLength);
+
+            keys[c] = {key, uint32_t(c)};
+        }
+
+        // stable on the cluster index so equal keys keep a deterministic order
+        std::sort(keys.begin(), keys.end(), [](const ClusterKey &a, const ClusterKey &b)
+                  { return a.key > b.key || (a.key == b.key && a.cluster < b.cluster); });
+
+        size_t written = 0;
+        for (const auto &k : keys)
+        {
+            size_t start = clusters[k.cluster];
+            size_t end = k.cluster + 1 < clusters.size() ? clusters[k.cluster + 1] : triangleCount;
+            std::copy(source.begin() + start * 3, source.begin() + end * 3, destination + written);
+            written += (end - start) * 3;
+        }
+    }
+
+    size_t OptimizeVertexFetch(
+        Vertex *destination,
+        uint32_t *indices,
+        size_t indexCount,
+        const Vertex *vertices,
+        size_t vertexCount)
+    {
+        constexpr uint32_t UNUSED = 0xFFFFFFFFu;
+        std::vector<uint32_t> remap(vertexCount, UNUSED);
+
+        // tolerate destination == vertices
+        std::vector<Vertex> source(vertices, vertices + vertexCount);
+
+        uint32_t next = 0;
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            uint32_t &r = remap[indices[i]];
+            if (r == UNUSED)
+            {
+                r = next++;
+                destination[r] = source[indices[i]];
+            }
+            indices[i] = r;
+        }
+
+        return next;
+    }
+
+    void OptimizeSubmesh(CookedMesh::SubmeshData &submesh)
+    {
+        namespace MO = Config::MeshOptimization;
+
+        auto &vertices = submesh.vertices;
+        auto &indices = submesh.indices;
+        if (indices.size() < 3 || vertices.empty())
+            return;
+
+        CacheStats initial = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size(), MO::CACHE_SIZE);
+
+        OptimizeVertexCache(indices.data(), indices.data(), indices.size(), vertices.size(), MO::CACHE_SIZE);
+        CacheStats afterCache = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size(), MO::CACHE_SIZE);
+        LogStats("vertex cache", initial, afterCache);
+
+        OptimizeOverdraw(indices.data(), indices.data(), indices.size(), vertices.data(), vertices.size(),
+                         MO::CACHE_SIZE, MO::OVERDRAW_THRESHOLD);
+        CacheStats afterOverdraw = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size(), MO::CACHE_SIZE);
+        LogStats("overdraw", afterCache, afterOverdraw);
+
+        size_t vertexCount = OptimizeVertexFetch(vertices.data(), indices.data(), indices.size(), vertices.data(), vertices.size());
+        vertices.resize(vertexCount);
+        CacheStats afterFetch = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size(), MO::CACHE_SIZE);
+        LogStats("vertex fetch", afterOverdraw, afterFetch);
+    }
+
+    void OptimizeSubmeshes(std::vector<CookedMesh::SubmeshData> &submeshes, ThreadPool *pool)
+    {
+        auto run = [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                OptimizeSubmesh(submeshes[i]);
+        };
+
+        if (pool)
+            pool->ParallelFor(submeshes.size(), 1, run);
+        else
+            run(0, submeshes.size());
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "assets/CookedMesh.h"
+#include "rendering/Vertex.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// import-time reordering of index and vertex buffers
+// every step only permutes data, the set of triangles is never changed
+namespace MeshOptimizer
+{
+    // post-transform cache efficiency for a fifo cache of the given size
+    struct CacheStats
+    {
+        float acmr = 0.0f; // average cache misses per triangle, 0.5 is ideal on large grids
+        float atvr = 0.0f; // average transforms per referenced vertex, 1.0 is ideal
+    };
+
+    CacheStats AnalyzeVertexCache(
+        const uint32_t *indices,
+        size_t indexCount,
+        size_t vertexCount,
+        unsigned cacheSize);
+
+    // tipsify (sander et al. 2007): greedy fan walk that keeps recently used
+    // vertices in the cache
+    void OptimizeVertexCache(
+        uint32_t *destination,
+        const uint32_t *indices,
+        size_t indexCount,
+        size_t vertexCount,
+        unsigned cacheSize);
+
+    // splits the cache-optimized order into clusters and sorts them so outward
+    // facing clusters draw first. threshold bounds how much acmr may degrade
+    void OptimizeOverdraw(
+        uint32_t *destination,
+        const uint32_t *indices,
+        size_t indexCount,
+        const Vertex *vertices,
+        size_t vertexCount,
+        unsigned cacheSize,
+        float threshold);
+
+    // reorders vertices by first use and rewrites indices in place.
+    // unreferenced vertices are dropped, returns the new vertex count
+    size_t OptimizeVertexFetch(
+        Vertex *destination,
+        uint32_t *indices,
+        size_t indexCount,
+        const Vertex *vertices,
+        size_t vertexCount);
+
+    // runs all three steps in order on one submesh and logs the stats of each
+    void OptimizeSubmesh(CookedMesh::SubmeshData &submesh);
+
+    // one submesh per task. results are identical to running them serially
+    void OptimizeSubmeshes(std::vector<CookedMesh::SubmeshData> &submeshes, ThreadPool *pool);
+}
@@ -0,0 +1,450 @@
+#include "MeshProcessing.h"
+#include "core/ThreadPool.h"
+#include "cfg/Config.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // vertices, corners or faces per task
+    constexpr size_t GRAIN = 64 * 1024;
+
+    // vertices are partitioned by the top bits of their hash so each bucket
+    // can be searched by one task
+    constexpr unsigned BUCKET_BITS = 8;
+    constexpr size_t BUCKETS = size_t(1) << BUCKET_BITS;
+    constexpr uint64_t EMPTY_SLOT = UINT64_MAX;
+
+    // attributes two vertices must share to be grouped
+    enum Fields : uint32_t
+    {
+        POSITION = 1,
+        NORMAL = 2,
+        TEXCOORD = 4,
+        TANGENT = 8,
+        ALL_FIELDS = POSITION | NORMAL | TEXCOORD | TANGENT,
+    };
+
+    struct HashedVertex
+    {
+        uint64_t hash;
+        uint32_t vertex;
+    };
+
+    template <typename Fn>
+    void Run(ThreadPool *pool, size_t count, size_t grain, const Fn &fn)
+    {
+        if (pool)
+            pool->ParallelFor(count, grain, fn);
+        else
+            fn(0, count);
+    }
+
+    uint64_t Mix(uint64_t h, float f)
+    {
+        // -0 and +0 compare equal, so they have to hash alike
+        if (f == 0.0f)
+            f = 0.0f;
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        h = (h ^ bits) * 0x9E3779B97F4A7C15ull;
+        return h ^ (h >> 29);
+    }
+
+    uint64_t HashVertex(const Vertex &v, uint32_t fields)
+    {
+        uint64_t h = fields;
+        if (fields & POSITION)
+            h = Mix(Mix(Mix(h, v.Position.x), v.Position.y), v.Position.z);
+        if (fields & NORMAL)
+            h = Mix(Mix(Mix(h, v.Normal.x), v.Normal.y), v.Normal.z);
+        if (fields & TEXCOORD)
+            h = Mix(Mix(h, v.TexCoord.x), v.TexCoord.y);
+        if (fields & TANGENT)
+            h = Mix(Mix(Mix(h, v.Tangent.x), v.Tangent.y), v.Tangent.z);
+
+        // buckets come from the top bits and table slots from the bottom
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        return h ^ (h >> 33);
+    }
+
+    bool Equal(const Vertex &a, const Vertex &b, uint32_t fields)
+    {
+        return (!(fields & POSITION) || a.Position == b.Position) &&
+               (!(fields & NORMAL) || a.Normal == b.Normal) &&
+               (!(fields & TEXCOORD) || a.TexCoord == b.TexCoord) &&
+               (!(fields & TANGENT) || a.Tangent == b.Tangent);
+    }
+
+    // for every vertex the first vertex equal to it on fields, itself when
+    // none comes before it
+    UninitVector<uint32_t> FindFirstEqual(const Vertex *vertices, size_t count, uint32_t fields, ThreadPool *pool)
+    {
+        UninitVector<uint64_t> hashes(count);
+        Run(pool, count, GRAIN, [&](size_t begin, size_t end)
+            {
+                for (size_t v = begin; v < end; ++v)
+                    hashes[v] = HashVertex(vertices[v], fields); });
+
+        // stable partition into buckets: per chunk histograms, then every
+        // chunk scatters to its own range so vertices keep their order
+        const size_t chunkCount = (count + GRAIN - 1) / GRAIN;
+        std::vector<uint32_t> cursors(chunkCount * BUCKETS, 0);
+        auto bucketOf = [&](size_t v)
+        { return static_cast<size_t>(hashes[v] >> (64 - BUCKET_BITS)); };
+
+        Run(pool, chunkCount, 1, [&](size_t begin, size_t end)
+            {
+                for (size_t c = begin; c < end; ++c)
+                {
+                    uint32_t *histogram = &cursors[c * BUCKETS];
+                    for (size_t v = c * GRAIN; v < std::min(count, (c + 1) * GRAIN); ++v)
+                        histogram[bucketOf(v)]++;
+                } });
+
+        std::vector<uint32_t> bucketStart(BUCKETS + 1);
+        uint32_t total = 0;
+        for (size_t b = 0; b < BUCKETS; ++b)
+        {
+            bucketStart[b] = total;
+            for (size_t c = 0; c < chunkCount; ++c)
+            {
+                const uint32_t n = cursors[c * BUCKETS + b];
+                cursors[c * BUCKETS + b] = total;
+                total += n;
+            }
+        }
+        bucketStart[BUCKETS] = total;
+
+        // hashes travel with the indices so the search below reads them in order
+        UninitVector<HashedVertex> order(count);
+        Run(pool, chunkCount, 1, [&](size_t begin, size_t end)
+            {
+                for (size_t c = begin; c < end; ++c)
+                {
+                    uint32_t *cursor = &cursors[c * BUCKETS];
+                    for (size_t v = c * GRAIN; v < std::min(count, (c + 1) * GRAIN); ++v)
+                        order[cursor[bucketOf(v)]++] = {hashes[v], static_cast<uint32_t>(v)};
+                } });
+
+        // open addressing per bucket. vertices arrive in index order, so the
+        // one left in the table is always the first of its kind. slots hold
+        // part of the hash next to the index, vertices are only compared
+        // when that part matches
+        UninitVector<uint32_t> first(count);
+        Run(pool, BUCKETS, 1, [&](size_t begin, size_t end)
+            {
+                std::vector<uint64_t> table;
+                for (size_t b = begin; b < end; ++b)
+                {
+                    const size_t size = bucketStart[b + 1] - bucketStart[b];
+                    size_t capacity = 16;
+                    while (capacity < size * 2)
+                        capacity *= 2;
+                    table.assign(capacity, EMPTY_SLOT);
+
+                    for (size_t i = bucketStart[b]; i < bucketStart[b + 1]; ++i)
+                    {
+                        const HashedVertex &e = order[i];
+                        const uint64_t tag = e.hash & 0xFFFFFFFF00000000ull;
+                        size_t slot = e.hash & (capacity - 1);
+                        for (;;)
+                        {
+                            const uint64_t s = table[slot];
+                            if (s == EMPTY_SLOT)
+                            {
+                                table[slot] = tag | e.vertex;
+                                first[e.vertex] = e.vertex;
+                                break;
+                            }
+                            const uint32_t u = static_cast<uint32_t>(s);
+                            if ((s & 0xFFFFFFFF00000000ull) == tag && Equal(vertices[u], vertices[e.vertex], fields))
+                            {
+                                first[e.vertex] = u;
+                                break;
+                            }
+                            slot = (slot + 1) & (capacity - 1);
+                        }
+                    }
+                } });
+        return first;
+    }
+
+    // corners (face * 3 + k) around each group in compressed row form. lists
+    // are sorted so sums over them come out the same for any pool
+    struct CornerLists
+    {
+        UninitVector<uint32_t> offsets; // vertexCount + 1, empty rows for non-representatives
+        UninitVector<uint32_t> corners;
+    };
+
+    void BuildCornerLists(
+        const uint32_t *indices,
+        size_t indexCount,
+        const UninitVector<uint32_t> &group,
+        ThreadPool *pool,
+        CornerLists &out)
+    {
+        const size_t vertexCount = group.size();
+        std::unique_ptr<std::atomic<uint32_t>[]> cursors(new std::atomic<uint32_t>[vertexCount]);
+        Run(pool, vertexCount, GRAIN, [&](size_t begin, size_t end)
+            {
+                for (size_t v = begin; v < end; ++v)
+                    cursors[v].store(0, std::memory_order_relaxed); });
+        Run(pool, indexCount, GRAIN, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                    cursors[group[indices[i]]].fetch_add(1, std::memory_order_relaxed); });
+
+        out.offsets.resize(vertexCount + 1);
+        uint32_t total = 0;
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            out.offsets[v] = total;
+            const uint32_t n = cursors[v].load(std::memory_order_relaxed);
+            cursors[v].store(total, std::memory_order_relaxed);
+            total += n;
+        }
+        out.offsets[vertexCount] = total;
+
+        out.corners.resize(indexCount);
+        Run(pool, indexCount, GRAIN, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                    out.corners[cursors[group[indices[i]]].fetch_add(1, std::memory_order_relaxed)] = static_cast<uint32_t>(i); });
+        Run(pool, vertexCount, GRAIN, [&](size_t begin, size_t end)
+            {
+                for (size_t v = begin; v < end; ++v)
+                    std::sort(out.corners.begin() + out.offsets[v], out.corners.begin() + out.offsets[v + 1]); });
+    }
+
+    glm::vec3 SafeNormalize(const glm::vec3 &v)
+    {
+        const float length = glm::length(v);
+        return length > 0.0f ? v / length : glm::vec3(0.0f);
+    }
+
+    // the part of v in the plane of unit normal n
+    glm::vec3 Project(const glm::vec3 &v, const glm::vec3 &n)
+    {
+        return v - n * glm::dot(n, v);
+    }
+
+    // for vertices none of whose faces has uv area
+    glm::vec3 AnyPerpendicular(const glm::vec3 &n)
+    {
+        const glm::vec3 axis = std::abs(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        const glm::vec3 t = SafeNormalize(Project(axis, n));
+        return t == glm::vec3(0.0f) ? axis : t;
+    }
+
+    // every vertex takes the value its group representative computed
+    void CopyFromFirst(Vertex *vertices, const UninitVector<uint32_t> &first, glm::vec3 Vertex::*field, ThreadPool *pool)
+    {
+        Run(pool, first.size(), GRAIN, [&](size_t begin, size_t end)
+            {
+                for (size_t v = begin; v < end; ++v)
+                {
+                    if (first[v] != v)
+                        vertices[v].*field = vertices[first[v]].*field;
+                } });
+    }
+
+    // assimp computes tangents before our normals exist, and skips meshes
+    // without normals, so both have to come from the same side
+    constexpr bool NormalsWithTangents(uint32_t stages)
+    {
+        namespace MI = Config::MeshImport;
+        return !(stages & MI::NORMALS) || (stages & MI::TANGENTS);
+    }
+
+    constexpr bool OverridesNormalsWithTangents()
+    {
+        for (const auto &o : Config::MeshImport::OVERRIDES)
+        {
+            if (!NormalsWithTangents(o.parallelStages))
+                return false;
+        }
+        return true;
+    }
+    static_assert(NormalsWithTangents(Config::MeshImport::PARALLEL_STAGES) && OverridesNormalsWithTangents(),
+                  "MeshImport stages with NORMALS must include TANGENTS.");
+}
+
+namespace MeshProcessing
+{
+    uint32_t GetParallelStages(const AssetID &source)
+    {
+        namespace MI = Config::MeshImport;
+        uint32_t stages = MI::PARALLEL_STAGES;
+        const std::string path = source.lexically_normal().generic_string();
+        for (const auto &o : MI::OVERRIDES)
+        {
+            if (path == o.source)
+                stages = o.parallelStages;
+        }
+        return stages;
+    }
+
+    size_t WeldVertices(UninitVector<Vertex> &vertices, UninitVector<uint32_t> &indices, ThreadPool *pool)
+    {
+        const size_t count = vertices.size();
+        const UninitVector<uint32_t> first = FindFirstEqual(vertices.data(), count, ALL_FIELDS, pool);
+
+        // kept vertices are numbered in order: count per chunk, then a scan
+        const size_t chunkCount = (count + GRAIN - 1) / GRAIN;
+        std::vector<uint32_t> chunkStart(chunkCount + 1, 0);
+        Run(pool, chunkCount, 1, [&](size_t begin, size_t end)
+            {
+                for (size_t c = begin; c < end; ++c)
+                {
+                    uint32_t kept = 0;
+                    for (size_t v = c * GRAIN; v < std::min(count, (c + 1) * GRAIN); ++v)
+                        kept += first[v] == v;
+                    chunkStart[c + 1] = kept;
+                } });
+        for (size_t c = 0; c < chunkCount; ++c)
+            chunkStart[c + 1] += chunkStart[c];
+
+        UninitVector<uint32_t> remap(count);
+        Run(pool, chunkCount, 1, [&](size_t begin, size_t end)
+            {
+                for (size_t c = begin; c < end; ++c)
+                {
+                    uint32_t next = chunkStart[c];
+                    for (size_t v = c * GRAIN; v < std::min(count, (c + 1) * GRAIN); ++v)
+                    {
+                        if (first[v] == v)
+                            remap[v] = next++;
+                    }
+                } });
+
+        // duplicates point at an earlier vertex, which is numbered by now
+        UninitVector<Vertex> welded(chunkStart[chunkCount]);
+        Run(pool, count, GRAIN, [&](size_t begin, size_t end)
+            {
+                for (size_t v = begin; v < end; ++v)
+                {
+                    if (first[v] == v)
+                        welded[remap[v]] = vertices[v];
+                    else
+                        remap[v] = remap[first[v]];
+                } });
+        Run(pool, indices.size(), GRAIN, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                    indices[i] = remap[indices[i]]; });
+
+        vertices.swap(welded);
+        return vertices.size();
+    }
+
+    void GenerateNormals(
+        Vertex *vertices,
+        size_t vertexCount,
+        const uint32_t *indices,
+        size_t indexCount,
+        ThreadPool *pool)
+    {
+        const size_t faceCount = indexCount / 3;
+        UninitVector<glm::vec3> faceNormals(faceCount);
+        Run(pool, faceCount, GRAIN, [&](size_t begin, size_t end)
+            {
+                for (size_t f = begin; f < end; ++f)
+                {
+                    const uint32_t *tri = indices + f * 3;
+                    const glm::vec3 &p0 = vertices[tri[0]].Position;
+                    const glm::vec3 &p1 = vertices[tri[1]].Position;
+                    const glm::vec3 &p2 = vertices[tri[2]].Position;
+                    // clockwise, so the edges cross the other way round
+                    faceNormals[f] = SafeNormalize(glm::cross(p2 - p0, p1 - p0));
+                } });
+
+        const UninitVector<uint32_t> first = FindFirstEqual(vertices, vertexCount, POSITION, pool);
+        CornerLists lists;
+        BuildCornerLists(indices, indexCount, first, pool, lists);
+
+        Run(pool, vertexCount, GRAIN, [&](size_t begin, size_t end)
+            {
+                for (size_t v = begin; v < end; ++v)
+                {
+                    if (first[v] != v)
+                        continue;
+                    glm::vec3 sum(0.0f);
+                    for (uint32_t i = lists.offsets[v]; i < lists.offsets[v + 1]; ++i)
+                        sum += faceNormals[lists.corners[i] / 3];
+                    vertices[v].Normal = SafeNormalize(sum);
+                } });
+        CopyFromFirst(vertices, first, &Vertex::Normal, pool);
+    }
+
+    void GenerateTangents(
+        Vertex *vertices,
+        size_t vertexCount,
+        const uint32_t *indices,
+        size_t indexCount,
+        ThreadPool *pool)
+    {
+        // unit direction of increasing u over each face, zero for faces
+        // without uv area. the sign of the uv area undoes mirroring
+        const size_t faceCount = indexCount / 3;
+        UninitVector<glm::vec3> faceTangents(faceCount);
+        Run(pool, faceCount, GRAIN, [&](size_t begin, size_t end)
+            {
+                for (size_t f = begin; f < end; ++f)
+                {
+                    const uint32_t *tri = indices + f * 3;
+                    const Vertex &v0 = vertices[tri[0]];
+                    const glm::vec3 d1 = vertices[tri[1]].Position - v0.Position;
+                    const glm::vec3 d2 = vertices[tri[2]].Position - v0.Position;
+                    const glm::vec2 t1 = vertices[tri[1]].TexCoord - v0.TexCoord;
+                    const glm::vec2 t2 = vertices[tri[2]].TexCoord - v0.TexCoord;
+                    const float uvArea = t1.x * t2.y - t1.y * t2.x;
+                    const glm::vec3 tangent = SafeNormalize(t2.y * d1 - t1.y * d2);
+                    faceTangents[f] = uvArea > 0.0f ? tangent : uvArea < 0.0f ? -tangent : glm::vec3(0.0f);
+                } });
+
+        // mikktspace sums over corners of identical vertices, not just
+        // the same index, so it doesn't depend on welding first
+        const UninitVector<uint32_t> first = FindFirstEqual(vertices, vertexCount, POSITION | NORMAL | TEXCOORD, pool);
+        CornerLists lists;
+        BuildCornerLists(indices, indexCount, first, pool, lists);
+
+        Run(pool, vertexCount, GRAIN, [&](size_t begin, size_t end)
+            {
+                for (size_t v = begin; v < end; ++v)
+                {
+                    if (first[v] != v)
+                        continue;
+                    const glm::vec3 n = SafeNormalize(vertices[v].Normal);
+                    const glm::vec3 &p = vertices[v].Position;
+                    glm::vec3 sum(0.0f);
+                    for (uint32_t i = lists.offsets[v]; i < lists.offsets[v + 1]; ++i)
+                    {
+                        const uint32_t corner = lists.corners[i];
+                        const glm::vec3 t = SafeNormalize(Project(faceTangents[corner / 3], n));
+                        if (t == glm::vec3(0.0f))
+                            continue;
+
+                        // angle of the face at this corner, measured in the tangent plane
+                        const uint32_t *tri = indices + corner - corner % 3;
+                        const glm::vec3 &next = vertices[tri[(corner + 1) % 3]].Position;
+                        const glm::vec3 &prev = vertices[tri[(corner + 2) % 3]].Position;
+                        const glm::vec3 e1 = SafeNormalize(Project(next - p, n));
+                        const glm::vec3 e2 = SafeNormalize(Project(prev - p, n));
+                        const float angle = std::acos(std::clamp(glm::dot(e1, e2), -1.0f, 1.0f));
+                        sum += t * angle;
+                    }
+                    const glm::vec3 tangent = SafeNormalize(sum);
+                    vertices[v].Tangent = tangent == glm::vec3(0.0f) ? AnyPerpendicular(n) : tangent;
+                } });
+        CopyFromFirst(vertices, first, &Vertex::Tangent, pool);
+    }
+}
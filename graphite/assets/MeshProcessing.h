@@ -0,0 +1,43 @@
+#pragma once
+
+#include "core/CommonTypes.h"
+#include "rendering/Vertex.h"
+#include "utils/DefaultInitAllocator.h"
+#include <cstddef>
+#include <cstdint>
+
+class ThreadPool;
+
+// parallel replacements for assimp's JoinIdenticalVertices, GenSmoothNormals
+// and CalcTangentSpace, which run on one thread and dominate the import of
+// large scans. every step gives the same result with or without a pool
+namespace MeshProcessing
+{
+    // Config::MeshImport::PARALLEL_STAGES, or the override for source
+    uint32_t GetParallelStages(const AssetID &source);
+
+    // merges vertices whose attributes are bit identical (-0 equals +0) and
+    // rewrites indices. the first occurrence of each vertex is kept and the
+    // order is preserved, like assimp. returns the new vertex count
+    size_t WeldVertices(UninitVector<Vertex> &vertices, UninitVector<uint32_t> &indices, ThreadPool *pool = nullptr);
+
+    // sum of the unit face normals around every vertex position, as
+    // GenSmoothNormals does. indices wind clockwise (flipped for d3d)
+    void GenerateNormals(
+        Vertex *vertices,
+        size_t vertexCount,
+        const uint32_t *indices,
+        size_t indexCount,
+        ThreadPool *pool = nullptr);
+
+    // mikktspace style: the uv gradient of each face projected onto the vertex
+    // normal, weighted by the corner angle and summed over corners that share
+    // position, normal and uv. Vertex has no bitangent sign, so mirrored faces
+    // meeting at one vertex are summed together instead of split
+    void GenerateTangents(
+        Vertex *vertices,
+        size_t vertexCount,
+        const uint32_t *indices,
+        size_t indexCount,
+        ThreadPool *pool = nullptr);
+}
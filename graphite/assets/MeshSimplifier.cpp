@@ -0,0 +1,659 @@
+#include "MeshSimplifier.h"
+#include "assets/MeshOptimizer.h"
+#include "core/ThreadPool.h"
+#include "utils/Logger.h"
+#include "cfg/Config.h"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace
+{
+    // open edge markers
+    constexpr uint32_t NONE = ~0u;
+    constexpr uint32_t MULTIPLE = ~0u - 1;
+
+    // planes that pin borders and seams, relative to triangle planes
+    constexpr double EDGE_WEIGHT = 10.0;
+
+    // attribute terms of the collapse cost, positions are normalized to a unit box
+    constexpr float NORMAL_WEIGHT = 1e-3f;
+    constexpr float UV_WEIGHT = 1e-3f;
+
+    enum class VertexKind : uint8_t
+    {
+        Manifold, // interior, collapses onto any neighbour
+        Border,   // on an open edge, collapses along it
+        Seam,     // two wedges on a uv/normal seam, both collapse along it together
+        Locked    // anything more complex, never moves
+    };
+
+    struct Quadric
+    {
+        double a00 = 0, a11 = 0, a22 = 0, a01 = 0, a02 = 0, a12 = 0;
+        double b0 = 0, b1 = 0, b2 = 0, c = 0;
+        double weight = 0;
+
+        // plane n.p + d = 0 with unit n
+        void AddPlane(const glm::dvec3 &n, double d, double w)
+        {
+            a00 += w * n.x * n.x;
+            a11 += w * n.y * n.y;
+            a22 += w * n.z * n.z;
+            a01 += w * n.x * n.y;
+            a02 += w * n.x * n.z;
+            a12 += w * n.y * n.z;
+            b0 += w * n.x * d;
+            b1 += w * n.y * d;
+            b2 += w * n.z * d;
+            c += w * d * d;
+            weight += w;
+        }
+
+        void Add(const Quadric &o)
+        {
+            a00 += o.a00;
+            a11 += o.a11;
+            a22 += o.a22;
+            a01 += o.a01;
+            a02 += o.a02;
+            a12 += o.a12;
+            b0 += o.b0;
+            b1 += o.b1;
+            b2 += o.b2;
+            c += o.c;
+            weight += o.weight;
+        }
+
+        // weighted mean squared distance to the accumulated planes
+        double Error(const glm::vec3 &p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            double r = a00 * x * x + a11 * y * y + a22 * z * z +
+                       2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                       2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            return weight > 0.0 ? std::max(r, 0.0) / weight : 0.0;
+        }
+    };
+
+    struct PositionKey
+    {
+        uint32_t x, y, z;
+        bool operator==(const PositionKey &o) const { return x == o.x && y == o.y && z == o.z; }
+    };
+
+    struct PositionKeyHash
+    {
+        size_t operator()(const PositionKey &k) const
+        {
+            // fnv-1a over the three words
+            uint64_t h = 1469598103934665603ull;
+            for (uint32_t w : {k.x, k.y, k.z})
+            {
+                h ^= w;
+                h *= 1099511628211ull;
+            }
+            return static_cast<size_t>(h);
+        }
+    };
+
+    struct Collapse
+    {
+        uint32_t v;
+        uint32_t t;
+        float cost;
+        float error; // squared, normalized units
+    };
+
+    struct SimplifierState
+    {
+        const Vertex *vertices = nullptr;
+        size_t vertexCount = 0;
+
+        std::vector<glm::vec3> positions; // normalized to the unit box
+        float extent = 1.0f;              // normalized -> object space
+
+        std::vector<uint32_t> remap;   // first vertex with the same position
+        std::vector<uint32_t> wedge;   // circular list of vertices sharing a position
+        std::vector<uint32_t> openOut; // next vertex along an open edge
+        std::vector<uint32_t> openIn;  // previous vertex along an open edge
+        std::vector<VertexKind> kind;
+        std::vector<Quadric> quadrics; // by remap[v]
+
+        // vertex -> triangle fans of the current pass
+        std::vector<uint32_t> fanOffsets;
+        std::vector<uint32_t> fanTriangles;
+    };
+
+    void NormalizePositions(SimplifierState &s)
+    {
+        glm::vec3 minP(std::numeric_limits<float>::max());
+        glm::vec3 maxP(std::numeric_limits<float>::lowest());
+        for (size_t i = 0; i < s.vertexCount; ++i)
+        {
+            minP = glm::min(minP, s.vertices[i].Position);
+            maxP = glm::max(maxP, s.vertices[i].Position);
+        }
+
+        glm::vec3 size = maxP - minP;
+        s.extent = std::max(std::max(size.x, size.y), std::max(size.z, 1e-20f));
+        float inv = 1.0f / s.extent;
+
+        s.positions.resize(s.vertexCount);
+        for (size_t i = 0; i < s.vertexCount; ++i)
+            s.positions[i] = (s.vertices[i].Position - minP) * inv;
+    }
+
+    void BuildPositionRemap(SimplifierState &s)
+    {
+        s.remap.resize(s.vertexCount);
+        s.wedge.resize(s.vertexCount);
+
+        std::unordered_map<PositionKey, uint32_t, PositionKeyHash> firstByPosition;
+        firstByPosition.reserve(s.vertexCount);
+        for (uint32_t i = 0; i < s.vertexCount; ++i)
+        {
+            // + 0.0f folds -0 into +0 so both hash the same
+            glm::vec3 p = s.vertices[i].Position + glm::vec3(0.0f);
+            PositionKey key;
+            std::memcpy(&key, &p, sizeof(key));
+            auto [it, inserted] = firstByPosition.emplace(key, i);
+            s.remap[i] = it->second;
+
+            // splice into the canonical vertex's wedge list
+            s.wedge[i] = i;
+            if (!inserted)
+            {
+                uint32_t r = it->second;
+                s.wedge[i] = s.wedge[r];
+                s.wedge[r] = i;
+            }
+        }
+    }
+
+    bool HasEdge(const std::vector<uint32_t> &offsets, const std::vector<uint32_t> &targets, uint32_t a, uint32_t b)
+    {
+        for (uint32_t i = offsets[a]; i < offsets[a + 1]; ++i)
+        {
+            if (targets[i] == b)
+                return true;
+        }
+        return false;
+    }
+
+    // finds open edges (no opposite half-edge between the same two vertices),
+    // classifies every vertex and accumulates the initial quadrics
+    void ClassifyAndBuildQuadrics(SimplifierState &s, const uint32_t *indices, size_t indexCount)
+    {
+        // outgoing half-edges per vertex
+        std::vector<uint32_t> offsets(s.vertexCount + 1, 0);
+        for (size_t i = 0; i < indexCount; ++i)
+            offsets[indices[i] + 1]++;
+        for (size_t v = 0; v < s.vertexCount; ++v)
+            offsets[v + 1] += offsets[v];
+
+        std::vector<uint32_t> targets(indexCount);
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indexCount; i += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                uint32_t a = indices[i + k];
+                uint32_t b = indices[i + (k + 1) % 3];
+                targets[cursor[a]++] = b;
+            }
+        }
+
+        s.openOut.assign(s.vertexCount, NONE);
+        s.openIn.assign(s.vertexCount, NONE);
+        s.quadrics.assign(s.vertexCount, Quadric{});
+
+        for (size_t i = 0; i < indexCount; i += 3)
+        {
+            const uint32_t tri[3] = {indices[i], indices[i + 1], indices[i + 2]};
+            glm::dvec3 p0(s.positions[tri[0]]), p1(s.positions[tri[1]]), p2(s.positions[tri[2]]);
+            glm::dvec3 cross = glm::cross(p1 - p0, p2 - p0);
+            double length = glm::length(cross);
+
+            if (length > 0.0)
+            {
+                // weighted by area
+                glm::dvec3 n = cross / length;
+                double d = -glm::dot(n, p0);
+                for (uint32_t v : tri)
+                    s.quadrics[s.remap[v]].AddPlane(n, d, length * 0.5);
+            }
+
+            for (int k = 0; k < 3; ++k)
+            {
+                uint32_t a = tri[k];
+                uint32_t b = tri[(k + 1) % 3];
+                if (HasEdge(offsets, targets, b, a))
+                    continue;
+
+                s.openOut[a] = s.openOut[a] == NONE ? b : MULTIPLE;
+                s.openIn[b] = s.openIn[b] == NONE ? a : MULTIPLE;
+
+                // plane through the edge, perpendicular to the triangle
+                if (length > 0.0)
+                {
+                    glm::dvec3 pa(s.positions[a]), pb(s.positions[b]);
+                    glm::dvec3 edge = pb - pa;
+                    glm::dvec3 n = glm::cross(edge, cross / length);
+                    double nl = glm::length(n);
+                    if (nl > 0.0)
+                    {
+                        n /= nl;
+                        double d = -glm::dot(n, pa);
+                        double w = glm::dot(edge, edge) * EDGE_WEIGHT;
+                        s.quadrics[s.remap[a]].AddPlane(n, d, w);
+                        s.quadrics[s.remap[b]].AddPlane(n, d, w);
+                    }
+                }
+            }
+        }
+
+        auto single = [](uint32_t v)
+        { return v < MULTIPLE; };
+
+        s.kind.assign(s.vertexCount, VertexKind::Locked);
+        for (uint32_t v = 0; v < s.vertexCount; ++v)
+        {
+            if (s.remap[v] != v)
+                continue;
+
+            VertexKind k = VertexKind::Locked;
+            uint32_t w = s.wedge[v];
+            if (w == v)
+            {
+                if (s.openOut[v] == NONE && s.openIn[v] == NONE)
+                    k = VertexKind::Manifold;
+                else if (single(s.openOut[v]) && single(s.openIn[v]))
+                    k = VertexKind::Border;
+            }
+            else if (s.wedge[w] == v)
+            {
+                // the open edges of both wedges must be the two sides of one seam
+                if (single(s.openOut[v]) && single(s.openIn[v]) &&
+                    single(s.openOut[w]) && single(s.openIn[w]) &&
+                    s.remap[s.openOut[v]] == s.remap[s.openIn[w]] &&
+                    s.remap[s.openIn[v]] == s.remap[s.openOut[w]])
+                    k = VertexKind::Seam;
+            }
+
+            uint32_t i = v;
+            do
+            {
+                s.kind[i] = k;
+                i = s.wedge[i];
+            } while (i != v);
+        }
+    }
+
+    void BuildFans(SimplifierState &s, const uint32_t *indices, size_t indexCount)
+    {
+        s.fanOffsets.assign(s.vertexCount + 1, 0);
+        for (size_t i = 0; i < indexCount; ++i)
+            s.fanOffsets[indices[i] + 1]++;
+        for (size_t v = 0; v < s.vertexCount; ++v)
+            s.fanOffsets[v + 1] += s.fanOffsets[v];
+
+        s.fanTriangles.resize(indexCount);
+        std::vector<uint32_t> cursor(s.fanOffsets.begin(), s.fanOffsets.end() - 1);
+        for (size_t i = 0; i < indexCount; ++i)
+            s.fanTriangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    // wedge of t that v's seam partner collapses onto, NONE if the seam doesn't line up
+    uint32_t SeamPartnerTarget(const SimplifierState &s, uint32_t v, uint32_t t)
+    {
+        uint32_t partner = s.wedge[v];
+        uint32_t target = s.openOut[v] == t ? s.openIn[partner] : s.openOut[partner];
+        return (target < MULTIPLE && s.remap[target] == s.remap[t]) ? target : NONE;
+    }
+
+    bool CanCollapse(const SimplifierState &s, uint32_t v, uint32_t t)
+    {
+        if (s.remap[v] == s.remap[t])
+            return false;
+
+        switch (s.kind[v])
+        {
+        case VertexKind::Manifold:
+            return true;
+        case VertexKind::Border:
+            return s.openOut[v] == t || s.openIn[v] == t;
+        case VertexKind::Seam:
+            return (s.openOut[v] == t || s.openIn[v] == t) && SeamPartnerTarget(s, v, t) != NONE;
+        default:
+            return false;
+        }
+    }
+
+    float AttributeCost(const SimplifierState &s, uint32_t v, uint32_t t)
+    {
+        const Vertex &a = s.vertices[v];
+        const Vertex &b = s.vertices[t];
+        glm::vec3 dn = a.Normal - b.Normal;
+        glm::vec2 duv = a.TexCoord - b.TexCoord;
+        return NORMAL_WEIGHT * glm::dot(dn, dn) + UV_WEIGHT * glm::dot(duv, duv);
+    }
+
+    Collapse EvaluateCollapse(const SimplifierState &s, uint32_t v, uint32_t t)
+    {
+        Collapse c;
+        c.v = v;
+        c.t = t;
+        c.error = static_cast<float>(s.quadrics[s.remap[v]].Error(s.positions[t]));
+        c.cost = c.error + AttributeCost(s, v, t);
+        if (s.kind[v] == VertexKind::Seam)
+            c.cost += AttributeCost(s, s.wedge[v], SeamPartnerTarget(s, v, t));
+        return c;
+    }
+
+    // true if moving v onto t turns any of v's remaining triangles over
+    bool HasFlips(
+        const SimplifierState &s,
+        const uint32_t *indices,
+        const std::vector<uint32_t> &collapseRemap,
+        uint32_t v,
+        uint32_t t)
+    {
+        const glm::vec3 &target = s.positions[t];
+        for (uint32_t f = s.fanOffsets[v]; f < s.fanOffsets[v + 1]; ++f)
+        {
+            const uint32_t *tri = indices + size_t(s.fanTriangles[f]) * 3;
+            uint32_t c[3] = {collapseRemap[tri[0]], collapseRemap[tri[1]], collapseRemap[tri[2]]};
+
+            // triangles on the collapsed edge disappear
+            if (s.remap[c[0]] == s.remap[t] || s.remap[c[1]] == s.remap[t] || s.remap[c[2]] == s.remap[t])
+                continue;
+
+            glm::vec3 p[3] = {s.positions[c[0]], s.positions[c[1]], s.positions[c[2]]};
+            glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            for (int k = 0; k < 3; ++k)
+            {
+                if (c[k] == v)
+                    p[k] = target;
+            }
+            glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+
+            if (glm::dot(before, after) <= 0.0f)
+                return true;
+        }
+        return false;
+    }
+
+    void PickCollapses(
+        const SimplifierState &s,
+        const uint32_t *indices,
+        size_t indexCount,
+        std::vector<Collapse> &outCollapses)
+    {
+        outCollapses.clear();
+        for (size_t i = 0; i < indexCount; i += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                uint32_t a = indices[i + k];
+                uint32_t b = indices[i + (k + 1) % 3];
+
+                // interior edges show up in two triangles, keep the one with a < b.
+                // open edges have no twin and are always kept
+                if (a > b && s.openOut[a] != b && s.openIn[b] != a)
+                    continue;
+
+                bool ab = CanCollapse(s, a, b);
+                bool ba = CanCollapse(s, b, a);
+                if (!ab && !ba)
+                    continue;
+
+                // only the cheaper direction is worth considering
+                if (ab && ba)
+                {
+                    Collapse c0 = EvaluateCollapse(s, a, b);
+                    Collapse c1 = EvaluateCollapse(s, b, a);
+                    outCollapses.push_back(c0.cost <= c1.cost ? c0 : c1);
+                }
+                else
+                {
+                    outCollapses.push_back(ab ? EvaluateCollapse(s, a, b) : EvaluateCollapse(s, b, a));
+                }
+            }
+        }
+
+        std::sort(outCollapses.begin(), outCollapses.end(), [](const Collapse &x, const Collapse &y)
+                  { return x.cost < y.cost || (x.cost == y.cost && (x.v < y.v || (x.v == y.v && x.t < y.t))); });
+    }
+
+    // keeps open edge links pointing at live vertices after a pass
+    void RemapOpenEdges(std::vector<uint32_t> &links, const std::vector<uint32_t> &collapseRemap)
+    {
+        std::vector<uint32_t> old = links;
+        for (uint32_t i = 0; i < links.size(); ++i)
+        {
+            uint32_t j = old[i];
+            if (j >= MULTIPLE)
+                continue;
+
+            uint32_t r = collapseRemap[j];
+            if (r != i)
+                links[i] = r;
+            else
+                links[i] = old[j] < MULTIPLE ? collapseRemap[old[j]] : old[j]; // j merged into i, skip over it
+        }
+    }
+
+    // drops triangles that collapsed, returns the new index count
+    size_t ApplyCollapses(
+        const SimplifierState &s,
+        uint32_t *indices,
+        size_t indexCount,
+        const std::vector<uint32_t> &collapseRemap)
+    {
+        size_t write = 0;
+        for (size_t i = 0; i < indexCount; i += 3)
+        {
+            uint32_t a = collapseRemap[indices[i]];
+            uint32_t b = collapseRemap[indices[i + 1]];
+            uint32_t c = collapseRemap[indices[i + 2]];
+            uint32_t ra = s.remap[a], rb = s.remap[b], rc = s.remap[c];
+            if (ra == rb || rb == rc || ra == rc)
+                continue;
+
+            indices[write++] = a;
+            indices[write++] = b;
+            indices[write++] = c;
+        }
+        return write;
+    }
+
+    double ElapsedMs(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+namespace MeshSimplifier
+{
+    size_t Simplify(
+        uint32_t *destination,
+        const uint32_t *indices,
+        size_t indexCount,
+        const Vertex *vertices,
+        size_t vertexCount,
+        size_t targetIndexCount,
+        float maxError,
+        float *outError)
+    {
+        if (destination != indices)
+            std::memmove(destination, indices, indexCount * sizeof(uint32_t));
+
+        if (outError)
+            *outError = 0.0f;
+        if (indexCount == 0 || vertexCount == 0)
+            return indexCount;
+
+        SimplifierState s;
+        s.vertices = vertices;
+        s.vertexCount = vertexCount;
+        NormalizePositions(s);
+        BuildPositionRemap(s);
+        ClassifyAndBuildQuadrics(s, destination, indexCount);
+
+        const float maxErrorSq = (maxError / s.extent) * (maxError / s.extent);
+        float reachedSq = 0.0f;
+
+        std::vector<Collapse> collapses;
+        std::vector<uint32_t> collapseRemap(vertexCount);
+        std::vector<uint8_t> locked(vertexCount);
+
+        while (indexCount > targetIndexCount)
+        {
+            BuildFans(s, destination, indexCount);
+            PickCollapses(s, destination, indexCount, collapses);
+            if (collapses.empty())
+                break;
+
+            for (uint32_t i = 0; i < vertexCount; ++i)
+                collapseRemap[i] = i;
+            std::fill(locked.begin(), locked.end(), uint8_t(0));
+
+            // each collapse removes about two triangles
+            size_t triangleGoal = (indexCount - targetIndexCount) / 3;
+            size_t collapseGoal = std::max<size_t>(1, triangleGoal / 2);
+            size_t applied = 0;
+
+            for (const auto &c : collapses)
+            {
+                if (applied >= collapseGoal)
+                    break;
+                if (c.error > maxErrorSq)
+                    continue;
+
+                uint32_t rv = s.remap[c.v];
+                uint32_t rt = s.remap[c.t];
+                if (locked[rv] || locked[rt])
+                    continue;
+
+                bool seam = s.kind[c.v] == VertexKind::Seam;
+                uint32_t partner = seam ? s.wedge[c.v] : NONE;
+                uint32_t partnerTarget = seam ? SeamPartnerTarget(s, c.v, c.t) : NONE;
+
+                if (HasFlips(s, destination, collapseRemap, c.v, c.t) ||
+                    (seam && HasFlips(s, destination, collapseRemap, partner, partnerTarget)))
+                    continue;
+
+                collapseRemap[c.v] = c.t;
+                if (seam)
+                    collapseRemap[partner] = partnerTarget;
+
+                s.quadrics[rt].Add(s.quadrics[rv]);
+                locked[rv] = 1;
+                locked[rt] = 1;
+                reachedSq = std::max(reachedSq, c.error);
+                ++applied;
+            }
+
+            if (applied == 0)
+                break;
+
+            indexCount = ApplyCollapses(s, destination, indexCount, collapseRemap);
+            RemapOpenEdges(s.openOut, collapseRemap);
+            RemapOpenEdges(s.openIn, collapseRemap);
+        }
+
+        if (outError)
+            *outError = std::sqrt(reachedSq) * s.extent;
+        return indexCount;
+    }
+
+    void GenerateLods(CookedMesh::SubmeshData &submesh)
+    {
+        namespace LodCfg = Config::Lod;
+
+        auto &indices = submesh.indices;
+        const size_t baseCount = indices.size();
+        submesh.lods.clear();
+        submesh.lods.push_back({0, static_cast<uint32_t>(baseCount), 0.0f, 0});
+
+        if (baseCount == 0 || submesh.vertices.empty())
+            return;
+
+        auto start = std::chrono::steady_clock::now();
+
+        glm::vec3 minP(std::numeric_limits<float>::max());
+        glm::vec3 maxP(std::numeric_limits<float>::lowest());
+        for (const auto &v : submesh.vertices)
+        {
+            minP = glm::min(minP, v.Position);
+            maxP = glm::max(maxP, v.Position);
+        }
+        const float maxError = glm::length(maxP - minP) * LodCfg::MAX_RELATIVE_ERROR;
+
+        std::vector<uint32_t> level(indices.begin(), indices.end());
+        std::vector<uint32_t> optimized;
+        float error = 0.0f;
+
+        while (submesh.lods.size() < LodCfg::MAX_LEVELS)
+        {
+            size_t previousCount = level.size();
+            size_t target = size_t(float(previousCount / 3) * LodCfg::REDUCTION_PER_LEVEL) * 3;
+            if (target < size_t(LodCfg::MIN_TRIANGLES) * 3)
+                break;
+
+            // each level starts from the previous one, so its error adds on top
+            float levelError = 0.0f;
+            size_t count = Simplify(
+                level.data(),
+                level.data(),
+                level.size(),
+                submesh.vertices.data(),
+                submesh.vertices.size(),
+                target,
+                maxError - error,
+                &levelError);
+
+            // not worth a level if the simplifier got stuck on locked geometry
+            if (count == 0 || float(count) > float(previousCount) * LodCfg::MIN_LEVEL_REDUCTION)
+                break;
+
+            level.resize(count);
+            error += levelError;
+
+            optimized.resize(count);
+            MeshOptimizer::OptimizeVertexCache(optimized.data(), level.data(), count, submesh.vertices.size(), Config::MeshOptimization::CACHE_SIZE);
+
+            CookedMesh::LodLevel lod{};
+            lod.indexOffset = static_cast<uint32_t>(indices.size());
+            lod.indexCount = static_cast<uint32_t>(count);
+            lod.error = error;
+            submesh.lods.push_back(lod);
+            indices.insert(indices.end(), optimized.begin(), optimized.end());
+        }
+
+        LOG_DEBUG("MeshSimplifier: {} levels from {} triangles in {:.2f} ms",
+                  submesh.lods.size(), baseCount / 3, ElapsedMs(start));
+        for (size_t i = 1; i < submesh.lods.size(); ++i)
+            LOG_DEBUG("  lod {}: {} triangles, error {:.5f}", i, submesh.lods[i].indexCount / 3, submesh.lods[i].error);
+    }
+
+    void GenerateLods(std::vector<CookedMesh::SubmeshData> &submeshes, ThreadPool *pool)
+    {
+        auto run = [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                GenerateLods(submeshes[i]);
+        };
+
+        if (pool)
+            pool->ParallelFor(submeshes.size(), 1, run);
+        else
+            run(0, submeshes.size());
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "assets/CookedMesh.h"
+#include "rendering/Vertex.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// quadric error metric edge collapse (garland & heckbert 1997) for lod generation.
+// a collapse always moves a vertex onto an existing neighbour, so every level
+// indexes the same vertex buffer. mesh borders and uv seams only collapse
+// along themselves, which keeps them in place
+namespace MeshSimplifier
+{
+    // writes the simplified index buffer to destination (at least indexCount
+    // long, may alias indices) and returns its length. stops at
+    // targetIndexCount or once every remaining collapse would move the surface
+    // further than maxError (object space). outError receives the error reached
+    size_t Simplify(
+        uint32_t *destination,
+        const uint32_t *indices,
+        size_t indexCount,
+        const Vertex *vertices,
+        size_t vertexCount,
+        size_t targetIndexCount,
+        float maxError,
+        float *outError = nullptr);
+
+    // appends coarser levels after the existing indices, which become level 0,
+    // and fills submesh.lods. levels are cache optimized
+    void GenerateLods(CookedMesh::SubmeshData &submesh);
+
+    // one submesh per task
+    void GenerateLods(std::vector<CookedMesh::SubmeshData> &submeshes, ThreadPool *pool);
+}
@@ -0,0 +1,161 @@
+#include "MeshletBuilder.h"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    // cones wider than this (min dot of a normal with the axis) never cull anything
+    constexpr float MIN_CONE_DOT = 0.1f;
+
+    constexpr size_t SIMD_PADDING = 8;
+
+    void ComputeBounds(
+        const CookedMesh::SubmeshView &submesh,
+        const Meshlet &meshlet,
+        std::vector<glm::vec3> &normals,
+        MeshletBounds &b)
+    {
+        const uint32_t *indices = submesh.indices + meshlet.indexOffset;
+        const Vertex *vertices = submesh.vertices;
+
+        // sphere around the box center
+        glm::vec3 minP(std::numeric_limits<float>::max());
+        glm::vec3 maxP(std::numeric_limits<float>::lowest());
+        for (uint32_t i = 0; i < meshlet.indexCount; ++i)
+        {
+            minP = glm::min(minP, vertices[indices[i]].Position);
+            maxP = glm::max(maxP, vertices[indices[i]].Position);
+        }
+        glm::vec3 center = (minP + maxP) * 0.5f;
+        float radiusSq = 0.0f;
+        for (uint32_t i = 0; i < meshlet.indexCount; ++i)
+        {
+            glm::vec3 d = vertices[indices[i]].Position - center;
+            radiusSq = std::max(radiusSq, glm::dot(d, d));
+        }
+
+        // face normals, oriented by the vertex normals so the cone doesn't
+        // depend on the winding convention
+        normals.clear();
+        glm::vec3 axis(0.0f);
+        for (uint32_t i = 0; i + 2 < meshlet.indexCount; i += 3)
+        {
+            const Vertex &v0 = vertices[indices[i]];
+            const Vertex &v1 = vertices[indices[i + 1]];
+            const Vertex &v2 = vertices[indices[i + 2]];
+            glm::vec3 n = glm::cross(v1.Position - v0.Position, v2.Position - v0.Position);
+            float length = glm::length(n);
+            if (length <= 0.0f)
+                continue;
+
+            n = n / length;
+            if (glm::dot(n, v0.Normal + v1.Normal + v2.Normal) < 0.0f)
+                n = -n;
+
+            normals.push_back(n);
+            axis += n;
+        }
+
+        float cutoff = 1.0f;
+        float axisLength = glm::length(axis);
+        if (!normals.empty() && axisLength > 0.0f)
+        {
+            axis = axis / axisLength;
+            float minDot = 1.0f;
+            for (const auto &n : normals)
+                minDot = std::min(minDot, glm::dot(axis, n));
+
+            if (minDot > MIN_CONE_DOT)
+                cutoff = std::sqrt(1.0f - minDot * minDot);
+        }
+        else
+        {
+            axis = glm::vec3(0.0f, 0.0f, 1.0f);
+        }
+
+        b.centerX.push_back(center.x);
+        b.centerY.push_back(center.y);
+        b.centerZ.push_back(center.z);
+        b.radius.push_back(std::sqrt(radiusSq));
+        b.axisX.push_back(axis.x);
+        b.axisY.push_back(axis.y);
+        b.axisZ.push_back(axis.z);
+        b.cutoff.push_back(cutoff);
+    }
+
+    void PadBounds(MeshletBounds &b)
+    {
+        for (auto *v : {&b.centerX, &b.centerY, &b.centerZ, &b.radius, &b.axisX, &b.axisY, &b.axisZ})
+            v->resize(v->size() + SIMD_PADDING, 0.0f);
+        b.cutoff.resize(b.cutoff.size() + SIMD_PADDING, 1.0f);
+    }
+}
+
+namespace MeshletBuilder
+{
+    void Build(
+        const CookedMesh::SubmeshView &submesh,
+        size_t maxVertices,
+        size_t maxTriangles,
+        MeshletData &outData)
+    {
+        outData = MeshletData{};
+        outData.lodRanges.resize(submesh.lodCount);
+
+        // marks which meshlet last used a vertex, avoids clearing a set per meshlet
+        std::vector<uint32_t> lastMeshlet(submesh.vertexCount, std::numeric_limits<uint32_t>::max());
+
+        for (uint32_t l = 0; l < submesh.lodCount; ++l)
+        {
+            const auto &lod = submesh.lods[l];
+            auto &range = outData.lodRanges[l];
+            range.first = static_cast<uint32_t>(outData.meshlets.size());
+
+            Meshlet current{lod.indexOffset, 0};
+            size_t vertexCount = 0;
+            uint32_t id = static_cast<uint32_t>(outData.meshlets.size());
+
+            for (uint32_t i = 0; i + 2 < lod.indexCount; i += 3)
+            {
+                const uint32_t *tri = submesh.indices + lod.indexOffset + i;
+                size_t added = 0;
+                for (int k = 0; k < 3; ++k)
+                    added += lastMeshlet[tri[k]] != id ? 1 : 0;
+
+                if (current.indexCount > 0 &&
+                    (vertexCount + added > maxVertices || current.indexCount / 3 + 1 > maxTriangles))
+                {
+                    outData.meshlets.push_back(current);
+                    current = Meshlet{lod.indexOffset + i, 0};
+                    vertexCount = 0;
+                    ++id;
+                }
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    if (lastMeshlet[tri[k]] != id)
+                    {
+                        lastMeshlet[tri[k]] = id;
+                        ++vertexCount;
+                    }
+                }
+                current.indexCount += 3;
+            }
+
+            if (current.indexCount > 0)
+                outData.meshlets.push_back(current);
+
+            range.count = static_cast<uint32_t>(outData.meshlets.size()) - range.first;
+        }
+
+        std::vector<glm::vec3> normals;
+        normals.reserve(maxTriangles);
+        for (const auto &m : outData.meshlets)
+            ComputeBounds(submesh, m, normals, outData.bounds);
+        PadBounds(outData.bounds);
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "assets/CookedMesh.h"
+#include "rendering/Meshlet.h"
+#include <cstddef>
+#include <cstdint>
+
+// splits each lod of a submesh into meshlets. triangles keep their order, so
+// the index buffer is used as is and every meshlet is a contiguous range of it
+namespace MeshletBuilder
+{
+    void Build(
+        const CookedMesh::SubmeshView &submesh,
+        size_t maxVertices,
+        size_t maxTriangles,
+        MeshletData &outData);
+}
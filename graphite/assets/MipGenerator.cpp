@@ -0,0 +1,388 @@
+#include "MipGenerator.h"
+#include "core/ThreadPool.h"
+#include "utils/Simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+    // destination rows per pool task
+    constexpr size_t ROWS_PER_TASK = 8;
+
+    // kaiser window: support in destination pixels and shape
+    constexpr float KAISER_RADIUS = 2.0f;
+    constexpr float KAISER_ALPHA = 4.0f;
+
+    // srgb lookups. decoding has 256 rgb entries followed by 256 linear alpha
+    // entries, so one gather handles a whole pixel. encoding is indexed by
+    // sqrt(linear), which spreads the entries evenly over the srgb curve
+    constexpr int ENCODE_ENTRIES = 4096;
+
+    struct SrgbTables
+    {
+        float toLinear[512];
+        int32_t fromLinear[ENCODE_ENTRIES];
+    };
+
+    const SrgbTables &GetSrgbTables()
+    {
+        static const SrgbTables tables = []
+        {
+            SrgbTables t{};
+            for (int i = 0; i < 256; ++i)
+            {
+                float c = i / 255.0f;
+                t.toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+                t.toLinear[256 + i] = c;
+            }
+            for (int i = 0; i < ENCODE_ENTRIES; ++i)
+            {
+                float s = i / float(ENCODE_ENTRIES - 1);
+                float l = s * s;
+                float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                t.fromLinear[i] = static_cast<int32_t>(c * 255.0f + 0.5f);
+            }
+            return t;
+        }();
+        return tables;
+    }
+
+    // a * b + c, rounded once wherever the avx2 loops fuse it, so the scalar
+    // code gives the same bytes as they do
+    float MulAdd(float a, float b, float c)
+    {
+#if defined(GRAPHITE_AVX2)
+        return std::fma(a, b, c);
+#else
+        return a * b + c;
+#endif
+    }
+
+    // every destination pixel reads the same number of source pixels, shorter
+    // footprints are padded with zero weights
+    struct Taps
+    {
+        int count = 0;
+        std::vector<int> index; // [destination * count + k]
+        std::vector<float> weight;
+    };
+
+    float BesselI0(float x)
+    {
+        float sum = 1.0f, term = 1.0f;
+        for (int k = 1; k < 32; ++k)
+        {
+            term *= (x * 0.5f / k) * (x * 0.5f / k);
+            sum += term;
+            if (term < sum * 1e-7f)
+                break;
+        }
+        return sum;
+    }
+
+    float Kaiser(float t)
+    {
+        float x = t / KAISER_RADIUS;
+        if (std::abs(x) >= 1.0f)
+            return 0.0f;
+        float sinc = t == 0.0f ? 1.0f : std::sin(3.14159265f * t) / (3.14159265f * t);
+        return sinc * BesselI0(KAISER_ALPHA * std::sqrt(1.0f - x * x)) / BesselI0(KAISER_ALPHA);
+    }
+
+    Taps BuildTaps(int srcSize, int dstSize, MipGenerator::Filter filter)
+    {
+        const float ratio = float(srcSize) / float(dstSize);
+        const float support = filter == MipGenerator::Filter::Box ? 0.5f * ratio : KAISER_RADIUS * ratio;
+
+        std::vector<std::vector<std::pair<int, float>>> perPixel(dstSize);
+        Taps taps;
+        for (int d = 0; d < dstSize; ++d)
+        {
+            const float center = (d + 0.5f) * ratio;
+            auto &list = perPixel[d];
+            float total = 0.0f;
+            for (int s = int(std::floor(center - support)); s <= int(std::ceil(center + support)); ++s)
+            {
+                // box: overlap of the source pixel with the footprint,
+                // kaiser: point sampled at the source pixel center
+                float w = filter == MipGenerator::Filter::Box
+                              ? std::min(s + 1.0f, center + support) - std::max(float(s), center - support)
+                              : Kaiser((s + 0.5f - center) / ratio);
+                if (filter == MipGenerator::Filter::Box ? w <= 0.0f : w == 0.0f)
+                    continue; // kaiser keeps its negative lobes
+                list.emplace_back(std::clamp(s, 0, srcSize - 1), w); // clamp to edge
+                total += w;
+            }
+            for (auto &tap : list)
+                tap.second /= total;
+            taps.count = std::max(taps.count, int(list.size()));
+        }
+
+        taps.index.resize(size_t(dstSize) * taps.count);
+        taps.weight.resize(size_t(dstSize) * taps.count, 0.0f);
+        for (int d = 0; d < dstSize; ++d)
+        {
+            const auto &list = perPixel[d];
+            for (int k = 0; k < taps.count; ++k)
+            {
+                size_t i = size_t(d) * taps.count + k;
+                taps.index[i] = k < int(list.size()) ? list[k].first : list.back().first;
+                taps.weight[i] = k < int(list.size()) ? list[k].second : 0.0f;
+            }
+        }
+        return taps;
+    }
+
+    // acc += weight * decode(src), count bytes of rgba8
+    void AccumulateRow(float *acc, const unsigned char *src, float weight, size_t count, bool srgb, bool simd)
+    {
+        const float *toLinear = GetSrgbTables().toLinear;
+        size_t i = 0;
+#if defined(GRAPHITE_AVX2)
+        const __m256 w = _mm256_set1_ps(weight);
+        const __m256 unorm = _mm256_set1_ps(1.0f / 255.0f);
+        const __m256i alphaOffset = _mm256_setr_epi32(0, 0, 0, 256, 0, 0, 0, 256);
+        for (; simd && i + 8 <= count; i += 8)
+        {
+            __m128i bytes;
+            std::memcpy(&bytes, src + i, 8);
+            __m256i v = _mm256_cvtepu8_epi32(bytes);
+            __m256 f = srgb ? _mm256_i32gather_ps(toLinear, _mm256_add_epi32(v, alphaOffset), 4)
+                            : _mm256_mul_ps(_mm256_cvtepi32_ps(v), unorm);
+            _mm256_storeu_ps(acc + i, _mm256_fmadd_ps(f, w, _mm256_loadu_ps(acc + i)));
+        }
+#else
+        (void)simd;
+#endif
+        for (; i < count; ++i)
+        {
+            float f = srgb ? toLinear[src[i] + ((i & 3) == 3 ? 256 : 0)] : src[i] * (1.0f / 255.0f);
+            acc[i] = MulAdd(f, weight, acc[i]);
+        }
+    }
+
+    // one rgba pixel per destination x
+    void FilterRow(const float *src, const Taps &taps, float *dst, int dstWidth, bool simd)
+    {
+        for (int x = 0; x < dstWidth; ++x)
+        {
+            const int *index = taps.index.data() + size_t(x) * taps.count;
+            const float *weight = taps.weight.data() + size_t(x) * taps.count;
+#if defined(GRAPHITE_AVX2)
+            if (simd)
+            {
+                __m128 sum = _mm_setzero_ps();
+                for (int k = 0; k < taps.count; ++k)
+                    sum = _mm_fmadd_ps(_mm_loadu_ps(src + size_t(index[k]) * 4), _mm_set1_ps(weight[k]), sum);
+                _mm_storeu_ps(dst + size_t(x) * 4, sum);
+                continue;
+            }
+#else
+            (void)simd;
+#endif
+            float sum[4] = {};
+            for (int k = 0; k < taps.count; ++k)
+            {
+                for (int c = 0; c < 4; ++c)
+                    sum[c] = MulAdd(src[size_t(index[k]) * 4 + c], weight[k], sum[c]);
+            }
+            std::memcpy(dst + size_t(x) * 4, sum, sizeof(sum));
+        }
+    }
+
+    // filtered unorm vectors back to unit length, alpha untouched
+    void RenormalizeRow(float *pixels, int width, bool simd)
+    {
+#if defined(GRAPHITE_AVX2)
+        const __m128 two = _mm_set1_ps(2.0f), one = _mm_set1_ps(1.0f), half = _mm_set1_ps(0.5f);
+#else
+        (void)simd;
+#endif
+        for (int x = 0; x < width; ++x)
+        {
+            float *p = pixels + size_t(x) * 4;
+#if defined(GRAPHITE_AVX2)
+            if (simd)
+            {
+                __m128 v = _mm_fmsub_ps(_mm_loadu_ps(p), two, one);
+                __m128 lengthSq = _mm_dp_ps(v, v, 0x7F);
+                if (_mm_cvtss_f32(lengthSq) > 1e-12f)
+                    v = _mm_div_ps(v, _mm_sqrt_ps(lengthSq));
+                else
+                    v = _mm_setr_ps(0.0f, 0.0f, 1.0f, 0.0f);
+                v = _mm_fmadd_ps(v, half, half);
+                _mm_storeu_ps(p, _mm_blend_ps(v, _mm_loadu_ps(p), 0x8));
+                continue;
+            }
+#endif
+            // summed in the order dpps sums
+            float x0 = p[0] * 2.0f - 1.0f, y0 = p[1] * 2.0f - 1.0f, z0 = p[2] * 2.0f - 1.0f;
+            float lengthSq = (x0 * x0 + y0 * y0) + z0 * z0;
+            if (lengthSq > 1e-12f)
+            {
+                float length = std::sqrt(lengthSq);
+                x0 /= length, y0 /= length, z0 /= length;
+            }
+            else
+            {
+                x0 = 0.0f, y0 = 0.0f, z0 = 1.0f;
+            }
+            p[0] = x0 * 0.5f + 0.5f;
+            p[1] = y0 * 0.5f + 0.5f;
+            p[2] = z0 * 0.5f + 0.5f;
+        }
+    }
+
+    void EncodeRow(const float *src, unsigned char *dst, size_t count, bool srgb, bool simd)
+    {
+        const int32_t *fromLinear = GetSrgbTables().fromLinear;
+        size_t i = 0;
+#if defined(GRAPHITE_AVX2)
+        const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+        const __m256 unorm = _mm256_set1_ps(255.0f), round = _mm256_set1_ps(0.5f);
+        const __m256 lutScale = _mm256_set1_ps(float(ENCODE_ENTRIES - 1));
+        for (; simd && i + 8 <= count; i += 8)
+        {
+            __m256 v = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i), zero), one);
+            __m256i bytes = _mm256_cvttps_epi32(_mm256_fmadd_ps(v, unorm, round));
+            if (srgb)
+            {
+                __m256i index = _mm256_cvttps_epi32(_mm256_fmadd_ps(_mm256_sqrt_ps(v), lutScale, round));
+                bytes = _mm256_blend_epi32(_mm256_i32gather_epi32(fromLinear, index, 4), bytes, 0x88);
+            }
+            __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(bytes), _mm256_extracti128_si256(bytes, 1));
+            __m128i packed = _mm_packus_epi16(words, words);
+            std::memcpy(dst + i, &packed, 8);
+        }
+#else
+        (void)simd;
+#endif
+        for (; i < count; ++i)
+        {
+            float v = std::min(std::max(src[i], 0.0f), 1.0f);
+            if (srgb && (i & 3) != 3)
+                dst[i] = static_cast<unsigned char>(fromLinear[int(MulAdd(std::sqrt(v), float(ENCODE_ENTRIES - 1), 0.5f))]);
+            else
+                dst[i] = static_cast<unsigned char>(MulAdd(v, 255.0f, 0.5f));
+        }
+    }
+
+    void DownsampleLevel(
+        const unsigned char *src,
+        int srcWidth,
+        int srcHeight,
+        unsigned char *dst,
+        int dstWidth,
+        int dstHeight,
+        TextureRole role,
+        MipGenerator::Filter filter,
+        ThreadPool *pool,
+        bool simd)
+    {
+        const Taps horizontal = BuildTaps(srcWidth, dstWidth, filter);
+        const Taps vertical = BuildTaps(srcHeight, dstHeight, filter);
+        const bool srgb = role == TextureRole::Albedo;
+
+        // vertical pass into a float row, then horizontal pass and encode
+        auto run = [&](size_t begin, size_t end)
+        {
+            std::vector<float> column(size_t(srcWidth) * 4);
+            std::vector<float> row(size_t(dstWidth) * 4);
+            for (size_t y = begin; y < end; ++y)
+            {
+                std::fill(column.begin(), column.end(), 0.0f);
+                for (int k = 0; k < vertical.count; ++k)
+                {
+                    size_t t = y * vertical.count + k;
+                    if (vertical.weight[t] == 0.0f)
+                        continue;
+                    const unsigned char *srcRow = src + size_t(vertical.index[t]) * srcWidth * 4;
+                    AccumulateRow(column.data(), srcRow, vertical.weight[t], column.size(), srgb, simd);
+                }
+
+                FilterRow(column.data(), horizontal, row.data(), dstWidth, simd);
+                if (role == TextureRole::Normal)
+                    RenormalizeRow(row.data(), dstWidth, simd);
+                EncodeRow(row.data(), dst + y * dstWidth * 4, row.size(), srgb, simd);
+            }
+        };
+
+        if (pool)
+            pool->ParallelFor(size_t(dstHeight), ROWS_PER_TASK, run);
+        else
+            run(0, size_t(dstHeight));
+    }
+
+    void GenerateChain(
+        const unsigned char *pixels,
+        int width,
+        int height,
+        TextureRole role,
+        MipGenerator::Filter filter,
+        std::vector<unsigned char> &outChain,
+        ThreadPool *pool,
+        bool simd)
+    {
+        const int levels = MipGenerator::CountLevels(width, height);
+
+        size_t total = 0;
+        for (int l = 1; l < levels; ++l)
+            total += size_t(MipGenerator::LevelSize(width, l)) * MipGenerator::LevelSize(height, l) * 4;
+        outChain.resize(total);
+
+        const unsigned char *src = pixels;
+        unsigned char *dst = outChain.data();
+        for (int l = 1; l < levels; ++l)
+        {
+            int srcWidth = MipGenerator::LevelSize(width, l - 1), srcHeight = MipGenerator::LevelSize(height, l - 1);
+            int dstWidth = MipGenerator::LevelSize(width, l), dstHeight = MipGenerator::LevelSize(height, l);
+            DownsampleLevel(src, srcWidth, srcHeight, dst, dstWidth, dstHeight, role, filter, pool, simd);
+
+            src = dst;
+            dst += size_t(dstWidth) * dstHeight * 4;
+        }
+    }
+}
+
+namespace MipGenerator
+{
+    int CountLevels(int width, int height)
+    {
+        int levels = 1;
+        for (int size = std::max(width, height); size > 1; size >>= 1)
+            ++levels;
+        return levels;
+    }
+
+    int LevelSize(int size, int level)
+    {
+        return std::max(1, size >> level);
+    }
+
+    void Generate(
+        const unsigned char *pixels,
+        int width,
+        int height,
+        TextureRole role,
+        Filter filter,
+        std::vector<unsigned char> &outChain,
+        ThreadPool *pool)
+    {
+        GenerateChain(pixels, width, height, role, filter, outChain, pool, true);
+    }
+
+    void GenerateScalar(
+        const unsigned char *pixels,
+        int width,
+        int height,
+        TextureRole role,
+        Filter filter,
+        std::vector<unsigned char> &outChain,
+        ThreadPool *pool)
+    {
+        GenerateChain(pixels, width, height, role, filter, outChain, pool, false);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "rendering/Material.h"
+#include <cstddef>
+#include <vector>
+
+class ThreadPool;
+
+// cpu mip chain generation for rgba8 images. each level is filtered from the
+// previous one with a separable kernel, in linear light for albedo and with
+// renormalized vectors for normal maps
+namespace MipGenerator
+{
+    enum class Filter
+    {
+        Box,    // exact pixel coverage, 2 taps per axis for even sizes
+        Kaiser, // kaiser windowed sinc, sharper but 8 taps per axis
+    };
+
+    // levels down to 1x1, level 0 included
+    int CountLevels(int width, int height);
+
+    // width or height of a level, never below 1
+    int LevelSize(int size, int level);
+
+    // writes levels 1..CountLevels-1 back to back into outChain, tightly
+    // packed. rows of each level are split into bands across the pool
+    void Generate(
+        const unsigned char *pixels,
+        int width,
+        int height,
+        TextureRole role,
+        Filter filter,
+        std::vector<unsigned char> &outChain,
+        ThreadPool *pool = nullptr);
+
+    // the same without the avx2 row loops, kept as the reference they are
+    // measured and checked against. the bytes are identical
+    void GenerateScalar(
+        const unsigned char *pixels,
+        int width,
+        int height,
+        TextureRole role,
+        Filter filter,
+        std::vector<unsigned char> &outChain,
+        ThreadPool *pool = nullptr);
+}
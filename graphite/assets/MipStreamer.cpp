@@ -0,0 +1,229 @@
+#include "MipStreamer.h"
+#include "assets/MipGenerator.h"
+#include <algorithm>
+#include <cmath>
+
+MipStreamer::MipStreamer(uint64_t budgetBytes)
+    : m_Budget(budgetBytes)
+{
+}
+
+void MipStreamer::Add(Key key, std::vector<uint64_t> levelBytes, int residentMip, int coarsestMip)
+{
+    Remove(key);
+    if (levelBytes.empty())
+        return;
+
+    Entry e;
+    e.levelBytes = std::move(levelBytes);
+    e.coarsestMip = std::clamp(coarsestMip, 0, int(e.levelBytes.size()) - 1);
+    e.residentMip = std::clamp(residentMip, 0, e.coarsestMip);
+    e.requestedMip = e.coarsestMip;
+    m_ResidentBytes += BytesFrom(e, e.residentMip);
+    m_Entries.emplace(key, std::move(e));
+}
+
+void MipStreamer::Remove(Key key)
+{
+    auto it = m_Entries.find(key);
+    if (it == m_Entries.end())
+        return;
+
+    const Entry &e = it->second;
+    m_ResidentBytes -= BytesFrom(e, e.residentMip);
+    if (e.pendingMip >= 0)
+    {
+        m_ResidentBytes -= e.levelBytes[e.pendingMip];
+        --m_PendingCount;
+    }
+    m_Entries.erase(it);
+}
+
+void MipStreamer::Request(Key key, int mip)
+{
+    auto it = m_Entries.find(key);
+    if (it == m_Entries.end())
+        return;
+
+    Entry &e = it->second;
+    mip = std::clamp(mip, 0, e.coarsestMip);
+    if (e.lastRequested != m_Frame)
+    {
+        e.lastRequested = m_Frame;
+        e.requestedMip = mip;
+    }
+    else
+    {
+        e.requestedMip = std::min(e.requestedMip, mip);
+    }
+}
+
+void MipStreamer::Update(uint64_t uploadBytes, std::vector<Transition> &out)
+{
+    // the budget shrank, or loads landed on top of a full pool
+    if (m_Budget > 0 && m_ResidentBytes > m_Budget)
+        Shed(m_ResidentBytes - m_Budget, nullptr, false, out);
+
+    // biggest shortfall first, so everything on screen gets a bit sharper
+    // before anything gets its finest level
+    std::vector<std::pair<Key, Entry *>> loads;
+    for (auto &[key, e] : m_Entries)
+    {
+        if (e.pendingMip < 0 && WantedMip(e) < e.residentMip)
+            loads.emplace_back(key, &e);
+    }
+    std::sort(loads.begin(), loads.end(), [this](const auto &a, const auto &b)
+              {
+                  const int da = a.second->residentMip - WantedMip(*a.second);
+                  const int db = b.second->residentMip - WantedMip(*b.second);
+                  return da != db ? da > db : a.first < b.first;
+              });
+
+    // always at least one load, a single large level can't stall forever
+    uint64_t uploaded = 0;
+    for (auto &[key, e] : loads)
+    {
+        const int next = e->residentMip - 1;
+        const uint64_t bytes = e->levelBytes[next];
+        if (uploaded > 0 && uploaded + bytes > uploadBytes)
+            continue;
+        if (m_Budget > 0 && m_ResidentBytes + bytes > m_Budget &&
+            !Shed(m_ResidentBytes + bytes - m_Budget, e, true, out))
+            continue;
+
+        e->pendingMip = next;
+        ++m_PendingCount;
+        m_ResidentBytes += bytes;
+        uploaded += bytes;
+        out.push_back({key, e->residentMip, next});
+        if (uploaded >= uploadBytes)
+            break;
+    }
+
+    ++m_Frame;
+}
+
+void MipStreamer::Complete(Key key, bool succeeded)
+{
+    auto it = m_Entries.find(key);
+    if (it == m_Entries.end() || it->second.pendingMip < 0)
+        return;
+
+    Entry &e = it->second;
+    if (succeeded)
+        e.residentMip = e.pendingMip;
+    else
+        m_ResidentBytes -= e.levelBytes[e.pendingMip];
+    e.pendingMip = -1;
+    --m_PendingCount;
+}
+
+int MipStreamer::GetResidentMip(Key key) const
+{
+    auto it = m_Entries.find(key);
+    return it != m_Entries.end() ? it->second.residentMip : -1;
+}
+
+int MipStreamer::RequiredMip(float texelsPerUnit, float pixelsPerUnit, int mipLevels)
+{
+    if (mipLevels <= 1 || texelsPerUnit <= 0.0f || pixelsPerUnit <= 0.0f)
+        return std::max(mipLevels - 1, 0);
+
+    const float mip = std::floor(std::log2(texelsPerUnit / pixelsPerUnit));
+    return int(std::clamp(mip, 0.0f, float(mipLevels - 1)));
+}
+
+int MipStreamer::CoarsestTopMip(TextureFormat format, int width, int height, int mipLevels)
+{
+    if (!BlockCompression::IsCompressed(format))
+        return std::max(mipLevels - 1, 0);
+
+    int mip = 0;
+    while (mip + 1 < mipLevels &&
+           MipGenerator::LevelSize(width, mip + 1) % 4 == 0 &&
+           MipGenerator::LevelSize(height, mip + 1) % 4 == 0)
+        ++mip;
+    return mip;
+}
+
+int MipStreamer::StartMip(TextureFormat format, int width, int height, int mipLevels, int maxSize)
+{
+    if (maxSize <= 0)
+        return 0;
+
+    const int coarsest = CoarsestTopMip(format, width, height, mipLevels);
+    int mip = 0;
+    while (mip < coarsest &&
+           std::max(MipGenerator::LevelSize(width, mip), MipGenerator::LevelSize(height, mip)) > maxSize)
+        ++mip;
+    return mip;
+}
+
+uint64_t MipStreamer::BytesFrom(const Entry &e, int mip) const
+{
+    uint64_t bytes = 0;
+    for (size_t l = size_t(mip); l < e.levelBytes.size(); ++l)
+        bytes += e.levelBytes[l];
+    return bytes;
+}
+
+int MipStreamer::WantedMip(const Entry &e) const
+{
+    return e.lastRequested == m_Frame ? e.requestedMip : e.coarsestMip;
+}
+
+bool MipStreamer::Shed(uint64_t bytes, const Entry *keep, bool onlyUnneeded, std::vector<Transition> &out)
+{
+    uint64_t freed = 0;
+    while (freed < bytes)
+    {
+        // least recently needed first, then whatever has the most to give
+        Key victimKey = 0;
+        Entry *victim = nullptr;
+        int victimTarget = 0;
+        for (auto &[key, e] : m_Entries)
+        {
+            if (&e == keep || e.pendingMip >= 0 || e.residentMip >= e.coarsestMip)
+                continue;
+
+            // a texture on screen keeps one level past what it asked for, so
+            // one that sits on a mip boundary doesn't flip every frame
+            int target = e.residentMip + 1;
+            if (onlyUnneeded)
+                target = e.lastRequested == m_Frame ? e.requestedMip - 1 : e.coarsestMip;
+            if (target <= e.residentMip)
+                continue;
+
+            const bool better = !victim || e.lastRequested < victim->lastRequested ||
+                                (e.lastRequested == victim->lastRequested &&
+                                 (target - e.residentMip > victimTarget - victim->residentMip ||
+                                  (target - e.residentMip == victimTarget - victim->residentMip && key < victimKey)));
+            if (better)
+            {
+                victimKey = key;
+                victim = &e;
+                victimTarget = target;
+            }
+        }
+        if (!victim)
+            return false;
+
+        freed += BytesFrom(*victim, victim->residentMip) - BytesFrom(*victim, victimTarget);
+        Drop(victimKey, *victim, victimTarget, out);
+    }
+    return true;
+}
+
+void MipStreamer::Drop(Key key, Entry &e, int toMip, std::vector<Transition> &out)
+{
+    m_ResidentBytes -= BytesFrom(e, e.residentMip) - BytesFrom(e, toMip);
+
+    // successive drops of one texture in a frame become one transition
+    auto merged = std::find_if(out.begin(), out.end(), [&](const Transition &t)
+                               { return t.key == key && t.toMip > t.fromMip; });
+    if (merged != out.end())
+        merged->toMip = toMip;
+    else
+        out.push_back({key, e.residentMip, toMip});
+    e.residentMip = toMip;
+}
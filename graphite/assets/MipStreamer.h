@@ -0,0 +1,90 @@
+#pragma once
+
+#include "assets/BlockCompression.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// decides which mip levels of each streamed texture are resident. textures
+// start at a coarse level and move finer one level at a time while something
+// on screen resolves the extra detail, within a per frame upload cap. over
+// the budget, levels nothing needs go first, then the least recently needed.
+// bookkeeping only like ResidencyTracker, the owner moves the actual data
+class MipStreamer
+{
+public:
+    using Key = uint32_t;
+
+    struct Transition
+    {
+        Key key;
+        int fromMip; // most detailed resident level before
+        int toMip;   // finer than fromMip loads levels, coarser drops them
+    };
+
+    // 0 disables the budget
+    explicit MipStreamer(uint64_t budgetBytes = 0);
+
+    // levelBytes[i] is the size of mip i. coarsestMip is the coarsest level
+    // allowed at the top of the texture, it and everything below never leave
+    void Add(Key key, std::vector<uint64_t> levelBytes, int residentMip, int coarsestMip);
+    void Remove(Key key);
+    bool Contains(Key key) const { return m_Entries.count(key) != 0; }
+
+    // most detailed level needed this frame, the finest request wins
+    void Request(Key key, int mip);
+
+    // once per frame after the requests. drops in out take effect right away,
+    // loads count against the budget but stay pending until Complete
+    void Update(uint64_t uploadBytes, std::vector<Transition> &out);
+
+    // a failed load leaves the previous level resident
+    void Complete(Key key, bool succeeded);
+
+    int GetResidentMip(Key key) const;
+    size_t GetPendingCount() const { return m_PendingCount; }
+
+    void SetBudget(uint64_t budgetBytes) { m_Budget = budgetBytes; }
+    uint64_t GetBudget() const { return m_Budget; }
+    uint64_t GetResidentBytes() const { return m_ResidentBytes; }
+
+    // level at which one texel covers about one pixel. texelsPerUnit is the
+    // density of mip 0 on the surface, pixelsPerUnit the on screen size of
+    // the same unit
+    static int RequiredMip(float texelsPerUnit, float pixelsPerUnit, int mipLevels);
+
+    // d3d wants block compressed textures to start at a multiple of 4
+    static int CoarsestTopMip(TextureFormat format, int width, int height, int mipLevels);
+
+    // first level no larger than maxSize on either axis, within CoarsestTopMip
+    static int StartMip(TextureFormat format, int width, int height, int mipLevels, int maxSize);
+
+private:
+    struct Entry
+    {
+        std::vector<uint64_t> levelBytes;
+        int residentMip = 0;
+        int coarsestMip = 0;
+        int requestedMip = 0;
+        int pendingMip = -1;       // level being loaded, -1 when idle
+        uint64_t lastRequested = 0; // frame
+    };
+
+    uint64_t BytesFrom(const Entry &e, int mip) const;
+
+    // requested level this frame, the coarsest level once out of view
+    int WantedMip(const Entry &e) const;
+
+    // drops levels of anything but keep until bytes are freed. onlyUnneeded
+    // spares levels something on screen asked for, so a load never pushes
+    // out another visible texture
+    bool Shed(uint64_t bytes, const Entry *keep, bool onlyUnneeded, std::vector<Transition> &out);
+    void Drop(Key key, Entry &e, int toMip, std::vector<Transition> &out);
+
+    std::unordered_map<Key, Entry> m_Entries;
+    uint64_t m_Budget = 0;
+    uint64_t m_ResidentBytes = 0; // includes pending loads
+    size_t m_PendingCount = 0;
+    uint64_t m_Frame = 1;
+};
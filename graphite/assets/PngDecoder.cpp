@@ -0,0 +1,494 @@
+#include "PngDecoder.h"
+#include "utils/DefaultInitAllocator.h"
+#include "utils/Inflate.h"
+#include "utils/Simd.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+    constexpr unsigned char SIGNATURE[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    constexpr uint32_t MAX_DIMENSION = 1 << 24; // same limit as stb_image
+
+    // loads of 16 bytes may run this far past the last row of image data
+    constexpr size_t LOAD_SLACK = 16;
+
+    constexpr uint32_t ChunkType(const char (&name)[5])
+    {
+        return uint32_t(uint8_t(name[0])) << 24 | uint32_t(uint8_t(name[1])) << 16 |
+               uint32_t(uint8_t(name[2])) << 8 | uint32_t(uint8_t(name[3]));
+    }
+
+    constexpr uint32_t IHDR = ChunkType("IHDR");
+    constexpr uint32_t IDAT = ChunkType("IDAT");
+    constexpr uint32_t IEND = ChunkType("IEND");
+    constexpr uint32_t TRNS = ChunkType("tRNS");
+    constexpr uint32_t CGBI = ChunkType("CgBI"); // apple's variant, stb_image knows it
+
+    enum Filter : uint8_t
+    {
+        NONE,
+        SUB,
+        UP,
+        AVERAGE,
+        PAETH,
+    };
+
+    uint32_t ReadBE32(const uint8_t *p)
+    {
+        return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+    }
+
+    struct Chunk
+    {
+        uint32_t type;
+        const uint8_t *data;
+        uint32_t length;
+    };
+
+    // every chunk up to IEND in order. crcs are not checked, stb_image doesn't either
+    template <typename Visit>
+    bool ForEachChunk(const uint8_t *data, size_t size, Visit &&visit)
+    {
+        if (size < sizeof(SIGNATURE) || std::memcmp(data, SIGNATURE, sizeof(SIGNATURE)) != 0)
+            return false;
+
+        size_t pos = sizeof(SIGNATURE);
+        for (;;)
+        {
+            if (size - pos < 12)
+                return false;
+            const uint32_t length = ReadBE32(data + pos);
+            const uint32_t type = ReadBE32(data + pos + 4);
+            if (length > size - pos - 12)
+                return false;
+            if (!visit(Chunk{type, data + pos + 8, length}))
+                return false;
+            if (type == IEND)
+                return true;
+            pos += 12 + size_t(length);
+        }
+    }
+
+#if defined(GRAPHITE_SSE41)
+    // pixels go through general registers. odd sizes are put together from
+    // power of two pieces, a memcpy of 3 or 6 bytes is assembled on the stack
+    // and the wider load after it stalls on store forwarding
+    template <unsigned BYTES>
+    uint64_t LoadBytes(const uint8_t *p)
+    {
+        if constexpr (BYTES == 3)
+            return LoadBytes<2>(p) | LoadBytes<1>(p + 2) << 16;
+        else if constexpr (BYTES == 6)
+            return LoadBytes<4>(p) | LoadBytes<2>(p + 4) << 32;
+        else
+        {
+            using Word = std::conditional_t<BYTES == 1, uint8_t, std::conditional_t<BYTES == 2, uint16_t, std::conditional_t<BYTES == 4, uint32_t, uint64_t>>>;
+            Word v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+    }
+
+    template <unsigned BYTES>
+    void StoreBytes(uint8_t *p, uint64_t v)
+    {
+        if constexpr (BYTES == 3)
+        {
+            StoreBytes<2>(p, v);
+            StoreBytes<1>(p + 2, v >> 16);
+        }
+        else if constexpr (BYTES == 6)
+        {
+            StoreBytes<4>(p, v);
+            StoreBytes<2>(p + 4, v >> 32);
+        }
+        else
+        {
+            using Word = std::conditional_t<BYTES == 1, uint8_t, std::conditional_t<BYTES == 2, uint16_t, std::conditional_t<BYTES == 4, uint32_t, uint64_t>>>;
+            const Word w = static_cast<Word>(v);
+            std::memcpy(p, &w, sizeof(w));
+        }
+    }
+
+    template <unsigned BPP>
+    __m128i LoadPixel(const uint8_t *p)
+    {
+        return _mm_cvtsi64_si128(static_cast<long long>(LoadBytes<BPP>(p)));
+    }
+
+    template <unsigned BPP>
+    void StorePixel(uint8_t *p, __m128i v)
+    {
+        StoreBytes<BPP>(p, static_cast<uint64_t>(_mm_cvtsi128_si64(v)));
+    }
+
+    // whole pixels that fit in a register
+    template <unsigned BPP>
+    constexpr unsigned BlockBytes()
+    {
+        return 16 / BPP * BPP;
+    }
+
+    // running sum of the pixels in a register, each byte adds the same byte
+    // of every pixel before it
+    template <unsigned BPP>
+    __m128i PrefixSum(__m128i v)
+    {
+        constexpr unsigned BLOCK = BlockBytes<BPP>();
+        v = _mm_add_epi8(v, _mm_slli_si128(v, BPP));
+        if constexpr (2 * BPP < BLOCK)
+            v = _mm_add_epi8(v, _mm_slli_si128(v, 2 * BPP));
+        if constexpr (4 * BPP < BLOCK)
+            v = _mm_add_epi8(v, _mm_slli_si128(v, 4 * BPP));
+        if constexpr (8 * BPP < BLOCK)
+            v = _mm_add_epi8(v, _mm_slli_si128(v, 8 * BPP));
+        return v;
+    }
+
+    // shuffle that repeats the last pixel of a block into every pixel slot
+    template <unsigned BPP>
+    __m128i LastPixelMask()
+    {
+        constexpr unsigned BLOCK = BlockBytes<BPP>();
+        alignas(16) int8_t mask[16];
+        for (unsigned j = 0; j < 16; ++j)
+            mask[j] = j < BLOCK ? static_cast<int8_t>(BLOCK - BPP + j % BPP) : int8_t(-128);
+        return _mm_load_si128(reinterpret_cast<const __m128i *>(mask));
+    }
+#endif
+
+    // dst may be src (unfiltered in place), prior is the unfiltered row above
+    template <unsigned BPP>
+    void UnfilterSub(const uint8_t *src, uint8_t *dst, size_t rowBytes)
+    {
+        size_t i = 0;
+        for (; i < BPP; ++i)
+            dst[i] = src[i];
+
+#if defined(GRAPHITE_SSE41)
+        // a register of pixels at a time: their prefix sum plus the last
+        // pixel of the block before
+        constexpr unsigned BLOCK = BlockBytes<BPP>();
+        const __m128i lastPixel = LastPixelMask<BPP>();
+        __m128i previous = _mm_slli_si128(LoadPixel<BPP>(dst), BLOCK - BPP);
+        for (; i + 16 <= rowBytes; i += BLOCK)
+        {
+            __m128i v = PrefixSum<BPP>(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)));
+            v = _mm_add_epi8(v, _mm_shuffle_epi8(previous, lastPixel));
+            if constexpr (BLOCK == 16)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), v);
+            }
+            else
+            {
+                // the bytes past the block are the next source pixels when in place
+                alignas(16) uint8_t bytes[16];
+                _mm_store_si128(reinterpret_cast<__m128i *>(bytes), v);
+                std::memcpy(dst + i, bytes, BLOCK);
+            }
+            previous = v;
+        }
+#endif
+        for (; i < rowBytes; ++i)
+            dst[i] = static_cast<uint8_t>(src[i] + dst[i - BPP]);
+    }
+
+    void UnfilterUp(const uint8_t *src, const uint8_t *prior, uint8_t *dst, size_t rowBytes)
+    {
+        size_t i = 0;
+#if defined(GRAPHITE_SSE41)
+        for (; i + 16 <= rowBytes; i += 16)
+        {
+            const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(prior + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_add_epi8(s, p));
+        }
+#endif
+        for (; i < rowBytes; ++i)
+            dst[i] = static_cast<uint8_t>(src[i] + prior[i]);
+    }
+
+    // average and paeth depend on the pixel to the left, so they go a pixel
+    // at a time with every channel in one register
+    template <unsigned BPP>
+    void UnfilterAverage(const uint8_t *src, const uint8_t *prior, uint8_t *dst, size_t rowBytes)
+    {
+        size_t i = 0;
+        for (; i < BPP; ++i)
+            dst[i] = static_cast<uint8_t>(src[i] + (prior[i] >> 1));
+
+#if defined(GRAPHITE_SSE41)
+        const __m128i one = _mm_set1_epi8(1);
+        __m128i a = LoadPixel<BPP>(dst);
+        for (; i + BPP <= rowBytes; i += BPP)
+        {
+            // pavgb rounds up, png rounds down
+            const __m128i b = LoadPixel<BPP>(prior + i);
+            const __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+            a = _mm_add_epi8(LoadPixel<BPP>(src + i), average);
+            StorePixel<BPP>(dst + i, a);
+        }
+#endif
+        for (; i < rowBytes; ++i)
+            dst[i] = static_cast<uint8_t>(src[i] + ((dst[i - BPP] + prior[i]) >> 1));
+    }
+
+    template <unsigned BPP>
+    void UnfilterPaeth(const uint8_t *src, const uint8_t *prior, uint8_t *dst, size_t rowBytes)
+    {
+        // nothing on the left or above-left, so the predictor is the pixel above
+        size_t i = 0;
+        for (; i < BPP; ++i)
+            dst[i] = static_cast<uint8_t>(src[i] + prior[i]);
+
+#if defined(GRAPHITE_SSE41)
+        const __m128i zero = _mm_setzero_si128();
+        __m128i a = _mm_unpacklo_epi8(LoadPixel<BPP>(dst), zero);
+        __m128i c = _mm_unpacklo_epi8(LoadPixel<BPP>(prior), zero);
+        for (; i + BPP <= rowBytes; i += BPP)
+        {
+            const __m128i b = _mm_unpacklo_epi8(LoadPixel<BPP>(prior + i), zero);
+
+            // distances of p = a + b - c to a, b and c
+            const __m128i pa = _mm_abs_epi16(_mm_sub_epi16(b, c));
+            const __m128i pb = _mm_abs_epi16(_mm_sub_epi16(a, c));
+            const __m128i pc = _mm_abs_epi16(_mm_sub_epi16(_mm_add_epi16(a, b), _mm_add_epi16(c, c)));
+
+            // a when it is nearest, then b, then c, ties in that order
+            __m128i predictor = _mm_blendv_epi8(b, c, _mm_cmpgt_epi16(pb, pc));
+            predictor = _mm_blendv_epi8(a, predictor, _mm_cmpgt_epi16(pa, _mm_min_epi16(pb, pc)));
+
+            const __m128i x = _mm_add_epi8(LoadPixel<BPP>(src + i), _mm_packus_epi16(predictor, predictor));
+            StorePixel<BPP>(dst + i, x);
+            a = _mm_unpacklo_epi8(x, zero);
+            c = b;
+        }
+#endif
+        for (; i < rowBytes; ++i)
+        {
+            const int a = dst[i - BPP], b = prior[i], c = prior[i - BPP];
+            const int pa = std::abs(b - c), pb = std::abs(a - c), pc = std::abs(a + b - 2 * c);
+            const int predictor = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+            dst[i] = static_cast<uint8_t>(src[i] + predictor);
+        }
+    }
+
+    template <unsigned BPP>
+    bool UnfilterRow(uint8_t filter, const uint8_t *src, const uint8_t *prior, uint8_t *dst, size_t rowBytes)
+    {
+        switch (filter)
+        {
+        case NONE:
+            if (dst != src)
+                std::memcpy(dst, src, rowBytes);
+            return true;
+        case SUB:
+            UnfilterSub<BPP>(src, dst, rowBytes);
+            return true;
+        case UP:
+            UnfilterUp(src, prior, dst, rowBytes);
+            return true;
+        case AVERAGE:
+            UnfilterAverage<BPP>(src, prior, dst, rowBytes);
+            return true;
+        case PAETH:
+            UnfilterPaeth<BPP>(src, prior, dst, rowBytes);
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    using UnfilterFn = bool (*)(uint8_t, const uint8_t *, const uint8_t *, uint8_t *, size_t);
+
+    UnfilterFn GetUnfilter(unsigned bpp)
+    {
+        switch (bpp)
+        {
+        case 1: return UnfilterRow<1>;
+        case 2: return UnfilterRow<2>;
+        case 3: return UnfilterRow<3>;
+        case 4: return UnfilterRow<4>;
+        case 6: return UnfilterRow<6>;
+        case 8: return UnfilterRow<8>;
+        default: return nullptr;
+        }
+    }
+
+    // source byte of output byte k (rgba) of a pixel, -1 for opaque alpha.
+    // gray is replicated and 16 bit samples keep their high (first) byte
+    template <unsigned CHANNELS, unsigned BYTES>
+    constexpr int SourceByte(unsigned pixel, unsigned k)
+    {
+        int channel;
+        if (k < 3)
+            channel = CHANNELS >= 3 ? int(k) : 0;
+        else
+            channel = CHANNELS == 2 ? 1 : CHANNELS == 4 ? 3 : -1;
+        return channel < 0 ? -1 : int(pixel * CHANNELS * BYTES + channel * BYTES);
+    }
+
+    // one unfiltered row to rgba8
+    template <unsigned CHANNELS, unsigned BYTES>
+    void ExpandRow(const uint8_t *src, uint8_t *dst, size_t width)
+    {
+        constexpr unsigned BPP = CHANNELS * BYTES;
+        size_t x = 0;
+
+#if defined(GRAPHITE_SSE41)
+        // one shuffle turns as many pixels as fit in 16 source bytes (at most
+        // 4) into rgba. reads past the row land in the next one or the slack
+        constexpr unsigned PIXELS = 16 / BPP < 4 ? 16 / BPP : 4;
+        alignas(16) int8_t mask[16];
+        for (unsigned j = 0; j < 16; ++j)
+        {
+            const int s = j < PIXELS * 4 ? SourceByte<CHANNELS, BYTES>(j / 4, j % 4) : -1;
+            mask[j] = s < 0 ? int8_t(-128) : static_cast<int8_t>(s);
+        }
+        const __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i *>(mask));
+        const __m128i alpha = CHANNELS % 2 == 0 ? _mm_setzero_si128() : _mm_set1_epi32(int(0xFF000000u));
+
+        for (; x + PIXELS <= width; x += PIXELS)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x * BPP));
+            const __m128i rgba = _mm_or_si128(_mm_shuffle_epi8(v, shuffle), alpha);
+            if constexpr (PIXELS == 4)
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x * 4), rgba);
+            else
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x * 4), rgba);
+        }
+#endif
+        for (; x < width; ++x)
+        {
+            for (unsigned k = 0; k < 4; ++k)
+            {
+                const int s = SourceByte<CHANNELS, BYTES>(0, k);
+                dst[x * 4 + k] = s < 0 ? 255 : src[x * BPP + s];
+            }
+        }
+    }
+
+    using ExpandFn = void (*)(const uint8_t *, uint8_t *, size_t);
+
+    ExpandFn GetExpand(int channels, int bitDepth)
+    {
+        const bool wide = bitDepth == 16;
+        switch (channels)
+        {
+        case 1: return wide ? ExpandRow<1, 2> : ExpandRow<1, 1>;
+        case 2: return wide ? ExpandRow<2, 2> : ExpandRow<2, 1>;
+        case 3: return wide ? ExpandRow<3, 2> : ExpandRow<3, 1>;
+        case 4: return wide ? ExpandRow<4, 2> : ExpandRow<4, 1>;
+        default: return nullptr;
+        }
+    }
+}
+
+namespace PngDecoder
+{
+    bool ReadInfo(const unsigned char *data, size_t size, Info &outInfo)
+    {
+        bool header = false, imageData = false;
+        int colorType = 0;
+        const bool valid = ForEachChunk(data, size, [&](const Chunk &chunk)
+                                        {
+            if (!header)
+            {
+                if (chunk.type != IHDR || chunk.length != 13)
+                    return false;
+                const uint32_t width = ReadBE32(chunk.data);
+                const uint32_t height = ReadBE32(chunk.data + 4);
+                const uint8_t bitDepth = chunk.data[8];
+                colorType = chunk.data[9];
+                // compression, filter method and interlacing
+                if (width == 0 || height == 0 || width > MAX_DIMENSION || height > MAX_DIMENSION ||
+                    chunk.data[10] != 0 || chunk.data[11] != 0 || chunk.data[12] != 0)
+                    return false;
+                if (bitDepth != 8 && bitDepth != 16)
+                    return false;
+
+                // gray, rgb, gray alpha, rgba. palettes go to stb_image
+                static constexpr int CHANNELS[7] = {1, 0, 3, 0, 2, 0, 4};
+                if (colorType > 6 || CHANNELS[colorType] == 0)
+                    return false;
+
+                outInfo.width = static_cast<int>(width);
+                outInfo.height = static_cast<int>(height);
+                outInfo.channels = CHANNELS[colorType];
+                outInfo.bitDepth = bitDepth;
+                header = true;
+                return true;
+            }
+
+            // color key transparency becomes alpha in stb_image, leave it there
+            if (chunk.type == TRNS || chunk.type == CGBI)
+                return false;
+            if (chunk.type == IDAT)
+                imageData = true;
+            return true; });
+        return valid && header && imageData;
+    }
+
+    bool Decode(const unsigned char *data, size_t size, const Info &info, unsigned char *out, size_t outStride)
+    {
+        const UnfilterFn unfilter = GetUnfilter(unsigned(info.channels * info.bitDepth / 8));
+        const ExpandFn expand = GetExpand(info.channels, info.bitDepth);
+        if (!unfilter || !expand || info.width <= 0 || info.height <= 0)
+            return false;
+
+        // the zlib stream may be split over any number of IDAT chunks
+        const uint8_t *stream = nullptr;
+        size_t streamSize = 0, chunkCount = 0;
+        std::vector<uint8_t> joined;
+        bool ok = ForEachChunk(data, size, [&](const Chunk &chunk)
+                               {
+            if (chunk.type != IDAT)
+                return true;
+            if (++chunkCount == 1)
+            {
+                stream = chunk.data;
+            }
+            else
+            {
+                if (chunkCount == 2)
+                    joined.assign(stream, stream + streamSize);
+                joined.insert(joined.end(), chunk.data, chunk.data + chunk.length);
+                stream = joined.data();
+            }
+            streamSize += chunk.length;
+            return true; });
+        if (!ok || chunkCount == 0)
+            return false;
+
+        // every row starts with its filter byte
+        const size_t width = size_t(info.width), height = size_t(info.height);
+        const size_t bpp = size_t(info.channels) * (info.bitDepth / 8);
+        const size_t rowBytes = width * bpp;
+        const size_t filteredStride = rowBytes + 1;
+        UninitVector<uint8_t> filtered(filteredStride * height + LOAD_SLACK);
+        if (!Inflate::DecompressZlib(stream, streamSize, filtered.data(), filteredStride * height))
+            return false;
+        std::memset(filtered.data() + filteredStride * height, 0, LOAD_SLACK);
+
+        // rgba8 rows are unfiltered straight into the output, everything else
+        // in place and then expanded
+        const bool direct = info.channels == 4 && info.bitDepth == 8;
+        const std::vector<uint8_t> zeroRow(rowBytes, 0);
+        for (size_t y = 0; y < height; ++y)
+        {
+            uint8_t *row = filtered.data() + y * filteredStride;
+            uint8_t *outRow = out + y * outStride;
+            const uint8_t *prior = y == 0 ? zeroRow.data() : direct ? outRow - outStride : row - rowBytes;
+            uint8_t *dst = direct ? outRow : row + 1;
+            if (!unfilter(row[0], row + 1, prior, dst, rowBytes))
+                return false;
+            if (!direct)
+                expand(dst, outRow, width);
+        }
+        return true;
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+// png decoder for the texture load path. handles what large textures are
+// saved as: 8 or 16 bit gray, gray alpha, rgb and rgba without interlacing.
+// palettes, low bit depths, interlacing and color key transparency are left
+// to stb_image, ReadInfo turns those down
+namespace PngDecoder
+{
+    struct Info
+    {
+        int width = 0;
+        int height = 0;
+        int channels = 0; // in the file, 1 to 4
+        int bitDepth = 0;
+    };
+
+    // header and chunk layout only. false when data isn't a png this decoder handles
+    bool ReadInfo(const unsigned char *data, size_t size, Info &outInfo);
+
+    // decodes to rgba8 rows of outStride bytes at out, sized by the caller
+    // for info.height rows. 16 bit channels keep their high byte, like stb_image
+    bool Decode(const unsigned char *data, size_t size, const Info &info, unsigned char *out, size_t outStride);
+}
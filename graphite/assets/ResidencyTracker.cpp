@@ -0,0 +1,92 @@
+#include "ResidencyTracker.h"
+#include <algorithm>
+
+ResidencyTracker::ResidencyTracker(uint64_t budgetBytes)
+    : m_Budget(budgetBytes)
+{
+}
+
+uint32_t ResidencyTracker::AddRef(Key key)
+{
+    Entry &e = m_Entries[key];
+    e.lastUsed = ++m_Tick;
+    return ++e.refs;
+}
+
+uint32_t ResidencyTracker::Release(Key key)
+{
+    auto it = m_Entries.find(key);
+    if (it == m_Entries.end() || it->second.refs == 0)
+        return 0;
+
+    // the last release is the last use, nothing draws an unreferenced asset
+    it->second.lastUsed = ++m_Tick;
+    return --it->second.refs;
+}
+
+uint32_t ResidencyTracker::GetRefCount(Key key) const
+{
+    auto it = m_Entries.find(key);
+    return it != m_Entries.end() ? it->second.refs : 0;
+}
+
+void ResidencyTracker::MarkResident(Key key, uint64_t bytes)
+{
+    Entry &e = m_Entries[key];
+    if (e.resident)
+        m_ResidentBytes -= e.bytes;
+    else
+        ++m_ResidentCount;
+
+    e.resident = true;
+    e.bytes = bytes;
+    e.lastUsed = ++m_Tick;
+    m_ResidentBytes += bytes;
+}
+
+void ResidencyTracker::MarkEvicted(Key key)
+{
+    auto it = m_Entries.find(key);
+    if (it == m_Entries.end() || !it->second.resident)
+        return;
+
+    it->second.resident = false;
+    m_ResidentBytes -= it->second.bytes;
+    --m_ResidentCount;
+}
+
+bool ResidencyTracker::IsResident(Key key) const
+{
+    auto it = m_Entries.find(key);
+    return it != m_Entries.end() && it->second.resident;
+}
+
+std::vector<ResidencyTracker::Key> ResidencyTracker::CollectEvictions()
+{
+    std::vector<Key> evicted;
+    if (m_Budget == 0 || m_ResidentBytes <= m_Budget)
+        return evicted;
+
+    struct Candidate
+    {
+        uint64_t lastUsed;
+        Key key;
+    };
+    std::vector<Candidate> candidates;
+    for (const auto &[key, e] : m_Entries)
+    {
+        if (e.resident && e.refs == 0)
+            candidates.push_back({e.lastUsed, key});
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b)
+              { return a.lastUsed < b.lastUsed; });
+
+    for (const Candidate &c : candidates)
+    {
+        if (m_ResidentBytes <= m_Budget)
+            break;
+        MarkEvicted(c.key);
+        evicted.push_back(c.key);
+    }
+    return evicted;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// bookkeeping behind asset residency: reference counts, resident bytes and a
+// budget. holds no resources itself, the owner frees whatever
+// CollectEvictions returns, so the policy runs without a device
+class ResidencyTracker
+{
+public:
+    using Key = uint64_t;
+
+    // 0 disables eviction
+    explicit ResidencyTracker(uint64_t budgetBytes = 0);
+
+    void SetBudget(uint64_t budgetBytes) { m_Budget = budgetBytes; }
+    uint64_t GetBudget() const { return m_Budget; }
+    uint64_t GetResidentBytes() const { return m_ResidentBytes; }
+    size_t GetResidentCount() const { return m_ResidentCount; }
+
+    // both return the new count. releasing an unreferenced key does nothing
+    uint32_t AddRef(Key key);
+    uint32_t Release(Key key);
+    uint32_t GetRefCount(Key key) const;
+
+    // resident assets count against the budget until evicted
+    void MarkResident(Key key, uint64_t bytes);
+    void MarkEvicted(Key key);
+    bool IsResident(Key key) const;
+
+    // unreferenced resident assets, least recently used first, until the
+    // resident bytes fit the budget. the returned keys are already marked
+    // evicted. referenced assets are never picked, so the result can leave
+    // the total over budget
+    std::vector<Key> CollectEvictions();
+
+private:
+    struct Entry
+    {
+        uint32_t refs = 0;
+        bool resident = false;
+        uint64_t bytes = 0;
+        uint64_t lastUsed = 0; // tick of the last ref change or load
+    };
+
+    std::unordered_map<Key, Entry> m_Entries;
+    uint64_t m_Budget = 0;
+    uint64_t m_ResidentBytes = 0;
+    size_t m_ResidentCount = 0;
+    uint64_t m_Tick = 0;
+};
@@ -0,0 +1,358 @@
+#include "VertexPacking.h"
+#include "utils/Simd.h"
+
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(GRAPHITE_SSE41) && defined(GRAPHITE_F16C)
+#define VERTEX_PACKING_SIMD 1
+#endif
+
+namespace
+{
+    // the simd path reads Vertex as 11 consecutive floats
+    static_assert(sizeof(Vertex) == 11 * sizeof(float), "VertexPacking expects a tightly packed Vertex.");
+    static_assert(offsetof(Vertex, Normal) == 3 * sizeof(float), "VertexPacking expects a tightly packed Vertex.");
+    static_assert(offsetof(Vertex, TexCoord) == 6 * sizeof(float), "VertexPacking expects a tightly packed Vertex.");
+    static_assert(offsetof(Vertex, Tangent) == 8 * sizeof(float), "VertexPacking expects a tightly packed Vertex.");
+
+    constexpr float UNORM16_MAX = 65535.0f;
+    constexpr float SNORM16_MAX = 32767.0f;
+
+    float SafeReciprocal(float v)
+    {
+        return v > 0.0f ? 1.0f / v : 0.0f;
+    }
+
+    uint16_t QuantizeUnorm16(float v)
+    {
+        v = std::clamp(v, 0.0f, 1.0f);
+        return static_cast<uint16_t>(std::lrintf(v * UNORM16_MAX));
+    }
+
+    int16_t QuantizeSnorm16(float v)
+    {
+        v = std::clamp(v, -1.0f, 1.0f);
+        return static_cast<int16_t>(std::lrintf(v * SNORM16_MAX));
+    }
+
+    // octahedral mapping (cigolle et al. 2014): project onto the l1 unit
+    // octahedron and fold the lower half over the diagonals
+    void OctEncode(const glm::vec3 &n, int16_t out[2])
+    {
+        float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+        float inv = 1.0f / std::max(l1, 1e-20f);
+        float ox = n.x * inv;
+        float oy = n.y * inv;
+        if (n.z < 0.0f)
+        {
+            float fx = std::copysign(1.0f - std::fabs(oy), ox);
+            float fy = std::copysign(1.0f - std::fabs(ox), oy);
+            ox = fx;
+            oy = fy;
+        }
+        out[0] = QuantizeSnorm16(ox);
+        out[1] = QuantizeSnorm16(oy);
+    }
+
+    void PackScalar(
+        const Vertex &v,
+        const glm::vec3 &offset,
+        const glm::vec3 &invScale,
+        PackedVertex &out)
+    {
+        glm::vec3 p = (v.Position - offset) * invScale;
+        out.Position[0] = QuantizeUnorm16(p.x);
+        out.Position[1] = QuantizeUnorm16(p.y);
+        out.Position[2] = QuantizeUnorm16(p.z);
+        out.Position[3] = 0;
+        OctEncode(v.Normal, out.Normal);
+        OctEncode(v.Tangent, out.Tangent);
+        out.TexCoord[0] = VertexPacking::FloatToHalf(v.TexCoord.x);
+        out.TexCoord[1] = VertexPacking::FloatToHalf(v.TexCoord.y);
+    }
+
+#if !defined(VERTEX_PACKING_SIMD)
+    glm::vec3 OctDecode(const int16_t in[2])
+    {
+        // same as the gpu: snorm maps -32768 and -32767 to -1
+        float x = std::max(in[0] / SNORM16_MAX, -1.0f);
+        float y = std::max(in[1] / SNORM16_MAX, -1.0f);
+        float z = 1.0f - std::fabs(x) - std::fabs(y);
+        float t = std::max(-z, 0.0f);
+        x += x >= 0.0f ? -t : t;
+        y += y >= 0.0f ? -t : t;
+        float inv = 1.0f / std::sqrt(x * x + y * y + z * z);
+        return {x * inv, y * inv, z * inv};
+    }
+
+    void UnpackScalar(const PackedVertex &v, const VertexQuantization &q, Vertex &out)
+    {
+        out.Position = q.offset + glm::vec3(v.Position[0] / UNORM16_MAX,
+                                            v.Position[1] / UNORM16_MAX,
+                                            v.Position[2] / UNORM16_MAX) *
+                                      q.scale;
+        out.Normal = OctDecode(v.Normal);
+        out.Tangent = OctDecode(v.Tangent);
+        out.TexCoord = {VertexPacking::HalfToFloat(v.TexCoord[0]),
+                        VertexPacking::HalfToFloat(v.TexCoord[1])};
+    }
+#endif
+
+#if defined(VERTEX_PACKING_SIMD)
+    const __m128 SIGN_MASK = _mm_set1_ps(-0.0f);
+
+    __m128 Abs(__m128 v)
+    {
+        return _mm_andnot_ps(SIGN_MASK, v);
+    }
+
+    // magnitude of a with the sign of b
+    __m128 CopySign(__m128 a, __m128 b)
+    {
+        return _mm_or_ps(Abs(a), _mm_and_ps(b, SIGN_MASK));
+    }
+
+    // four vectors in soa form to four pairs of snorm16, one 32-bit lane each
+    __m128i OctEncode4(__m128 x, __m128 y, __m128 z)
+    {
+        const __m128 one = _mm_set1_ps(1.0f);
+        __m128 l1 = _mm_add_ps(_mm_add_ps(Abs(x), Abs(y)), Abs(z));
+        __m128 inv = _mm_div_ps(one, _mm_max_ps(l1, _mm_set1_ps(1e-20f)));
+        __m128 ox = _mm_mul_ps(x, inv);
+        __m128 oy = _mm_mul_ps(y, inv);
+
+        __m128 fx = CopySign(_mm_sub_ps(one, Abs(oy)), ox);
+        __m128 fy = CopySign(_mm_sub_ps(one, Abs(ox)), oy);
+        __m128 lower = _mm_cmplt_ps(z, _mm_setzero_ps());
+        ox = _mm_blendv_ps(ox, fx, lower);
+        oy = _mm_blendv_ps(oy, fy, lower);
+
+        const __m128 scale = _mm_set1_ps(SNORM16_MAX);
+        __m128i qx = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(ox, _mm_set1_ps(-1.0f)), one), scale));
+        __m128i qy = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(oy, _mm_set1_ps(-1.0f)), one), scale));
+        return _mm_unpacklo_epi16(_mm_packs_epi32(qx, qx), _mm_packs_epi32(qy, qy));
+    }
+
+    __m128i QuantizeUnorm4(__m128 p, __m128 offset, __m128 invScale)
+    {
+        __m128 n = _mm_mul_ps(_mm_sub_ps(p, offset), invScale);
+        n = _mm_min_ps(_mm_max_ps(n, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+        __m128i q = _mm_cvtps_epi32(_mm_mul_ps(n, _mm_set1_ps(UNORM16_MAX)));
+        return _mm_packus_epi32(q, q);
+    }
+
+    void StoreVertex(PackedVertex *dst, __m128i position, __m128i normalTangent, int texCoord)
+    {
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst->Position), position);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst->Normal), normalTangent);
+        std::memcpy(dst->TexCoord, &texCoord, sizeof(texCoord));
+    }
+
+    // packs four vertices. loads are three overlapping 16-byte reads per vertex
+    // (position + normal.x, normal + u, v + tangent) transposed into soa form
+    void Pack4(
+        const Vertex *vertices,
+        const __m128 offset[3],
+        const __m128 invScale[3],
+        PackedVertex *dst)
+    {
+        const float *f0 = reinterpret_cast<const float *>(vertices);
+        const float *f1 = f0 + 11;
+        const float *f2 = f0 + 22;
+        const float *f3 = f0 + 33;
+
+        __m128 px = _mm_loadu_ps(f0), py = _mm_loadu_ps(f1), pz = _mm_loadu_ps(f2), pw = _mm_loadu_ps(f3);
+        _MM_TRANSPOSE4_PS(px, py, pz, pw);
+
+        __m128 nx = _mm_loadu_ps(f0 + 3), ny = _mm_loadu_ps(f1 + 3), nz = _mm_loadu_ps(f2 + 3), u = _mm_loadu_ps(f3 + 3);
+        _MM_TRANSPOSE4_PS(nx, ny, nz, u);
+
+        __m128 v = _mm_loadu_ps(f0 + 7), tx = _mm_loadu_ps(f1 + 7), ty = _mm_loadu_ps(f2 + 7), tz = _mm_loadu_ps(f3 + 7);
+        _MM_TRANSPOSE4_PS(v, tx, ty, tz);
+
+        // x0 y0 z0 0 x1 y1 z1 0 | x2 y2 z2 0 x3 y3 z3 0
+        __m128i xy = _mm_unpacklo_epi16(QuantizeUnorm4(px, offset[0], invScale[0]),
+                                        QuantizeUnorm4(py, offset[1], invScale[1]));
+        __m128i zw = _mm_unpacklo_epi16(QuantizeUnorm4(pz, offset[2], invScale[2]), _mm_setzero_si128());
+        __m128i pos01 = _mm_unpacklo_epi32(xy, zw);
+        __m128i pos23 = _mm_unpackhi_epi32(xy, zw);
+
+        // n0 t0 n1 t1 | n2 t2 n3 t3
+        __m128i n = OctEncode4(nx, ny, nz);
+        __m128i t = OctEncode4(tx, ty, tz);
+        __m128i nt01 = _mm_unpacklo_epi32(n, t);
+        __m128i nt23 = _mm_unpackhi_epi32(n, t);
+
+        __m128i uv = _mm_unpacklo_epi16(_mm_cvtps_ph(u, _MM_FROUND_TO_NEAREST_INT),
+                                        _mm_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+
+        StoreVertex(dst + 0, pos01, nt01, _mm_cvtsi128_si32(uv));
+        StoreVertex(dst + 1, _mm_srli_si128(pos01, 8), _mm_srli_si128(nt01, 8), _mm_extract_epi32(uv, 1));
+        StoreVertex(dst + 2, pos23, nt23, _mm_extract_epi32(uv, 2));
+        StoreVertex(dst + 3, _mm_srli_si128(pos23, 8), _mm_srli_si128(nt23, 8), _mm_extract_epi32(uv, 3));
+    }
+
+    // one vertex per call, normal and tangent decode share a register
+    void Unpack1(const PackedVertex &src, __m128 offset, __m128 scale, Vertex &out)
+    {
+        __m128i qp = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src.Position)));
+        __m128 p = _mm_add_ps(offset, _mm_mul_ps(_mm_cvtepi32_ps(qp), _mm_mul_ps(scale, _mm_set1_ps(1.0f / UNORM16_MAX))));
+
+        // lanes: nx tx nx tx / ny ty ny ty
+        __m128i qnt = _mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src.Normal)));
+        __m128 nt = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(qnt), _mm_set1_ps(1.0f / SNORM16_MAX)), _mm_set1_ps(-1.0f));
+        __m128 x = _mm_shuffle_ps(nt, nt, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 y = _mm_shuffle_ps(nt, nt, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 z = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.0f), Abs(x)), Abs(y));
+        __m128 t = _mm_max_ps(_mm_sub_ps(_mm_setzero_ps(), z), _mm_setzero_ps());
+        x = _mm_sub_ps(x, CopySign(t, x));
+        y = _mm_sub_ps(y, CopySign(t, y));
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(len2));
+        x = _mm_mul_ps(x, inv);
+        y = _mm_mul_ps(y, inv);
+        z = _mm_mul_ps(z, inv);
+
+        alignas(16) float px[4], vx[4], vy[4], vz[4];
+        _mm_store_ps(px, p);
+        _mm_store_ps(vx, x);
+        _mm_store_ps(vy, y);
+        _mm_store_ps(vz, z);
+
+        uint32_t uvBits;
+        std::memcpy(&uvBits, src.TexCoord, sizeof(uvBits));
+        alignas(16) float uv[4];
+        _mm_store_ps(uv, _mm_cvtph_ps(_mm_cvtsi32_si128(static_cast<int>(uvBits))));
+
+        out.Position = {px[0], px[1], px[2]};
+        out.Normal = {vx[0], vy[0], vz[0]};
+        out.Tangent = {vx[1], vy[1], vz[1]};
+        out.TexCoord = {uv[0], uv[1]};
+    }
+#endif
+}
+
+namespace VertexPacking
+{
+    VertexQuantization ComputeQuantization(const Vertex *vertices, size_t count)
+    {
+        VertexQuantization q;
+        if (count == 0)
+            return q;
+
+        glm::vec3 minP(std::numeric_limits<float>::max());
+        glm::vec3 maxP(std::numeric_limits<float>::lowest());
+        for (size_t i = 0; i < count; ++i)
+        {
+            minP = glm::min(minP, vertices[i].Position);
+            maxP = glm::max(maxP, vertices[i].Position);
+        }
+
+        q.offset = minP;
+        q.scale = maxP - minP;
+        return q;
+    }
+
+    void Pack(
+        const Vertex *vertices,
+        size_t count,
+        const VertexQuantization &quantization,
+        PackedVertex *destination)
+    {
+        glm::vec3 invScale(SafeReciprocal(quantization.scale.x),
+                           SafeReciprocal(quantization.scale.y),
+                           SafeReciprocal(quantization.scale.z));
+        size_t i = 0;
+
+#if defined(VERTEX_PACKING_SIMD)
+        const __m128 offset[3] = {_mm_set1_ps(quantization.offset.x),
+                                  _mm_set1_ps(quantization.offset.y),
+                                  _mm_set1_ps(quantization.offset.z)};
+        const __m128 inv[3] = {_mm_set1_ps(invScale.x),
+                               _mm_set1_ps(invScale.y),
+                               _mm_set1_ps(invScale.z)};
+        for (; i + 4 <= count; i += 4)
+            Pack4(vertices + i, offset, inv, destination + i);
+#endif
+
+        for (; i < count; ++i)
+            PackScalar(vertices[i], quantization.offset, invScale, destination[i]);
+    }
+
+    void Unpack(
+        const PackedVertex *vertices,
+        size_t count,
+        const VertexQuantization &quantization,
+        Vertex *destination)
+    {
+#if defined(VERTEX_PACKING_SIMD)
+        const __m128 offset = _mm_setr_ps(quantization.offset.x, quantization.offset.y, quantization.offset.z, 0.0f);
+        const __m128 scale = _mm_setr_ps(quantization.scale.x, quantization.scale.y, quantization.scale.z, 0.0f);
+        for (size_t i = 0; i < count; ++i)
+            Unpack1(vertices[i], offset, scale, destination[i]);
+#else
+        for (size_t i = 0; i < count; ++i)
+            UnpackScalar(vertices[i], quantization, destination[i]);
+#endif
+    }
+
+    uint16_t FloatToHalf(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        uint32_t sign = (bits >> 16) & 0x8000u;
+        uint32_t absBits = bits & 0x7FFFFFFFu;
+
+        // inf and nan (keeping nan quiet)
+        if (absBits >= 0x7F800000u)
+            return static_cast<uint16_t>(sign | 0x7C00u | (absBits > 0x7F800000u ? 0x200u : 0u));
+
+        // 65520 and up rounds past the largest half
+        if (absBits >= 0x477FF000u)
+            return static_cast<uint16_t>(sign | 0x7C00u);
+
+        // below the smallest normal half the result is a denormal (or zero),
+        // scaling by 2^24 is exact and nearbyint rounds to even
+        if (absBits < 0x38800000u)
+        {
+            float scaled = std::fabs(value) * 16777216.0f;
+            return static_cast<uint16_t>(sign | static_cast<uint32_t>(std::nearbyint(scaled)));
+        }
+
+        uint32_t exponent = (absBits >> 23) - 127 + 15;
+        uint32_t mantissa = absBits & 0x7FFFFFu;
+        uint32_t half = (exponent << 10) | (mantissa >> 13);
+        uint32_t rest = mantissa & 0x1FFFu;
+        if (rest > 0x1000u || (rest == 0x1000u && (half & 1u)))
+            ++half; // a carry out of the mantissa correctly bumps the exponent
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    float HalfToFloat(uint16_t value)
+    {
+        uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+        uint32_t exponent = (value >> 10) & 0x1Fu;
+        uint32_t mantissa = value & 0x3FFu;
+
+        if (exponent == 0)
+        {
+            float f = std::ldexp(static_cast<float>(mantissa), -24);
+            return sign ? -f : f;
+        }
+
+        uint32_t bits;
+        if (exponent == 31)
+            bits = sign | 0x7F800000u | (mantissa << 13);
+        else
+            bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "rendering/PackedVertex.h"
+#include "rendering/Vertex.h"
+#include <cstddef>
+#include <cstdint>
+
+// conversion between Vertex and PackedVertex
+// both directions have a simd path (sse4.1 + f16c) and a scalar fallback
+namespace VertexPacking
+{
+    // bounds of the positions, used as the unorm range when packing
+    VertexQuantization ComputeQuantization(const Vertex *vertices, size_t count);
+
+    void Pack(
+        const Vertex *vertices,
+        size_t count,
+        const VertexQuantization &quantization,
+        PackedVertex *destination);
+
+    void Unpack(
+        const PackedVertex *vertices,
+        size_t count,
+        const VertexQuantization &quantization,
+        Vertex *destination);
+
+    // ieee half conversion, round to nearest even like f16c
+    uint16_t FloatToHalf(float value);
+    float HalfToFloat(uint16_t value);
+}
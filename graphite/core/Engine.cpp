@@ -3,11 +3,14 @@
 #include "managers/DeviceManager.h"
 #include "managers/AssetManager.h"
 #include "input/InputManager.h"
+#include "platform/FileWatcher.h"
 #include "systems/RenderSystem.h"
 #include "systems/StatsSystem.h"
 #include "systems/CameraController.h"
 #include "utils/Logger.h"
+#include "cfg/Config.h"
 
+Engine::Engine() = default;
 Engine::~Engine() = default; // Define destructor here
 
 void Engine::Init(HWND hwnd, UINT width, UINT height)
@@ -21,12 +24,17 @@ void Engine::Init(HWND hwnd, UINT width, UINT height)
     m_SceneManager->Init(width, height);
 
     InitSystems();
+    InitHotReload();
 
     m_SceneManager->InitScene();
 }
 
 void Engine::Update(float deltaTime)
 {
+    // frame boundary: pick up edited files and finish streamed assets before
+    // any system touches them
+    ProcessFileChanges();
+    m_AssetManager->Update();
     m_SystemManager->UpdateAll(deltaTime);
 }
 
@@ -53,6 +61,7 @@ void Engine::InitServices(HWND hwnd, UINT width, UINT height)
 
     m_AssetManager = std::make_unique<AssetManager>();
     m_AssetManager->SetDeviceManager(m_DeviceManager.get());
+    m_AssetManager->InitPlaceholders();
     ServiceLocator::Provide(m_AssetManager.get());
 
     m_InputManager = std::make_unique<InputManager>();
@@ -76,4 +85,31 @@ void Engine::InitSystems()
 
     // initialize all registered systems
     m_SystemManager->InitAll();
-}
\ No newline at end of file
+}
+
+void Engine::InitHotReload()
+{
+    if (!Config::HotReload::ENABLE)
+        return;
+
+    m_FileWatcher = std::make_unique<FileWatcher>();
+    for (const char *dir : Config::HotReload::WATCH_DIRS)
+    {
+        if (m_FileWatcher->AddDirectory(dir))
+            LOG_INFO("Watching {} for changes", dir);
+    }
+}
+
+void Engine::ProcessFileChanges()
+{
+    if (!m_FileWatcher)
+        return;
+
+    // each consumer ignores paths it doesn't know
+    for (const auto &path : m_FileWatcher->Poll(Config::HotReload::SETTLE_MS))
+    {
+        LOG_DEBUG("File changed: {}", path.string());
+        m_AssetManager->OnSourceChanged(path);
+        m_SystemManager->OnFileChanged(path);
+    }
+}
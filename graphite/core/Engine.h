@@ -14,10 +14,12 @@ class InputManager;
 class RenderSystem;
 class StatsSystem;
 class CameraController;
+class FileWatcher;
 
 class Engine
 {
 public:
+    Engine();
     ~Engine();
     void Init(HWND hwnd, UINT width, UINT height);
     void Update(float deltaTime);
@@ -29,6 +31,7 @@ private:
     std::unique_ptr<DeviceManager> m_DeviceManager;
     std::unique_ptr<AssetManager> m_AssetManager;
     std::unique_ptr<InputManager> m_InputManager;
+    std::unique_ptr<FileWatcher> m_FileWatcher; // null when hot reload is off
 
     // core components
     std::unique_ptr<SceneManager> m_SceneManager;
@@ -40,4 +43,6 @@ private:
     // helpers
     void InitServices(HWND hwnd, UINT width, UINT height);
     void InitSystems();
+    void InitHotReload();
+    void ProcessFileChanges();
 };
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <filesystem>
+
 // all engine systems to be derived from this class
 class ISystem
 {
@@ -9,4 +11,6 @@ public:
     virtual void Update(float /*deltaTime*/) = 0;
     virtual void Shutdown() = 0;
     virtual void OnResize(int /*width*/, int /*height*/) {}
+    // hot reload, called between frames for every changed file under a watched directory
+    virtual void OnFileChanged(const std::filesystem::path & /*path*/) {}
 };
\ No newline at end of file
@@ -66,20 +66,31 @@ void SceneManager::InitScene()
         AssetID normalPath = SA::NORMAL_PATH;
         AssetID ormPath = SA::ORM_PATH;
 
-        // load model
-        if (!assetManager.LoadModel(modelPath))
-            LOG_ERROR("Failed to load model");
+        // stream in the model and textures, the entity renders once they land
+        ModelHandle model = assetManager.RequestModel(modelPath, [modelPath](ModelHandle, AssetState state)
+                                  {
+            if (state == AssetState::Failed)
+                LOG_ERROR("Failed to load model: {}", modelPath.string()); });
 
-        // load textures
-        if (!assetManager.LoadTexture(albedoPath) ||
-            !assetManager.LoadTexture(normalPath) ||
-            !assetManager.LoadTexture(ormPath))
-            LOG_ERROR("Failed to load textures");
+        auto requestTexture = [&assetManager](const AssetID &texturePath, TextureRole role)
+        {
+            return assetManager.RequestTexture(texturePath, role, [texturePath](TextureHandle, AssetState state)
+                                               {
+                if (state == AssetState::Failed)
+                    LOG_ERROR("Failed to load texture: {}", texturePath.string()); });
+        };
 
         // create material
-        Material mat{albedoPath, normalPath, ormPath};
-        if (!assetManager.AddMaterial(materialID, mat))
-            LOG_ERROR("Failed to add material");
+        Material mat;
+        mat.albedo = requestTexture(albedoPath, TextureRole::Albedo);
+        mat.normal = requestTexture(normalPath, TextureRole::Normal);
+        mat.orm = requestTexture(ormPath, TextureRole::ORM);
+        MaterialHandle material = assetManager.AddMaterial(materialID, mat);
+
+        // the material holds its own references now
+        assetManager.Release(mat.albedo);
+        assetManager.Release(mat.normal);
+        assetManager.Release(mat.orm);
 
         auto entity = m_Registry->CreateEntity();
         // set at origin with no rotation and scale of 1
@@ -88,7 +99,7 @@ void SceneManager::InitScene()
         t.rotation = glm::vec3(glm::pi<float>(), 0, 0);
         t.scale = glm::vec3(1, 1, 1);
         m_Registry->AddComponent<TransformComponent>(entity, t);
-        m_Registry->AddComponent<RenderableComponent>(entity, RenderableComponent{modelPath, 0, materialID});
+        m_Registry->AddComponent<RenderableComponent>(entity, RenderableComponent{model, 0, material});
     }
     catch (const std::exception &e)
     {
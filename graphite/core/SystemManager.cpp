@@ -35,4 +35,12 @@ void SystemManager::OnResize(int width, int height)
     {
         sys->OnResize(width, height);
     }
+}
+
+void SystemManager::OnFileChanged(const std::filesystem::path &path)
+{
+    for (auto &sys : m_Systems)
+    {
+        sys->OnFileChanged(path);
+    }
 }
\ No newline at end of file
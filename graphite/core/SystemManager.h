@@ -12,6 +12,7 @@ public:
     void UpdateAll(float deltaTime) const;
     void ShutdownAll() const;
     void OnResize(int width, int height);
+    void OnFileChanged(const std::filesystem::path &path);
 
 private:
     std::vector<std::unique_ptr<ISystem>> m_Systems;
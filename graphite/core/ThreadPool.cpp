@@ -0,0 +1,128 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+
+namespace
+{
+    // shared between the caller of ParallelFor and the helper tasks it queues.
+    // helpers that start after all chunks are claimed exit without touching fn
+    struct ParallelForState
+    {
+        const std::function<void(size_t, size_t)> *fn = nullptr;
+        size_t count = 0;
+        size_t grain = 1;
+        size_t chunkCount = 0;
+        std::atomic<size_t> nextChunk{0};
+        std::atomic<size_t> doneChunks{0};
+        std::mutex mutex;
+        std::condition_variable done;
+
+        void RunChunks()
+        {
+            for (;;)
+            {
+                size_t chunk = nextChunk.fetch_add(1);
+                if (chunk >= chunkCount)
+                    return;
+
+                size_t begin = chunk * grain;
+                size_t end = std::min(begin + grain, count);
+                (*fn)(begin, end);
+
+                if (doneChunks.fetch_add(1) + 1 == chunkCount)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    done.notify_all();
+                }
+            }
+        }
+    };
+}
+
+ThreadPool::ThreadPool(size_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        size_t hw = std::thread::hardware_concurrency();
+        threadCount = hw > 1 ? hw - 1 : 1;
+    }
+
+    m_Workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i)
+        m_Workers.emplace_back([this]()
+                               { WorkerLoop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_Condition.notify_all();
+
+    for (auto &worker : m_Workers)
+        worker.join();
+}
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Tasks.push_back(std::move(task));
+    }
+    m_Condition.notify_one();
+}
+
+void ThreadPool::WorkerLoop()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [this]()
+                             { return m_Stopping || !m_Tasks.empty(); });
+
+            // drain remaining work before exiting so no future is left unsatisfied
+            if (m_Tasks.empty())
+                return;
+
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)> &fn)
+{
+    if (count == 0)
+        return;
+
+    grain = std::max<size_t>(grain, 1);
+    size_t chunkCount = (count + grain - 1) / grain;
+    if (chunkCount == 1)
+    {
+        fn(0, count);
+        return;
+    }
+
+    auto state = std::make_shared<ParallelForState>();
+    state->fn = &fn;
+    state->count = count;
+    state->grain = grain;
+    state->chunkCount = chunkCount;
+
+    size_t helpers = std::min(chunkCount - 1, m_Workers.size());
+    for (size_t i = 0; i < helpers; ++i)
+        Enqueue([state]()
+                { state->RunChunks(); });
+
+    state->RunChunks();
+
+    // only wait on chunks already claimed by other threads, never on queued helpers
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&]()
+                     { return state->doneChunks.load() == chunkCount; });
+}
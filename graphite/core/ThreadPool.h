@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// fixed-size pool of worker threads fed from a single fifo queue
+class ThreadPool
+{
+public:
+    // 0 picks one worker per hardware thread, minus the calling thread
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    // prevent copy and assignment
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    template <typename F>
+    auto Submit(F &&fn) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+        // packaged_task is move-only, std::function needs something copyable
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(fn));
+        std::future<Result> future = task->get_future();
+        Enqueue([task]()
+                { (*task)(); });
+        return future;
+    }
+
+    // runs fn(begin, end) over [0, count) in chunks of at most grain items and
+    // blocks until every chunk is done. the calling thread works on chunks too,
+    // so this is safe to call from inside a pool task. fn must not throw
+    void ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)> &fn);
+
+    size_t GetThreadCount() const { return m_Workers.size(); }
+
+private:
+    void Enqueue(std::function<void()> task);
+    void WorkerLoop();
+
+    std::vector<std::thread> m_Workers;
+    std::deque<std::function<void()>> m_Tasks;
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    bool m_Stopping = false;
+};
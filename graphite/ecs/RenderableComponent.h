@@ -1,12 +1,15 @@
 #pragma once
-#include "core/CommonTypes.h"
+#include "assets/AssetHandle.h"
+#include <cstddef>
+#include <cstdint>
 
+// handles are resolved from paths once at load time, see AssetManager
 struct RenderableComponent
 {
     // std::string primitiveID;
 
-    // AssetID meshID;
-    AssetID modelID;
+    ModelHandle model;
     size_t subMeshIndex = 0; // submesh index in the model
-    AssetID materialID;
+    MaterialHandle material;
+    uint32_t lodIndex = 0; // level drawn last frame, kept for lod hysteresis
 };
@@ -1,14 +1,186 @@
 #include "AssetManager.h"
 #include "DeviceManager.h"
+#include "assets/AssetCache.h"
+#include "assets/AssetDecoder.h"
+#include "assets/AssetFiles.h"
+#include "assets/MipGenerator.h"
+#include "core/ThreadPool.h"
+#include "rendering/VertexLayout.h"
 #include "utils/Logger.h"
+#include "cfg/Config.h"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-#include <assimp/Importer.hpp>
-#include <assimp/mesh.h>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
 #include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <system_error>
+
+namespace
+{
+    // vertices split into the streams of Layout, back to back in out
+    template <typename Layout, typename Source>
+    void SplitStreams(const Source *vertices, size_t count, std::vector<unsigned char> &out)
+    {
+        out.resize(count * Layout::STRIDE);
+        std::array<void *, Layout::STREAM_COUNT> streams;
+        unsigned char *cursor = out.data();
+        for (UINT s = 0; s < Layout::STREAM_COUNT; ++s)
+        {
+            streams[s] = cursor;
+            cursor += count * Layout::STRIDES[s];
+        }
+        Layout::Split(vertices, count, streams.data());
+    }
+
+    // runs on the decode worker right after DecodeModel, so finalizing on the
+    // main thread only hands the streams to the geometry arena
+    void SplitModelStreams(AssetDecoder::DecodedModel &model, ThreadPool *pool)
+    {
+        const bool packed = !model.quantization.empty();
+        model.vertexStreams.resize(model.submeshes.size());
+
+        auto run = [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const auto &sm = model.submeshes[i];
+                if (packed)
+                {
+                    SplitStreams<VertexLayout::Packed>(model.packedVertices[i].data(), sm.vertexCount, model.vertexStreams[i]);
+                    std::vector<PackedVertex>().swap(model.packedVertices[i]);
+                }
+                else
+                {
+                    SplitStreams<VertexLayout::Full>(sm.vertices, sm.vertexCount, model.vertexStreams[i]);
+                }
+            }
+        };
+
+        if (pool)
+            pool->ParallelFor(model.submeshes.size(), 1, run);
+        else
+            run(0, model.submeshes.size());
+    }
+
+    DXGI_FORMAT ToDxgiFormat(TextureFormat format)
+    {
+        switch (format)
+        {
+        case TextureFormat::BC1:
+            return DXGI_FORMAT_BC1_UNORM;
+        case TextureFormat::BC4:
+            return DXGI_FORMAT_BC4_UNORM;
+        case TextureFormat::BC5:
+            return DXGI_FORMAT_BC5_UNORM;
+        case TextureFormat::BC7:
+            return DXGI_FORMAT_BC7_UNORM;
+        default:
+            return DXGI_FORMAT_R8G8B8A8_UNORM;
+        }
+    }
+
+    // bytes per row of texels, or per row of 4x4 blocks for bc formats
+    UINT RowPitch(DXGI_FORMAT format, UINT width)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC4_UNORM:
+            return ((width + 3) / 4) * 8;
+        case DXGI_FORMAT_BC5_UNORM:
+        case DXGI_FORMAT_BC7_UNORM:
+            return ((width + 3) / 4) * 16;
+        default:
+            return width * 4; // rgba8
+        }
+    }
+
+    // models and textures share one tracker, the top half tells them apart
+    constexpr ResidencyTracker::Key TEXTURE_KEY_BIT = ResidencyTracker::Key(1) << 32;
+
+    ResidencyTracker::Key ResidencyKey(ModelHandle handle) { return handle.id; }
+    ResidencyTracker::Key ResidencyKey(TextureHandle handle) { return TEXTURE_KEY_BIT | handle.id; }
+
+    uint64_t TextureLevelBytes(const AssetManager::TextureResource &texture, int level)
+    {
+        return BlockCompression::LevelBytes(
+            texture.format,
+            MipGenerator::LevelSize(int(texture.width), level),
+            MipGenerator::LevelSize(int(texture.height), level));
+    }
+
+    uint64_t ResidentTextureBytes(const AssetManager::TextureResource &texture)
+    {
+        uint64_t bytes = 0;
+        for (int l = texture.residentMip; l < texture.mipLevels; ++l)
+            bytes += TextureLevelBytes(texture, l);
+        return bytes;
+    }
+
+    double ElapsedMs(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // brings an evicted model or texture back when it is referenced again
+    template <typename Request, typename StartDecode>
+    void ReloadIfEvicted(Request &request, const char *kind, StartDecode &&startDecode)
+    {
+        if (request.state != AssetState::Evicted)
+            return;
+
+        LOG_INFO("Reloading evicted {}: {}", kind, request.path.string());
+        // a reload still running from before the eviction serves as the load
+        if (request.decode.valid())
+            request.state = AssetStates::Decoding(request.state);
+        else
+            startDecode();
+    }
+
+    // pool jobs, a null result means the decode failed and was already logged
+    std::unique_ptr<AssetDecoder::DecodedModel> DecodeModelJob(const AssetID &path, ThreadPool *pool)
+    {
+        auto decoded = std::make_unique<AssetDecoder::DecodedModel>();
+        if (!AssetDecoder::DecodeModel(path, *decoded, pool))
+            decoded.reset();
+        else
+            SplitModelStreams(*decoded, pool);
+        return decoded;
+    }
+
+    std::unique_ptr<CookedTexture::TextureData> ReadMipJob(const std::filesystem::path &path, int mip)
+    {
+        auto data = std::make_unique<CookedTexture::TextureData>();
+        if (!CookedTexture::Read(path, *data, mip, 1))
+            data.reset();
+        return data;
+    }
+
+    std::unique_ptr<AssetDecoder::DecodedTexture> DecodeTextureJob(const AssetID &path, TextureRole role, ThreadPool *pool)
+    {
+        auto decoded = std::make_unique<AssetDecoder::DecodedTexture>();
+        if (!AssetDecoder::DecodeTexture(path, role, *decoded, pool))
+            decoded.reset();
+        return decoded;
+    }
+}
+
+AssetManager::AssetManager()
+    : m_Residency(Config::Residency::BUDGET_MB * 1024 * 1024),
+      m_MipStreamer(Config::TextureStreaming::POOL_MB * 1024 * 1024),
+      m_DecodePool(std::make_unique<ThreadPool>(Config::Threading::ASSET_WORKER_COUNT))
+{
+    // packs that ship next to the exe, everything else is read loose
+    for (const char *pack : Config::AssetPacks::FILES)
+    {
+        std::error_code ec;
+        if (std::filesystem::is_regular_file(pack, ec))
+            AssetFiles::Mount(pack);
+    }
+}
+
+AssetManager::~AssetManager() = default;
 
 void AssetManager::SetDeviceManager(
     DeviceManager *deviceManager)
@@ -18,264 +190,866 @@ void AssetManager::SetDeviceManager(
 
 void AssetManager::Shutdown()
 {
+    // in-flight decodes reference nothing owned here, but wait so the pool is idle
+    for (auto handle : m_PendingModels)
+        m_Models.Get(handle)->decode.wait();
+    for (auto handle : m_PendingTextures)
+        m_Textures.Get(handle)->decode.wait();
+    for (auto &load : m_MipLoads)
+        load.data.wait();
+    m_PendingModels.clear();
+    m_PendingTextures.clear();
+    m_MipLoads.clear();
+    m_QueuedCallbacks.clear();
+
+    LOG_INFO("AssetManager: releasing {} models and {} textures ({} MB resident)",
+             m_Models.Size(), m_Textures.Size(), m_Residency.GetResidentBytes() / (1024 * 1024));
+    m_Models.Clear();
+    m_Textures.Clear();
+    m_Materials.Clear();
+    m_ModelHandles.clear();
+    m_TextureHandles.clear();
+    m_MaterialHandles.clear();
+    m_Dependents.clear();
+    m_Residency = ResidencyTracker(m_Residency.GetBudget());
+    m_MipStreamer = MipStreamer(m_MipStreamer.GetBudget());
+    for (auto &placeholder : m_Placeholders)
+        placeholder = {};
+    AssetFiles::UnmountAll();
+
     LOG_INFO("AssetManager: Shutdown complete");
 }
 
-bool AssetManager::LoadTexture(
-    const AssetID &path)
+void AssetManager::InitPlaceholders()
 {
-    if (m_Textures.count(path))
-        return true;
+    // neutral values: white albedo, flat tangent space normal, no occlusion,
+    // fully rough and non-metallic
+    const unsigned char texels[size_t(TextureRole::Count)][4] = {
+        {255, 255, 255, 255},
+        {128, 128, 255, 255},
+        {255, 255, 0, 255}};
 
-    int w, h, c;
-    auto *data = LoadImageDataFromFile(path, w, h, c);
-    if (!data)
+    for (size_t i = 0; i < m_Placeholders.size(); ++i)
     {
-        LOG_CRITICAL("Failed to load texture data from file: {}", path.string());
-        throw std::runtime_error("Failed to load texture: " + path.string());
+        const unsigned char *level = texels[i];
+        if (!CreateTextureAndSRV(1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, 1, &level, m_Placeholders[i]))
+        {
+            LOG_CRITICAL("Failed to create placeholder texture");
+            throw std::runtime_error("Failed to create placeholder texture");
+        }
     }
+}
 
-    TextureResource res;
-    if (!CreateTextureAndSRV(w, h, DXGI_FORMAT_R8G8B8A8_UNORM, data, res))
+ModelHandle AssetManager::RequestModel(
+    const AssetID &path,
+    ModelCallback onComplete)
+{
+    ModelHandle handle;
+    auto it = m_ModelHandles.find(path);
+    if (it != m_ModelHandles.end())
+    {
+        handle = it->second;
+    }
+    else
     {
-        LOG_CRITICAL("Failed to create texture and SRV");
-        throw std::runtime_error("Failed to create texture and SRV: " + path.string());
+        ModelRequest request;
+        request.path = path;
+        handle = m_Models.Insert(std::move(request));
+        m_ModelHandles[path] = handle;
+        for (const auto &file : AssetCache::GetSourceFiles(path, AssetCache::Kind::Model))
+            m_Dependents.emplace(file.generic_string(), ResidencyKey(handle));
+        StartModelDecode(handle);
     }
 
-    m_Textures[path] = std::move(res);
-    return true;
+    // reloads an evicted model
+    AddRef(handle);
+
+    auto &request = *m_Models.Get(handle);
+    if (onComplete)
+    {
+        if (request.state == AssetState::Pending)
+            request.callbacks.push_back(std::move(onComplete));
+        else
+            m_QueuedCallbacks.push_back([cb = std::move(onComplete), handle, state = request.state]()
+                                        { cb(handle, state); });
+    }
+    return handle;
 }
 
-bool AssetManager::LoadModel(
-    const AssetID &path)
+TextureHandle AssetManager::RequestTexture(
+    const AssetID &path,
+    TextureRole role,
+    TextureCallback onComplete)
 {
-    // if (m_Meshes.count(path))
-    //    return true;
+    TextureHandle handle;
+    auto it = m_TextureHandles.find(path);
+    if (it != m_TextureHandles.end())
+    {
+        handle = it->second;
+    }
+    else
+    {
+        TextureRequest request;
+        request.path = path;
+        request.role = role;
+        handle = m_Textures.Insert(std::move(request));
+        m_TextureHandles[path] = handle;
+        m_Dependents.emplace(path.lexically_normal().generic_string(), ResidencyKey(handle));
+        StartTextureDecode(handle);
+    }
+
+    // reloads an evicted texture
+    AddRef(handle);
+
+    auto &request = *m_Textures.Get(handle);
+    if (onComplete)
+    {
+        if (request.state == AssetState::Pending)
+            request.callbacks.push_back(std::move(onComplete));
+        else
+            m_QueuedCallbacks.push_back([cb = std::move(onComplete), handle, state = request.state]()
+                                        { cb(handle, state); });
+    }
+    return handle;
+}
 
-    if (m_Models.count(path))
-        return true;
+void AssetManager::StartModelDecode(
+    ModelHandle handle)
+{
+    auto &request = *m_Models.Get(handle);
+    request.state = AssetStates::Decoding(request.state);
+    request.decode = m_DecodePool->Submit([path = request.path, pool = m_DecodePool.get()]()
+                                          { return DecodeModelJob(path, pool); });
+    m_PendingModels.push_back(handle);
+}
 
-    Assimp::Importer importer;
-    unsigned flags =
-        aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_JoinIdenticalVertices | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_ValidateDataStructure | aiProcess_FlipWindingOrder;
-    const aiScene *scene = importer.ReadFile(
-        path.string(),
-        flags);
+void AssetManager::StartTextureDecode(
+    TextureHandle handle)
+{
+    auto &request = *m_Textures.Get(handle);
+    request.state = AssetStates::Decoding(request.state);
+    request.decode = m_DecodePool->Submit([path = request.path, role = request.role, pool = m_DecodePool.get()]()
+                                          { return DecodeTextureJob(path, role, pool); });
+    m_PendingTextures.push_back(handle);
+}
 
-    if (!scene || !scene->HasMeshes())
+void AssetManager::OnSourceChanged(
+    const std::filesystem::path &path)
+{
+    auto range = m_Dependents.equal_range(path.lexically_normal().generic_string());
+    for (auto it = range.first; it != range.second; ++it)
     {
-        LOG_CRITICAL("AssetManager Failed to load model: {}", path.string());
-        throw std::runtime_error("Failed to load model: " + path.string());
+        if (it->second & TEXTURE_KEY_BIT)
+            ReloadTexture(TextureHandle{static_cast<uint32_t>(it->second)});
+        else
+            ReloadModel(ModelHandle{static_cast<uint32_t>(it->second)});
     }
+}
 
-    ModelResource model;
-    model.meshes.reserve(scene->mNumMeshes);
-    for (unsigned i = 0; i < scene->mNumMeshes; ++i)
+void AssetManager::ReloadModel(
+    ModelHandle handle)
+{
+    auto &request = *m_Models.Get(handle);
+    if (request.state == AssetState::Evicted)
+        return; // loads the new version whenever it is referenced again
+
+    // the running decode may have read the old file, go again once it lands
+    if (request.decode.valid())
     {
-        aiMesh *mesh = scene->mMeshes[i];
-        std::vector<Vertex> vertices;
-        std::vector<uint32_t> indices;
+        request.reloadQueued = true;
+        return;
+    }
 
-        if (!ProcessAssimpMesh(mesh, vertices, indices))
-        {
-            LOG_CRITICAL("AssetManager Failed to process mesh: {}", path.string());
-            throw std::runtime_error("Failed to process mesh: " + path.string());
-        }
+    LOG_INFO("Source changed, reloading model: {}", request.path.string());
+    StartModelDecode(handle);
+}
 
-        MeshResource mr;
-        if (!CreateMeshResourceBuffers(vertices, indices, mr))
-        {
-            LOG_CRITICAL("AssetManager Failed to create mesh resource buffers: {}", path.string());
-            throw std::runtime_error("Failed to create mesh resource buffers: " + path.string());
-        }
+void AssetManager::ReloadTexture(
+    TextureHandle handle)
+{
+    auto &request = *m_Textures.Get(handle);
+    if (request.state == AssetState::Evicted)
+        return;
 
-        model.meshes.push_back(std::move(mr));
+    if (request.decode.valid())
+    {
+        request.reloadQueued = true;
+        return;
     }
 
-    m_Models[path] = std::move(model);
-    LOG_INFO("Model loaded successfully: {}", path.string());
-    return true;
+    LOG_INFO("Source changed, reloading texture: {}", request.path.string());
+    StartTextureDecode(handle);
 }
 
-bool AssetManager::AddMaterial(
-    const AssetID &id,
-    const Material &material)
+void AssetManager::AddRef(
+    ModelHandle handle)
 {
-    m_Materials[id] = material;
-    return true;
+    auto *request = m_Models.Get(handle);
+    if (!request)
+        return;
+
+    m_Residency.AddRef(ResidencyKey(handle));
+    ReloadIfEvicted(*request, "model", [&]()
+                    { StartModelDecode(handle); });
 }
 
-const Material *AssetManager::GetMaterial(
-    const AssetID &id) const
+void AssetManager::AddRef(
+    TextureHandle handle)
 {
-    auto it = m_Materials.find(id);
-    return it != m_Materials.end() ? &it->second : nullptr;
+    auto *request = m_Textures.Get(handle);
+    if (!request)
+        return;
+
+    m_Residency.AddRef(ResidencyKey(handle));
+    ReloadIfEvicted(*request, "texture", [&]()
+                    { StartTextureDecode(handle); });
 }
 
-const AssetManager::ModelResource *AssetManager::GetModel(
-    const AssetID &id) const
+void AssetManager::Release(
+    ModelHandle handle)
 {
-    auto it = m_Models.find(id);
-    return (it != m_Models.end()) ? &it->second : nullptr;
+    if (m_Models.Get(handle))
+        m_Residency.Release(ResidencyKey(handle));
 }
 
-const AssetManager::TextureResource *AssetManager::GetTexture(
-    const AssetID &id) const
+void AssetManager::Release(
+    TextureHandle handle)
 {
-    auto it = m_Textures.find(id);
-    return (it != m_Textures.end()) ? &it->second : nullptr;
+    if (m_Textures.Get(handle))
+        m_Residency.Release(ResidencyKey(handle));
 }
 
-bool AssetManager::ProcessAssimpMesh(
-    aiMesh *mesh,
-    std::vector<Vertex> &outVertices,
-    std::vector<uint32_t> &outIndices) const
+AssetState AssetManager::GetModelState(
+    ModelHandle handle) const
 {
-    if (!mesh->HasPositions())
-        return false;
+    auto *request = m_Models.Get(handle);
+    return request ? request->state : AssetState::Failed;
+}
 
-    outVertices.reserve(mesh->mNumVertices);
-    for (unsigned i = 0; i < mesh->mNumVertices; ++i)
+AssetState AssetManager::GetTextureState(
+    TextureHandle handle) const
+{
+    auto *request = m_Textures.Get(handle);
+    return request ? request->state : AssetState::Failed;
+}
+
+void AssetManager::Update()
+{
+    ProcessCompletedRequests(Config::Streaming::UPLOAD_BUDGET_MS);
+    EnforceResidencyBudget();
+    UpdateTextureStreaming();
+    FlushCallbacks();
+}
+
+void AssetManager::RequestTextureDetail(
+    TextureHandle handle,
+    float uvDensity,
+    float pixelsPerUnit)
+{
+    if (!m_MipStreamer.Contains(handle.id))
+        return;
+
+    // uv density is per unit of uv area, so scale by the texel count of mip 0
+    const auto &texture = m_Textures.Get(handle)->resource;
+    const float texelsPerUnit = uvDensity * std::sqrt(float(texture.width) * float(texture.height));
+    m_MipStreamer.Request(handle.id, MipStreamer::RequiredMip(texelsPerUnit, pixelsPerUnit, texture.mipLevels));
+}
+
+void AssetManager::UpdateTextureStreaming()
+{
+    // reads that finished since last frame. they were paid for in the upload
+    // cap when issued, so all of them go up now
+    for (size_t i = 0; i < m_MipLoads.size();)
     {
-        Vertex v{};
+        MipLoad &load = m_MipLoads[i];
+        if (load.data.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++i;
+            continue;
+        }
+
+        auto data = load.data.get();
+        auto *request = m_Textures.Get(load.handle);
+        if (request && request->state == AssetState::Ready && request->streamSerial == load.serial)
+        {
+            bool applied = false;
+            if (data)
+            {
+                std::vector<const unsigned char *> levels(request->resource.mipLevels, nullptr);
+                levels[load.mip] = data->levels.data();
+                applied = ChangeResidentMip(request->resource, load.mip, levels.data());
+            }
+            if (!applied)
+                LOG_WARN("Failed to stream mip {} of {}", load.mip, request->path.string());
 
-        v.Position = {mesh->mVertices[i].x,
-                      mesh->mVertices[i].y,
-                      mesh->mVertices[i].z};
+            m_MipStreamer.Complete(load.handle.id, applied);
+            m_Residency.MarkResident(ResidencyKey(load.handle), request->resource.gpuBytes);
+        }
+        m_MipLoads.erase(m_MipLoads.begin() + i);
+    }
 
-        if (mesh->HasNormals())
+    std::vector<MipStreamer::Transition> transitions;
+    m_MipStreamer.Update(Config::TextureStreaming::UPLOAD_KB_PER_FRAME * 1024, transitions);
+    for (const auto &t : transitions)
+    {
+        const TextureHandle handle{t.key};
+        auto &request = *m_Textures.Get(handle);
+
+        // dropping levels only copies what stays, nothing to read
+        if (t.toMip > t.fromMip)
         {
-            v.Normal = {mesh->mNormals[i].x,
-                        mesh->mNormals[i].y,
-                        mesh->mNormals[i].z};
+            if (!ChangeResidentMip(request.resource, t.toMip, nullptr))
+                LOG_WARN("Failed to drop mips of {}", request.path.string());
+            m_Residency.MarkResident(ResidencyKey(handle), request.resource.gpuBytes);
+            continue;
         }
 
-        if (mesh->HasTextureCoords(0))
+        MipLoad load;
+        load.handle = handle;
+        load.serial = request.streamSerial;
+        load.mip = t.toMip;
+        load.data = m_DecodePool->Submit([path = request.streamSource, mip = t.toMip]()
+                                         { return ReadMipJob(path, mip); });
+        m_MipLoads.push_back(std::move(load));
+    }
+}
+
+void AssetManager::EnforceResidencyBudget()
+{
+    auto evicted = m_Residency.CollectEvictions();
+    for (ResidencyTracker::Key key : evicted)
+    {
+        // dropping the resource releases the d3d objects
+        if (key & TEXTURE_KEY_BIT)
         {
-            v.TexCoord = {mesh->mTextureCoords[0][i].x,
-                          mesh->mTextureCoords[0][i].y};
+            auto &request = *m_Textures.Get(TextureHandle{static_cast<uint32_t>(key)});
+            request.resource = {};
+            request.state = AssetState::Evicted;
+            ++request.streamSerial;
+            m_MipStreamer.Remove(static_cast<uint32_t>(key));
+            LOG_DEBUG("Evicted texture: {}", request.path.string());
         }
+        else
+        {
+            auto &request = *m_Models.Get(ModelHandle{static_cast<uint32_t>(key)});
+            request.resource = {};
+            request.state = AssetState::Evicted;
+            LOG_DEBUG("Evicted model: {}", request.path.string());
+        }
+    }
+
+    if (!evicted.empty())
+        LOG_INFO("Evicted {} assets, {} of {} MB resident", evicted.size(),
+                 m_Residency.GetResidentBytes() / (1024 * 1024), m_Residency.GetBudget() / (1024 * 1024));
+}
+
+void AssetManager::ProcessCompletedRequests(
+    double budgetMs)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto isReady = [](const auto &future)
+    {
+        return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    };
+    auto budgetSpent = [&]()
+    {
+        return budgetMs > 0.0 && ElapsedMs(start) >= budgetMs;
+    };
 
-        if (mesh->HasTangentsAndBitangents())
+    // at least one upload per call, so a single large asset can't stall forever
+    for (size_t i = 0; i < m_PendingModels.size();)
+    {
+        ModelHandle handle = m_PendingModels[i];
+        if (!isReady(m_Models.Get(handle)->decode))
         {
-            v.Tangent = {mesh->mTangents[i].x,
-                         mesh->mTangents[i].y,
-                         mesh->mTangents[i].z};
+            ++i;
+            continue;
         }
 
-        outVertices.push_back(v);
+        CompleteModelRequest(handle);
+        m_PendingModels.erase(m_PendingModels.begin() + i);
+        if (budgetSpent())
+            return;
     }
 
-    outIndices.reserve(mesh->mNumFaces * 3);
-    for (unsigned f = 0; f < mesh->mNumFaces; ++f)
+    for (size_t i = 0; i < m_PendingTextures.size();)
     {
-        const auto &face = mesh->mFaces[f];
-        outIndices.push_back(face.mIndices[0]);
-        outIndices.push_back(face.mIndices[1]);
-        outIndices.push_back(face.mIndices[2]);
+        TextureHandle handle = m_PendingTextures[i];
+        if (!isReady(m_Textures.Get(handle)->decode))
+        {
+            ++i;
+            continue;
+        }
+
+        CompleteTextureRequest(handle);
+        m_PendingTextures.erase(m_PendingTextures.begin() + i);
+        if (budgetSpent())
+            return;
     }
+}
+
+void AssetManager::CompleteModelRequest(
+    ModelHandle handle)
+{
+    auto &request = *m_Models.Get(handle);
+    auto decoded = request.decode.get();
 
+    if (!AssetStates::KeepsResult(request.state))
+    {
+        LOG_DEBUG("Dropped reload of evicted model: {}", request.path.string());
+        request.reloadQueued = false;
+        return;
+    }
+
+    const bool reload = request.state == AssetState::Ready;
+    ModelResource resource;
+    if (!decoded)
+    {
+        LOG_ERROR("AssetManager Failed to load model: {}", request.path.string());
+        request.state = AssetStates::Completed(request.state, false);
+    }
+    else if (!FinalizeModel(*decoded, resource))
+    {
+        LOG_ERROR("AssetManager Failed to create mesh resource buffers: {}", request.path.string());
+        request.state = AssetStates::Completed(request.state, false);
+    }
+    else
+    {
+        LOG_INFO("Model {} ({}): {}", reload ? "reloaded" : "loaded", decoded->fromCooked ? "cooked" : "assimp", request.path.string());
+        request.resource = std::move(resource);
+        request.state = AssetStates::Completed(request.state, true);
+        m_Residency.MarkResident(ResidencyKey(handle), request.resource.gpuBytes);
+    }
+
+    for (auto &cb : request.callbacks)
+        m_QueuedCallbacks.push_back([cb = std::move(cb), handle, state = request.state]()
+                                    { cb(handle, state); });
+    request.callbacks.clear();
+
+    if (request.reloadQueued)
+    {
+        request.reloadQueued = false;
+        ReloadModel(handle);
+    }
+}
+
+void AssetManager::CompleteTextureRequest(
+    TextureHandle handle)
+{
+    auto &request = *m_Textures.Get(handle);
+    auto decoded = request.decode.get();
+
+    if (!AssetStates::KeepsResult(request.state))
+    {
+        LOG_DEBUG("Dropped reload of evicted texture: {}", request.path.string());
+        request.reloadQueued = false;
+        return;
+    }
+
+    const bool reload = request.state == AssetState::Ready;
+    TextureResource resource;
+    if (!decoded)
+    {
+        LOG_ERROR("Failed to load texture data from file: {}", request.path.string());
+        request.state = AssetStates::Completed(request.state, false);
+    }
+    else if (!FinalizeTexture(*decoded, resource))
+    {
+        LOG_ERROR("Failed to create texture and SRV: {}", request.path.string());
+        request.state = AssetStates::Completed(request.state, false);
+    }
+    else
+    {
+        if (reload)
+            LOG_INFO("Texture reloaded: {}", request.path.string());
+        request.resource = std::move(resource);
+        request.state = AssetStates::Completed(request.state, true);
+        m_Residency.MarkResident(ResidencyKey(handle), request.resource.gpuBytes);
+
+        // finer levels stream from the cooked file, a reload starts over
+        ++request.streamSerial;
+        request.streamSource = std::move(decoded->cookedPath);
+        const auto &texture = request.resource;
+        if (Config::TextureStreaming::ENABLE && !request.streamSource.empty())
+        {
+            std::vector<uint64_t> levelBytes(texture.mipLevels);
+            for (int l = 0; l < texture.mipLevels; ++l)
+                levelBytes[l] = TextureLevelBytes(texture, l);
+            m_MipStreamer.Add(handle.id, std::move(levelBytes), texture.residentMip,
+                              MipStreamer::CoarsestTopMip(texture.format, int(texture.width), int(texture.height), texture.mipLevels));
+        }
+        else
+        {
+            m_MipStreamer.Remove(handle.id);
+        }
+    }
+
+    for (auto &cb : request.callbacks)
+        m_QueuedCallbacks.push_back([cb = std::move(cb), handle, state = request.state]()
+                                    { cb(handle, state); });
+    request.callbacks.clear();
+
+    if (request.reloadQueued)
+    {
+        request.reloadQueued = false;
+        ReloadTexture(handle);
+    }
+}
+
+void AssetManager::FlushCallbacks()
+{
+    // callbacks may issue new requests, so run from a local copy
+    while (!m_QueuedCallbacks.empty())
+    {
+        auto callbacks = std::move(m_QueuedCallbacks);
+        m_QueuedCallbacks.clear();
+        for (auto &cb : callbacks)
+            cb();
+    }
+}
+
+bool AssetManager::LoadTexture(
+    const AssetID &path,
+    TextureRole role)
+{
+    return LoadAssets({}, {{path, role}});
+}
+
+bool AssetManager::LoadModel(
+    const AssetID &path)
+{
+    return LoadAssets({path}, {});
+}
+
+bool AssetManager::LoadAssets(
+    const std::vector<AssetID> &models,
+    const std::vector<std::pair<AssetID, TextureRole>> &textures)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // queue everything first so all decodes run concurrently
+    std::vector<ModelHandle> modelHandles;
+    for (const auto &path : models)
+        modelHandles.push_back(RequestModel(path));
+
+    std::vector<TextureHandle> textureHandles;
+    for (const auto &[path, role] : textures)
+        textureHandles.push_back(RequestTexture(path, role));
+
+    // then wait for each one and finalize without a budget
+    for (auto handle : modelHandles)
+    {
+        auto &request = *m_Models.Get(handle);
+        if (request.state == AssetState::Pending)
+            request.decode.wait();
+    }
+    for (auto handle : textureHandles)
+    {
+        auto &request = *m_Textures.Get(handle);
+        if (request.state == AssetState::Pending)
+            request.decode.wait();
+    }
+    ProcessCompletedRequests(0.0);
+    FlushCallbacks();
+
+    for (auto handle : modelHandles)
+    {
+        const auto &request = *m_Models.Get(handle);
+        if (request.state != AssetState::Ready)
+            throw std::runtime_error("Failed to load model: " + request.path.string());
+    }
+    for (auto handle : textureHandles)
+    {
+        const auto &request = *m_Textures.Get(handle);
+        if (request.state != AssetState::Ready)
+            throw std::runtime_error("Failed to load texture: " + request.path.string());
+    }
+
+    LOG_INFO("Loaded {} models and {} textures in {} ms using {} workers",
+             modelHandles.size(), textureHandles.size(), ElapsedMs(start), m_DecodePool->GetThreadCount());
     return true;
 }
 
-bool AssetManager::CreateMeshResourceBuffers(
-    const std::vector<Vertex> &vertices,
-    const std::vector<uint32_t> &indices,
-    MeshResource &outResource) const
+bool AssetManager::FinalizeModel(
+    AssetDecoder::DecodedModel &decoded,
+    ModelResource &outModel)
 {
-    auto *device = m_DeviceManager->GetDevice();
-    if (!device)
+    // the decode worker already split the vertices into the streams of
+    // VertexLayout::Full or Packed. indices go straight from the decoded
+    // views, which for cooked meshes point into the mapped file
+    static_assert(VertexLayout::Full::STREAM_COUNT == VertexLayout::Packed::STREAM_COUNT);
+    const bool packed = !decoded.quantization.empty();
+    const UINT *strides = packed ? VertexLayout::Packed::STRIDES.data() : VertexLayout::Full::STRIDES.data();
+    ModelResource model;
+    model.meshes.reserve(decoded.submeshes.size());
+    for (size_t i = 0; i < decoded.submeshes.size(); ++i)
+    {
+        const auto &sm = decoded.submeshes[i];
+        std::array<const void *, VertexLayout::Full::STREAM_COUNT> streams;
+        const unsigned char *cursor = decoded.vertexStreams[i].data();
+        for (UINT s = 0; s < VertexLayout::Full::STREAM_COUNT; ++s)
+        {
+            streams[s] = cursor;
+            cursor += sm.vertexCount * strides[s];
+        }
+
+        // the tangent stream is the last one, so leaving it out keeps the rest in place
+        const UINT streamCount = decoded.hasTangents[i] ? VERTEX_STREAM_TANGENT + 1 : VERTEX_STREAM_TANGENT;
+
+        MeshResource mr;
+        if (!CreateMeshResourceBuffers(streams.data(), strides, streamCount, sm.vertexCount, sm.indices, sm.indexCount, mr))
+            return false;
+
+        if (packed)
+            mr.quantization = decoded.quantization[i];
+
+        mr.lods.assign(sm.lods, sm.lods + sm.lodCount);
+        mr.indexCount = mr.lods.front().indexCount;
+        mr.uvDensity = sm.uvDensity;
+        mr.bounds = decoded.bounds[i];
+        if (i < decoded.meshlets.size())
+            mr.meshlets = std::move(decoded.meshlets[i]);
+
+        model.gpuBytes += mr.geometry.bytes;
+        model.meshes.push_back(std::move(mr));
+    }
+
+    outModel = std::move(model);
+    return true;
+}
+
+bool AssetManager::FinalizeTexture(
+    const AssetDecoder::DecodedTexture &decoded,
+    TextureResource &outTexture)
+{
+    auto levels = AssetDecoder::GetLevels(decoded);
+
+    // streamed textures go up with their coarse levels only
+    int first = decoded.firstLevel;
+    if (Config::TextureStreaming::ENABLE && !decoded.cookedPath.empty())
+        first = std::max(first, MipStreamer::StartMip(decoded.format, decoded.width, decoded.height, decoded.mipLevels,
+                                                      Config::TextureStreaming::START_SIZE));
+
+    TextureResource res;
+    if (!CreateTextureAndSRV(
+            MipGenerator::LevelSize(decoded.width, first),
+            MipGenerator::LevelSize(decoded.height, first),
+            ToDxgiFormat(decoded.format),
+            UINT(decoded.mipLevels - first),
+            levels.data() + first,
+            res))
         return false;
 
-    // fill index count
-    // using static cast to avoid narrowing conversion preemptively
-    outResource.indexCount = static_cast<UINT>(indices.size());
+    res.width = UINT(decoded.width);
+    res.height = UINT(decoded.height);
+    res.format = decoded.format;
+    res.mipLevels = decoded.mipLevels;
+    res.residentMip = first;
+    res.gpuBytes = ResidentTextureBytes(res);
+
+    outTexture = std::move(res);
+    return true;
+}
+
+MaterialHandle AssetManager::AddMaterial(
+    const AssetID &id,
+    const Material &material)
+{
+    AddRef(material.albedo);
+    AddRef(material.normal);
+    AddRef(material.orm);
 
-    // vertex buffer
-    D3D11_BUFFER_DESC vbDesc{};
-    vbDesc.Usage = D3D11_USAGE_IMMUTABLE;
-    vbDesc.ByteWidth = UINT(sizeof(Vertex) * vertices.size());
-    vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-    D3D11_SUBRESOURCE_DATA vbData{vertices.data(), 0, 0};
-    if (FAILED(device->CreateBuffer(&vbDesc, &vbData, outResource.vertexBuffer.GetAddressOf())))
+    auto it = m_MaterialHandles.find(id);
+    if (it != m_MaterialHandles.end())
     {
-        LOG_ERROR("Vertex buffer creation failed");
-        return false;
+        Material &old = *m_Materials.Get(it->second);
+        Release(old.albedo);
+        Release(old.normal);
+        Release(old.orm);
+        old = material;
+        return it->second;
     }
 
-    // index buffer
-    D3D11_BUFFER_DESC ibDesc{};
-    ibDesc.Usage = D3D11_USAGE_IMMUTABLE;
-    ibDesc.ByteWidth = UINT(sizeof(uint32_t) * indices.size());
-    ibDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-    D3D11_SUBRESOURCE_DATA ibData{indices.data(), 0, 0};
-    if (FAILED(device->CreateBuffer(&ibDesc, &ibData, outResource.indexBuffer.GetAddressOf())))
+    MaterialHandle handle = m_Materials.Insert(material);
+    m_MaterialHandles[id] = handle;
+    return handle;
+}
+
+ModelHandle AssetManager::FindModel(
+    const AssetID &path) const
+{
+    auto it = m_ModelHandles.find(path);
+    return it != m_ModelHandles.end() ? it->second : ModelHandle{};
+}
+
+TextureHandle AssetManager::FindTexture(
+    const AssetID &path) const
+{
+    auto it = m_TextureHandles.find(path);
+    return it != m_TextureHandles.end() ? it->second : TextureHandle{};
+}
+
+MaterialHandle AssetManager::FindMaterial(
+    const AssetID &id) const
+{
+    auto it = m_MaterialHandles.find(id);
+    return it != m_MaterialHandles.end() ? it->second : MaterialHandle{};
+}
+
+const Material *AssetManager::GetMaterial(
+    MaterialHandle handle) const
+{
+    return m_Materials.Get(handle);
+}
+
+const AssetManager::ModelResource *AssetManager::GetModel(
+    ModelHandle handle) const
+{
+    auto *request = m_Models.Get(handle);
+    return (request && request->state == AssetState::Ready) ? &request->resource : nullptr;
+}
+
+const AssetManager::TextureResource *AssetManager::GetTexture(
+    TextureHandle handle) const
+{
+    auto *request = m_Textures.Get(handle);
+    return (request && request->state == AssetState::Ready) ? &request->resource : nullptr;
+}
+
+const AssetManager::TextureResource &AssetManager::GetPlaceholderTexture(
+    TextureRole role) const
+{
+    return m_Placeholders[size_t(role)];
+}
+
+bool AssetManager::CreateMeshResourceBuffers(
+    const void *const *streams,
+    const UINT *strides,
+    UINT streamCount,
+    size_t vertexCount,
+    const uint32_t *indices,
+    size_t indexCount,
+    MeshResource &outResource)
+{
+    // fill index count
+    // using static cast to avoid narrowing conversion preemptively
+    outResource.indexCount = static_cast<UINT>(indexCount);
+
+    // sub-allocated from the shared buffers, indices shrink to 16 bit when they fit
+    if (!m_Geometry.Upload(
+            m_DeviceManager->GetDevice(),
+            m_DeviceManager->GetContext(),
+            streams,
+            strides,
+            streamCount,
+            vertexCount,
+            indices,
+            indexCount,
+            outResource.geometry))
     {
-        LOG_ERROR("Index buffer creation failed");
+        LOG_ERROR("Mesh upload failed ({} vertices, {} indices)", vertexCount, indexCount);
         return false;
     }
 
     return true;
 }
 
-unsigned char *AssetManager::LoadImageDataFromFile(
-    const AssetID &path,
-    int &outWidth,
-    int &outHeight,
-    int &outChannels) const
+bool AssetManager::ChangeResidentMip(
+    TextureResource &texture,
+    int mip,
+    const unsigned char *const *levels)
 {
-    unsigned char *data = stbi_load(
-        path.string().c_str(),
-        &outWidth,
-        &outHeight,
-        &outChannels,
-        4); // 4 channels (rgba)
+    auto *device = m_DeviceManager->GetDevice();
+    auto *context = m_DeviceManager->GetContext();
+    if (!device || !context || mip < 0 || mip >= texture.mipLevels)
+        return false;
+
+    // default usage, the levels arrive by copy and update after creation
+    const DXGI_FORMAT format = ToDxgiFormat(texture.format);
+    D3D11_TEXTURE2D_DESC texDesc{};
+    texDesc.Width = UINT(MipGenerator::LevelSize(int(texture.width), mip));
+    texDesc.Height = UINT(MipGenerator::LevelSize(int(texture.height), mip));
+    texDesc.MipLevels = UINT(texture.mipLevels - mip);
+    texDesc.ArraySize = 1;
+    texDesc.Format = format;
+    texDesc.SampleDesc = {1, 0};
+    texDesc.Usage = D3D11_USAGE_DEFAULT;
+    texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
 
-    if (!data)
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> tex;
+    HRESULT hr = device->CreateTexture2D(&texDesc, nullptr, tex.GetAddressOf());
+    if (FAILED(hr))
     {
-        LOG_ERROR("Failed to load image data from file: {}", path.string());
+        LOG_ERROR("CreateTexture2D failed: {}", hr);
+        return false;
+    }
+
+    for (int l = mip; l < texture.mipLevels; ++l)
+    {
+        const UINT dst = UINT(l - mip);
+        if (l >= texture.residentMip)
+        {
+            context->CopySubresourceRegion(tex.Get(), dst, 0, 0, 0, texture.texture.Get(), UINT(l - texture.residentMip), nullptr);
+            continue;
+        }
+        if (!levels || !levels[l])
+            return false;
+        context->UpdateSubresource(tex.Get(), dst, nullptr, levels[l], RowPitch(format, UINT(MipGenerator::LevelSize(int(texture.width), l))), 0);
     }
 
-    return data;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+    hr = device->CreateShaderResourceView(tex.Get(), nullptr, srv.GetAddressOf());
+    if (FAILED(hr))
+    {
+        LOG_ERROR("CreateShaderResourceView failed: {}", hr);
+        return false;
+    }
+
+    texture.texture = std::move(tex);
+    texture.srv = std::move(srv);
+    texture.residentMip = mip;
+    texture.gpuBytes = ResidentTextureBytes(texture);
+    return true;
 }
 
 bool AssetManager::CreateTextureAndSRV(
     int width,
     int height,
     DXGI_FORMAT format,
-    unsigned char *pixelData,
+    UINT mipLevels,
+    const unsigned char *const *levels,
     TextureResource &outResource) const
 {
     auto *device = m_DeviceManager->GetDevice();
     if (!device)
-    {
-        stbi_image_free(pixelData);
         return false;
-    }
 
     // texture description
     D3D11_TEXTURE2D_DESC texDesc{};
     texDesc.Width = width;
     texDesc.Height = height;
-    texDesc.MipLevels = 1;
+    texDesc.MipLevels = mipLevels;
     texDesc.ArraySize = 1;
     texDesc.Format = format;
     texDesc.SampleDesc = {1, 0};
     texDesc.Usage = D3D11_USAGE_IMMUTABLE;
     texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
 
-    D3D11_SUBRESOURCE_DATA initData{};
-    initData.pSysMem = pixelData;
-    initData.SysMemPitch = width * 4; // 4 bytes per pixel (RGBA)
-    initData.SysMemSlicePitch = 0;    // not used for 2D textures
+    // one subresource per mip, all uploaded by the same call
+    std::vector<D3D11_SUBRESOURCE_DATA> initData(mipLevels);
+    for (UINT l = 0; l < mipLevels; ++l)
+    {
+        initData[l].pSysMem = levels[l];
+        initData[l].SysMemPitch = RowPitch(format, UINT(MipGenerator::LevelSize(width, int(l))));
+        initData[l].SysMemSlicePitch = 0; // not used for 2D textures
+    }
 
     // create texture
     Microsoft::WRL::ComPtr<ID3D11Texture2D> tex;
-    HRESULT hr = device->CreateTexture2D(&texDesc, &initData, tex.GetAddressOf());
+    HRESULT hr = device->CreateTexture2D(&texDesc, initData.data(), tex.GetAddressOf());
     if (FAILED(hr))
     {
         LOG_ERROR("CreateTexture2D failed: {}", hr);
-        stbi_image_free(pixelData);
         return false;
     }
 
@@ -288,16 +1062,14 @@ bool AssetManager::CreateTextureAndSRV(
     if (FAILED(hr))
     {
         LOG_ERROR("CreateShaderResourceView failed: {}", hr);
-        stbi_image_free(pixelData);
         return false;
     }
 
-    // populate the texture resource, then free the pixel data
+    // populate the texture resource; the caller keeps ownership of the pixel data
     outResource.texture = std::move(tex);
     outResource.srv = std::move(srv);
     outResource.width = width;
     outResource.height = height;
 
-    stbi_image_free(pixelData);
     return true;
 }
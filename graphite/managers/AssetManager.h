@@ -1,51 +1,146 @@
 #pragma once
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <string>
 #include <wrl/client.h>
 #include <d3d11.h>
 #include <Windows.h>
-#include <assimp/mesh.h>
+#include <memory>
+#include <functional>
+#include <future>
+#include <array>
 #include "DeviceManager.h"
+#include "assets/AssetHandle.h"
+#include "assets/HandleTable.h"
+#include "assets/ResidencyTracker.h"
+#include "assets/MipStreamer.h"
+#include "assets/CookedTexture.h"
 #include "rendering/Material.h"
 #include "rendering/Vertex.h"
+#include "rendering/PackedVertex.h"
+#include "rendering/MeshBounds.h"
+#include "rendering/Meshlet.h"
+#include "rendering/GeometryArena.h"
+#include "assets/CookedMesh.h"
 #include "core/CommonTypes.h"
 
+class ThreadPool;
+
+namespace AssetDecoder
+{
+    struct DecodedModel;
+    struct DecodedTexture;
+}
+
 class AssetManager
 {
 public:
     struct MeshResource
     {
-        Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
-        Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
-        UINT indexCount = 0;
+        GeometryArena::Allocation geometry; // slice of the shared vertex and index buffers
+        UINT indexCount = 0; // level 0
+        float uvDensity = 0.0f; // uv units per object space unit, see AssetDecoder::ComputeUvDensity
+        std::vector<CookedMesh::LodLevel> lods; // index ranges relative to geometry.firstIndex, finest first
+        MeshBounds bounds;
+        VertexQuantization quantization; // identity unless the streams are VertexLayout::Packed
+        MeshletData meshlets; // empty when meshlets are disabled
     };
 
     struct TextureResource
     {
         Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
         Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
-        UINT width = 0, height = 0;
+        UINT width = 0, height = 0; // of mip 0, even while it isn't resident
+        TextureFormat format = TextureFormat::RGBA8;
+        int mipLevels = 1;
+        int residentMip = 0;   // most detailed level on the gpu, the top of texture
+        uint64_t gpuBytes = 0; // resident mip levels
     };
 
     struct ModelResource
     {
         std::vector<MeshResource> meshes;
+        uint64_t gpuBytes = 0; // vertex and index buffers of every mesh
     };
 
-    AssetManager() = default;
-    ~AssetManager() = default;
+    using ModelCallback = std::function<void(ModelHandle, AssetState)>;
+    using TextureCallback = std::function<void(TextureHandle, AssetState)>;
+
+    AssetManager();
+    ~AssetManager();
 
     void SetDeviceManager(DeviceManager *deviceManager);
 
-    bool LoadTexture(const AssetID &path);
+    // 1x1 stand-ins bound while a material's textures are still streaming in
+    void InitPlaceholders();
+
+    // non-blocking loads. decoding starts right away on the worker pool and the
+    // gpu resources are created later by Update(). requesting the same path
+    // twice returns the same handle. callbacks always run inside Update()
+    // a texture keeps the role of its first request, it decides mip filtering.
+    // paths are only looked up here, everything after works on handles.
+    // every request takes a reference that the caller gives back with Release
+    ModelHandle RequestModel(const AssetID &path, ModelCallback onComplete = nullptr);
+    TextureHandle RequestTexture(const AssetID &path, TextureRole role, TextureCallback onComplete = nullptr);
+
+    // referenced assets stay resident. unreferenced ones are evicted least
+    // recently used first once the resident bytes exceed the budget, and
+    // reload transparently on the next AddRef or request of their path.
+    // a handle stays valid across eviction, lookups just return null meanwhile
+    void AddRef(ModelHandle handle);
+    void AddRef(TextureHandle handle);
+    void Release(ModelHandle handle);
+    void Release(TextureHandle handle);
+
+    // 0 disables eviction
+    void SetResidencyBudget(uint64_t bytes) { m_Residency.SetBudget(bytes); }
+    uint64_t GetResidencyBudget() const { return m_Residency.GetBudget(); }
+    uint64_t GetResidentBytes() const { return m_Residency.GetResidentBytes(); }
+
+    AssetState GetModelState(ModelHandle handle) const;
+    AssetState GetTextureState(TextureHandle handle) const;
+
+    // texture streaming: the finest mip a draw can resolve, from its mesh's
+    // uv density and the on screen size of one object space unit. the finest
+    // request of a frame wins and Update() streams towards it
+    void RequestTextureDetail(TextureHandle handle, float uvDensity, float pixelsPerUnit);
+    const MipStreamer &GetMipStreamer() const { return m_MipStreamer; }
+
+    // hot reload: re-imports every model or texture built from path, leaving
+    // anything else alone. the current version keeps drawing until the new one
+    // is finalized by Update(), which swaps it in between frames. materials
+    // refer to textures by handle, so they pick up a reloaded texture as is
+    void OnSourceChanged(const std::filesystem::path &path);
+
+    // main thread pump, call once per frame. finalizes completed decodes within
+    // the per-frame upload budget and delivers completion callbacks
+    void Update();
+
+    // blocking loads built on the request api. throw if any asset fails.
+    // the assets keep the reference taken by the request
+    bool LoadTexture(const AssetID &path, TextureRole role);
     bool LoadModel(const AssetID &path);
-    bool AddMaterial(const AssetID &id, const Material &material);
+    bool LoadAssets(
+        const std::vector<AssetID> &models,
+        const std::vector<std::pair<AssetID, TextureRole>> &textures);
+
+    // adding an id again replaces the material behind the same handle.
+    // a material holds a reference on each of its textures
+    MaterialHandle AddMaterial(const AssetID &id, const Material &material);
 
-    const TextureResource *GetTexture(const AssetID &id) const;
-    const ModelResource *GetModel(const AssetID &id) const;
-    const Material *GetMaterial(const AssetID &id) const;
+    // load time path -> handle, invalid if the path was never requested
+    ModelHandle FindModel(const AssetID &path) const;
+    TextureHandle FindTexture(const AssetID &path) const;
+    MaterialHandle FindMaterial(const AssetID &id) const;
+
+    // draw path lookups. null until the asset is ready, or for stale handles
+    const TextureResource *GetTexture(TextureHandle handle) const;
+    const ModelResource *GetModel(ModelHandle handle) const;
+    const Material *GetMaterial(MaterialHandle handle) const;
+    const TextureResource &GetPlaceholderTexture(TextureRole role) const;
+    const GeometryArena &GetGeometryArena() const { return m_Geometry; }
 
     void
     Shutdown();
@@ -53,33 +148,113 @@ public:
 private:
     DeviceManager *m_DeviceManager = nullptr;
 
-    // stores all loaded model.
-    // each model can have multiple meshes
-    std::map<AssetID, ModelResource> m_Models;
-    std::map<AssetID, TextureResource> m_Textures;
-    std::map<AssetID, Material> m_Materials;
+    // declared ahead of the tables so mesh allocations are given back before it goes
+    GeometryArena m_Geometry;
+
+    // one slot per requested asset, holding the request and, once ready,
+    // the resource. each model can have multiple meshes
+    struct ModelRequest
+    {
+        AssetID path;
+        AssetState state = AssetState::Pending;
+        std::future<std::unique_ptr<AssetDecoder::DecodedModel>> decode;
+        std::vector<ModelCallback> callbacks;
+        bool reloadQueued = false; // source changed while a decode was running
+        ModelResource resource;
+    };
+
+    struct TextureRequest
+    {
+        AssetID path;
+        AssetState state = AssetState::Pending;
+        std::future<std::unique_ptr<AssetDecoder::DecodedTexture>> decode;
+        std::vector<TextureCallback> callbacks;
+        bool reloadQueued = false;
+        TextureRole role = TextureRole::Albedo;
+        TextureResource resource;
+        std::filesystem::path streamSource; // cooked file finer mips are read from, empty if not streamed
+        uint32_t streamSerial = 0;          // bumped whenever resource is replaced
+    };
+
+    // a finer mip level of a streamed texture, read on the pool
+    struct MipLoad
+    {
+        TextureHandle handle;
+        uint32_t serial = 0; // TextureRequest::streamSerial at issue, stale once it moved on
+        int mip = 0;
+        std::future<std::unique_ptr<CookedTexture::TextureData>> data;
+    };
+
+    HandleTable<ModelRequest, ModelHandle> m_Models;
+    HandleTable<TextureRequest, TextureHandle> m_Textures;
+    HandleTable<Material, MaterialHandle> m_Materials;
+
+    // only consulted when loading
+    std::map<AssetID, ModelHandle> m_ModelHandles;
+    std::map<AssetID, TextureHandle> m_TextureHandles;
+    std::map<AssetID, MaterialHandle> m_MaterialHandles;
+
+    // source file (generic, lexically normal) -> residency key of each asset built from it
+    std::unordered_multimap<std::string, ResidencyTracker::Key> m_Dependents;
+
+    // requests still waiting on their decode
+    std::vector<ModelHandle> m_PendingModels;
+    std::vector<TextureHandle> m_PendingTextures;
+
+    ResidencyTracker m_Residency;
+
+    MipStreamer m_MipStreamer;
+    std::vector<MipLoad> m_MipLoads;
+
+    // completion callbacks queued for the next flush
+    std::vector<std::function<void()>> m_QueuedCallbacks;
+
+    std::array<TextureResource, size_t(TextureRole::Count)> m_Placeholders;
+
+    // file reads, image decode and mesh import run here
+    std::unique_ptr<ThreadPool> m_DecodePool;
 
     // helpers
-    bool ProcessAssimpMesh(
-        aiMesh *mesh,
-        std::vector<Vertex> &outVertices,
-        std::vector<uint32_t> &outIndices) const;
+    // finalizes requests whose decode has finished. stops early once budgetMs is
+    // spent, a budget <= 0 finalizes everything that is ready
+    void ProcessCompletedRequests(double budgetMs);
+    void StartModelDecode(ModelHandle handle);
+    void StartTextureDecode(TextureHandle handle);
+    void ReloadModel(ModelHandle handle);
+    void ReloadTexture(TextureHandle handle);
+    void CompleteModelRequest(ModelHandle handle);
+    void CompleteTextureRequest(TextureHandle handle);
+    void FlushCallbacks();
+    void EnforceResidencyBudget();
+    void UpdateTextureStreaming();
+
+    // owning-thread half of a load: create gpu resources from decoded data
+    bool FinalizeModel(AssetDecoder::DecodedModel &decoded, ModelResource &outModel);
+    bool FinalizeTexture(const AssetDecoder::DecodedTexture &decoded, TextureResource &outTexture);
 
+    // streams[s] holds vertexCount * strides[s] bytes, see VertexLayout
     bool CreateMeshResourceBuffers(
-        const std::vector<Vertex> &vertices,
-        const std::vector<uint32_t> &indices,
-        MeshResource &outResource) const;
+        const void *const *streams,
+        const UINT *strides,
+        UINT streamCount,
+        size_t vertexCount,
+        const uint32_t *indices,
+        size_t indexCount,
+        MeshResource &outResource);
 
-    unsigned char *LoadImageDataFromFile(
-        const AssetID &path,
-        int &outWidth,
-        int &outHeight,
-        int &outChannels) const;
+    // recreates texture with mip as its top level. levels that stay resident
+    // are copied on the gpu, finer ones come from levels[l] (indexed by level)
+    bool ChangeResidentMip(
+        TextureResource &texture,
+        int mip,
+        const unsigned char *const *levels);
 
+    // levels[i] points at tightly packed data of mip i, rgba8 or bc blocks
     bool CreateTextureAndSRV(
         int width,
         int height,
         DXGI_FORMAT format,
-        unsigned char *pixelData,
+        UINT mipLevels,
+        const unsigned char *const *levels,
         TextureResource &outResource) const;
 };
\ No newline at end of file
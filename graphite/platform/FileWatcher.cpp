@@ -0,0 +1,227 @@
+#include "FileWatcher.h"
+#include "utils/Logger.h"
+
+#include <algorithm>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+void FileWatcher::Record(const std::filesystem::path &path)
+{
+    m_Changed[path.lexically_normal().generic_string()] = Clock::now();
+}
+
+std::vector<std::filesystem::path> FileWatcher::Poll(double settleMs)
+{
+    ReadEvents();
+
+    std::vector<std::filesystem::path> settled;
+    const auto now = Clock::now();
+    for (auto it = m_Changed.begin(); it != m_Changed.end();)
+    {
+        if (std::chrono::duration<double, std::milli>(now - it->second).count() >= settleMs)
+        {
+            settled.emplace_back(it->first);
+            it = m_Changed.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    std::sort(settled.begin(), settled.end());
+    return settled;
+}
+
+#if defined(_WIN32)
+
+struct FileWatcher::WatchedDirectory
+{
+    std::filesystem::path path;
+    HANDLE handle = INVALID_HANDLE_VALUE;
+    OVERLAPPED overlapped{};
+    alignas(DWORD) unsigned char buffer[64 * 1024];
+
+    bool Issue()
+    {
+        overlapped = {};
+        return ReadDirectoryChangesW(
+                   handle,
+                   buffer,
+                   sizeof(buffer),
+                   TRUE, // subtree
+                   FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME,
+                   nullptr,
+                   &overlapped,
+                   nullptr) != 0;
+    }
+
+    ~WatchedDirectory()
+    {
+        if (handle != INVALID_HANDLE_VALUE)
+        {
+            // the kernel writes into buffer until the read is cancelled
+            DWORD bytes = 0;
+            CancelIoEx(handle, &overlapped);
+            GetOverlappedResult(handle, &overlapped, &bytes, TRUE);
+            CloseHandle(handle);
+        }
+    }
+};
+
+FileWatcher::FileWatcher() = default;
+FileWatcher::~FileWatcher() = default;
+
+bool FileWatcher::AddDirectory(const std::filesystem::path &directory)
+{
+    auto watched = std::make_unique<WatchedDirectory>();
+    watched->path = directory;
+    watched->handle = CreateFileW(
+        directory.c_str(),
+        FILE_LIST_DIRECTORY,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+        nullptr);
+    if (watched->handle == INVALID_HANDLE_VALUE || !watched->Issue())
+    {
+        LOG_WARN("FileWatcher: cannot watch {}", directory.string());
+        return false;
+    }
+
+    m_Directories.push_back(std::move(watched));
+    return true;
+}
+
+void FileWatcher::ReadEvents()
+{
+    for (auto &dir : m_Directories)
+    {
+        DWORD bytes = 0;
+        if (!GetOverlappedResult(dir->handle, &dir->overlapped, &bytes, FALSE))
+        {
+            if (GetLastError() == ERROR_IO_INCOMPLETE)
+                continue; // nothing new yet
+            bytes = 0;
+        }
+
+        // zero bytes means the buffer overflowed and the changes are lost
+        const unsigned char *cursor = dir->buffer;
+        while (bytes > 0)
+        {
+            const auto *info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(cursor);
+            if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED ||
+                info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+            {
+                std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                Record(dir->path / name);
+            }
+            if (info->NextEntryOffset == 0)
+                break;
+            cursor += info->NextEntryOffset;
+        }
+
+        if (!dir->Issue())
+            LOG_WARN("FileWatcher: lost watch on {}", dir->path.string());
+    }
+}
+
+#else
+
+FileWatcher::FileWatcher()
+{
+    m_Fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_Fd < 0)
+        LOG_WARN("FileWatcher: inotify_init1 failed, errno {}", errno);
+}
+
+FileWatcher::~FileWatcher()
+{
+    if (m_Fd >= 0)
+        ::close(m_Fd);
+}
+
+bool FileWatcher::AddWatch(const std::filesystem::path &directory)
+{
+    // close_write catches in place saves, moved_to editors that save via rename
+    int wd = inotify_add_watch(m_Fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (wd < 0)
+    {
+        LOG_WARN("FileWatcher: cannot watch {}, errno {}", directory.string(), errno);
+        return false;
+    }
+    m_Watches[wd] = directory;
+    return true;
+}
+
+bool FileWatcher::AddDirectory(const std::filesystem::path &directory)
+{
+    if (m_Fd < 0 || !AddWatch(directory))
+        return false;
+
+    // inotify is not recursive, every subdirectory needs its own watch
+    std::error_code ec;
+    for (auto it = std::filesystem::recursive_directory_iterator(directory, ec);
+         !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+    {
+        if (it->is_directory(ec))
+            AddWatch(it->path());
+    }
+    return true;
+}
+
+void FileWatcher::ReadEvents()
+{
+    if (m_Fd < 0)
+        return;
+
+    alignas(inotify_event) char buffer[16 * 1024];
+    for (;;)
+    {
+        ssize_t length = ::read(m_Fd, buffer, sizeof(buffer));
+        if (length <= 0)
+            return; // EAGAIN once drained
+
+        for (char *cursor = buffer; cursor < buffer + length;)
+        {
+            const auto *event = reinterpret_cast<const inotify_event *>(cursor);
+            cursor += sizeof(inotify_event) + event->len;
+
+            auto dir = m_Watches.find(event->wd);
+            if (dir == m_Watches.end() || event->len == 0)
+                continue;
+
+            std::filesystem::path path = dir->second / event->name;
+            if (event->mask & IN_ISDIR)
+            {
+                // new directories need a watch of their own, then anything
+                // already inside counts as changed
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                {
+                    AddDirectory(path);
+                    std::error_code ec;
+                    for (auto it = std::filesystem::recursive_directory_iterator(path, ec);
+                         !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+                    {
+                        if (it->is_regular_file(ec))
+                            Record(it->path());
+                    }
+                }
+            }
+            else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+            {
+                Record(path);
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// recursive watch of directories for files that were written, created or
+// renamed into place. polled from the main thread, never blocks.
+// inotify on linux, ReadDirectoryChangesW on windows
+class FileWatcher
+{
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    // prevent copy and assignment
+    FileWatcher(const FileWatcher &) = delete;
+    FileWatcher &operator=(const FileWatcher &) = delete;
+
+    bool AddDirectory(const std::filesystem::path &directory);
+
+    // files whose last change is at least settleMs old, each reported once.
+    // editors tend to write in several steps, waiting avoids reading a half
+    // saved file. paths are lexically normal and relative if the watched
+    // directory was
+    std::vector<std::filesystem::path> Poll(double settleMs);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void ReadEvents();
+    void Record(const std::filesystem::path &path);
+
+    std::unordered_map<std::string, Clock::time_point> m_Changed; // generic path -> last change
+
+#if defined(_WIN32)
+    struct WatchedDirectory;
+    std::vector<std::unique_ptr<WatchedDirectory>> m_Directories;
+#else
+    bool AddWatch(const std::filesystem::path &directory);
+
+    int m_Fd = -1;
+    std::unordered_map<int, std::filesystem::path> m_Watches; // watch descriptor -> directory
+#endif
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+// read-only memory mapping of an entire file
+// the view stays valid until Close() or destruction
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    // prevent copy, allow move
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    bool Open(const std::filesystem::path &path);
+    void Close();
+
+    const unsigned char *GetData() const { return m_Data; }
+    size_t GetSize() const { return m_Size; }
+    bool IsOpen() const { return m_Data != nullptr; }
+
+private:
+    void MoveFrom(MappedFile &other);
+
+    const unsigned char *m_Data = nullptr;
+    size_t m_Size = 0;
+
+#if defined(_WIN32)
+    void *m_File = nullptr;
+    void *m_Mapping = nullptr;
+#else
+    int m_Fd = -1;
+#endif
+};
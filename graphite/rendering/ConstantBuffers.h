@@ -9,8 +9,10 @@ struct alignas(16) PerFrameData
 };
 static_assert((sizeof(PerFrameData) % 16) == 0, "PerFrameData size must be 16-byte aligned.");
 
-struct alignas(16) PerObjectData
+// world matrices are per instance, see VertexLayout::Instance
+struct alignas(16) PerMeshData
 {
-    glm::mat4 worldMatrix;
+    glm::vec4 positionScale;  // packed vertices only, see VertexQuantization
+    glm::vec4 positionOffset;
 };
-static_assert((sizeof(PerObjectData) % 16) == 0, "PerObjectData size must be 16-byte aligned.");
+static_assert((sizeof(PerMeshData) % 16) == 0, "PerMeshData size must be 16-byte aligned.");
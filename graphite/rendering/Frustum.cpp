@@ -0,0 +1,41 @@
+#include "Frustum.h"
+
+Frustum Frustum::FromMatrix(const glm::mat4 &m)
+{
+    // glm is column major, row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    auto row = [&m](int i)
+    { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+
+    Frustum f;
+    f.planes[0] = row(3) + row(0); // left
+    f.planes[1] = row(3) - row(0); // right
+    f.planes[2] = row(3) + row(1); // bottom
+    f.planes[3] = row(3) - row(1); // top
+    f.planes[4] = row(3) + row(2); // near
+    f.planes[5] = row(3) - row(2); // far
+
+    for (auto &p : f.planes)
+        p = p / glm::length(glm::vec3(p));
+    return f;
+}
+
+Frustum Frustum::Transformed(const glm::mat4 &world) const
+{
+    // plane . (world * p) == (transpose(world) * plane) . p, so distances
+    // keep their world space units
+    glm::mat4 t = glm::transpose(world);
+    Frustum f;
+    for (int i = 0; i < 6; ++i)
+        f.planes[i] = t * planes[i];
+    return f;
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3 &center, float radius) const
+{
+    for (const auto &p : planes)
+    {
+        if (glm::dot(glm::vec3(p), center) + p.w < -radius)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// view frustum as six inward facing planes (xyz = unit normal, w = distance)
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    // gribb/hartmann extraction from a view-projection matrix with -w..w clip
+    // depth (glm default). for 0..w matrices the near plane ends up slightly
+    // behind the real one, which only makes culling conservative
+    static Frustum FromMatrix(const glm::mat4 &viewProjection);
+
+    // the same planes expressed in the object space of world. plane
+    // distances stay in world units, so radii passed in must be world sized
+    Frustum Transformed(const glm::mat4 &world) const;
+
+    // false only if the sphere is fully outside
+    bool IntersectsSphere(const glm::vec3 &center, float radius) const;
+};
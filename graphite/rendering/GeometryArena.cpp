@@ -0,0 +1,241 @@
+#include "GeometryArena.h"
+#include "cfg/Config.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    constexpr uint32_t MB = 1024 * 1024;
+
+    // vertices addressable by a 16 bit index relative to baseVertex
+    constexpr size_t MAX_16BIT_VERTICES = size_t(std::numeric_limits<uint16_t>::max()) + 1;
+
+    void UploadRange(ID3D11DeviceContext *context, ID3D11Buffer *buffer, UINT byteOffset, const void *data, UINT bytes)
+    {
+        D3D11_BOX box{};
+        box.left = byteOffset;
+        box.right = byteOffset + bytes;
+        box.bottom = 1;
+        box.back = 1;
+        context->UpdateSubresource(buffer, 0, &box, data, 0, 0);
+    }
+}
+
+GeometryArena::Allocation &GeometryArena::Allocation::operator=(Allocation &&other) noexcept
+{
+    if (this == &other)
+        return *this;
+
+    Reset();
+    vertexBuffer = other.vertexBuffer;
+    streamCount = other.streamCount;
+    std::copy(other.strides, other.strides + MAX_VERTEX_STREAMS, strides);
+    std::copy(other.streamOffsets, other.streamOffsets + MAX_VERTEX_STREAMS, streamOffsets);
+    baseVertex = other.baseVertex;
+    indexBuffer = other.indexBuffer;
+    indexFormat = other.indexFormat;
+    firstIndex = other.firstIndex;
+    bytes = other.bytes;
+    m_Arena = other.m_Arena;
+    m_VertexPage = other.m_VertexPage;
+    m_IndexPage = other.m_IndexPage;
+    m_VertexCount = other.m_VertexCount;
+    m_IndexCount = other.m_IndexCount;
+    other.m_Arena = nullptr;
+    return *this;
+}
+
+void GeometryArena::Allocation::Reset()
+{
+    if (!m_Arena)
+        return;
+
+    m_Arena->Free(m_VertexPage, baseVertex, m_VertexCount);
+    m_Arena->Free(m_IndexPage, firstIndex, m_IndexCount);
+    m_Arena = nullptr;
+    vertexBuffer = nullptr;
+    indexBuffer = nullptr;
+    bytes = 0;
+}
+
+bool GeometryArena::Upload(
+    ID3D11Device *device,
+    ID3D11DeviceContext *context,
+    const void *const *streams,
+    const UINT *strides,
+    UINT streamCount,
+    size_t vertexCount,
+    const uint32_t *indices,
+    size_t indexCount,
+    Allocation &outAllocation)
+{
+    if (!device || !context || streamCount == 0 || streamCount > MAX_VERTEX_STREAMS || vertexCount == 0 || indexCount == 0)
+        return false;
+
+    UINT stride = 0;
+    for (UINT s = 0; s < streamCount; ++s)
+    {
+        if (strides[s] == 0)
+            return false;
+        stride += strides[s];
+    }
+    if (vertexCount >= OffsetAllocator::INVALID || indexCount >= OffsetAllocator::INVALID ||
+        uint64_t(vertexCount) * stride > std::numeric_limits<UINT>::max() ||
+        uint64_t(indexCount) * sizeof(uint32_t) > std::numeric_limits<UINT>::max())
+    {
+        LOG_ERROR("GeometryArena: mesh with {} vertices and {} indices is too large", vertexCount, indexCount);
+        return false;
+    }
+
+    const bool shortIndices = Config::Geometry::USE_16BIT_INDICES && vertexCount <= MAX_16BIT_VERTICES;
+    const UINT indexSize = shortIndices ? sizeof(uint16_t) : sizeof(uint32_t);
+
+    Page *vertexPage = nullptr, *indexPage = nullptr;
+    uint32_t baseVertex = 0, firstIndex = 0;
+    if (!Allocate(device, false, strides, streamCount, uint32_t(vertexCount), vertexPage, baseVertex))
+        return false;
+    if (!Allocate(device, true, &indexSize, 1, uint32_t(indexCount), indexPage, firstIndex))
+    {
+        Free(vertexPage, baseVertex, uint32_t(vertexCount));
+        return false;
+    }
+
+    for (UINT s = 0; s < streamCount; ++s)
+        UploadRange(context, vertexPage->buffer.Get(), vertexPage->streamOffsets[s] + baseVertex * strides[s], streams[s], UINT(vertexCount * strides[s]));
+
+    const void *indexData = indices;
+    if (shortIndices)
+    {
+        m_ShortIndices.resize(indexCount);
+        std::transform(indices, indices + indexCount, m_ShortIndices.begin(), [](uint32_t i)
+                       { return static_cast<uint16_t>(i); });
+        indexData = m_ShortIndices.data();
+    }
+    UploadRange(context, indexPage->buffer.Get(), firstIndex * indexSize, indexData, UINT(indexCount * indexSize));
+
+    Allocation a;
+    a.vertexBuffer = vertexPage->buffer.Get();
+    a.streamCount = streamCount;
+    std::copy(strides, strides + streamCount, a.strides);
+    std::copy(vertexPage->streamOffsets, vertexPage->streamOffsets + streamCount, a.streamOffsets);
+    a.baseVertex = baseVertex;
+    a.indexBuffer = indexPage->buffer.Get();
+    a.indexFormat = shortIndices ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    a.firstIndex = firstIndex;
+    a.bytes = uint64_t(vertexCount) * stride + uint64_t(indexCount) * indexSize;
+    a.m_Arena = this;
+    a.m_VertexPage = vertexPage;
+    a.m_IndexPage = indexPage;
+    a.m_VertexCount = uint32_t(vertexCount);
+    a.m_IndexCount = uint32_t(indexCount);
+    outAllocation = std::move(a);
+    return true;
+}
+
+uint64_t GeometryArena::GetCapacityBytes() const
+{
+    uint64_t bytes = 0;
+    for (const auto &page : m_Pages)
+        bytes += uint64_t(page->allocator.GetCapacity()) * page->elementSize;
+    return bytes;
+}
+
+uint64_t GeometryArena::GetUsedBytes() const
+{
+    uint64_t bytes = 0;
+    for (const auto &page : m_Pages)
+        bytes += uint64_t(page->allocator.GetUsed()) * page->elementSize;
+    return bytes;
+}
+
+bool GeometryArena::IsKind(const Page &page, bool isIndex, const UINT *strides, UINT streamCount)
+{
+    return page.isIndex == isIndex && page.streamCount == streamCount &&
+           std::equal(strides, strides + streamCount, page.strides);
+}
+
+bool GeometryArena::Allocate(ID3D11Device *device, bool isIndex, const UINT *strides, UINT streamCount, uint32_t count, Page *&outPage, uint32_t &outOffset)
+{
+    for (auto &page : m_Pages)
+    {
+        if (page->dedicated || !IsKind(*page, isIndex, strides, streamCount))
+            continue;
+        const uint32_t offset = page->allocator.Allocate(count);
+        if (offset != OffsetAllocator::INVALID)
+        {
+            outPage = page.get();
+            outOffset = offset;
+            return true;
+        }
+    }
+
+    UINT elementSize = 0;
+    for (UINT s = 0; s < streamCount; ++s)
+        elementSize += strides[s];
+
+    const uint32_t pageBytes = (isIndex ? Config::Geometry::INDEX_PAGE_MB : Config::Geometry::VERTEX_PAGE_MB) * MB;
+    const uint32_t pageCapacity = pageBytes / elementSize;
+    const bool dedicated = count > pageCapacity;
+
+    Page *page = CreatePage(device, isIndex, strides, streamCount, dedicated ? count : pageCapacity, dedicated);
+    if (!page)
+        return false;
+
+    outPage = page;
+    outOffset = page->allocator.Allocate(count);
+    return true;
+}
+
+void GeometryArena::Free(Page *page, uint32_t offset, uint32_t count)
+{
+    page->allocator.Free(offset, count);
+    if (page->allocator.GetUsed() != 0)
+        return;
+
+    // keep one empty shared page of each kind around for the next load
+    auto sameKind = [page](const std::unique_ptr<Page> &p)
+    {
+        return p.get() != page && !p->dedicated && IsKind(*p, page->isIndex, page->strides, page->streamCount);
+    };
+    if (!page->dedicated && std::none_of(m_Pages.begin(), m_Pages.end(), sameKind))
+        return;
+
+    m_Pages.erase(std::find_if(m_Pages.begin(), m_Pages.end(), [page](const std::unique_ptr<Page> &p)
+                               { return p.get() == page; }));
+}
+
+GeometryArena::Page *GeometryArena::CreatePage(ID3D11Device *device, bool isIndex, const UINT *strides, UINT streamCount, uint32_t capacity, bool dedicated)
+{
+    // streams one after another, each sized for the full capacity
+    auto page = std::make_unique<Page>();
+    page->streamCount = streamCount;
+    UINT elementSize = 0;
+    for (UINT s = 0; s < streamCount; ++s)
+    {
+        page->strides[s] = strides[s];
+        page->streamOffsets[s] = capacity * elementSize;
+        elementSize += strides[s];
+    }
+
+    D3D11_BUFFER_DESC desc{};
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.ByteWidth = capacity * elementSize;
+    desc.BindFlags = isIndex ? D3D11_BIND_INDEX_BUFFER : D3D11_BIND_VERTEX_BUFFER;
+
+    if (FAILED(device->CreateBuffer(&desc, nullptr, page->buffer.GetAddressOf())))
+    {
+        LOG_ERROR("GeometryArena: failed to create a {} byte {} page", desc.ByteWidth, isIndex ? "index" : "vertex");
+        return nullptr;
+    }
+
+    page->allocator = OffsetAllocator(capacity);
+    page->elementSize = elementSize;
+    page->isIndex = isIndex;
+    page->dedicated = dedicated;
+
+    LOG_INFO("GeometryArena: new {} page, {} KB ({} byte elements in {} streams){}",
+             isIndex ? "index" : "vertex", desc.ByteWidth / 1024, elementSize, streamCount, dedicated ? ", dedicated" : "");
+    m_Pages.push_back(std::move(page));
+    return m_Pages.back().get();
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "rendering/OffsetAllocator.h"
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// static geometry shares a few large vertex and index buffers instead of owning
+// two small ones per mesh. vertex pages are kept per set of stream strides and
+// index pages per index format, each sub-allocated with an OffsetAllocator. a
+// vertex page holds each stream in a range of its own buffer, so one baseVertex
+// addresses every stream. draws address their mesh through baseVertex and
+// firstIndex, so meshes in one page bind once.
+// main thread only, like every other gpu resource
+class GeometryArena
+{
+    struct Page;
+
+public:
+    static constexpr UINT MAX_VERTEX_STREAMS = 4;
+
+    // a mesh's slice of the arena, given back when destroyed
+    class Allocation
+    {
+    public:
+        Allocation() = default;
+        ~Allocation() { Reset(); }
+
+        Allocation(Allocation &&other) noexcept { *this = std::move(other); }
+        Allocation &operator=(Allocation &&other) noexcept;
+        Allocation(const Allocation &) = delete;
+        Allocation &operator=(const Allocation &) = delete;
+
+        void Reset();
+        bool IsValid() const { return m_Arena != nullptr; }
+
+        ID3D11Buffer *vertexBuffer = nullptr; // every stream, at streamOffsets
+        UINT streamCount = 0;
+        UINT strides[MAX_VERTEX_STREAMS] = {};
+        UINT streamOffsets[MAX_VERTEX_STREAMS] = {}; // bytes, for IASetVertexBuffers
+        UINT baseVertex = 0;
+        ID3D11Buffer *indexBuffer = nullptr;
+        DXGI_FORMAT indexFormat = DXGI_FORMAT_R32_UINT;
+        UINT firstIndex = 0;
+        uint64_t bytes = 0; // vertex and index data
+
+    private:
+        friend class GeometryArena;
+
+        GeometryArena *m_Arena = nullptr;
+        Page *m_VertexPage = nullptr;
+        Page *m_IndexPage = nullptr;
+        uint32_t m_VertexCount = 0;
+        uint32_t m_IndexCount = 0;
+    };
+
+    GeometryArena() = default;
+    ~GeometryArena() = default;
+
+    // prevent copy and assignment, allocations point back at the arena
+    GeometryArena(const GeometryArena &) = delete;
+    GeometryArena &operator=(const GeometryArena &) = delete;
+
+    // copies a mesh into the arena, streams[s] holding vertexCount * strides[s]
+    // bytes (see VertexLayout::Split). indices are stored as 16 bit whenever
+    // every vertex is reachable with them, otherwise as 32 bit
+    bool Upload(
+        ID3D11Device *device,
+        ID3D11DeviceContext *context,
+        const void *const *streams,
+        const UINT *strides,
+        UINT streamCount,
+        size_t vertexCount,
+        const uint32_t *indices,
+        size_t indexCount,
+        Allocation &outAllocation);
+
+    size_t GetPageCount() const { return m_Pages.size(); }
+    uint64_t GetCapacityBytes() const;
+    uint64_t GetUsedBytes() const;
+
+private:
+    struct Page
+    {
+        Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+        OffsetAllocator allocator; // in elements (vertices or indices)
+        UINT elementSize = 0;      // vertex bytes over every stream, or index size
+        UINT streamCount = 1;
+        UINT strides[MAX_VERTEX_STREAMS] = {};
+        UINT streamOffsets[MAX_VERTEX_STREAMS] = {}; // capacity elements of each stream
+        bool isIndex = false;
+        bool dedicated = false; // sized for a single oversized mesh
+    };
+
+    // offset into page, creating a new page when none of the existing ones fits.
+    // index pages have a single stream of the index size
+    bool Allocate(ID3D11Device *device, bool isIndex, const UINT *strides, UINT streamCount, uint32_t count, Page *&outPage, uint32_t &outOffset);
+    void Free(Page *page, uint32_t offset, uint32_t count);
+    Page *CreatePage(ID3D11Device *device, bool isIndex, const UINT *strides, UINT streamCount, uint32_t capacity, bool dedicated);
+    static bool IsKind(const Page &page, bool isIndex, const UINT *strides, UINT streamCount);
+
+    std::vector<std::unique_ptr<Page>> m_Pages;
+    std::vector<uint16_t> m_ShortIndices; // scratch for 16 bit conversion
+};
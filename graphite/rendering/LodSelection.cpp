@@ -0,0 +1,46 @@
+#include "LodSelection.h"
+
+namespace LodSelection
+{
+    float ErrorToPixelScale(const glm::mat4 &projection, float viewportHeight)
+    {
+        // proj[1][1] = 1 / tan(fovY / 2), ndc spans 2 units over the viewport
+        return projection[1][1] * viewportHeight * 0.5f;
+    }
+
+    uint32_t SelectLod(
+        const CookedMesh::LodLevel *lods,
+        uint32_t lodCount,
+        float pixelsPerUnit,
+        uint32_t currentLod,
+        float thresholdPixels,
+        float hysteresis)
+    {
+        if (lodCount == 0)
+            return 0;
+        if (currentLod >= lodCount)
+            currentLod = lodCount - 1;
+
+        auto coarsestWithin = [&](float limit)
+        {
+            uint32_t level = 0;
+            for (uint32_t i = 1; i < lodCount; ++i)
+            {
+                if (lods[i].error * pixelsPerUnit > limit)
+                    break;
+                level = i;
+            }
+            return level;
+        };
+
+        uint32_t coarser = coarsestWithin(thresholdPixels * (1.0f - hysteresis));
+        if (coarser > currentLod)
+            return coarser;
+
+        // keep the current level for as long as it is still good enough
+        if (lods[currentLod].error * pixelsPerUnit <= thresholdPixels)
+            return currentLod;
+
+        return coarsestWithin(thresholdPixels);
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "assets/CookedMesh.h"
+#include <glm/mat4x4.hpp>
+#include <cstdint>
+
+// screen-space error based level of detail selection
+namespace LodSelection
+{
+    // pixels covered by one world unit at distance 1 for a symmetric perspective projection
+    float ErrorToPixelScale(const glm::mat4 &projection, float viewportHeight);
+
+    // picks the coarsest level whose error projects to at most thresholdPixels,
+    // pixelsPerUnit being the size of one object space unit on screen.
+    // errors must be ascending. stepping to a coarser level than currentLod needs
+    // threshold * (1 - hysteresis), so objects near a boundary don't flicker
+    uint32_t SelectLod(
+        const CookedMesh::LodLevel *lods,
+        uint32_t lodCount,
+        float pixelsPerUnit,
+        uint32_t currentLod,
+        float thresholdPixels,
+        float hysteresis);
+}
@@ -1,11 +1,21 @@
 #pragma once
 #include "core/CommonTypes.h"
+#include "assets/AssetHandle.h"
+
+// what a texture is used for in a material
+enum class TextureRole
+{
+    Albedo,
+    Normal,
+    ORM,
+    Count
+};
 
 struct Material
 {
-    AssetID albedo;
-    AssetID normal;
-    AssetID orm;
+    TextureHandle albedo;
+    TextureHandle normal;
+    TextureHandle orm;
 
     float baseColor[4] = {1, 1, 1, 1};
     float roughness = 1.0f;
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+// object space bounds of a submesh
+struct MeshBounds
+{
+    glm::vec3 min{0.0f, 0.0f, 0.0f};
+    glm::vec3 max{0.0f, 0.0f, 0.0f};
+    glm::vec3 center{0.0f, 0.0f, 0.0f};
+    float radius = 0.0f; // sphere around center
+};
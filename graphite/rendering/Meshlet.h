@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// contiguous run of a submesh's index buffer, at most
+// Config::Meshlets::MAX_VERTICES unique vertices and MAX_TRIANGLES triangles
+struct Meshlet
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+};
+
+// meshlets of one lod level
+struct MeshletRange
+{
+    uint32_t first = 0;
+    uint32_t count = 0;
+};
+
+// culling data as separate arrays so 8 meshlets can be tested per instruction.
+// every array holds 8 padding entries past the end, so a full-width load
+// starting at any valid meshlet stays in bounds
+struct MeshletBounds
+{
+    std::vector<float> centerX, centerY, centerZ, radius;
+    // normal cone, cutoff = sin of the cone spread (1 disables cone culling)
+    std::vector<float> axisX, axisY, axisZ, cutoff;
+};
+
+struct MeshletData
+{
+    std::vector<Meshlet> meshlets;
+    MeshletBounds bounds;
+    std::vector<MeshletRange> lodRanges; // indexed like the submesh lods
+};
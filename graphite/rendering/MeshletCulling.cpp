@@ -0,0 +1,133 @@
+#include "MeshletCulling.h"
+#include "utils/Simd.h"
+
+#include <cmath>
+
+namespace
+{
+    bool IsVisible(const MeshletBounds &b, uint32_t i, const MeshletCulling::Params &params)
+    {
+        const float radius = b.radius[i] * params.radiusScale;
+        for (const auto &p : params.frustum.planes)
+        {
+            if (p.x * b.centerX[i] + p.y * b.centerY[i] + p.z * b.centerZ[i] + p.w < -radius)
+                return false;
+        }
+
+        if (params.coneCulling)
+        {
+            // whole cone faces away from the camera (meshoptimizer's sphere-based test)
+            float dx = b.centerX[i] - params.cameraPosition.x;
+            float dy = b.centerY[i] - params.cameraPosition.y;
+            float dz = b.centerZ[i] - params.cameraPosition.z;
+            float d = dx * b.axisX[i] + dy * b.axisY[i] + dz * b.axisZ[i];
+            float length = std::sqrt(dx * dx + dy * dy + dz * dz);
+            if (d >= b.cutoff[i] * length + b.radius[i])
+                return false;
+        }
+
+        return true;
+    }
+
+#if defined(GRAPHITE_AVX2)
+    size_t CullAvx2(
+        const MeshletBounds &b,
+        uint32_t first,
+        uint32_t count,
+        const MeshletCulling::Params &params,
+        uint32_t *outVisible)
+    {
+        __m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+        for (int p = 0; p < 6; ++p)
+        {
+            planeX[p] = _mm256_set1_ps(params.frustum.planes[p].x);
+            planeY[p] = _mm256_set1_ps(params.frustum.planes[p].y);
+            planeZ[p] = _mm256_set1_ps(params.frustum.planes[p].z);
+            planeW[p] = _mm256_set1_ps(params.frustum.planes[p].w);
+        }
+        const __m256 radiusScale = _mm256_set1_ps(params.radiusScale);
+        const __m256 camX = _mm256_set1_ps(params.cameraPosition.x);
+        const __m256 camY = _mm256_set1_ps(params.cameraPosition.y);
+        const __m256 camZ = _mm256_set1_ps(params.cameraPosition.z);
+
+        size_t visible = 0;
+        const uint32_t end = first + count;
+        for (uint32_t i = first; i < end; i += 8)
+        {
+            __m256 cx = _mm256_loadu_ps(b.centerX.data() + i);
+            __m256 cy = _mm256_loadu_ps(b.centerY.data() + i);
+            __m256 cz = _mm256_loadu_ps(b.centerZ.data() + i);
+            __m256 r = _mm256_loadu_ps(b.radius.data() + i);
+            __m256 negR = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_mul_ps(r, radiusScale));
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p)
+            {
+                __m256 d = _mm256_fmadd_ps(planeX[p], cx, _mm256_fmadd_ps(planeY[p], cy, _mm256_fmadd_ps(planeZ[p], cz, planeW[p])));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, negR, _CMP_GE_OQ));
+            }
+
+            if (params.coneCulling)
+            {
+                __m256 dx = _mm256_sub_ps(cx, camX);
+                __m256 dy = _mm256_sub_ps(cy, camY);
+                __m256 dz = _mm256_sub_ps(cz, camZ);
+                __m256 ax = _mm256_loadu_ps(b.axisX.data() + i);
+                __m256 ay = _mm256_loadu_ps(b.axisY.data() + i);
+                __m256 az = _mm256_loadu_ps(b.axisZ.data() + i);
+                __m256 cutoff = _mm256_loadu_ps(b.cutoff.data() + i);
+
+                __m256 d = _mm256_fmadd_ps(dx, ax, _mm256_fmadd_ps(dy, ay, _mm256_mul_ps(dz, az)));
+                __m256 length = _mm256_sqrt_ps(_mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz))));
+                __m256 backfacing = _mm256_cmp_ps(d, _mm256_fmadd_ps(cutoff, length, r), _CMP_GE_OQ);
+                inside = _mm256_andnot_ps(backfacing, inside);
+            }
+
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(inside));
+            if (end - i < 8)
+                mask &= (1u << (end - i)) - 1u; // padding lanes
+
+            while (mask)
+            {
+                unsigned bit = Simd::CountTrailingZeros(mask);
+                outVisible[visible++] = i + bit;
+                mask &= mask - 1u;
+            }
+        }
+        return visible;
+    }
+#endif
+}
+
+namespace MeshletCulling
+{
+    size_t Cull(
+        const MeshletBounds &bounds,
+        uint32_t first,
+        uint32_t count,
+        const Params &params,
+        uint32_t *outVisible)
+    {
+#if defined(GRAPHITE_AVX2)
+        return CullAvx2(bounds, first, count, params, outVisible);
+#else
+        return CullScalar(bounds, first, count, params, outVisible);
+#endif
+    }
+
+    size_t CullScalar(
+        const MeshletBounds &bounds,
+        uint32_t first,
+        uint32_t count,
+        const Params &params,
+        uint32_t *outVisible)
+    {
+        size_t visible = 0;
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            if (IsVisible(bounds, i, params))
+                outVisible[visible++] = i;
+        }
+        return visible;
+    }
+}
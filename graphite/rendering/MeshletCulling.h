@@ -0,0 +1,37 @@
+#pragma once
+
+#include "rendering/Frustum.h"
+#include "rendering/Meshlet.h"
+#include <glm/vec3.hpp>
+#include <cstddef>
+#include <cstdint>
+
+// per meshlet frustum and backface cone culling, 8 meshlets per step with avx2
+namespace MeshletCulling
+{
+    struct Params
+    {
+        Frustum frustum;               // object space, see Frustum::Transformed
+        float radiusScale = 1.0f;      // object -> world scale for meshlet radii
+        glm::vec3 cameraPosition{0.0f}; // object space
+        bool coneCulling = true;       // only valid for uniform scale
+    };
+
+    // writes the ids of visible meshlets in [first, first + count) to
+    // outVisible (room for count entries), in ascending order. returns how many
+    size_t Cull(
+        const MeshletBounds &bounds,
+        uint32_t first,
+        uint32_t count,
+        const Params &params,
+        uint32_t *outVisible);
+
+    // the same tests one meshlet at a time, kept as the reference the avx2
+    // path is measured and checked against
+    size_t CullScalar(
+        const MeshletBounds &bounds,
+        uint32_t first,
+        uint32_t count,
+        const Params &params,
+        uint32_t *outVisible);
+}
@@ -0,0 +1,87 @@
+#include "ObjectCulling.h"
+#include "utils/Simd.h"
+
+namespace
+{
+#if defined(GRAPHITE_AVX2)
+    size_t CullAvx2(const ObjectBounds &b, const Frustum &frustum, uint32_t *outVisible)
+    {
+        __m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+        for (int p = 0; p < 6; ++p)
+        {
+            planeX[p] = _mm256_set1_ps(frustum.planes[p].x);
+            planeY[p] = _mm256_set1_ps(frustum.planes[p].y);
+            planeZ[p] = _mm256_set1_ps(frustum.planes[p].z);
+            planeW[p] = _mm256_set1_ps(frustum.planes[p].w);
+        }
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+        size_t visible = 0;
+        const uint32_t count = static_cast<uint32_t>(b.Size());
+        for (uint32_t i = 0; i < count; i += 8)
+        {
+            __m256 cx, cy, cz, r;
+            if (count - i >= 8)
+            {
+                cx = _mm256_loadu_ps(b.centerX.data() + i);
+                cy = _mm256_loadu_ps(b.centerY.data() + i);
+                cz = _mm256_loadu_ps(b.centerZ.data() + i);
+                r = _mm256_loadu_ps(b.radius.data() + i);
+            }
+            else
+            {
+                // the arrays end here, masked lanes read as zero and get dropped below
+                const __m256i load = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(count - i)), lanes);
+                cx = _mm256_maskload_ps(b.centerX.data() + i, load);
+                cy = _mm256_maskload_ps(b.centerY.data() + i, load);
+                cz = _mm256_maskload_ps(b.centerZ.data() + i, load);
+                r = _mm256_maskload_ps(b.radius.data() + i, load);
+            }
+            __m256 negR = _mm256_sub_ps(_mm256_setzero_ps(), r);
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p)
+            {
+                __m256 d = _mm256_fmadd_ps(planeX[p], cx, _mm256_fmadd_ps(planeY[p], cy, _mm256_fmadd_ps(planeZ[p], cz, planeW[p])));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, negR, _CMP_GE_OQ));
+            }
+
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(inside));
+            if (count - i < 8)
+                mask &= (1u << (count - i)) - 1u; // lanes past the end
+
+            while (mask)
+            {
+                unsigned bit = Simd::CountTrailingZeros(mask);
+                outVisible[visible++] = i + bit;
+                mask &= mask - 1u;
+            }
+        }
+        return visible;
+    }
+#endif
+}
+
+namespace ObjectCulling
+{
+    size_t Cull(const ObjectBounds &bounds, const Frustum &frustum, uint32_t *outVisible)
+    {
+#if defined(GRAPHITE_AVX2)
+        return CullAvx2(bounds, frustum, outVisible);
+#else
+        return CullScalar(bounds, frustum, outVisible);
+#endif
+    }
+
+    size_t CullScalar(const ObjectBounds &bounds, const Frustum &frustum, uint32_t *outVisible)
+    {
+        size_t visible = 0;
+        for (uint32_t i = 0; i < bounds.Size(); ++i)
+        {
+            const glm::vec3 center(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+            if (frustum.IntersectsSphere(center, bounds.radius[i]))
+                outVisible[visible++] = i;
+        }
+        return visible;
+    }
+}
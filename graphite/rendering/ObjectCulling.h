@@ -0,0 +1,45 @@
+#pragma once
+
+#include "rendering/Frustum.h"
+#include <glm/vec3.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// world space bounding spheres of the objects drawn in a frame, one array per
+// component like MeshletBounds so 8 objects can be tested per instruction.
+// refilled every frame, so no padding: the last partial group is masked
+struct ObjectBounds
+{
+    std::vector<float> centerX, centerY, centerZ, radius;
+
+    void Clear()
+    {
+        centerX.clear();
+        centerY.clear();
+        centerZ.clear();
+        radius.clear();
+    }
+
+    void Add(const glm::vec3 &center, float r)
+    {
+        centerX.push_back(center.x);
+        centerY.push_back(center.y);
+        centerZ.push_back(center.z);
+        radius.push_back(r);
+    }
+
+    size_t Size() const { return radius.size(); }
+};
+
+// whole object frustum culling, 8 spheres per step with avx2
+namespace ObjectCulling
+{
+    // writes the indices of the spheres intersecting frustum to outVisible
+    // (room for bounds.Size() entries), in ascending order. returns how many
+    size_t Cull(const ObjectBounds &bounds, const Frustum &frustum, uint32_t *outVisible);
+
+    // the same test one sphere at a time with Frustum::IntersectsSphere, kept
+    // as the reference the avx2 path is measured and checked against
+    size_t CullScalar(const ObjectBounds &bounds, const Frustum &frustum, uint32_t *outVisible);
+}
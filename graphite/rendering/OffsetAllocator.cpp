@@ -0,0 +1,79 @@
+#include "OffsetAllocator.h"
+#include <iterator>
+
+OffsetAllocator::OffsetAllocator(uint32_t capacity)
+    : m_Capacity(capacity)
+{
+    if (capacity > 0)
+        InsertFree(0, capacity);
+}
+
+uint32_t OffsetAllocator::Allocate(uint32_t size)
+{
+    if (size == 0)
+        return INVALID;
+
+    // smallest free range that fits keeps large ranges intact for large meshes,
+    // ties go to the lowest offset
+    auto fit = m_FreeBySize.lower_bound({size, 0});
+    if (fit == m_FreeBySize.end())
+        return INVALID;
+
+    const auto [rangeSize, offset] = *fit;
+    EraseFree(m_FreeByOffset.find(offset));
+    if (rangeSize > size)
+        InsertFree(offset + size, rangeSize - size);
+
+    m_Used += size;
+    return offset;
+}
+
+void OffsetAllocator::Free(uint32_t offset, uint32_t size)
+{
+    if (offset == INVALID || size == 0)
+        return;
+
+    m_Used -= size;
+
+    // merge with the free neighbours on either side
+    auto next = m_FreeByOffset.lower_bound(offset);
+    if (next != m_FreeByOffset.end() && next->first == offset + size)
+    {
+        size += next->second;
+        next = EraseFree(next);
+    }
+    if (next != m_FreeByOffset.begin())
+    {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset)
+        {
+            offset = prev->first;
+            size += prev->second;
+            EraseFree(prev);
+        }
+    }
+    InsertFree(offset, size);
+}
+
+uint32_t OffsetAllocator::GetLargestFree() const
+{
+    return m_FreeBySize.empty() ? 0 : m_FreeBySize.rbegin()->first;
+}
+
+float OffsetAllocator::GetFragmentation() const
+{
+    const uint32_t free = m_Capacity - m_Used;
+    return free == 0 ? 0.0f : 1.0f - float(GetLargestFree()) / float(free);
+}
+
+void OffsetAllocator::InsertFree(uint32_t offset, uint32_t size)
+{
+    m_FreeByOffset.emplace(offset, size);
+    m_FreeBySize.emplace(size, offset);
+}
+
+OffsetAllocator::FreeIterator OffsetAllocator::EraseFree(FreeIterator it)
+{
+    m_FreeBySize.erase({it->second, it->first});
+    return m_FreeByOffset.erase(it);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+
+// hands out ranges of a fixed size linear space (elements of a gpu buffer).
+// best fit from a free list indexed by size, freed ranges merge with free
+// neighbours. pure bookkeeping, never touches the memory it describes
+class OffsetAllocator
+{
+public:
+    static constexpr uint32_t INVALID = 0xFFFFFFFFu;
+
+    explicit OffsetAllocator(uint32_t capacity = 0);
+
+    // offset of a range of size elements, INVALID when no free range fits
+    uint32_t Allocate(uint32_t size);
+    void Free(uint32_t offset, uint32_t size);
+
+    uint32_t GetCapacity() const { return m_Capacity; }
+    uint32_t GetUsed() const { return m_Used; }
+    uint32_t GetLargestFree() const;
+    size_t GetFreeRangeCount() const { return m_FreeByOffset.size(); }
+
+    // 0 when all free space is one range, approaching 1 as it splinters
+    float GetFragmentation() const;
+
+private:
+    using FreeIterator = std::map<uint32_t, uint32_t>::iterator;
+
+    void InsertFree(uint32_t offset, uint32_t size);
+    FreeIterator EraseFree(FreeIterator it);
+
+    uint32_t m_Capacity = 0;
+    uint32_t m_Used = 0;
+    std::map<uint32_t, uint32_t> m_FreeByOffset;          // offset -> size
+    std::set<std::pair<uint32_t, uint32_t>> m_FreeBySize; // (size, offset)
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <cstddef>
+#include <cstdint>
+
+// compact alternative to Vertex, 20 bytes instead of 44
+//   position: unorm16 xyz inside the mesh bounds (w unused)
+//   normal, tangent: octahedral snorm16
+//   texcoord: half floats
+struct PackedVertex
+{
+    uint16_t Position[4];
+    int16_t Normal[2];
+    int16_t Tangent[2];
+    uint16_t TexCoord[2];
+};
+static_assert(sizeof(PackedVertex) == 20, "PackedVertex must match the packed input layout.");
+static_assert(offsetof(PackedVertex, Normal) == 8, "PackedVertex must match the packed input layout.");
+static_assert(offsetof(PackedVertex, Tangent) == 12, "PackedVertex must match the packed input layout.");
+static_assert(offsetof(PackedVertex, TexCoord) == 16, "PackedVertex must match the packed input layout.");
+
+// maps unorm positions back to object space: pos = offset + unorm * scale
+struct VertexQuantization
+{
+    glm::vec3 offset{0.0f, 0.0f, 0.0f};
+    glm::vec3 scale{1.0f, 1.0f, 1.0f};
+};
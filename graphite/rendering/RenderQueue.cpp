@@ -0,0 +1,106 @@
+#include "RenderQueue.h"
+#include "core/ThreadPool.h"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr uint32_t RADIX_BITS = 8;
+    constexpr uint32_t BUCKETS = 1u << RADIX_BITS;
+    // below this the histograms are cheaper than handing chunks to workers
+    constexpr size_t PARALLEL_MIN_ENTRIES = 16384;
+
+    template <typename Fn>
+    void Run(ThreadPool *pool, size_t count, size_t grain, const Fn &fn)
+    {
+        if (pool)
+            pool->ParallelFor(count, grain, fn);
+        else
+            fn(0, count);
+    }
+
+    uint64_t Field(uint32_t value, uint32_t bits)
+    {
+        return uint64_t(value) & ((uint64_t(1) << bits) - 1);
+    }
+}
+
+uint64_t RenderQueue::MakeKey(uint32_t pass, uint32_t variant, uint32_t material, uint32_t mesh, uint32_t lod, float depth)
+{
+    const float maxDepth = float((1u << DEPTH_BITS) - 1);
+    const uint32_t quantized = uint32_t(std::clamp(depth, 0.0f, 1.0f) * maxDepth);
+
+    uint64_t key = Field(pass, PASS_BITS);
+    key = (key << VARIANT_BITS) | Field(variant, VARIANT_BITS);
+    key = (key << MATERIAL_BITS) | Field(material, MATERIAL_BITS);
+    key = (key << MESH_BITS) | Field(mesh, MESH_BITS);
+    key = (key << LOD_BITS) | Field(lod, LOD_BITS);
+    key = (key << DEPTH_BITS) | Field(quantized, DEPTH_BITS);
+    return key;
+}
+
+void RenderQueue::Sort(ThreadPool *pool)
+{
+    const size_t count = m_Entries.size();
+    if (count < 2)
+        return;
+
+    // each chunk keeps a histogram of its own, so chunks scatter independently
+    // and the bucket major prefix sum below keeps equal digits in chunk order
+    const size_t chunkCount = pool && count >= PARALLEL_MIN_ENTRIES ? pool->GetThreadCount() + 1 : 1;
+    const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    ThreadPool *sortPool = chunkCount > 1 ? pool : nullptr;
+
+    m_Scratch.resize(count);
+    m_Counts.resize(chunkCount * BUCKETS);
+    Entry *src = m_Entries.data();
+    Entry *dst = m_Scratch.data();
+
+    for (uint32_t shift = 0; shift < 64; shift += RADIX_BITS)
+    {
+        Run(sortPool, chunkCount, 1, [&](size_t begin, size_t end)
+            {
+                for (size_t c = begin; c < end; ++c)
+                {
+                    uint32_t *counts = m_Counts.data() + c * BUCKETS;
+                    std::fill(counts, counts + BUCKETS, 0u);
+                    const size_t last = std::min(count, (c + 1) * chunkSize);
+                    for (size_t i = c * chunkSize; i < last; ++i)
+                        ++counts[(src[i].key >> shift) & (BUCKETS - 1)];
+                } });
+
+        // every key has the same digit here (unused material or mesh bits,
+        // the pass), so this pass wouldn't move anything
+        const uint32_t firstDigit = uint32_t(src[0].key >> shift) & (BUCKETS - 1);
+        size_t sameDigit = 0;
+        for (size_t c = 0; c < chunkCount; ++c)
+            sameDigit += m_Counts[c * BUCKETS + firstDigit];
+        if (sameDigit == count)
+            continue;
+
+        uint32_t offset = 0;
+        for (uint32_t b = 0; b < BUCKETS; ++b)
+        {
+            for (size_t c = 0; c < chunkCount; ++c)
+            {
+                const uint32_t n = m_Counts[c * BUCKETS + b];
+                m_Counts[c * BUCKETS + b] = offset;
+                offset += n;
+            }
+        }
+
+        Run(sortPool, chunkCount, 1, [&](size_t begin, size_t end)
+            {
+                for (size_t c = begin; c < end; ++c)
+                {
+                    uint32_t *offsets = m_Counts.data() + c * BUCKETS;
+                    const size_t last = std::min(count, (c + 1) * chunkSize);
+                    for (size_t i = c * chunkSize; i < last; ++i)
+                        dst[offsets[(src[i].key >> shift) & (BUCKETS - 1)]++] = src[i];
+                } });
+        std::swap(src, dst);
+    }
+
+    if (src != m_Entries.data())
+        m_Entries.swap(m_Scratch);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// the draws of a frame as 64 bit sort keys, most significant field first:
+//   pass (3) | shader variant (1) | material (20) | mesh (24) | lod (3) | depth (13)
+// sorting groups draws that share shaders, material and mesh, so submission
+// only rebinds what changed between neighbours and copies of one mesh level
+// end up next to each other for instancing. within a group draws go front to
+// back. an entry carries the caller's index of the draw it stands for
+class RenderQueue
+{
+public:
+    static constexpr uint32_t PASS_BITS = 3;
+    static constexpr uint32_t VARIANT_BITS = 1;
+    static constexpr uint32_t MATERIAL_BITS = 20;
+    static constexpr uint32_t MESH_BITS = 24;
+    static constexpr uint32_t LOD_BITS = 3;
+    static constexpr uint32_t DEPTH_BITS = 13;
+    static_assert(PASS_BITS + VARIANT_BITS + MATERIAL_BITS + MESH_BITS + LOD_BITS + DEPTH_BITS == 64, "Sort key fields must fill 64 bits.");
+
+    static constexpr uint32_t PASS_GEOMETRY = 0;
+
+    struct Entry
+    {
+        uint64_t key;
+        uint32_t item;
+    };
+
+    // fields are masked to their bits, so ids past them only group less well.
+    // depth is the view distance over the far plane, clamped to 0..1
+    static uint64_t MakeKey(uint32_t pass, uint32_t variant, uint32_t material, uint32_t mesh, uint32_t lod, float depth);
+
+    void Clear() { m_Entries.clear(); }
+    void Add(uint64_t key, uint32_t item) { m_Entries.push_back({key, item}); }
+
+    // stable lsd radix sort over 8 bit digits, skipping digits every key
+    // shares. pool is optional, large queues histogram and scatter on it
+    void Sort(ThreadPool *pool = nullptr);
+
+    size_t Size() const { return m_Entries.size(); }
+    const Entry &operator[](size_t i) const { return m_Entries[i]; }
+
+private:
+    std::vector<Entry> m_Entries;
+    std::vector<Entry> m_Scratch;
+    std::vector<uint32_t> m_Counts; // a histogram per chunk, then its scatter offsets
+};
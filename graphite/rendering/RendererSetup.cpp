@@ -1,10 +1,21 @@
 #include "RendererSetup.h"
+#include "rendering/VertexLayout.h"
 #include "utils/Logger.h"
 #include "ShaderUtils.h"
 #include "cfg/Config.h"
+#include <vector>
 
 namespace ShaderPaths = Config::ShaderPaths;
 
+namespace
+{
+    template <size_t N>
+    std::vector<D3D11_INPUT_ELEMENT_DESC> ToVector(const std::array<D3D11_INPUT_ELEMENT_DESC, N> &elements)
+    {
+        return {elements.begin(), elements.end()};
+    }
+}
+
 namespace RendererSetup
 {
     void InitStateObjects(ID3D11Device *device,
@@ -59,6 +70,7 @@ namespace RendererSetup
         sd.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
         sd.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
         sd.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+        sd.MaxLOD = D3D11_FLOAT32_MAX; // zero would pin sampling to mip 0
 
         hr = device->CreateSamplerState(&sd, outSampler.GetAddressOf());
 
@@ -72,12 +84,22 @@ namespace RendererSetup
     void InitGeometryShadersAndLayout(
         ID3D11Device *device,
         HWND hwnd,
+        VertexFormat vertexFormat,
+        bool tangents,
         ComPtr<ID3D11VertexShader> &outVS,
         ComPtr<ID3D11PixelShader> &outPS,
         ComPtr<ID3D11InputLayout> &outInputLayout)
     {
+        const bool packed = vertexFormat == VertexFormat::Packed;
+        D3D_SHADER_MACRO defines[3] = {};
+        D3D_SHADER_MACRO *define = defines;
+        if (packed)
+            *define++ = {"PACKED_VERTICES", "1"};
+        if (!tangents)
+            *define++ = {"NO_TANGENTS", "1"};
+
         ComPtr<ID3DBlob> vsBlob, psBlob;
-        if (!CompileShaderFromFile(ShaderPaths::GEOMETRY_VS, "main", "vs_5_0", vsBlob))
+        if (!CompileShaderFromFile(ShaderPaths::GEOMETRY_VS, "main", "vs_5_0", vsBlob, defines))
             throw std::runtime_error("GeometryVS compilation failed");
 
         HRESULT hr = device->CreateVertexShader(
@@ -92,7 +114,7 @@ namespace RendererSetup
             throw std::runtime_error("Failed to create vertex shader");
         }
 
-        if (!CompileShaderFromFile(ShaderPaths::GEOMETRY_PS, "main", "ps_5_0", psBlob))
+        if (!CompileShaderFromFile(ShaderPaths::GEOMETRY_PS, "main", "ps_5_0", psBlob, defines))
             throw std::runtime_error("GeometryPS compilation failed");
 
         hr = device->CreatePixelShader(
@@ -107,16 +129,15 @@ namespace RendererSetup
             throw std::runtime_error("Failed to create pixel shader");
         }
 
-        // input layout
-        D3D11_INPUT_ELEMENT_DESC layoutDesc[] = {
-            {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-            {"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0},
-            {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0},
-            {"TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 32, D3D11_INPUT_PER_VERTEX_DATA, 0}};
+        // input layout, one slot per stream (see VertexLayout.h)
+        const auto elements = packed ? (tangents ? ToVector(VertexLayout::Packed::InputElements())
+                                                 : ToVector(VertexLayout::PackedNoTangents::InputElements()))
+                                     : (tangents ? ToVector(VertexLayout::Full::InputElements())
+                                                 : ToVector(VertexLayout::FullNoTangents::InputElements()));
 
         hr = device->CreateInputLayout(
-            layoutDesc,
-            _countof(layoutDesc),
+            elements.data(),
+            UINT(elements.size()),
             vsBlob->GetBufferPointer(),
             vsBlob->GetBufferSize(),
             outInputLayout.GetAddressOf());
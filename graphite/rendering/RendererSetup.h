@@ -1,5 +1,6 @@
 #pragma once
 
+#include "rendering/Vertex.h"
 #include <d3d11.h>
 #include <wrl/client.h>
 
@@ -17,9 +18,14 @@ namespace RendererSetup
 
     // compile geometry shaders and create input layout
     // vsblob and psblob are optional out params
+    // the vertex shader is compiled with PACKED_VERTICES for VertexFormat::Packed,
+    // both stages with NO_TANGENTS when tangents is false. the layout then
+    // reads the streams before VERTEX_STREAM_TANGENT only
     void InitGeometryShadersAndLayout(
         ID3D11Device *device,
         HWND hwnd,
+        VertexFormat vertexFormat,
+        bool tangents,
         ComPtr<ID3D11VertexShader> &outVS,
         ComPtr<ID3D11PixelShader> &outPS,
         ComPtr<ID3D11InputLayout> &outInputLayout);
@@ -11,3 +11,10 @@ struct Vertex
     glm::vec3 Tangent;
 };
 // sizeof(Vertex) = 44 bytes
+
+// which vertex layout meshes are uploaded with, see PackedVertex.h
+enum class VertexFormat
+{
+    Full,
+    Packed
+};
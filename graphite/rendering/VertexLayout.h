@@ -0,0 +1,224 @@
+#pragma once
+
+#include "rendering/PackedVertex.h"
+#include "rendering/Vertex.h"
+#include "shaders/VertexLayout.hlsli"
+#include <d3d11.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// vertex layouts as compile time type lists. an attribute names its semantic,
+// dxgi format and c++ type, a stream lists the attributes sharing a buffer
+// and a layout lists the streams of a shader, one input slot each. the
+// per stream vertex structs, the input element descs and the split of an
+// interleaved Vertex or PackedVertex into streams all come from that. every
+// layout also reads Instance, the per instance stream
+namespace VertexLayout
+{
+    // attributes, read from the interleaved vertex they came from
+    struct Position
+    {
+        using Type = glm::vec3;
+        static constexpr const char *SEMANTIC = "POSITION";
+        static constexpr DXGI_FORMAT FORMAT = DXGI_FORMAT_R32G32B32_FLOAT;
+        static Type Read(const Vertex &v) { return v.Position; }
+    };
+
+    struct Normal
+    {
+        using Type = glm::vec3;
+        static constexpr const char *SEMANTIC = "NORMAL";
+        static constexpr DXGI_FORMAT FORMAT = DXGI_FORMAT_R32G32B32_FLOAT;
+        static Type Read(const Vertex &v) { return v.Normal; }
+    };
+
+    struct TexCoord
+    {
+        using Type = glm::vec2;
+        static constexpr const char *SEMANTIC = "TEXCOORD";
+        static constexpr DXGI_FORMAT FORMAT = DXGI_FORMAT_R32G32_FLOAT;
+        static Type Read(const Vertex &v) { return v.TexCoord; }
+    };
+
+    struct Tangent
+    {
+        using Type = glm::vec3;
+        static constexpr const char *SEMANTIC = "TANGENT";
+        static constexpr DXGI_FORMAT FORMAT = DXGI_FORMAT_R32G32B32_FLOAT;
+        static Type Read(const Vertex &v) { return v.Tangent; }
+    };
+
+    struct PackedPosition
+    {
+        using Type = std::array<uint16_t, 4>;
+        static constexpr const char *SEMANTIC = "POSITION";
+        static constexpr DXGI_FORMAT FORMAT = DXGI_FORMAT_R16G16B16A16_UNORM;
+        static Type Read(const PackedVertex &v) { return {v.Position[0], v.Position[1], v.Position[2], v.Position[3]}; }
+    };
+
+    struct PackedNormal
+    {
+        using Type = std::array<int16_t, 2>;
+        static constexpr const char *SEMANTIC = "NORMAL";
+        static constexpr DXGI_FORMAT FORMAT = DXGI_FORMAT_R16G16_SNORM;
+        static Type Read(const PackedVertex &v) { return {v.Normal[0], v.Normal[1]}; }
+    };
+
+    struct PackedTexCoord
+    {
+        using Type = std::array<uint16_t, 2>;
+        static constexpr const char *SEMANTIC = "TEXCOORD";
+        static constexpr DXGI_FORMAT FORMAT = DXGI_FORMAT_R16G16_FLOAT;
+        static Type Read(const PackedVertex &v) { return {v.TexCoord[0], v.TexCoord[1]}; }
+    };
+
+    struct PackedTangent
+    {
+        using Type = std::array<int16_t, 2>;
+        static constexpr const char *SEMANTIC = "TANGENT";
+        static constexpr DXGI_FORMAT FORMAT = DXGI_FORMAT_R16G16_SNORM;
+        static Type Read(const PackedVertex &v) { return {v.Tangent[0], v.Tangent[1]}; }
+    };
+
+    // attributes back to back in one buffer
+    template <typename... Attributes>
+    struct Stream
+    {
+        static constexpr UINT ATTRIBUTE_COUNT = sizeof...(Attributes);
+        static constexpr UINT STRIDE = (UINT(sizeof(typename Attributes::Type)) + ...);
+
+        template <typename Attribute>
+        static constexpr UINT OffsetOf()
+        {
+            static_assert((std::is_same_v<Attribute, Attributes> || ...), "attribute isn't part of this stream");
+            UINT offset = 0;
+            bool found = false;
+            ((found = found || std::is_same_v<Attribute, Attributes>,
+              offset += found ? 0 : UINT(sizeof(typename Attributes::Type))),
+             ...);
+            return offset;
+        }
+
+        // one vertex of the stream. attributes are copied in and out, so their
+        // types need no particular alignment within it
+        struct Element
+        {
+            unsigned char bytes[STRIDE];
+
+            template <typename Attribute>
+            typename Attribute::Type Get() const
+            {
+                typename Attribute::Type value;
+                std::memcpy(&value, bytes + OffsetOf<Attribute>(), sizeof(value));
+                return value;
+            }
+
+            template <typename Attribute>
+            void Set(const typename Attribute::Type &value)
+            {
+                std::memcpy(bytes + OffsetOf<Attribute>(), &value, sizeof(value));
+            }
+        };
+        static_assert(sizeof(Element) == STRIDE, "stream elements are tightly packed");
+
+        template <typename Source>
+        static void Gather(const Source *vertices, size_t count, Element *out)
+        {
+            for (size_t i = 0; i < count; ++i)
+                (out[i].template Set<Attributes>(Attributes::Read(vertices[i])), ...);
+        }
+
+        static void AppendElements(UINT slot, D3D11_INPUT_ELEMENT_DESC *&out)
+        {
+            ((*out++ = {Attributes::SEMANTIC, 0, Attributes::FORMAT, slot, OffsetOf<Attributes>(), D3D11_INPUT_PER_VERTEX_DATA, 0}), ...);
+        }
+    };
+
+    // what a draw instance reads from VERTEX_STREAM_INSTANCE: the first three
+    // rows of its world matrix, the fourth is always 0 0 0 1
+    struct Instance
+    {
+        static constexpr UINT ELEMENT_COUNT = 3;
+
+        glm::vec4 rows[ELEMENT_COUNT];
+
+        static Instance FromWorld(const glm::mat4 &world)
+        {
+            // glm is column major, row r is (m[0][r], m[1][r], m[2][r], m[3][r])
+            Instance instance;
+            for (int r = 0; r < 3; ++r)
+                instance.rows[r] = glm::vec4(world[0][r], world[1][r], world[2][r], world[3][r]);
+            return instance;
+        }
+
+        static void AppendElements(D3D11_INPUT_ELEMENT_DESC *&out)
+        {
+            for (UINT r = 0; r < ELEMENT_COUNT; ++r)
+                *out++ = {"WORLD", r, DXGI_FORMAT_R32G32B32A32_FLOAT, VERTEX_STREAM_INSTANCE, r * UINT(sizeof(glm::vec4)), D3D11_INPUT_PER_INSTANCE_DATA, 1};
+        }
+    };
+    static_assert(sizeof(Instance) == INSTANCE_STRIDE, "Instance doesn't match VertexLayout.hlsli.");
+
+    // streams in input slot order, then the instance stream
+    template <typename... Streams>
+    struct Layout
+    {
+        static constexpr UINT STREAM_COUNT = sizeof...(Streams);
+        static constexpr UINT ELEMENT_COUNT = (Streams::ATTRIBUTE_COUNT + ...) + Instance::ELEMENT_COUNT;
+        static constexpr std::array<UINT, STREAM_COUNT> STRIDES = {Streams::STRIDE...};
+        static constexpr UINT STRIDE = (Streams::STRIDE + ...); // over every stream
+
+        template <size_t SLOT>
+        using StreamAt = std::tuple_element_t<SLOT, std::tuple<Streams...>>;
+
+        static std::array<D3D11_INPUT_ELEMENT_DESC, ELEMENT_COUNT> InputElements()
+        {
+            std::array<D3D11_INPUT_ELEMENT_DESC, ELEMENT_COUNT> elements{};
+            D3D11_INPUT_ELEMENT_DESC *out = elements.data();
+            UINT slot = 0;
+            (Streams::AppendElements(slot++, out), ...);
+            Instance::AppendElements(out);
+            return elements;
+        }
+
+        // splits interleaved vertices into streams, out[s] holds count * STRIDES[s] bytes
+        template <typename Source>
+        static void Split(const Source *vertices, size_t count, void *const *out)
+        {
+            size_t slot = 0;
+            (Streams::Gather(vertices, count, static_cast<typename Streams::Element *>(out[slot++])), ...);
+        }
+    };
+
+    // what the geometry pass reads, see shaders/VertexLayout.hlsli. the
+    // variants without tangents are the same streams minus the last one
+    using Full = Layout<Stream<Position>, Stream<Normal, TexCoord>, Stream<Tangent>>;
+    using FullNoTangents = Layout<Stream<Position>, Stream<Normal, TexCoord>>;
+    using Packed = Layout<Stream<PackedPosition>, Stream<PackedNormal, PackedTexCoord>, Stream<PackedTangent>>;
+    using PackedNoTangents = Layout<Stream<PackedPosition>, Stream<PackedNormal, PackedTexCoord>>;
+
+    // every attribute of the interleaved vertex lands in exactly one stream
+    static_assert(Full::STRIDE == sizeof(Vertex), "Full must cover every Vertex attribute.");
+    static_assert(Packed::STRIDE == sizeof(PackedVertex), "Packed must cover every PackedVertex attribute.");
+
+    static_assert(Full::STRIDES[VERTEX_STREAM_POSITION] == FULL_POSITION_STRIDE, "Full layout doesn't match VertexLayout.hlsli.");
+    static_assert(Full::STRIDES[VERTEX_STREAM_SURFACE] == FULL_SURFACE_STRIDE, "Full layout doesn't match VertexLayout.hlsli.");
+    static_assert(Full::STRIDES[VERTEX_STREAM_TANGENT] == FULL_TANGENT_STRIDE, "Full layout doesn't match VertexLayout.hlsli.");
+    static_assert(Packed::STRIDES[VERTEX_STREAM_POSITION] == PACKED_POSITION_STRIDE, "Packed layout doesn't match VertexLayout.hlsli.");
+    static_assert(Packed::STRIDES[VERTEX_STREAM_SURFACE] == PACKED_SURFACE_STRIDE, "Packed layout doesn't match VertexLayout.hlsli.");
+    static_assert(Packed::STRIDES[VERTEX_STREAM_TANGENT] == PACKED_TANGENT_STRIDE, "Packed layout doesn't match VertexLayout.hlsli.");
+    static_assert(Full::STREAM_COUNT == VERTEX_STREAM_TANGENT + 1 && Packed::STREAM_COUNT == VERTEX_STREAM_TANGENT + 1,
+                  "The tangent stream must be the last one so it can be dropped.");
+    static_assert(VERTEX_STREAM_INSTANCE >= Full::STREAM_COUNT, "The instance stream can't share a slot with vertex streams.");
+    static_assert(FullNoTangents::STREAM_COUNT == VERTEX_STREAM_TANGENT && PackedNoTangents::STREAM_COUNT == VERTEX_STREAM_TANGENT,
+                  "Layouts without tangents are the tangent layouts minus their last stream.");
+    static_assert(std::is_same_v<Full::StreamAt<VERTEX_STREAM_SURFACE>, FullNoTangents::StreamAt<VERTEX_STREAM_SURFACE>> &&
+                      std::is_same_v<Packed::StreamAt<VERTEX_STREAM_SURFACE>, PackedNoTangents::StreamAt<VERTEX_STREAM_SURFACE>>,
+                  "Layouts without tangents are the tangent layouts minus their last stream.");
+}
@@ -1,23 +1,32 @@
 #include "RenderSystem.h"
 #include "core/ServiceLocator.h"
 #include "core/SceneManager.h"
+#include "core/ThreadPool.h"
 #include "managers/DeviceManager.h"
 #include "managers/AssetManager.h"
 #include "ecs/ECSRegistry.h"
 #include "ecs/RenderableComponent.h"
 #include "ecs/TransformComponent.h"
 #include "rendering/RendererSetup.h"
+#include "rendering/LodSelection.h"
+#include "rendering/Frustum.h"
 #include "rendering/Material.h"
-#include "rendering/Vertex.h"
+#include "rendering/VertexLayout.h"
 #include "utils/Logger.h"
 #include "utils/ImGuiConfig.h"
+#include "cfg/Config.h"
 #include <imgui.h>
 #include <imgui_impl_win32.h>
 #include <imgui_impl_dx11.h>
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cstring>
+
+static_assert(Config::Lod::MAX_LEVELS <= (1u << RenderQueue::LOD_BITS), "Levels don't fit the sort key.");
 
 RenderSystem::RenderSystem(SceneManager *sceneManager)
-    : m_SceneManager(sceneManager)
+    : m_SceneManager(sceneManager),
+      m_queuePool(std::make_unique<ThreadPool>(Config::Threading::RENDER_WORKER_COUNT))
 {
 }
 
@@ -111,9 +120,9 @@ void RenderSystem::InitConstantBuffers(ID3D11Device *device)
     hr = device->CreateBuffer(&cbDesc, nullptr, m_cbPerFrame.GetAddressOf());
     if (FAILED(hr)) throw std::runtime_error("Failed to create per-frame constant buffer");
 
-    cbDesc.ByteWidth = sizeof(PerObjectData);
-    hr = device->CreateBuffer(&cbDesc, nullptr, m_cbPerObject.GetAddressOf());
-    if (FAILED(hr)) throw std::runtime_error("Failed to create per-object constant buffer");
+    cbDesc.ByteWidth = sizeof(PerMeshData);
+    hr = device->CreateBuffer(&cbDesc, nullptr, m_cbPerMesh.GetAddressOf());
+    if (FAILED(hr)) throw std::runtime_error("Failed to create per-mesh constant buffer");
 
     cbDesc.ByteWidth = sizeof(DirectionalLightData);
     cbDesc.Usage = D3D11_USAGE_DEFAULT;
@@ -133,12 +142,15 @@ void RenderSystem::InitStateObjectsAndShaders()
         m_depthStencilStateDefault,
         m_samplerStateDefault);
 
-    RendererSetup::InitGeometryShadersAndLayout(
-        device,
-        deviceManager.GetHWND(),
-        m_vsGeometry,
-        m_psGeometry,
-        m_inputLayout);
+    for (int tangents = 0; tangents < 2; ++tangents)
+        RendererSetup::InitGeometryShadersAndLayout(
+            device,
+            deviceManager.GetHWND(),
+            Config::VertexCompression::USE_PACKED_VERTICES ? VertexFormat::Packed : VertexFormat::Full,
+            tangents != 0,
+            m_vsGeometry[tangents],
+            m_psGeometry[tangents],
+            m_inputLayout[tangents]);
 
     RendererSetup::InitLightingShaders(
         device,
@@ -146,10 +158,84 @@ void RenderSystem::InitStateObjectsAndShaders()
         m_psLighting);
 }
 
+void RenderSystem::OnFileChanged(const std::filesystem::path &path)
+{
+    namespace SP = Config::ShaderPaths;
+    const auto changed = path.lexically_normal();
+    auto is = [&](const wchar_t *shader)
+    {
+        return std::filesystem::path(shader).lexically_normal() == changed;
+    };
+
+    // no include tracking, a changed header may feed any shader
+    const bool header = changed.extension() == ".hlsli";
+    if (header || is(SP::GEOMETRY_VS) || is(SP::GEOMETRY_PS))
+        ReloadGeometryShaders();
+    if (header || is(SP::LIGHTING_VS) || is(SP::LIGHTING_PS))
+        ReloadLightingShaders();
+}
+
+void RenderSystem::ReloadGeometryShaders()
+{
+    auto &deviceManager = ServiceLocator::GetDeviceManager();
+
+    // compile into temporaries so a broken edit never leaves a stage unbound
+    decltype(m_vsGeometry) vs;
+    decltype(m_psGeometry) ps;
+    decltype(m_inputLayout) layout;
+    try
+    {
+        for (int tangents = 0; tangents < 2; ++tangents)
+            RendererSetup::InitGeometryShadersAndLayout(
+                deviceManager.GetDevice(),
+                deviceManager.GetHWND(),
+                Config::VertexCompression::USE_PACKED_VERTICES ? VertexFormat::Packed : VertexFormat::Full,
+                tangents != 0,
+                vs[tangents],
+                ps[tangents],
+                layout[tangents]);
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR("Geometry shader reload failed, keeping the previous version: {}", e.what());
+        return;
+    }
+
+    m_vsGeometry = vs;
+    m_psGeometry = ps;
+    m_inputLayout = layout;
+    LOG_INFO("Reloaded geometry shaders");
+}
+
+void RenderSystem::ReloadLightingShaders()
+{
+    Microsoft::WRL::ComPtr<ID3D11VertexShader> vs;
+    Microsoft::WRL::ComPtr<ID3D11PixelShader> ps;
+    try
+    {
+        RendererSetup::InitLightingShaders(ServiceLocator::GetDeviceManager().GetDevice(), vs, ps);
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR("Lighting shader reload failed, keeping the previous version: {}", e.what());
+        return;
+    }
+
+    m_vsLighting = vs;
+    m_psLighting = ps;
+    LOG_INFO("Reloaded lighting shaders");
+}
+
 void RenderSystem::BeginFrame()
 {
     m_drawCallCount = 0;
     m_triangleCount = 0;
+    m_objectsTested = 0;
+    m_objectsCulled = 0;
+    m_meshletsTested = 0;
+    m_meshletsCulled = 0;
+    m_stateChanges = 0;
+    m_stateChangesSkipped = 0;
 
     auto *context = ServiceLocator::GetDeviceManager().GetContext();
     m_GBuffer.Bind(context);
@@ -165,26 +251,159 @@ void RenderSystem::GeometryPass()
 
     SetGeometryPassState(context);
 
+    const auto &camera = m_SceneManager->GetCamera();
+    const glm::vec3 cameraPos = camera.GetPosition();
+    const float errorToPixels = LodSelection::ErrorToPixelScale(camera.GetProjection(), float(m_Height));
+    const Frustum frustum = Frustum::FromMatrix(camera.GetProjection() * camera.GetView());
+
+    // gather every object that can be drawn with its world bounding sphere,
+    // then cull them together 8 at a time instead of one sphere per loop
+    m_drawCandidates.clear();
+    m_objectBounds.Clear();
     auto view = registry.View<RenderableComponent, TransformComponent>();
     for (auto [ent, rc, tc] : view.each())
     {
-        auto *model = assetManager.GetModel(rc.modelID);
+        // not resident yet (still streaming) or failed to load
+        auto *model = assetManager.GetModel(rc.model);
         if (!model) continue;
 
         size_t index = std::min(rc.subMeshIndex, model->meshes.size() - 1);
         const auto &mesh = model->meshes[index];
 
-        auto *material = assetManager.GetMaterial(rc.materialID);
+        auto *material = assetManager.GetMaterial(rc.material);
         if (!material) continue;
 
-        UpdatePerObjectConstantBuffer(context, tc);
-        BindMaterial(context, material);
-        DrawMesh(context, &mesh);
-        UnbindMaterial(context);
+        DrawCandidate candidate;
+        candidate.renderable = &rc;
+        candidate.mesh = &mesh;
+        candidate.material = material;
+        candidate.world = ComputeWorldMatrix(tc);
+        candidate.scale = std::max({std::abs(tc.scale.x), std::abs(tc.scale.y), std::abs(tc.scale.z)});
+        candidate.uniformScale = tc.scale.x == tc.scale.y && tc.scale.y == tc.scale.z;
+
+        m_objectBounds.Add(glm::vec3(candidate.world * glm::vec4(mesh.bounds.center, 1.0f)), mesh.bounds.radius * candidate.scale);
+        m_drawCandidates.push_back(candidate);
+    }
+
+    m_visibleObjects.resize(m_drawCandidates.size());
+    const size_t visibleObjects = ObjectCulling::Cull(m_objectBounds, frustum, m_visibleObjects.data());
+    m_objectsTested += static_cast<int>(m_drawCandidates.size());
+    m_objectsCulled += static_cast<int>(m_drawCandidates.size() - visibleObjects);
 
-        m_drawCallCount++;
-        m_triangleCount += mesh.indexCount / 3;
+    // pick a level for every visible object and queue it under a key, so the
+    // sorted queue draws neighbours that share state back to back
+    m_renderQueue.Clear();
+    for (size_t v = 0; v < visibleObjects; ++v)
+    {
+        const uint32_t i = m_visibleObjects[v];
+        DrawCandidate &candidate = m_drawCandidates[i];
+        auto &rc = *candidate.renderable;
+        const auto &mesh = *candidate.mesh;
+        const auto *material = candidate.material;
+        const float scale = candidate.scale;
+
+        // distance to the nearest point of the bounding sphere, so large
+        // meshes don't coarsen while the camera is close to their surface
+        const glm::vec3 center(m_objectBounds.centerX[i], m_objectBounds.centerY[i], m_objectBounds.centerZ[i]);
+        float distance = std::max(glm::length(center - cameraPos) - m_objectBounds.radius[i], camera.GetNearZ());
+
+        const float pixelsPerUnit = scale * errorToPixels / distance;
+        rc.lodIndex = LodSelection::SelectLod(
+            mesh.lods.data(),
+            static_cast<uint32_t>(mesh.lods.size()),
+            pixelsPerUnit,
+            rc.lodIndex,
+            Config::Lod::PIXEL_ERROR_THRESHOLD,
+            Config::Lod::HYSTERESIS);
+        candidate.lodIndex = rc.lodIndex;
+
+        // finest texture detail this draw resolves, texture streaming loads towards it
+        assetManager.RequestTextureDetail(material->albedo, mesh.uvDensity, pixelsPerUnit);
+        assetManager.RequestTextureDetail(material->normal, mesh.uvDensity, pixelsPerUnit);
+        assetManager.RequestTextureDetail(material->orm, mesh.uvDensity, pixelsPerUnit);
+
+        // materials without a normal map, and meshes without tangents, skip the tangent stream.
+        // only the latter save its memory: which materials a mesh is drawn with isn't known
+        // when it's uploaded, so a mesh with tangents keeps them resident either way
+        candidate.tangents = material->normal.IsValid() && mesh.geometry.streamCount > VERTEX_STREAM_TANGENT;
+
+        // submeshes past the 16th share their model's id, which only groups them less well
+        const uint32_t meshId = (rc.model.Index() << 4) | uint32_t(std::min<size_t>(rc.subMeshIndex, 15));
+        m_renderQueue.Add(RenderQueue::MakeKey(RenderQueue::PASS_GEOMETRY, candidate.tangents, rc.material.Index(), meshId, rc.lodIndex,
+                                               distance / camera.GetFarZ()),
+                          i);
+    }
+
+    m_renderQueue.Sort(m_queuePool.get());
+
+    // world matrices in queue order, so every run of the queue reads a
+    // contiguous range of instances
+    m_instances.resize(m_renderQueue.Size());
+    for (size_t q = 0; q < m_renderQueue.Size(); ++q)
+        m_instances[q] = VertexLayout::Instance::FromWorld(m_drawCandidates[m_renderQueue[q].item].world);
+    // without instances there is nothing to draw from, but the pass still
+    // runs to the end so the material and state get unbound as usual
+    const size_t drawCount = UploadInstances(context) ? m_renderQueue.Size() : 0;
+    if (drawCount < m_renderQueue.Size())
+        LOG_ERROR("Failed to upload {} instances, skipping the geometry draws this frame", m_instances.size());
+
+    size_t q = 0;
+    while (q < drawCount)
+    {
+        const DrawCandidate &candidate = m_drawCandidates[m_renderQueue[q].item];
+        const auto &mesh = *candidate.mesh;
+        const auto &lod = mesh.lods[candidate.lodIndex];
+
+        // copies of this mesh level with this material sit next to each other,
+        // the key only groups them so the pointers are compared as well
+        size_t end = q + 1;
+        while (end < m_renderQueue.Size())
+        {
+            const DrawCandidate &next = m_drawCandidates[m_renderQueue[end].item];
+            if (next.mesh != candidate.mesh || next.material != candidate.material ||
+                next.lodIndex != candidate.lodIndex || next.tangents != candidate.tangents)
+                break;
+            ++end;
+        }
+        const size_t instanceCount = end - q;
+
+        // a group draws its whole level once per instance, a lone object
+        // keeps per meshlet culling in object space
+        const bool useMeshlets = instanceCount < Config::Instancing::MIN_INSTANCES &&
+                                 candidate.lodIndex < mesh.meshlets.lodRanges.size();
+        size_t visibleCount = 0;
+        if (useMeshlets)
+        {
+            const MeshletRange &range = mesh.meshlets.lodRanges[candidate.lodIndex];
+
+            MeshletCulling::Params params;
+            params.frustum = frustum.Transformed(candidate.world);
+            params.radiusScale = candidate.scale;
+            params.cameraPosition = glm::vec3(glm::inverse(candidate.world) * glm::vec4(cameraPos, 1.0f));
+            // cones don't survive non-uniform scale, and wireframe draws back faces
+            params.coneCulling = Config::Meshlets::CONE_CULLING && !m_useWire_NoCull && candidate.uniformScale;
+
+            m_visibleMeshlets.resize(range.count);
+            visibleCount = MeshletCulling::Cull(mesh.meshlets.bounds, range.first, range.count, params, m_visibleMeshlets.data());
+
+            m_meshletsTested += static_cast<int>(range.count);
+            m_meshletsCulled += static_cast<int>(range.count - visibleCount);
+        }
+
+        if (!useMeshlets || visibleCount > 0)
+        {
+            UpdatePerMeshConstants(context, mesh);
+            BindGeometryShaders(context, candidate.tangents);
+            BindMaterial(context, candidate.material);
+            BindMesh(context, &mesh);
+            if (useMeshlets)
+                DrawMeshlets(context, mesh, m_visibleMeshlets.data(), visibleCount, UINT(q));
+            else
+                DrawIndexRange(context, mesh, lod.indexOffset, lod.indexCount, UINT(q), UINT(instanceCount));
+        }
+        q = end;
     }
+    UnbindMaterial(context);
 }
 
 void RenderSystem::LightingPass()
@@ -244,38 +463,119 @@ void RenderSystem::SetGeometryPassState(ID3D11DeviceContext *context)
 {
     context->RSSetState(m_useWire_NoCull ? m_rasterizerStateWire_NoCull.Get() : m_rasterizerStateDefault.Get());
     context->OMSetDepthStencilState(m_depthStencilStateDefault.Get(), 1);
-    context->IASetInputLayout(m_inputLayout.Get());
-    context->VSSetShader(m_vsGeometry.Get(), nullptr, 0);
-    context->PSSetShader(m_psGeometry.Get(), nullptr, 0);
     context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     context->VSSetConstantBuffers(0, 1, m_cbPerFrame.GetAddressOf());
     context->PSSetSamplers(0, 1, m_samplerStateDefault.GetAddressOf());
+
+    // imgui and the lighting pass rebind the input assembler every frame
+    m_boundGeometryVariant = -1;
+    m_boundVertexBuffer = nullptr;
+    m_boundStreamCount = 0;
+    m_boundIndexBuffer = nullptr;
+    m_boundIndexFormat = DXGI_FORMAT_UNKNOWN;
+    m_boundMaterialSRVs = {};
+    m_boundMeshConstants = nullptr;
 }
 
-void RenderSystem::UpdatePerObjectConstantBuffer(ID3D11DeviceContext *context, const TransformComponent &transform)
+glm::mat4 RenderSystem::ComputeWorldMatrix(const TransformComponent &transform)
 {
-    PerObjectData pod{};
     glm::mat4 world(1.0f);
     world = glm::translate(world, transform.position);
     world = glm::rotate(world, transform.rotation.y, glm::vec3{0, 1, 0});
     world = glm::rotate(world, transform.rotation.x, glm::vec3{1, 0, 0});
     world = glm::rotate(world, transform.rotation.z, glm::vec3{0, 0, 1});
     world = glm::scale(world, transform.scale);
-    pod.worldMatrix = world;
+    return world;
+}
+
+void RenderSystem::UpdatePerMeshConstants(ID3D11DeviceContext *context, const AssetManager::MeshResource &mesh)
+{
+    // the queue keeps draws of one mesh together, so this maps once per mesh
+    if (m_boundMeshConstants == &mesh)
+    {
+        m_stateChangesSkipped++;
+        return;
+    }
+
+    PerMeshData pmd{};
+    pmd.positionScale = glm::vec4(mesh.quantization.scale, 0.0f);
+    pmd.positionOffset = glm::vec4(mesh.quantization.offset, 0.0f);
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (SUCCEEDED(context->Map(m_cbPerMesh.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+    {
+        *reinterpret_cast<PerMeshData *>(mapped.pData) = pmd;
+        context->Unmap(m_cbPerMesh.Get(), 0);
+    }
+    context->VSSetConstantBuffers(1, 1, m_cbPerMesh.GetAddressOf());
+    m_boundMeshConstants = &mesh;
+    m_stateChanges++;
+}
+
+bool RenderSystem::UploadInstances(ID3D11DeviceContext *context)
+{
+    if (m_instances.empty())
+        return true;
+
+    if (m_instances.size() > m_instanceCapacity)
+    {
+        UINT capacity = std::max<UINT>(m_instanceCapacity, Config::Instancing::INITIAL_CAPACITY);
+        while (capacity < m_instances.size())
+            capacity *= 2;
+
+        D3D11_BUFFER_DESC desc = {};
+        desc.ByteWidth = capacity * UINT(sizeof(VertexLayout::Instance));
+        desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+        desc.Usage = D3D11_USAGE_DYNAMIC;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+        Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+        auto *device = ServiceLocator::GetDeviceManager().GetDevice();
+        if (FAILED(device->CreateBuffer(&desc, nullptr, buffer.GetAddressOf())))
+        {
+            LOG_ERROR("Failed to create instance buffer for {} instances", capacity);
+            return false;
+        }
+        m_instanceBuffer = buffer;
+        m_instanceCapacity = capacity;
+    }
 
     D3D11_MAPPED_SUBRESOURCE mapped;
-    if (SUCCEEDED(context->Map(m_cbPerObject.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+    if (FAILED(context->Map(m_instanceBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+        return false;
+    std::memcpy(mapped.pData, m_instances.data(), m_instances.size() * sizeof(VertexLayout::Instance));
+    context->Unmap(m_instanceBuffer.Get(), 0);
+
+    const UINT stride = sizeof(VertexLayout::Instance);
+    const UINT offset = 0;
+    context->IASetVertexBuffers(VERTEX_STREAM_INSTANCE, 1, m_instanceBuffer.GetAddressOf(), &stride, &offset);
+    return true;
+}
+
+void RenderSystem::BindGeometryShaders(ID3D11DeviceContext *context, bool tangents)
+{
+    if (m_boundGeometryVariant == int(tangents))
     {
-        *reinterpret_cast<PerObjectData *>(mapped.pData) = pod;
-        context->Unmap(m_cbPerObject.Get(), 0);
+        m_stateChangesSkipped++;
+        return;
     }
-    context->VSSetConstantBuffers(1, 1, m_cbPerObject.GetAddressOf());
+
+    context->IASetInputLayout(m_inputLayout[tangents].Get());
+    context->VSSetShader(m_vsGeometry[tangents].Get(), nullptr, 0);
+    context->PSSetShader(m_psGeometry[tangents].Get(), nullptr, 0);
+    m_boundGeometryVariant = int(tangents);
+    m_stateChanges++;
 }
 
 void RenderSystem::BindMaterial(ID3D11DeviceContext *context, const Material *material)
 {
     auto &assetManager = ServiceLocator::GetAssetManager();
-    ID3D11ShaderResourceView *srvs[3] = {};
+
+    // textures that haven't streamed in yet keep their neutral placeholder
+    std::array<ID3D11ShaderResourceView *, 3> srvs = {
+        assetManager.GetPlaceholderTexture(TextureRole::Albedo).srv.Get(),
+        assetManager.GetPlaceholderTexture(TextureRole::Normal).srv.Get(),
+        assetManager.GetPlaceholderTexture(TextureRole::ORM).srv.Get()};
     if (material)
     {
         auto *albedo = assetManager.GetTexture(material->albedo);
@@ -285,20 +585,77 @@ void RenderSystem::BindMaterial(ID3D11DeviceContext *context, const Material *ma
         auto *orm = assetManager.GetTexture(material->orm);
         if (orm) srvs[2] = orm->srv.Get();
     }
-    context->PSSetShaderResources(0, 3, srvs);
+
+    // compared by view rather than material, so materials sharing textures
+    // and ones still on placeholders skip the bind as well
+    if (srvs == m_boundMaterialSRVs)
+    {
+        m_stateChangesSkipped++;
+        return;
+    }
+    context->PSSetShaderResources(0, UINT(srvs.size()), srvs.data());
+    m_boundMaterialSRVs = srvs;
+    m_stateChanges++;
+}
+
+void RenderSystem::BindMesh(ID3D11DeviceContext *context, const AssetManager::MeshResource *mesh)
+{
+    // meshes share arena pages, so consecutive draws mostly find them bound already
+    // every stream lives in the same page buffer, so buffer and stream count pin down the bindings
+    const auto &geometry = mesh->geometry;
+    if (geometry.vertexBuffer != m_boundVertexBuffer || geometry.streamCount != m_boundStreamCount)
+    {
+        ID3D11Buffer *buffers[GeometryArena::MAX_VERTEX_STREAMS];
+        std::fill(buffers, buffers + geometry.streamCount, geometry.vertexBuffer);
+        context->IASetVertexBuffers(0, geometry.streamCount, buffers, geometry.strides, geometry.streamOffsets);
+        m_boundVertexBuffer = geometry.vertexBuffer;
+        m_boundStreamCount = geometry.streamCount;
+        m_stateChanges++;
+    }
+    else
+        m_stateChangesSkipped++;
+
+    if (geometry.indexBuffer != m_boundIndexBuffer || geometry.indexFormat != m_boundIndexFormat)
+    {
+        context->IASetIndexBuffer(geometry.indexBuffer, geometry.indexFormat, 0);
+        m_boundIndexBuffer = geometry.indexBuffer;
+        m_boundIndexFormat = geometry.indexFormat;
+        m_stateChanges++;
+    }
+    else
+        m_stateChangesSkipped++;
+}
+
+void RenderSystem::DrawIndexRange(ID3D11DeviceContext *context, const AssetManager::MeshResource &mesh, UINT indexOffset, UINT indexCount, UINT firstInstance, UINT instanceCount)
+{
+    context->DrawIndexedInstanced(indexCount, instanceCount, mesh.geometry.firstIndex + indexOffset, INT(mesh.geometry.baseVertex), firstInstance);
+    m_drawCallCount++;
+    m_triangleCount += int(indexCount / 3 * instanceCount);
 }
 
-void RenderSystem::DrawMesh(ID3D11DeviceContext *context, const AssetManager::MeshResource *mesh)
+void RenderSystem::DrawMeshlets(ID3D11DeviceContext *context, const AssetManager::MeshResource &mesh, const uint32_t *visible, size_t visibleCount, UINT instance)
 {
-    UINT stride = sizeof(Vertex);
-    UINT offset = 0;
-    context->IASetVertexBuffers(0, 1, mesh->vertexBuffer.GetAddressOf(), &stride, &offset);
-    context->IASetIndexBuffer(mesh->indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
-    context->DrawIndexed(mesh->indexCount, 0, 0);
+    const MeshletData &meshlets = mesh.meshlets;
+    // meshlets of a level are back to back in the index buffer, so runs of
+    // visible neighbours collapse into one draw
+    size_t i = 0;
+    while (i < visibleCount)
+    {
+        const Meshlet &first = meshlets.meshlets[visible[i]];
+        UINT indexCount = first.indexCount;
+
+        size_t j = i + 1;
+        while (j < visibleCount && visible[j] == visible[j - 1] + 1)
+            indexCount += meshlets.meshlets[visible[j++]].indexCount;
+
+        DrawIndexRange(context, mesh, first.indexOffset, indexCount, instance, 1);
+        i = j;
+    }
 }
 
 void RenderSystem::UnbindMaterial(ID3D11DeviceContext *context)
 {
     ID3D11ShaderResourceView *nulls[3] = {};
     context->PSSetShaderResources(0, 3, nulls);
+    m_boundMaterialSRVs = {};
 }
\ No newline at end of file
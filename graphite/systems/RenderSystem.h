@@ -5,16 +5,24 @@
 #include "rendering/GBuffer.h"
 #include "rendering/ConstantBuffers.h"
 #include "rendering/Lighting.h"
+#include "rendering/MeshletCulling.h"
+#include "rendering/ObjectCulling.h"
+#include "rendering/RenderQueue.h"
+#include "rendering/VertexLayout.h"
 #include <Windows.h>
 #include <d3d11.h>
 #include <wrl/client.h>
 #include <glm/glm.hpp>
 #include <array>
+#include <memory>
+#include <vector>
 
 class SceneManager;
 class ECSRegistry;
 class StatsSystem;
+class ThreadPool;
 struct Material;
+struct RenderableComponent;
 struct TransformComponent;
 
 class RenderSystem : public ISystem
@@ -28,6 +36,7 @@ public:
     void Update(float deltaTime) override;
     void Shutdown() override;
     void OnResize(int width, int height) override;
+    void OnFileChanged(const std::filesystem::path &path) override;
 
     // state changers
     void SetWireframeMode(bool enable) { m_useWire_NoCull = enable; }
@@ -36,6 +45,12 @@ public:
     // getters
     int GetDrawCallCount() const { return m_drawCallCount; }
     int GetTriangleCount() const { return m_triangleCount; }
+    int GetObjectsTested() const { return m_objectsTested; }
+    int GetObjectsCulled() const { return m_objectsCulled; }
+    int GetMeshletsTested() const { return m_meshletsTested; }
+    int GetMeshletsCulled() const { return m_meshletsCulled; }
+    int GetStateChanges() const { return m_stateChanges; }
+    int GetStateChangesSkipped() const { return m_stateChangesSkipped; }
     bool GetWireframeMode() const { return m_useWire_NoCull; }
     GBuffer &GetGBuffer() { return m_GBuffer; }
 
@@ -51,33 +66,87 @@ private:
     Microsoft::WRL::ComPtr<ID3D11RasterizerState> m_rasterizerStateWire_NoCull;
     Microsoft::WRL::ComPtr<ID3D11DepthStencilState> m_depthStencilStateDefault;
     Microsoft::WRL::ComPtr<ID3D11SamplerState> m_samplerStateDefault;
-    Microsoft::WRL::ComPtr<ID3D11VertexShader> m_vsGeometry;
-    Microsoft::WRL::ComPtr<ID3D11PixelShader> m_psGeometry;
-    Microsoft::WRL::ComPtr<ID3D11InputLayout> m_inputLayout;
+    // geometry pass variants, indexed by whether they read tangents (see VertexLayout.h)
+    std::array<Microsoft::WRL::ComPtr<ID3D11VertexShader>, 2> m_vsGeometry;
+    std::array<Microsoft::WRL::ComPtr<ID3D11PixelShader>, 2> m_psGeometry;
+    std::array<Microsoft::WRL::ComPtr<ID3D11InputLayout>, 2> m_inputLayout;
     Microsoft::WRL::ComPtr<ID3D11VertexShader> m_vsLighting;
     Microsoft::WRL::ComPtr<ID3D11PixelShader> m_psLighting;
     Microsoft::WRL::ComPtr<ID3D11Buffer> m_cbPerFrame;
-    Microsoft::WRL::ComPtr<ID3D11Buffer> m_cbPerObject;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_cbPerMesh;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_instanceBuffer; // world matrices of every queued draw, grown on demand
+    UINT m_instanceCapacity = 0;
     Microsoft::WRL::ComPtr<ID3D11Buffer> m_cbLight;
 
     bool m_useWire_NoCull = false;
     int m_drawCallCount = 0;
     int m_triangleCount = 0;
+    int m_objectsTested = 0;
+    int m_objectsCulled = 0;
+    int m_meshletsTested = 0;
+    int m_meshletsCulled = 0;
+    int m_stateChanges = 0;        // shader, material and buffer binds issued
+    int m_stateChangesSkipped = 0; // binds a draw asked for that were already in place
+    std::vector<uint32_t> m_visibleMeshlets; // scratch, reused every draw
+
+    // an object the geometry pass gathered, culled as a batch before drawing
+    struct DrawCandidate
+    {
+        RenderableComponent *renderable = nullptr;
+        const AssetManager::MeshResource *mesh = nullptr;
+        const Material *material = nullptr;
+        glm::mat4 world{1.0f};
+        float scale = 1.0f; // largest axis, for bounds
+        bool uniformScale = true;
+
+        // filled in once the object survived culling and got queued
+        bool tangents = false;
+        uint32_t lodIndex = 0;
+    };
+    // scratch, reused every frame. m_objectBounds[i] is the world sphere of m_drawCandidates[i]
+    std::vector<DrawCandidate> m_drawCandidates;
+    ObjectBounds m_objectBounds;
+    std::vector<uint32_t> m_visibleObjects;
+    RenderQueue m_renderQueue; // items index m_drawCandidates
+    std::vector<VertexLayout::Instance> m_instances; // in queue order
+    std::unique_ptr<ThreadPool> m_queuePool;
+
+    // input assembler state of the geometry pass, to skip redundant binds
+    int m_boundGeometryVariant = -1;
+    ID3D11Buffer *m_boundVertexBuffer = nullptr;
+    UINT m_boundStreamCount = 0;
+    ID3D11Buffer *m_boundIndexBuffer = nullptr;
+    DXGI_FORMAT m_boundIndexFormat = DXGI_FORMAT_UNKNOWN;
+    std::array<ID3D11ShaderResourceView *, 3> m_boundMaterialSRVs = {};
+    const AssetManager::MeshResource *m_boundMeshConstants = nullptr;
 
     // private methods
     void InitImGui(HWND hwnd, ID3D11Device *device, ID3D11DeviceContext *context);
     void InitConstantBuffers(ID3D11Device *device);
     void InitStateObjectsAndShaders();
 
+    // hot reload. a shader that fails to compile keeps the previous version
+    void ReloadGeometryShaders();
+    void ReloadLightingShaders();
+
     void BeginFrame();
     void GeometryPass();
     void LightingPass();
     void RenderImGui();
 
     void UpdatePerFrameConstants();
-    void UpdatePerObjectConstantBuffer(ID3D11DeviceContext *context, const TransformComponent &transform);
+    static glm::mat4 ComputeWorldMatrix(const TransformComponent &transform);
+    void UpdatePerMeshConstants(ID3D11DeviceContext *context, const AssetManager::MeshResource &mesh);
+    // writes m_instances to the instance buffer and binds it at VERTEX_STREAM_INSTANCE
+    bool UploadInstances(ID3D11DeviceContext *context);
     void SetGeometryPassState(ID3D11DeviceContext *context);
+    void BindGeometryShaders(ID3D11DeviceContext *context, bool tangents);
     void BindMaterial(ID3D11DeviceContext *context, const Material *material);
+    // once after the last draw, binds are only skipped while the pass runs
     void UnbindMaterial(ID3D11DeviceContext *context);
-    void DrawMesh(ID3D11DeviceContext *context, const AssetManager::MeshResource *mesh);
+    void BindMesh(ID3D11DeviceContext *context, const AssetManager::MeshResource *mesh);
+    // offsets are relative to the mesh's slice of the geometry arena, instances
+    // to the start of the instance buffer
+    void DrawIndexRange(ID3D11DeviceContext *context, const AssetManager::MeshResource &mesh, UINT indexOffset, UINT indexCount, UINT firstInstance, UINT instanceCount);
+    void DrawMeshlets(ID3D11DeviceContext *context, const AssetManager::MeshResource &mesh, const uint32_t *visible, size_t visibleCount, UINT instance);
 };
\ No newline at end of file
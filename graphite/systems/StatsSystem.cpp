@@ -30,6 +30,26 @@ void StatsSystem::Update(float dt)
 
     m_drawCalls = m_renderSystem->GetDrawCallCount();
     m_triCount = m_renderSystem->GetTriangleCount();
+    m_objectsTested = m_renderSystem->GetObjectsTested();
+    m_objectsCulled = m_renderSystem->GetObjectsCulled();
+    m_meshletsTested = m_renderSystem->GetMeshletsTested();
+    m_meshletsCulled = m_renderSystem->GetMeshletsCulled();
+    m_stateChanges = m_renderSystem->GetStateChanges();
+    m_stateChangesSkipped = m_renderSystem->GetStateChangesSkipped();
+
+    auto &assetManager = ServiceLocator::GetAssetManager();
+    m_residentMB = float(assetManager.GetResidentBytes()) / (1024.0f * 1024.0f);
+    m_budgetMB = float(assetManager.GetResidencyBudget()) / (1024.0f * 1024.0f);
+
+    const auto &geometry = assetManager.GetGeometryArena();
+    m_geometryUsedMB = float(geometry.GetUsedBytes()) / (1024.0f * 1024.0f);
+    m_geometryCapacityMB = float(geometry.GetCapacityBytes()) / (1024.0f * 1024.0f);
+    m_geometryPages = geometry.GetPageCount();
+
+    const auto &mipStreamer = assetManager.GetMipStreamer();
+    m_streamedMB = float(mipStreamer.GetResidentBytes()) / (1024.0f * 1024.0f);
+    m_streamPoolMB = float(mipStreamer.GetBudget()) / (1024.0f * 1024.0f);
+    m_mipLoads = mipStreamer.GetPendingCount();
 
     auto &camera = m_sceneManager->GetCamera();
     m_camPos = camera.GetPosition();
@@ -80,6 +100,12 @@ void StatsSystem::DrawEngineStatsWindow()
     ImGui::Separator();
     ImGui::Text("Draw Calls: %d", m_drawCalls);
     ImGui::Text("Triangles:  %d", m_triCount);
+    ImGui::Text("Objects:    %d / %d culled", m_objectsCulled, m_objectsTested);
+    ImGui::Text("Meshlets:   %d / %d culled", m_meshletsCulled, m_meshletsTested);
+    ImGui::Text("Binds:      %d, %d skipped", m_stateChanges, m_stateChangesSkipped);
+    ImGui::Text("Assets:     %.1f / %.0f MB", m_residentMB, m_budgetMB);
+    ImGui::Text("Geometry:   %.1f / %.0f MB in %zu pages", m_geometryUsedMB, m_geometryCapacityMB, m_geometryPages);
+    ImGui::Text("Mips:       %.1f / %.0f MB, %zu loading", m_streamedMB, m_streamPoolMB, m_mipLoads);
 
     ImGui::Separator();
     ImGui::Text("Cam Pos:    %.2f, %.2f, %.2f",
@@ -33,6 +33,20 @@ private:
     float m_fps = 0.f;
     int m_drawCalls = 0;
     int m_triCount = 0;
+    int m_objectsTested = 0;
+    int m_objectsCulled = 0;
+    int m_meshletsTested = 0;
+    int m_meshletsCulled = 0;
+    int m_stateChanges = 0;
+    int m_stateChangesSkipped = 0;
+    float m_residentMB = 0.f;
+    float m_budgetMB = 0.f;
+    float m_geometryUsedMB = 0.f;
+    float m_geometryCapacityMB = 0.f;
+    size_t m_geometryPages = 0;
+    float m_streamedMB = 0.f;
+    float m_streamPoolMB = 0.f;
+    size_t m_mipLoads = 0;
     glm::vec3 m_camPos;
     float m_camYaw, m_camPitch;
 
@@ -7,8 +7,10 @@ struct PS_INPUT {
     float4 position : SV_Position;
     float3 normal   : NORMAL;
     float2 texCoord : TEXCOORD0;
+#ifndef NO_TANGENTS
     float3 tangent  : TANGENT;
     float3 bitangent: BITANGENT;
+#endif
 };
 
 struct PS_OUTPUT {
@@ -20,12 +22,20 @@ struct PS_OUTPUT {
 PS_OUTPUT main(PS_INPUT input) {
     PS_OUTPUT output;
 
-    // build tbn
-    float3 nm = normalTex.Sample(samplerState, input.texCoord).xyz * 2.0f - 1.0f;
     float3 N = normalize(input.normal);
+#ifdef NO_TANGENTS
+    // materials without a normal map keep the interpolated normal
+    float3 wN = N;
+#else
+    // build tbn
+    // normal maps may be bc5 (xy only), so z is always rebuilt
+    float3 nm;
+    nm.xy = normalTex.Sample(samplerState, input.texCoord).xy * 2.0f - 1.0f;
+    nm.z = sqrt(saturate(1.0f - dot(nm.xy, nm.xy)));
     float3 T = normalize(input.tangent);
     float3 B = normalize(input.bitangent);
     float3 wN = normalize(mul(nm, float3x3(T, B, N)));
+#endif
 
     output.Albedo = albedoTex.Sample(samplerState, input.texCoord);
     output.Normal = float4(wN * 0.5f + 0.5f, 1.0f);
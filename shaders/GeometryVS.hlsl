@@ -4,41 +4,68 @@ cbuffer PerFrameData : register(b0)
     matrix projectionMatrix;
 }
 
-cbuffer PerObjectData : register(b1)
+// world matrices come per instance, see VertexLayout.hlsli
+cbuffer PerMeshData : register(b1)
 {
-    matrix worldMatrix;
+    float4 positionScale;  // packed vertices: extent of the mesh bounds
+    float4 positionOffset; // packed vertices: minimum of the mesh bounds
 }
 
-struct VS_INPUT {
-    float3 position : POSITION;
-    float3 normal   : NORMAL;
-    float2 texCoord : TEXCOORD0;
-    float3 tangent  : TANGENT;
-};
+#include "VertexLayout.hlsli"
+
+#ifdef PACKED_VERTICES
+float3 OctDecode(float2 e)
+{
+    float3 v = float3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-v.z);
+    v.xy += (v.xy >= 0.0f) ? -t : t;
+    return normalize(v);
+}
+
+float3 DecodePosition(VS_INPUT input) { return positionOffset.xyz + input.position.xyz * positionScale.xyz; }
+float3 DecodeNormal(VS_INPUT input) { return OctDecode(input.normal); }
+#ifndef NO_TANGENTS
+float3 DecodeTangent(VS_INPUT input) { return OctDecode(input.tangent); }
+#endif
+#else
+float3 DecodePosition(VS_INPUT input) { return input.position; }
+float3 DecodeNormal(VS_INPUT input) { return input.normal; }
+#ifndef NO_TANGENTS
+float3 DecodeTangent(VS_INPUT input) { return input.tangent; }
+#endif
+#endif
 
 struct VS_OUTPUT {
     float4 position : SV_Position;
     float3 normal   : NORMAL;
     float2 texCoord : TEXCOORD0;
+#ifndef NO_TANGENTS
     float3 tangent  : TANGENT;
     float3 bitangent: BITANGENT;
+#endif
 };
 
 VS_OUTPUT main(VS_INPUT input) {
     VS_OUTPUT output;
-    float4 worldPos = mul(worldMatrix, float4(input.position, 1.0f));
+    float3 position = DecodePosition(input);
+    float3 normal = DecodeNormal(input);
+    float4x4 worldMatrix = float4x4(input.world0, input.world1, input.world2, float4(0.0f, 0.0f, 0.0f, 1.0f));
+
+    float4 worldPos = mul(worldMatrix, float4(position, 1.0f));
     float4 viewPos = mul(viewMatrix, worldPos);
     output.position = mul(projectionMatrix, viewPos);
 
     // i would use the inverse transpose of the world matrix here, but my inverse function doesn't work
 
-    output.normal = normalize(mul(input.normal, (float3x3)worldMatrix));
+    output.normal = normalize(mul(normal, (float3x3)worldMatrix));
     output.texCoord = input.texCoord;
 
-    float3 T = normalize(mul(input.tangent, (float3x3)worldMatrix));
+#ifndef NO_TANGENTS
+    float3 T = normalize(mul(DecodeTangent(input), (float3x3)worldMatrix));
     output.tangent = T;
 
-    float3 N = normalize(mul(input.normal, (float3x3)worldMatrix));
+    float3 N = normalize(mul(normal, (float3x3)worldMatrix));
     output.bitangent = normalize(cross(N, T));
+#endif
     return output;
 }
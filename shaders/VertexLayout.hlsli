@@ -0,0 +1,53 @@
+// vertex streams of the geometry pass, shared with rendering/VertexLayout.h.
+// only defines outside the hlsl block so the c++ compiler reads it too, the
+// layouts built there static_assert their slots and strides against these
+#ifndef VERTEX_LAYOUT_HLSLI
+#define VERTEX_LAYOUT_HLSLI
+
+// input assembler slots. position has a stream of its own so position only
+// passes fetch nothing else, and the tangent stream is the last per vertex one
+// so it can be left out. every layout reads the per instance stream
+#define VERTEX_STREAM_POSITION 0
+#define VERTEX_STREAM_SURFACE 1 // normal and texcoord
+#define VERTEX_STREAM_TANGENT 2
+#define VERTEX_STREAM_INSTANCE 3 // world matrix rows, one step per instance
+
+// bytes per vertex in each stream
+#define FULL_POSITION_STRIDE 12
+#define FULL_SURFACE_STRIDE 20
+#define FULL_TANGENT_STRIDE 12
+#define PACKED_POSITION_STRIDE 8
+#define PACKED_SURFACE_STRIDE 8
+#define PACKED_TANGENT_STRIDE 4
+#define INSTANCE_STRIDE 48
+
+#ifndef __cplusplus
+#ifdef PACKED_VERTICES
+// unorm16 position, octahedral snorm16 normal/tangent, half uv (see PackedVertex.h)
+struct VS_INPUT {
+    float4 position : POSITION; // VERTEX_STREAM_POSITION
+    float2 normal   : NORMAL;   // VERTEX_STREAM_SURFACE
+    float2 texCoord : TEXCOORD0;
+#ifndef NO_TANGENTS
+    float2 tangent  : TANGENT;  // VERTEX_STREAM_TANGENT
+#endif
+    float4 world0   : WORLD0;   // VERTEX_STREAM_INSTANCE
+    float4 world1   : WORLD1;
+    float4 world2   : WORLD2;
+};
+#else
+struct VS_INPUT {
+    float3 position : POSITION; // VERTEX_STREAM_POSITION
+    float3 normal   : NORMAL;   // VERTEX_STREAM_SURFACE
+    float2 texCoord : TEXCOORD0;
+#ifndef NO_TANGENTS
+    float3 tangent  : TANGENT;  // VERTEX_STREAM_TANGENT
+#endif
+    float4 world0   : WORLD0;   // VERTEX_STREAM_INSTANCE
+    float4 world1   : WORLD1;
+    float4 world2   : WORLD2;
+};
+#endif
+#endif
+
+#endif
@@ -0,0 +1,203 @@
+#include "SelfTest.h"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace SelfTest
+{
+    // SelfTestAssets.cpp
+    bool TestHandleTable();
+    bool TestEvictionDuringReload();
+    bool BenchHandleLookup();
+    bool BenchLz();
+
+    // SelfTestCulling.cpp
+    bool TestMeshletCulling();
+    bool BenchMeshletCulling();
+
+    // SelfTestMeshes.cpp
+    bool TestMeshOptimizer();
+    bool TestVertexPacking();
+    bool TestMeshProcessing();
+    bool BenchMeshImport();
+    bool BenchMeshDecode();
+
+    // SelfTestGeometry.cpp
+    bool TestOffsetAllocator();
+
+    // SelfTestRendering.cpp
+    bool TestRenderQueueSort();
+
+    // SelfTestLods.cpp
+    bool TestLodChain();
+    bool TestLodHysteresis();
+    bool BenchSimplifier();
+
+    // SelfTestTextures.cpp
+    bool TestMipGenerator();
+    bool TestBlockCompression();
+    bool TestMipStreamer();
+    bool BenchMipGenerator();
+}
+
+namespace
+{
+    struct Entry
+    {
+        const char *name;
+        bool (*run)();
+    };
+
+    const Entry TESTS[] = {
+        {"mesh-optimizer", SelfTest::TestMeshOptimizer},
+        {"vertex-packing", SelfTest::TestVertexPacking},
+        {"mesh-processing", SelfTest::TestMeshProcessing},
+        {"lod-chain", SelfTest::TestLodChain},
+        {"lod-hysteresis", SelfTest::TestLodHysteresis},
+        {"meshlet-culling", SelfTest::TestMeshletCulling},
+        {"mip-generator", SelfTest::TestMipGenerator},
+        {"block-compression", SelfTest::TestBlockCompression},
+        {"mip-streamer", SelfTest::TestMipStreamer},
+        {"handle-table", SelfTest::TestHandleTable},
+        {"offset-allocator", SelfTest::TestOffsetAllocator},
+        {"render-queue-sort", SelfTest::TestRenderQueueSort},
+        {"eviction-during-reload", SelfTest::TestEvictionDuringReload},
+    };
+
+    const Entry BENCHES[] = {
+        {"mesh-import", SelfTest::BenchMeshImport},
+        {"mesh-decode", SelfTest::BenchMeshDecode},
+        {"simplifier", SelfTest::BenchSimplifier},
+        {"meshlet-culling", SelfTest::BenchMeshletCulling},
+        {"mip-generator", SelfTest::BenchMipGenerator},
+        {"handle-lookup", SelfTest::BenchHandleLookup},
+        {"lz", SelfTest::BenchLz},
+    };
+
+    template <size_t N>
+    int Run(const Entry (&entries)[N], const char *filter, const char *kind)
+    {
+        size_t ran = 0, failed = 0;
+        for (const Entry &e : entries)
+        {
+            if (std::strncmp(e.name, filter, std::strlen(filter)) != 0)
+                continue;
+
+            std::printf("%s %s\n", kind, e.name);
+            const auto start = std::chrono::steady_clock::now();
+            const bool passed = e.run();
+            std::printf("%s %s: %s in %.1f ms\n", kind, e.name, passed ? "passed" : "FAILED", SelfTest::Milliseconds(start));
+            ++ran;
+            failed += passed ? 0 : 1;
+        }
+
+        if (ran == 0)
+        {
+            std::fprintf(stderr, "no %s matches '%s'\n", kind, filter);
+            return EXIT_FAILURE;
+        }
+        std::printf("%zu of %zu passed\n", ran - failed, ran);
+        return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+}
+
+namespace SelfTest
+{
+    bool Check(bool condition, const char *expression, const char *file, int line)
+    {
+        if (!condition)
+            std::printf("  %s:%d: check failed: %s\n", file, line, expression);
+        return condition;
+    }
+
+    double Milliseconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    CookedMesh::SubmeshData MakeTerrain(uint32_t size, float bumpHeight, uint32_t seed)
+    {
+        Random random(seed);
+        const float phaseX = random.Range(0.0f, 6.28f), phaseY = random.Range(0.0f, 6.28f);
+        auto height = [&](float x, float y)
+        { return bumpHeight * std::sin(x * 0.37f + phaseX) * std::cos(y * 0.23f + phaseY); };
+
+        CookedMesh::SubmeshData sm;
+        const uint32_t side = size + 1;
+        sm.vertices.resize(size_t(side) * side);
+        for (uint32_t y = 0; y < side; ++y)
+        {
+            for (uint32_t x = 0; x < side; ++x)
+            {
+                Vertex &v = sm.vertices[size_t(y) * side + x];
+                v.Position = glm::vec3(float(x), height(float(x), float(y)), float(y));
+                // central differences, good enough for a normal that isn't flat
+                const float dx = height(float(x) + 0.5f, float(y)) - height(float(x) - 0.5f, float(y));
+                const float dy = height(float(x), float(y) + 0.5f) - height(float(x), float(y) - 0.5f);
+                v.Normal = glm::normalize(glm::vec3(-dx, 1.0f, -dy));
+                v.TexCoord = glm::vec2(float(x) / float(size), float(y) / float(size));
+                v.Tangent = glm::normalize(glm::vec3(1.0f, dx, 0.0f));
+            }
+        }
+
+        sm.indices.resize(size_t(size) * size * 6);
+        size_t i = 0;
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                const uint32_t a = y * side + x, b = a + 1, c = a + side, d = c + 1;
+                sm.indices[i++] = a;
+                sm.indices[i++] = c;
+                sm.indices[i++] = b;
+                sm.indices[i++] = b;
+                sm.indices[i++] = c;
+                sm.indices[i++] = d;
+            }
+        }
+        return sm;
+    }
+
+    std::vector<unsigned char> MakeImage(int width, int height, uint32_t seed)
+    {
+        Random random(seed);
+        float phase[4], frequency[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            phase[c] = random.Range(0.0f, 6.28f);
+            frequency[c] = random.Range(0.01f, 0.08f);
+        }
+
+        std::vector<unsigned char> pixels(size_t(width) * height * 4);
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                // a checker of 32 pixel cells gives the edges
+                const float edge = ((x / 32) + (y / 32)) % 2 ? 40.0f : -40.0f;
+                unsigned char *p = pixels.data() + (size_t(y) * width + x) * 4;
+                for (int c = 0; c < 4; ++c)
+                {
+                    const float smooth = 127.5f + 80.0f * std::sin(x * frequency[c] + phase[c]) * std::cos(y * frequency[3 - c] - phase[c]);
+                    const float noise = random.Range(-6.0f, 6.0f);
+                    p[c] = static_cast<unsigned char>(std::clamp(smooth + (c < 3 ? edge : 0.0f) + noise, 0.0f, 255.0f));
+                }
+            }
+        }
+        return pixels;
+    }
+
+    int RunTests(const char *filter)
+    {
+        return Run(TESTS, filter, "test");
+    }
+
+    int RunBenches(const char *filter)
+    {
+        return Run(BENCHES, filter, "bench");
+    }
+}
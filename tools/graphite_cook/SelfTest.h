@@ -0,0 +1,75 @@
+#pragma once
+
+#include "assets/CookedMesh.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// checks behind graphite_cook --test and timings behind --bench. every one
+// builds its own input, so they need no asset root and give the same
+// results on every machine. they live in a file per area (SelfTestMeshes.cpp
+// and so on) and are listed in SelfTest.cpp
+namespace SelfTest
+{
+    // prints the failed expression. a test keeps going after a failed check
+    // so it reports everything, and fails at the end
+    bool Check(bool condition, const char *expression, const char *file, int line);
+
+    double Milliseconds(std::chrono::steady_clock::time_point start);
+
+    // best of a few runs, the first one also pays for page faults
+    template <typename Fn>
+    double BestMilliseconds(Fn &&fn, int runs = 3)
+    {
+        double best = 0.0;
+        for (int run = 0; run < runs; ++run)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            fn();
+            const double ms = Milliseconds(start);
+            best = run == 0 ? ms : std::min(best, ms);
+        }
+        return best;
+    }
+
+    // xorshift, so inputs don't depend on the standard library's distributions
+    class Random
+    {
+    public:
+        explicit Random(uint32_t seed) : m_State(seed ? seed : 1u) {}
+
+        uint32_t Next()
+        {
+            m_State ^= m_State << 13;
+            m_State ^= m_State >> 17;
+            m_State ^= m_State << 5;
+            return m_State;
+        }
+        uint32_t Below(uint32_t n) { return uint32_t((uint64_t(Next()) * n) >> 32); }
+        float Float() { return float(Next() >> 8) / float(1u << 24); } // [0, 1)
+        float Range(float lo, float hi) { return lo + (hi - lo) * Float(); }
+
+    private:
+        uint32_t m_State;
+    };
+
+    // (size + 1)^2 vertex height field over [0, size]^2 with uvs over [0, 1]
+    // and bumps of the given height, triangles in row order
+    CookedMesh::SubmeshData MakeTerrain(uint32_t size, float bumpHeight, uint32_t seed);
+
+    // width * height rgba8 pixels: smooth gradients, a few hard edges and
+    // a little noise, roughly what a photographed texture holds
+    std::vector<unsigned char> MakeImage(int width, int height, uint32_t seed);
+
+    // runs every test whose name starts with filter, all of them when it
+    // is empty. EXIT_SUCCESS when every one passed
+    int RunTests(const char *filter);
+
+    // the same for the timings. a bench also checks its results, so a
+    // fast wrong answer fails
+    int RunBenches(const char *filter);
+}
+
+#define SELF_CHECK(condition) SelfTest::Check((condition), #condition, __FILE__, __LINE__)
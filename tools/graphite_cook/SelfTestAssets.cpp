@@ -0,0 +1,326 @@
+#include "SelfTest.h"
+#include "assets/HandleTable.h"
+#include "assets/ResidencyTracker.h"
+#include "utils/Lz.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Slot
+    {
+        uint32_t value = 0;
+    };
+
+    using Table = HandleTable<Slot, ModelHandle>;
+
+    // one asset driven through ResidencyTracker and AssetStates in the order
+    // AssetManager does it, with the decode finishing whenever the test says
+    struct Asset
+    {
+        ResidencyTracker::Key key;
+        uint64_t bytes;
+        AssetState state = AssetState::Pending;
+        bool decoding = false;
+
+        void StartDecode()
+        {
+            state = AssetStates::Decoding(state);
+            decoding = true;
+        }
+
+        void FinishDecode(ResidencyTracker &residency, bool succeeded)
+        {
+            decoding = false;
+            if (!AssetStates::KeepsResult(state))
+                return;
+            state = AssetStates::Completed(state, succeeded);
+            if (succeeded)
+                residency.MarkResident(key, bytes);
+        }
+
+        void Reference(ResidencyTracker &residency)
+        {
+            residency.AddRef(key);
+            if (state != AssetState::Evicted)
+                return;
+            if (decoding)
+                state = AssetStates::Decoding(state);
+            else
+                StartDecode();
+        }
+    };
+
+    void EnforceBudget(ResidencyTracker &residency, std::initializer_list<Asset *> assets)
+    {
+        for (ResidencyTracker::Key key : residency.CollectEvictions())
+        {
+            for (Asset *asset : assets)
+            {
+                if (asset->key == key)
+                    asset->state = AssetState::Evicted;
+            }
+        }
+    }
+}
+
+namespace SelfTest
+{
+    bool TestHandleTable()
+    {
+        bool ok = true;
+        Table table;
+
+        const ModelHandle first = table.Insert({1});
+        const ModelHandle second = table.Insert({2});
+        ok &= SELF_CHECK(table.Size() == 2 && table.Get(first)->value == 1 && table.Get(second)->value == 2);
+
+        // a removed slot rejects its old handle, and keeps rejecting it once
+        // the index is reused under the next generation
+        ok &= SELF_CHECK(table.Remove(first));
+        ok &= SELF_CHECK(table.Get(first) == nullptr && !table.Contains(first));
+        ok &= SELF_CHECK(!table.Remove(first));
+        const ModelHandle reused = table.Insert({3});
+        ok &= SELF_CHECK(reused.Index() == first.Index() && reused.Generation() == first.Generation() + 1);
+        ok &= SELF_CHECK(table.Get(first) == nullptr && table.Get(reused)->value == 3);
+        ok &= SELF_CHECK(table.Size() == 2);
+
+        // handles that were never issued
+        ok &= SELF_CHECK(table.Get(ModelHandle{}) == nullptr);
+        ok &= SELF_CHECK(table.Get(ModelHandle::Make(7, 0)) == nullptr);
+        ok &= SELF_CHECK(table.Get(ModelHandle::Make(second.Index(), second.Generation() + 1)) == nullptr);
+
+        // every generation the field holds is a distinct handle: none of the
+        // reuses of one slot before it wraps accepts an earlier handle
+        Table cycled;
+        const ModelHandle original = cycled.Insert({0});
+        ModelHandle previous = original;
+        size_t aliased = 0;
+        for (uint32_t cycle = 1; cycle <= ModelHandle::GENERATION_MASK; ++cycle)
+        {
+            cycled.Remove(previous);
+            const ModelHandle next = cycled.Insert({cycle});
+            aliased += cycled.Get(original) != nullptr || cycled.Get(previous) != nullptr || next.Index() != original.Index() ? 1 : 0;
+            previous = next;
+        }
+        ok &= SELF_CHECK(aliased == 0);
+        ok &= SELF_CHECK(previous.Generation() == ModelHandle::GENERATION_MASK && previous.IsValid());
+
+        // the slot limit keeps the all ones (invalid) index from being issued
+        ok &= SELF_CHECK(ModelHandle::MAX_SLOTS == ModelHandle::INDEX_MASK);
+        ok &= SELF_CHECK(ModelHandle::Make(ModelHandle::MAX_SLOTS - 1, ModelHandle::GENERATION_MASK) != ModelHandle{});
+
+        table.Clear();
+        ok &= SELF_CHECK(table.Size() == 0 && table.Get(second) == nullptr && table.Get(reused) == nullptr);
+        return ok;
+    }
+
+    bool TestEvictionDuringReload()
+    {
+        bool ok = true;
+        for (bool reloadSucceeds : {true, false})
+        {
+            // a loaded but unreferenced asset starts a reload, then a referenced
+            // one pushes the total over budget and evicts it mid reload
+            ResidencyTracker residency(100);
+            Asset idle{1, 80}, busy{2, 60};
+            idle.Reference(residency);
+            idle.StartDecode();
+            idle.FinishDecode(residency, true);
+            residency.Release(idle.key);
+            idle.StartDecode();
+            ok &= SELF_CHECK(idle.state == AssetState::Ready && idle.decoding);
+
+            busy.Reference(residency);
+            busy.StartDecode();
+            busy.FinishDecode(residency, true);
+            EnforceBudget(residency, {&idle, &busy});
+            ok &= SELF_CHECK(idle.state == AssetState::Evicted && !residency.IsResident(idle.key));
+
+            // the reload landing afterwards must neither bring it back nor fail it
+            idle.FinishDecode(residency, reloadSucceeds);
+            ok &= SELF_CHECK(idle.state == AssetState::Evicted);
+            ok &= SELF_CHECK(!residency.IsResident(idle.key));
+            ok &= SELF_CHECK(residency.GetResidentBytes() == busy.bytes && residency.GetResidentBytes() <= residency.GetBudget());
+            EnforceBudget(residency, {&idle, &busy});
+            ok &= SELF_CHECK(busy.state == AssetState::Ready && residency.IsResident(busy.key));
+
+            // referenced again later it decodes afresh
+            idle.Reference(residency);
+            ok &= SELF_CHECK(idle.state == AssetState::Pending && idle.decoding);
+            idle.FinishDecode(residency, true);
+            ok &= SELF_CHECK(idle.state == AssetState::Ready && residency.IsResident(idle.key));
+        }
+
+        {
+            // referenced again while the reload is still running: that reload is the load
+            ResidencyTracker residency(100);
+            Asset idle{1, 80}, busy{2, 60};
+            idle.StartDecode();
+            idle.FinishDecode(residency, true);
+            idle.StartDecode();
+            busy.Reference(residency);
+            busy.StartDecode();
+            busy.FinishDecode(residency, true);
+            EnforceBudget(residency, {&idle, &busy});
+            ok &= SELF_CHECK(idle.state == AssetState::Evicted && idle.decoding);
+
+            idle.Reference(residency);
+            ok &= SELF_CHECK(idle.state == AssetState::Pending && idle.decoding);
+            idle.FinishDecode(residency, true);
+            ok &= SELF_CHECK(idle.state == AssetState::Ready && residency.IsResident(idle.key));
+            // both referenced now, so nothing may go even though the total is over
+            EnforceBudget(residency, {&idle, &busy});
+            ok &= SELF_CHECK(idle.state == AssetState::Ready && busy.state == AssetState::Ready);
+        }
+
+        // the transitions on their own
+        ok &= SELF_CHECK(AssetStates::Decoding(AssetState::Ready) == AssetState::Ready);
+        ok &= SELF_CHECK(AssetStates::Decoding(AssetState::Evicted) == AssetState::Pending);
+        ok &= SELF_CHECK(AssetStates::Decoding(AssetState::Failed) == AssetState::Pending);
+        ok &= SELF_CHECK(AssetStates::Completed(AssetState::Pending, false) == AssetState::Failed);
+        ok &= SELF_CHECK(AssetStates::Completed(AssetState::Ready, false) == AssetState::Ready);
+        ok &= SELF_CHECK(AssetStates::Completed(AssetState::Pending, true) == AssetState::Ready);
+        ok &= SELF_CHECK(!AssetStates::KeepsResult(AssetState::Evicted) && AssetStates::KeepsResult(AssetState::Ready));
+        return ok;
+    }
+
+    bool BenchHandleLookup()
+    {
+        // 100k renderables, each draw does what GeometryPass and BindMaterial
+        // do: look up its model and material, then the material's 3 textures.
+        // once keyed on asset paths in std::maps, as before, once with handles
+        constexpr uint32_t RENDERABLES = 100000, MODELS = 2000, MATERIALS = 1000, TEXTURES = 3000;
+        Random random(17);
+
+        std::map<std::filesystem::path, Slot> modelsByPath, materialsByPath, texturesByPath;
+        std::vector<std::filesystem::path> modelPaths, materialPaths, texturePaths;
+        Table models, materials, textures;
+        std::vector<ModelHandle> modelHandles, materialHandles, textureHandles;
+        auto add = [&](const char *folder, uint32_t count, auto &byPath, auto &paths, Table &table, auto &handles)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                paths.push_back(std::filesystem::path("assets") / folder / ("asset_" + std::to_string(i * 7919u % 100000u) + ".bin"));
+                byPath[paths.back()] = Slot{i};
+                handles.push_back(table.Insert(Slot{i}));
+            }
+        };
+        add("models", MODELS, modelsByPath, modelPaths, models, modelHandles);
+        add("materials", MATERIALS, materialsByPath, materialPaths, materials, materialHandles);
+        add("textures", TEXTURES, texturesByPath, texturePaths, textures, textureHandles);
+
+        struct Renderable
+        {
+            uint32_t model, material, textures[3];
+        };
+        std::vector<Renderable> renderables(RENDERABLES);
+        for (Renderable &r : renderables)
+            r = {random.Below(MODELS), random.Below(MATERIALS), {random.Below(TEXTURES), random.Below(TEXTURES), random.Below(TEXTURES)}};
+
+        uint64_t mapSum = 0, handleSum = 0;
+        const double mapMs = BestMilliseconds(
+            [&]
+            {
+                mapSum = 0;
+                for (const Renderable &r : renderables)
+                {
+                    mapSum += modelsByPath.find(modelPaths[r.model])->second.value;
+                    mapSum += materialsByPath.find(materialPaths[r.material])->second.value;
+                    for (uint32_t t : r.textures)
+                        mapSum += texturesByPath.find(texturePaths[t])->second.value;
+                }
+            });
+        const double handleMs = BestMilliseconds(
+            [&]
+            {
+                handleSum = 0;
+                for (const Renderable &r : renderables)
+                {
+                    handleSum += models.Get(modelHandles[r.model])->value;
+                    handleSum += materials.Get(materialHandles[r.material])->value;
+                    for (uint32_t t : r.textures)
+                        handleSum += textures.Get(textureHandles[t])->value;
+                }
+            });
+
+        std::printf("  %u draws, 5 lookups each: path maps %.2f ms (%.1f ns per draw), handles %.2f ms (%.1f ns per draw), %.1fx\n",
+                    RENDERABLES, mapMs, mapMs * 1e6 / RENDERABLES, handleMs, handleMs * 1e6 / RENDERABLES, mapMs / std::max(handleMs, 1e-6));
+        return SELF_CHECK(mapSum == handleSum);
+    }
+
+    bool BenchLz()
+    {
+        // 64 KB blocks like asset packs use, over data shaped like what they
+        // hold: vertex floats and indices, noisy texels that barely compress
+        // and a mask of flat 32x32 cells that compresses to almost nothing
+        constexpr size_t BLOCK = 64 * 1024;
+        const CookedMesh::SubmeshData terrain = MakeTerrain(600, 3.0f, 3);
+        const std::vector<unsigned char> image = MakeImage(2048, 2048, 5);
+        std::vector<unsigned char> mask(image.size());
+        Random random(6);
+        std::vector<uint32_t> cells(64 * 64);
+        for (uint32_t &cell : cells)
+            cell = random.Below(4) == 0 ? random.Next() : 0u;
+        for (size_t i = 0; i < mask.size() / 4; ++i)
+            std::memcpy(mask.data() + i * 4, &cells[(i / 2048 / 32) * 64 + (i % 2048) / 32], 4);
+
+        struct Input
+        {
+            const char *name;
+            const void *data;
+            size_t size;
+        };
+        const Input inputs[] = {
+            {"vertices", terrain.vertices.data(), terrain.vertices.size() * sizeof(Vertex)},
+            {"indices", terrain.indices.data(), terrain.indices.size() * sizeof(uint32_t)},
+            {"texels", image.data(), image.size()},
+            {"mask", mask.data(), mask.size()},
+        };
+
+        bool ok = true;
+        for (const Input &input : inputs)
+        {
+            const auto *bytes = static_cast<const unsigned char *>(input.data);
+            const size_t blocks = (input.size + BLOCK - 1) / BLOCK;
+            std::vector<unsigned char> compressed(blocks * Lz::CompressBound(BLOCK));
+            std::vector<size_t> sizes(blocks);
+            size_t total = 0;
+            const double compressMs = BestMilliseconds(
+                [&]
+                {
+                    total = 0;
+                    for (size_t b = 0; b < blocks; ++b)
+                    {
+                        const size_t size = std::min(BLOCK, input.size - b * BLOCK);
+                        sizes[b] = Lz::Compress(bytes + b * BLOCK, size, compressed.data() + b * Lz::CompressBound(BLOCK), Lz::CompressBound(BLOCK));
+                        total += sizes[b];
+                    }
+                });
+
+            std::vector<unsigned char> decompressed(input.size);
+            bool decoded = true;
+            const double decompressMs = BestMilliseconds(
+                [&]
+                {
+                    decoded = true;
+                    for (size_t b = 0; b < blocks; ++b)
+                    {
+                        const size_t size = std::min(BLOCK, input.size - b * BLOCK);
+                        decoded &= Lz::Decompress(compressed.data() + b * Lz::CompressBound(BLOCK), sizes[b], decompressed.data() + b * BLOCK, size);
+                    }
+                },
+                5);
+            ok &= SELF_CHECK(decoded && std::memcmp(decompressed.data(), bytes, input.size) == 0);
+            std::printf("  %-8s %6.1f MB, ratio %.2f: compress %.0f MB/s, decompress %.2f GB/s\n", input.name, input.size / 1e6,
+                        double(input.size) / double(total), input.size / (compressMs * 1000.0), input.size / (decompressMs * 1e6));
+        }
+        return ok;
+    }
+}
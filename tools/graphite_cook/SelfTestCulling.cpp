@@ -0,0 +1,151 @@
+#include "SelfTest.h"
+#include "rendering/MeshletCulling.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t SIMD_PADDING = 8;
+
+    // meshlets scattered through a cube around the origin with random cones,
+    // some of them disabled (cutoff 1), padded like MeshletBuilder pads them
+    MeshletBounds RandomMeshlets(uint32_t count, uint32_t seed)
+    {
+        SelfTest::Random random(seed);
+        MeshletBounds b;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            b.centerX.push_back(random.Range(-100.0f, 100.0f));
+            b.centerY.push_back(random.Range(-100.0f, 100.0f));
+            b.centerZ.push_back(random.Range(-100.0f, 100.0f));
+            b.radius.push_back(random.Range(0.5f, 5.0f));
+
+            glm::vec3 axis(random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f));
+            axis = glm::length(axis) > 0.01f ? glm::normalize(axis) : glm::vec3(0.0f, 0.0f, 1.0f);
+            b.axisX.push_back(axis.x);
+            b.axisY.push_back(axis.y);
+            b.axisZ.push_back(axis.z);
+            b.cutoff.push_back(random.Below(8) == 0 ? 1.0f : random.Range(-0.5f, 0.95f));
+        }
+        for (auto *v : {&b.centerX, &b.centerY, &b.centerZ, &b.radius, &b.axisX, &b.axisY, &b.axisZ})
+            v->resize(v->size() + SIMD_PADDING, 0.0f);
+        b.cutoff.resize(b.cutoff.size() + SIMD_PADDING, 1.0f);
+        return b;
+    }
+
+    MeshletCulling::Params CameraAt(const glm::vec3 &eye, const glm::vec3 &target, float radiusScale, bool coneCulling)
+    {
+        const glm::mat4 view = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+        const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 150.0f);
+        MeshletCulling::Params params;
+        params.frustum = Frustum::FromMatrix(projection * view);
+        params.radiusScale = radiusScale;
+        params.cameraPosition = eye;
+        params.coneCulling = coneCulling;
+        return params;
+    }
+
+    // true when a meshlet sits so close to a plane or its cone's limit that
+    // fused and separate multiply-adds may decide it either way
+    bool Borderline(const MeshletBounds &b, uint32_t i, const MeshletCulling::Params &params)
+    {
+        constexpr double EPSILON = 1e-3;
+        const double x = b.centerX[i], y = b.centerY[i], z = b.centerZ[i];
+        for (const glm::vec4 &p : params.frustum.planes)
+        {
+            const double d = p.x * x + p.y * y + p.z * z + p.w + double(b.radius[i]) * params.radiusScale;
+            if (std::abs(d) < EPSILON)
+                return true;
+        }
+        if (!params.coneCulling)
+            return false;
+        const double dx = x - params.cameraPosition.x, dy = y - params.cameraPosition.y, dz = z - params.cameraPosition.z;
+        const double d = dx * b.axisX[i] + dy * b.axisY[i] + dz * b.axisZ[i];
+        const double length = std::sqrt(dx * dx + dy * dy + dz * dz);
+        return std::abs(b.cutoff[i] * length + b.radius[i] - d) < EPSILON;
+    }
+}
+
+namespace SelfTest
+{
+    bool TestMeshletCulling()
+    {
+        bool ok = true;
+        const uint32_t count = 20000;
+        const MeshletBounds bounds = RandomMeshlets(count, 11);
+        std::vector<uint32_t> scalar(count), culled(count);
+
+        // aligned and unaligned ranges, so the batches start mid-vector and end in padding
+        const uint32_t ranges[][2] = {{0, count}, {3, 1001}, {count - 13, 13}, {40, 7}, {100, 0}};
+        Random random(12);
+        size_t borderline = 0, visibleTotal = 0;
+        for (int camera = 0; camera < 16; ++camera)
+        {
+            const glm::vec3 eye(random.Range(-120.0f, 120.0f), random.Range(-120.0f, 120.0f), random.Range(-120.0f, 120.0f));
+            const glm::vec3 target(random.Range(-30.0f, 30.0f), random.Range(-30.0f, 30.0f), random.Range(-30.0f, 30.0f));
+            const MeshletCulling::Params params = CameraAt(eye, target, random.Range(0.5f, 2.0f), camera % 4 != 0);
+
+            for (const auto &range : ranges)
+            {
+                const uint32_t first = range[0], rangeCount = range[1];
+                const size_t scalarVisible = MeshletCulling::CullScalar(bounds, first, rangeCount, params, scalar.data());
+                const size_t visible = MeshletCulling::Cull(bounds, first, rangeCount, params, culled.data());
+                visibleTotal += scalarVisible;
+
+                bool ascending = true;
+                for (size_t v = 0; v < visible; ++v)
+                {
+                    ascending &= culled[v] >= first && culled[v] < first + rangeCount;
+                    ascending &= v == 0 || culled[v] > culled[v - 1];
+                }
+                ok &= SELF_CHECK(ascending);
+
+                // walk both sorted lists, any meshlet only one of them kept must be a close call
+                size_t a = 0, c = 0, wrong = 0;
+                while (a < scalarVisible || c < visible)
+                {
+                    if (a < scalarVisible && c < visible && scalar[a] == culled[c])
+                    {
+                        ++a;
+                        ++c;
+                        continue;
+                    }
+                    const bool fromScalar = c == visible || (a < scalarVisible && scalar[a] < culled[c]);
+                    const uint32_t id = fromScalar ? scalar[a++] : culled[c++];
+                    if (Borderline(bounds, id, params))
+                        ++borderline;
+                    else
+                        ++wrong;
+                }
+                ok &= SELF_CHECK(wrong == 0);
+            }
+        }
+        ok &= SELF_CHECK(visibleTotal > 0);
+        std::printf("  %zu visible over 16 cameras, %zu close calls decided differently\n", visibleTotal, borderline);
+        return ok;
+    }
+
+    bool BenchMeshletCulling()
+    {
+        const uint32_t count = 1u << 20;
+        const MeshletBounds bounds = RandomMeshlets(count, 21);
+        std::vector<uint32_t> scalar(count), culled(count);
+        bool ok = true;
+
+        for (bool coneCulling : {false, true})
+        {
+            const MeshletCulling::Params params = CameraAt(glm::vec3(0.0f, 0.0f, 60.0f), glm::vec3(0.0f), 1.0f, coneCulling);
+            size_t scalarVisible = 0, visible = 0;
+            const double scalarMs = BestMilliseconds([&] { scalarVisible = MeshletCulling::CullScalar(bounds, 0, count, params, scalar.data()); });
+            const double ms = BestMilliseconds([&] { visible = MeshletCulling::Cull(bounds, 0, count, params, culled.data()); });
+            ok &= SELF_CHECK(visible > 0 && visible + visible / 1000 >= scalarVisible && scalarVisible + scalarVisible / 1000 >= visible);
+            std::printf("  %u meshlets, cone culling %s: %zu visible, scalar %.2f ms, Cull %.2f ms (%.0f M meshlets/s), %.2fx\n",
+                        count, coneCulling ? "on" : "off", visible, scalarMs, ms, count / (ms * 1000.0), scalarMs / std::max(ms, 1e-6));
+        }
+        return ok;
+    }
+}
@@ -0,0 +1,138 @@
+#include "SelfTest.h"
+#include "rendering/OffsetAllocator.h"
+
+#include <cstdio>
+#include <iterator>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    // mostly small ranges with the odd large one, like meshes sharing an arena
+    uint32_t RandomSize(SelfTest::Random &random)
+    {
+        const uint32_t roll = random.Below(100);
+        if (roll < 70)
+            return 1 + random.Below(256);
+        if (roll < 95)
+            return 256 + random.Below(4096);
+        return 4096 + random.Below(65536);
+    }
+
+    struct Operation
+    {
+        bool allocate;
+        uint32_t size;  // allocations
+        uint32_t which; // frees: position in the live list
+    };
+}
+
+namespace SelfTest
+{
+    bool TestOffsetAllocator()
+    {
+        constexpr uint32_t CAPACITY = 1u << 22;
+        constexpr int STEPS = 200000;
+        bool ok = true;
+        Random random(31);
+        OffsetAllocator allocator(CAPACITY);
+
+        // live ranges by offset, so overlaps show up as neighbours that touch
+        std::map<uint32_t, uint32_t> live;
+        std::vector<uint32_t> liveOffsets;
+        std::vector<Operation> operations;
+        uint64_t used = 0;
+        size_t overlaps = 0, outOfRange = 0, falseFailures = 0, failures = 0;
+
+        for (int step = 0; step < STEPS; ++step)
+        {
+            // lean towards allocating until the space is about 3/4 full, then
+            // hover there so frees and allocations interleave under pressure
+            const bool allocate = liveOffsets.empty() || random.Below(100) < (used < CAPACITY / 4 * 3 ? 65u : 48u);
+            if (allocate)
+            {
+                const uint32_t size = RandomSize(random);
+                const uint32_t largest = allocator.GetLargestFree();
+                const uint32_t offset = allocator.Allocate(size);
+                operations.push_back({true, size, 0});
+                if (offset == OffsetAllocator::INVALID)
+                {
+                    // only allowed when no free range is big enough
+                    falseFailures += largest >= size ? 1 : 0;
+                    ++failures;
+                    continue;
+                }
+
+                outOfRange += uint64_t(offset) + size > CAPACITY ? 1 : 0;
+                auto next = live.lower_bound(offset);
+                if (next != live.end() && next->first < offset + size)
+                    ++overlaps;
+                if (next != live.begin() && std::prev(next)->first + std::prev(next)->second > offset)
+                    ++overlaps;
+                live[offset] = size;
+                liveOffsets.push_back(offset);
+                used += size;
+            }
+            else
+            {
+                const uint32_t which = random.Below(uint32_t(liveOffsets.size()));
+                const uint32_t offset = liveOffsets[which];
+                allocator.Free(offset, live[offset]);
+                operations.push_back({false, 0, which});
+                used -= live[offset];
+                live.erase(offset);
+                liveOffsets[which] = liveOffsets.back();
+                liveOffsets.pop_back();
+            }
+
+            if (step % 1000 == 0)
+            {
+                ok &= SELF_CHECK(allocator.GetUsed() == used);
+                ok &= SELF_CHECK(allocator.GetLargestFree() <= CAPACITY - used);
+            }
+        }
+        ok &= SELF_CHECK(overlaps == 0);
+        ok &= SELF_CHECK(outOfRange == 0);
+        ok &= SELF_CHECK(falseFailures == 0);
+        std::printf("  %d operations, %zu live ranges at the end, %zu allocations didn't fit, fragmentation %.3f over %zu free ranges\n",
+                    STEPS, live.size(), failures, allocator.GetFragmentation(), allocator.GetFreeRangeCount());
+
+        // freeing everything merges back into the single range it started as
+        for (const auto &[offset, size] : live)
+            allocator.Free(offset, size);
+        ok &= SELF_CHECK(allocator.GetUsed() == 0);
+        ok &= SELF_CHECK(allocator.GetFreeRangeCount() == 1);
+        ok &= SELF_CHECK(allocator.GetLargestFree() == CAPACITY);
+        ok &= SELF_CHECK(allocator.GetFragmentation() == 0.0f);
+
+        // the same sequence again without the checking, for speed
+        size_t allocations = 0;
+        const double ms = BestMilliseconds(
+            [&]
+            {
+                OffsetAllocator timed(CAPACITY);
+                std::vector<std::pair<uint32_t, uint32_t>> ranges;
+                allocations = 0;
+                for (const Operation &op : operations)
+                {
+                    if (op.allocate)
+                    {
+                        const uint32_t offset = timed.Allocate(op.size);
+                        ++allocations;
+                        if (offset != OffsetAllocator::INVALID)
+                            ranges.push_back({offset, op.size});
+                    }
+                    else
+                    {
+                        timed.Free(ranges[op.which].first, ranges[op.which].second);
+                        ranges[op.which] = ranges.back();
+                        ranges.pop_back();
+                    }
+                }
+            });
+        std::printf("  replay: %zu allocations and %zu frees in %.2f ms, %.2f M allocations/s\n",
+                    allocations, operations.size() - allocations, ms, double(allocations) / (ms * 1000.0));
+        return ok;
+    }
+}
@@ -0,0 +1,175 @@
+#include "SelfTest.h"
+#include "assets/MeshSimplifier.h"
+#include "core/ThreadPool.h"
+#include "rendering/LodSelection.h"
+#include "cfg/Config.h"
+
+#include <glm/glm.hpp>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    float Diagonal(const CookedMesh::SubmeshData &sm)
+    {
+        glm::vec3 minP = sm.vertices[0].Position, maxP = minP;
+        for (const Vertex &v : sm.vertices)
+        {
+            minP = glm::min(minP, v.Position);
+            maxP = glm::max(maxP, v.Position);
+        }
+        return glm::length(maxP - minP);
+    }
+
+    // one selection per frame, as the geometry pass does it
+    uint32_t Select(const std::vector<CookedMesh::LodLevel> &lods, float pixelsPerUnit, uint32_t current)
+    {
+        return LodSelection::SelectLod(lods.data(), uint32_t(lods.size()), pixelsPerUnit, current, 1.0f, 0.2f);
+    }
+}
+
+namespace SelfTest
+{
+    bool TestLodChain()
+    {
+        bool ok = true;
+        CookedMesh::SubmeshData sm = MakeTerrain(96, 3.0f, 7);
+        const size_t vertexCount = sm.vertices.size();
+        const size_t baseCount = sm.indices.size();
+        MeshSimplifier::GenerateLods(sm);
+
+        // each level is smaller and further from the surface than the one before,
+        // every error stays within the configured bound
+        const float maxError = Diagonal(sm) * Config::Lod::MAX_RELATIVE_ERROR;
+        ok &= SELF_CHECK(sm.lods.size() >= 3);
+        ok &= SELF_CHECK(sm.lods[0].indexOffset == 0 && sm.lods[0].indexCount == baseCount && sm.lods[0].error == 0.0f);
+        ok &= SELF_CHECK(sm.vertices.size() == vertexCount);
+        for (size_t i = 1; i < sm.lods.size(); ++i)
+        {
+            const CookedMesh::LodLevel &lod = sm.lods[i], &previous = sm.lods[i - 1];
+            ok &= SELF_CHECK(lod.indexCount % 3 == 0 && lod.indexCount < previous.indexCount);
+            ok &= SELF_CHECK(lod.indexOffset == previous.indexOffset + previous.indexCount);
+            ok &= SELF_CHECK(lod.error >= previous.error && lod.error <= maxError);
+            std::printf("  lod %zu: %u triangles, error %.4f\n", i, lod.indexCount / 3, lod.error);
+        }
+        const CookedMesh::LodLevel &last = sm.lods.back();
+        ok &= SELF_CHECK(sm.indices.size() == size_t(last.indexOffset) + last.indexCount);
+        size_t outOfRange = 0;
+        for (uint32_t index : sm.indices)
+            outOfRange += index >= vertexCount ? 1 : 0;
+        ok &= SELF_CHECK(outOfRange == 0);
+
+        // a looser bound never keeps more triangles, and the error reached respects it
+        const CookedMesh::SubmeshData base = MakeTerrain(96, 3.0f, 7);
+        std::vector<uint32_t> simplified(base.indices.size());
+        size_t previousCount = base.indices.size();
+        for (float bound : {0.001f, 0.01f, 0.05f, 0.2f, 1.0f})
+        {
+            float reached = -1.0f;
+            const size_t count = MeshSimplifier::Simplify(
+                simplified.data(), base.indices.data(), base.indices.size(),
+                base.vertices.data(), base.vertices.size(), 0, bound, &reached);
+            ok &= SELF_CHECK(count <= previousCount);
+            ok &= SELF_CHECK(reached >= 0.0f && reached <= bound);
+            previousCount = count;
+        }
+
+        // a flat grid loses almost everything at no cost
+        const CookedMesh::SubmeshData flat = MakeTerrain(32, 0.0f, 1);
+        float flatError = -1.0f;
+        const size_t flatCount = MeshSimplifier::Simplify(
+            simplified.data(), flat.indices.data(), flat.indices.size(),
+            flat.vertices.data(), flat.vertices.size(), 0, 1.0f, &flatError);
+        ok &= SELF_CHECK(flatCount < flat.indices.size() / 10);
+        ok &= SELF_CHECK(flatError < 1e-4f);
+        return ok;
+    }
+
+    bool TestLodHysteresis()
+    {
+        bool ok = true;
+        // threshold 1 pixel, hysteresis 0.2: level 2 (error 2) may be stepped
+        // down to from 0.4 pixels per unit and is held up to 0.5
+        const std::vector<CookedMesh::LodLevel> lods = {
+            {0, 0, 0.0f, 0}, {0, 0, 1.0f, 0}, {0, 0, 2.0f, 0}, {0, 0, 4.0f, 0}, {0, 0, 8.0f, 0}};
+
+        // inside the band both sides of the boundary stay where they are
+        ok &= SELF_CHECK(Select(lods, 0.45f, 1) == 1);
+        ok &= SELF_CHECK(Select(lods, 0.45f, 2) == 2);
+        // leaving it moves each of them over
+        ok &= SELF_CHECK(Select(lods, 0.39f, 1) == 2);
+        ok &= SELF_CHECK(Select(lods, 0.51f, 2) == 1);
+        // a level that is too coarse is dropped at once, whatever the band
+        ok &= SELF_CHECK(Select(lods, 0.9f, 4) == 1);
+        ok &= SELF_CHECK(Select(lods, 2.0f, 3) == 0);
+        // far away everything goes straight to the coarsest level
+        ok &= SELF_CHECK(Select(lods, 0.01f, 0) == 4);
+
+        // jitter across the boundary never switches, from either side
+        for (uint32_t start : {1u, 2u})
+        {
+            uint32_t level = start, switches = 0;
+            for (int frame = 0; frame < 100; ++frame)
+            {
+                const uint32_t next = Select(lods, frame % 2 ? 0.41f : 0.49f, level);
+                switches += next != level ? 1 : 0;
+                level = next;
+            }
+            ok &= SELF_CHECK(switches == 0 && level == start);
+        }
+
+        // a slow zoom in and back out crosses every boundary once each way
+        // and never selects a finer level while zooming out
+        uint32_t level = 4, switches = 0;
+        for (int frame = 0; frame <= 400; ++frame)
+        {
+            const float t = float(frame < 200 ? frame : 400 - frame) / 200.0f;
+            const float pixelsPerUnit = 0.05f * std::pow(40.0f, t);
+            const uint32_t next = Select(lods, pixelsPerUnit, level);
+            if (frame > 200)
+                ok &= SELF_CHECK(next >= level);
+            else
+                ok &= SELF_CHECK(next <= level);
+            switches += next != level ? 1 : 0;
+            level = next;
+        }
+        ok &= SELF_CHECK(level == 4 && switches == 8);
+
+        // no hysteresis is the plain threshold, and odd inputs stay in range
+        ok &= SELF_CHECK(LodSelection::SelectLod(lods.data(), uint32_t(lods.size()), 0.45f, 1, 1.0f, 0.0f) == 2);
+        ok &= SELF_CHECK(LodSelection::SelectLod(lods.data(), uint32_t(lods.size()), 0.45f, 99, 1.0f, 0.2f) == 2);
+        ok &= SELF_CHECK(LodSelection::SelectLod(lods.data(), 0, 0.45f, 3, 1.0f, 0.2f) == 0);
+        return ok;
+    }
+
+    bool BenchSimplifier()
+    {
+        bool ok = true;
+        for (uint32_t size : {64u, 128u, 256u})
+        {
+            const CookedMesh::SubmeshData source = MakeTerrain(size, 3.0f, size);
+            size_t levels = 0;
+            const double ms = BestMilliseconds(
+                [&]
+                {
+                    CookedMesh::SubmeshData sm = source;
+                    MeshSimplifier::GenerateLods(sm);
+                    levels = sm.lods.size();
+                });
+            const size_t triangles = source.indices.size() / 3;
+            ok &= SELF_CHECK(levels > 1);
+            std::printf("  %zu triangles: %zu levels in %.2f ms, %.2f M triangles/s\n", triangles, levels, ms, double(triangles) / (ms * 1000.0));
+        }
+
+        // a model's submeshes go to the pool one per task
+        std::vector<CookedMesh::SubmeshData> submeshes;
+        for (uint32_t seed = 1; seed <= 8; ++seed)
+            submeshes.push_back(MakeTerrain(128, 3.0f, seed));
+        ThreadPool pool;
+        const double serial = BestMilliseconds([&] { auto copy = submeshes; MeshSimplifier::GenerateLods(copy, nullptr); });
+        const double parallel = BestMilliseconds([&] { auto copy = submeshes; MeshSimplifier::GenerateLods(copy, &pool); });
+        std::printf("  8 submeshes: %.2f ms serial, %.2f ms on %zu threads\n", serial, parallel, pool.GetThreadCount());
+        return ok;
+    }
+}
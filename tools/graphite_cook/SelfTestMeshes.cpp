@@ -0,0 +1,506 @@
+#include "SelfTest.h"
+#include "assets/AssetDecoder.h"
+#include "assets/MeshCodec.h"
+#include "assets/MeshOptimizer.h"
+#include "assets/MeshProcessing.h"
+#include "assets/VertexPacking.h"
+#include "core/ThreadPool.h"
+#include "cfg/Config.h"
+
+#include <assimp/mesh.h>
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Triangle = std::array<float, 9>;
+
+    // triangles by the positions of their corners rather than by index, so
+    // reordered vertices compare equal. rotated to start at the smallest
+    // corner, winding is kept
+    std::vector<Triangle> TriangleSet(const CookedMesh::SubmeshData &sm)
+    {
+        std::vector<Triangle> triangles(sm.indices.size() / 3);
+        for (size_t t = 0; t < triangles.size(); ++t)
+        {
+            std::array<std::array<float, 3>, 3> corners;
+            for (int c = 0; c < 3; ++c)
+            {
+                const glm::vec3 &p = sm.vertices[sm.indices[t * 3 + c]].Position;
+                corners[c] = {p.x, p.y, p.z};
+            }
+            const int first = int(std::min_element(corners.begin(), corners.end()) - corners.begin());
+            for (int c = 0; c < 3; ++c)
+                std::copy(corners[(first + c) % 3].begin(), corners[(first + c) % 3].end(), triangles[t].begin() + c * 3);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    glm::vec3 RandomDirection(SelfTest::Random &random)
+    {
+        for (;;)
+        {
+            const glm::vec3 v(random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f));
+            const float length = glm::length(v);
+            if (length > 0.01f && length <= 1.0f)
+                return v / length;
+        }
+    }
+
+    // atan2 rather than acos of the dot, which cannot resolve angles this small in float
+    float AngleDegrees(const glm::vec3 &a, const glm::vec3 &b)
+    {
+        return std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b)) * 57.29578f;
+    }
+
+    bool SameSubmesh(const CookedMesh::SubmeshData &a, const CookedMesh::SubmeshData &b)
+    {
+        return a.vertices.size() == b.vertices.size() && a.indices == b.indices &&
+               std::memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(Vertex)) == 0;
+    }
+
+    // a scan sized mesh for the import and decode benches, 10M vertices
+    // and 20M triangles
+    constexpr uint32_t SCAN_SIZE = 3162;
+
+    // an aiMesh over arrays owned here, laid out the way assimp hands over a
+    // triangulated mesh. assimp's destructors free whatever a mesh and its
+    // faces point at, so the pointers are cleared first
+    struct BorrowedMesh
+    {
+        std::vector<aiVector3D> positions, normals, texCoords, tangents;
+        std::vector<unsigned> indices;
+        std::vector<aiFace> faces;
+        aiMesh mesh;
+
+        explicit BorrowedMesh(const CookedMesh::SubmeshData &sm)
+            : positions(sm.vertices.size()), normals(sm.vertices.size()), texCoords(sm.vertices.size()),
+              tangents(sm.vertices.size()), indices(sm.indices.begin(), sm.indices.end()), faces(sm.indices.size() / 3)
+        {
+            for (size_t i = 0; i < sm.vertices.size(); ++i)
+            {
+                const Vertex &v = sm.vertices[i];
+                positions[i] = {v.Position.x, v.Position.y, v.Position.z};
+                normals[i] = {v.Normal.x, v.Normal.y, v.Normal.z};
+                texCoords[i] = {v.TexCoord.x, v.TexCoord.y, 0.0f};
+                tangents[i] = {v.Tangent.x, v.Tangent.y, v.Tangent.z};
+            }
+            for (size_t f = 0; f < faces.size(); ++f)
+            {
+                faces[f].mNumIndices = 3;
+                faces[f].mIndices = indices.data() + f * 3;
+            }
+            mesh.mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+            mesh.mNumVertices = unsigned(positions.size());
+            mesh.mNumFaces = unsigned(faces.size());
+            mesh.mVertices = positions.data();
+            mesh.mNormals = normals.data();
+            mesh.mTextureCoords[0] = texCoords.data();
+            mesh.mTangents = tangents.data();
+            mesh.mBitangents = tangents.data(); // only checked for, never read
+            mesh.mFaces = faces.data();
+        }
+
+        ~BorrowedMesh()
+        {
+            for (aiFace &face : faces)
+                face.mIndices = nullptr;
+            mesh.mVertices = mesh.mNormals = mesh.mTangents = mesh.mBitangents = mesh.mTextureCoords[0] = nullptr;
+            mesh.mFaces = nullptr;
+            mesh.mNumVertices = mesh.mNumFaces = 0;
+        }
+
+        BorrowedMesh(const BorrowedMesh &) = delete;
+        BorrowedMesh &operator=(const BorrowedMesh &) = delete;
+    };
+
+    // MeshCodec may hand a triangle back rotated, never rewound
+    bool SameTriangles(const uint32_t *a, const uint32_t *b, size_t count)
+    {
+        for (size_t t = 0; t < count; t += 3)
+        {
+            bool same = false;
+            for (int r = 0; r < 3 && !same; ++r)
+                same = a[t] == b[t + r] && a[t + 1] == b[t + (r + 1) % 3] && a[t + 2] == b[t + (r + 2) % 3];
+            if (!same)
+                return false;
+        }
+        return true;
+    }
+
+    // every corner of sm written out as a vertex of its own, the way assimp
+    // hands over a mesh before welding. every other copy of a zero coordinate
+    // is -0, which has to weld with +0
+    void Unweld(const CookedMesh::SubmeshData &sm, UninitVector<Vertex> &outVertices, UninitVector<uint32_t> &outIndices)
+    {
+        outVertices.resize(sm.indices.size());
+        outIndices.resize(sm.indices.size());
+        for (size_t i = 0; i < sm.indices.size(); ++i)
+        {
+            Vertex v = sm.vertices[sm.indices[i]];
+            if (i % 2)
+            {
+                for (float *f : {&v.Position.x, &v.Position.z, &v.TexCoord.x, &v.TexCoord.y})
+                    *f = *f == 0.0f ? -0.0f : *f;
+            }
+            outVertices[i] = v;
+            outIndices[i] = uint32_t(i);
+        }
+    }
+
+    // the bits of every attribute, -0 counted as +0
+    std::array<uint32_t, 11> WeldKey(const Vertex &v)
+    {
+        const float fields[11] = {v.Position.x, v.Position.y, v.Position.z, v.Normal.x, v.Normal.y, v.Normal.z,
+                                  v.TexCoord.x, v.TexCoord.y, v.Tangent.x, v.Tangent.y, v.Tangent.z};
+        std::array<uint32_t, 11> key;
+        for (int f = 0; f < 11; ++f)
+        {
+            const float value = fields[f] == 0.0f ? 0.0f : fields[f];
+            std::memcpy(&key[f], &value, sizeof(float));
+        }
+        return key;
+    }
+
+    // unit uv sphere, u around the y axis and v from the top pole down. the
+    // seam column is duplicated at u = 0 and 1 and each pole has a vertex per
+    // segment. normals and tangents are left zero, triangles wind clockwise
+    // seen from outside and the degenerate ones at the poles are left out
+    void MakeSphere(uint32_t segments, uint32_t rings, UninitVector<Vertex> &outVertices, UninitVector<uint32_t> &outIndices)
+    {
+        constexpr float PI = 3.14159265358979f;
+        outVertices.clear();
+        outIndices.clear();
+        for (uint32_t r = 0; r <= rings; ++r)
+        {
+            // exact zeros at the poles and the same angle on both sides of the
+            // seam, so vertices meant to share a position do
+            const float theta = PI * float(r) / float(rings);
+            const float ringRadius = r == 0 || r == rings ? 0.0f : std::sin(theta);
+            for (uint32_t s = 0; s <= segments; ++s)
+            {
+                const float phi = 2.0f * PI * float(s % segments) / float(segments);
+                Vertex v{};
+                v.Position = glm::vec3(ringRadius * std::cos(phi), std::cos(theta), ringRadius * std::sin(phi));
+                v.TexCoord = glm::vec2(float(s) / float(segments), float(r) / float(rings));
+                outVertices.push_back(v);
+            }
+        }
+        for (uint32_t r = 0; r < rings; ++r)
+        {
+            for (uint32_t s = 0; s < segments; ++s)
+            {
+                const uint32_t a = r * (segments + 1) + s, b = a + 1, c = a + segments + 1, d = c + 1;
+                if (r != 0)
+                    outIndices.insert(outIndices.end(), {a, c, b});
+                if (r != rings - 1)
+                    outIndices.insert(outIndices.end(), {b, c, d});
+            }
+        }
+    }
+
+    void ProcessAll(UninitVector<Vertex> &vertices, UninitVector<uint32_t> &indices, ThreadPool *pool)
+    {
+        MeshProcessing::WeldVertices(vertices, indices, pool);
+        MeshProcessing::GenerateNormals(vertices.data(), vertices.size(), indices.data(), indices.size(), pool);
+        MeshProcessing::GenerateTangents(vertices.data(), vertices.size(), indices.data(), indices.size(), pool);
+    }
+}
+
+namespace SelfTest
+{
+    bool TestMeshOptimizer()
+    {
+        bool ok = true;
+
+        // a terrain with its triangles shuffled and rotated, the order an
+        // importer might hand over, plus a vertex no triangle uses
+        std::vector<CookedMesh::SubmeshData> submeshes;
+        for (uint32_t seed = 1; seed <= 4; ++seed)
+        {
+            CookedMesh::SubmeshData sm = MakeTerrain(64 + seed * 16, 2.0f, seed);
+            Random random(seed);
+            const size_t triangleCount = sm.indices.size() / 3;
+            for (size_t t = triangleCount - 1; t > 0; --t)
+            {
+                const size_t other = random.Below(uint32_t(t + 1));
+                for (int c = 0; c < 3; ++c)
+                    std::swap(sm.indices[t * 3 + c], sm.indices[other * 3 + c]);
+            }
+            for (size_t t = 0; t < triangleCount; ++t)
+                std::rotate(sm.indices.begin() + t * 3, sm.indices.begin() + t * 3 + random.Below(3), sm.indices.begin() + t * 3 + 3);
+            sm.vertices.push_back(sm.vertices[0]);
+            submeshes.push_back(std::move(sm));
+        }
+
+        std::vector<std::vector<Triangle>> before;
+        std::vector<MeshOptimizer::CacheStats> statsBefore;
+        for (const auto &sm : submeshes)
+        {
+            before.push_back(TriangleSet(sm));
+            statsBefore.push_back(MeshOptimizer::AnalyzeVertexCache(sm.indices.data(), sm.indices.size(), sm.vertices.size(), Config::MeshOptimization::CACHE_SIZE));
+        }
+
+        std::vector<CookedMesh::SubmeshData> serial = submeshes;
+        MeshOptimizer::OptimizeSubmeshes(serial, nullptr);
+        ThreadPool pool(3);
+        std::vector<CookedMesh::SubmeshData> parallel = submeshes;
+        MeshOptimizer::OptimizeSubmeshes(parallel, &pool);
+
+        for (size_t i = 0; i < submeshes.size(); ++i)
+        {
+            const auto &sm = serial[i];
+            ok &= SELF_CHECK(TriangleSet(sm) == before[i]);
+            ok &= SELF_CHECK(sm.vertices.size() == submeshes[i].vertices.size() - 1); // the unused vertex is dropped
+            ok &= SELF_CHECK(SameSubmesh(sm, parallel[i]));
+
+            const auto stats = MeshOptimizer::AnalyzeVertexCache(sm.indices.data(), sm.indices.size(), sm.vertices.size(), Config::MeshOptimization::CACHE_SIZE);
+            ok &= SELF_CHECK(stats.acmr < statsBefore[i].acmr);
+            std::printf("  submesh %zu: %zu triangles, acmr %.3f -> %.3f, atvr %.3f -> %.3f\n", i, sm.indices.size() / 3,
+                        statsBefore[i].acmr, stats.acmr, statsBefore[i].atvr, stats.atvr);
+        }
+        return ok;
+    }
+
+    bool TestVertexPacking()
+    {
+        // largest decode error each packed format may have
+        // position: half a unorm16 step of the bounds extent on every axis
+        // normal and tangent: octahedral snorm16 stays within 0.005 degrees
+        // texcoord: half float rounding, 2^-11 relative (2^-25 below the normal range)
+        constexpr float MAX_DIRECTION_DEGREES = 0.005f;
+        constexpr float HALF_RELATIVE_ERROR = 1.0f / 2048.0f;
+        constexpr float HALF_SMALLEST_STEP = 1.0f / 33554432.0f;
+        bool ok = true;
+
+        // every half survives a trip through float and back, nan aside
+        size_t halfMismatches = 0;
+        for (uint32_t h = 0; h < 0x10000; ++h)
+        {
+            const bool nan = (h & 0x7C00) == 0x7C00 && (h & 0x03FF) != 0;
+            if (!nan && VertexPacking::FloatToHalf(VertexPacking::HalfToFloat(uint16_t(h))) != h)
+                ++halfMismatches;
+        }
+        ok &= SELF_CHECK(halfMismatches == 0);
+
+        // an odd count, so the simd batches end with a scalar tail
+        Random random(5);
+        std::vector<Vertex> vertices(10007);
+        for (Vertex &v : vertices)
+        {
+            v.Position = glm::vec3(random.Range(-30.0f, 50.0f), random.Range(0.0f, 2.0f), random.Range(-1000.0f, 1000.0f));
+            v.Normal = RandomDirection(random);
+            v.Tangent = RandomDirection(random);
+            v.TexCoord = glm::vec2(random.Range(-4.0f, 4.0f), random.Range(0.0f, 1.0f) * random.Range(0.0f, 1.0f));
+        }
+        // axis directions and the octahedron's folded edges are the awkward ones
+        const glm::vec3 awkward[] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1},
+                                     {0.7071068f, 0, -0.7071068f}, {0, -0.7071068f, -0.7071068f}, {-0.5773503f, -0.5773503f, -0.5773503f}};
+        for (size_t i = 0; i < std::size(awkward); ++i)
+        {
+            vertices[i].Normal = awkward[i];
+            vertices[std::size(awkward) + i].Tangent = awkward[i];
+        }
+
+        const VertexQuantization quantization = VertexPacking::ComputeQuantization(vertices.data(), vertices.size());
+        std::vector<PackedVertex> packed(vertices.size());
+        std::vector<Vertex> unpacked(vertices.size());
+        VertexPacking::Pack(vertices.data(), vertices.size(), quantization, packed.data());
+        VertexPacking::Unpack(packed.data(), packed.size(), quantization, unpacked.data());
+
+        glm::vec3 positionError(0.0f), positionMagnitude(0.0f);
+        float normalError = 0.0f, tangentError = 0.0f, texCoordExcess = 0.0f, texCoordError = 0.0f;
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            const Vertex &a = vertices[i], &b = unpacked[i];
+            for (int c = 0; c < 3; ++c)
+            {
+                positionError[c] = std::max(positionError[c], std::abs(a.Position[c] - b.Position[c]));
+                positionMagnitude[c] = std::max(positionMagnitude[c], std::abs(a.Position[c]));
+            }
+            normalError = std::max(normalError, AngleDegrees(a.Normal, b.Normal));
+            tangentError = std::max(tangentError, AngleDegrees(a.Tangent, b.Tangent));
+            for (int c = 0; c < 2; ++c)
+            {
+                const float error = std::abs(a.TexCoord[c] - b.TexCoord[c]);
+                texCoordError = std::max(texCoordError, error);
+                texCoordExcess = std::max(texCoordExcess, error - std::max(std::abs(a.TexCoord[c]) * HALF_RELATIVE_ERROR, HALF_SMALLEST_STEP));
+            }
+        }
+
+        for (int c = 0; c < 3; ++c)
+        {
+            // the float math of decoding adds a few ulps of the coordinate on top of the step
+            const float step = quantization.scale[c] / 65535.0f;
+            ok &= SELF_CHECK(positionError[c] <= step * 0.5f + positionMagnitude[c] * 4.0f * FLT_EPSILON);
+            std::printf("  position axis %d: max error %.3g, step %.3g\n", c, positionError[c], step);
+        }
+        ok &= SELF_CHECK(normalError <= MAX_DIRECTION_DEGREES);
+        ok &= SELF_CHECK(tangentError <= MAX_DIRECTION_DEGREES);
+        ok &= SELF_CHECK(texCoordExcess <= 0.0f);
+        std::printf("  normal %.4f deg, tangent %.4f deg, texcoord %.3g max error\n", normalError, tangentError, texCoordError);
+        return ok;
+    }
+
+    bool TestMeshProcessing()
+    {
+        // on a 32 x 16 sphere. normals sum unweighted face normals, which
+        // lean towards the side of a vertex with more triangles. tangents
+        // split at the uv seam, where each copy sees the faces on one side
+        // only and leans by up to half a segment
+        constexpr uint32_t SEGMENTS = 32, RINGS = 16;
+        constexpr float MAX_NORMAL_DEGREES = 1.5f;
+        constexpr float MAX_TANGENT_DEGREES = 1.0f;
+        constexpr float MAX_SEAM_TANGENT_DEGREES = 180.0f / SEGMENTS;
+        bool ok = true;
+
+        // welding an unwelded grid gives what a std::map over the attribute
+        // bits gives: first occurrences in order, -0 merged with +0
+        const CookedMesh::SubmeshData grid = MakeTerrain(40, 3.0f, 3);
+        UninitVector<Vertex> vertices;
+        UninitVector<uint32_t> indices;
+        Unweld(grid, vertices, indices);
+
+        std::map<std::array<uint32_t, 11>, uint32_t> seen;
+        std::vector<Vertex> expectedVertices;
+        std::vector<uint32_t> expectedIndices;
+        for (uint32_t index : indices)
+        {
+            const auto [it, added] = seen.emplace(WeldKey(vertices[index]), uint32_t(expectedVertices.size()));
+            if (added)
+                expectedVertices.push_back(vertices[index]);
+            expectedIndices.push_back(it->second);
+        }
+
+        const size_t welded = MeshProcessing::WeldVertices(vertices, indices);
+        ok &= SELF_CHECK(welded == grid.vertices.size() && welded == expectedVertices.size());
+        ok &= SELF_CHECK(vertices.size() == welded && std::memcmp(vertices.data(), expectedVertices.data(), welded * sizeof(Vertex)) == 0);
+        ok &= SELF_CHECK(std::equal(indices.begin(), indices.end(), expectedIndices.begin(), expectedIndices.end()));
+
+        // a unit sphere's normal is its position and its tangent the
+        // direction of increasing u, (-sin phi, 0, cos phi)
+        MakeSphere(SEGMENTS, RINGS, vertices, indices);
+        MeshProcessing::GenerateNormals(vertices.data(), vertices.size(), indices.data(), indices.size());
+        MeshProcessing::GenerateTangents(vertices.data(), vertices.size(), indices.data(), indices.size());
+        float normalError = 0.0f, tangentError = 0.0f, seamTangentError = 0.0f;
+        for (const Vertex &v : vertices)
+        {
+            normalError = std::max(normalError, AngleDegrees(v.Normal, v.Position));
+            // the poles have no u direction
+            if (v.Position.y == 1.0f || v.Position.y == -1.0f)
+                continue;
+            const float phi = v.TexCoord.x * 2.0f * 3.14159265358979f;
+            const float error = AngleDegrees(v.Tangent, glm::vec3(-std::sin(phi), 0.0f, std::cos(phi)));
+            float &worst = v.TexCoord.x == 0.0f || v.TexCoord.x == 1.0f ? seamTangentError : tangentError;
+            worst = std::max(worst, error);
+        }
+        ok &= SELF_CHECK(normalError <= MAX_NORMAL_DEGREES);
+        ok &= SELF_CHECK(tangentError <= MAX_TANGENT_DEGREES);
+        ok &= SELF_CHECK(seamTangentError <= MAX_SEAM_TANGENT_DEGREES);
+
+        // more vertices than one task takes, so the pool splits every step,
+        // and the result has to be the same bytes as without it
+        const CookedMesh::SubmeshData terrain = MakeTerrain(300, 3.0f, 9);
+        UninitVector<Vertex> serialVertices, pooledVertices;
+        UninitVector<uint32_t> serialIndices, pooledIndices;
+        Unweld(terrain, serialVertices, serialIndices);
+        pooledVertices = serialVertices;
+        pooledIndices = serialIndices;
+        ThreadPool pool(3);
+        ProcessAll(serialVertices, serialIndices, nullptr);
+        ProcessAll(pooledVertices, pooledIndices, &pool);
+        ok &= SELF_CHECK(serialVertices.size() == terrain.vertices.size() && pooledVertices.size() == serialVertices.size());
+        ok &= SELF_CHECK(std::memcmp(serialVertices.data(), pooledVertices.data(), serialVertices.size() * sizeof(Vertex)) == 0);
+        ok &= SELF_CHECK(serialIndices == pooledIndices);
+
+        std::printf("  weld %zu -> %zu vertices, sphere normals within %.3f deg, tangents within %.3f deg (%.3f on the seam)\n",
+                    grid.indices.size(), welded, normalError, tangentError, seamTangentError);
+        return ok;
+    }
+
+    bool BenchMeshImport()
+    {
+        // ProcessAssimpMesh on one huge mesh, once on this thread and once
+        // split over the pool. both must give the same bytes
+        const CookedMesh::SubmeshData terrain = MakeTerrain(SCAN_SIZE, 3.0f, 5);
+        const BorrowedMesh source(terrain);
+        ThreadPool pool;
+
+        CookedMesh::SubmeshData serial, pooled;
+        bool processed = true;
+        auto process = [&](CookedMesh::SubmeshData &out, ThreadPool *p)
+        {
+            // fresh arrays each run, so first touching the pages is timed too
+            CookedMesh::SubmeshData sm;
+            processed &= AssetDecoder::ProcessAssimpMesh(&source.mesh, sm.vertices, sm.indices, p);
+            out = std::move(sm);
+        };
+        const double serialMs = BestMilliseconds([&] { process(serial, nullptr); });
+        const double pooledMs = BestMilliseconds([&] { process(pooled, &pool); });
+        bool ok = SELF_CHECK(processed);
+        ok &= SELF_CHECK(SameSubmesh(serial, pooled));
+        ok &= SELF_CHECK(SameSubmesh(serial, terrain));
+
+        const double megabytes = double(terrain.vertices.size() * sizeof(Vertex) + terrain.indices.size() * sizeof(uint32_t)) / (1024.0 * 1024.0);
+        std::printf("  %zu vertices, %zu triangles: serial %.1f ms (%.0f M vertices/s), %.1f ms on %zu threads (%.0f MB/s out), %.2fx\n",
+                    terrain.vertices.size(), terrain.indices.size() / 3, serialMs, terrain.vertices.size() / (serialMs * 1000.0),
+                    pooledMs, pool.GetThreadCount(), megabytes / (pooledMs / 1000.0), serialMs / std::max(pooledMs, 1e-6));
+        return ok;
+    }
+
+    bool BenchMeshDecode()
+    {
+        // the MeshCodec streams of a cooked scan decoded back, as a .gmesh
+        // stored encoded is at load
+        const CookedMesh::SubmeshData terrain = MakeTerrain(SCAN_SIZE, 3.0f, 5);
+        const size_t vertexCount = terrain.vertices.size(), indexCount = terrain.indices.size();
+        ThreadPool pool;
+        std::vector<unsigned char> vertexStream, indexStream;
+        bool ok = SELF_CHECK(MeshCodec::EncodeVertices(terrain.vertices.data(), vertexCount, sizeof(Vertex), vertexStream, &pool) &&
+                             MeshCodec::EncodeIndices(terrain.indices.data(), indexCount, indexStream, &pool));
+
+        const double rawMegabytes = double(vertexCount * sizeof(Vertex) + indexCount * sizeof(uint32_t)) / (1024.0 * 1024.0);
+        const double encodedMegabytes = double(vertexStream.size() + indexStream.size()) / (1024.0 * 1024.0);
+        std::printf("  %zu vertices, %zu triangles: %.1f MB encoded to %.1f MB\n", vertexCount, indexCount / 3, rawMegabytes, encodedMegabytes);
+
+        // decoded bytes per second, vertices and indices together. one core
+        // has to keep up with a fast disk, the pool should reach the multi
+        // GB/s a streamed scene needs once it has the cores for it. timing
+        // floors only mean something with optimizations on
+        constexpr double CORE_FLOOR_GBPS = 0.8, POOL_TARGET_GBPS = 3.0;
+        const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        const double poolFloor = std::min(POOL_TARGET_GBPS, CORE_FLOOR_GBPS * double(cores));
+
+        UninitVector<Vertex> vertices(vertexCount);
+        UninitVector<uint32_t> indices(indexCount);
+        for (ThreadPool *p : {static_cast<ThreadPool *>(nullptr), &pool})
+        {
+            bool decoded = false;
+            const double vertexMs = BestMilliseconds([&] { decoded = MeshCodec::DecodeVertices(vertexStream.data(), vertexStream.size(), vertices.data(), vertexCount, sizeof(Vertex), p); });
+            const double indexMs = BestMilliseconds([&] { decoded = MeshCodec::DecodeIndices(indexStream.data(), indexStream.size(), indices.data(), indexCount, vertexCount, p) && decoded; });
+            ok &= SELF_CHECK(decoded);
+            ok &= SELF_CHECK(std::memcmp(vertices.data(), terrain.vertices.data(), vertexCount * sizeof(Vertex)) == 0);
+            ok &= SELF_CHECK(SameTriangles(indices.data(), terrain.indices.data(), indexCount));
+
+            const double gbps = rawMegabytes * 1024.0 * 1024.0 / ((vertexMs + indexMs) * 1e6);
+            const double floor = p ? poolFloor : CORE_FLOOR_GBPS;
+            std::printf("  %s: vertices %.1f ms (%.0f M vertices/s, %.2f GB/s out), indices %.1f ms (%.0f M triangles/s)\n",
+                        p ? "on the pool" : "serial", vertexMs, vertexCount / (vertexMs * 1000.0),
+                        double(vertexCount * sizeof(Vertex)) / (vertexMs * 1e6), indexMs, indexCount / 3 / (indexMs * 1000.0));
+            std::printf("    %.2f GB/s decoded on %zu core%s, floor %.2f GB/s\n", gbps, p ? cores : size_t(1),
+                        p && cores > 1 ? "s" : "", floor);
+#ifdef NDEBUG
+            ok &= SELF_CHECK(gbps >= floor);
+#endif
+        }
+        return ok;
+    }
+}
@@ -0,0 +1,117 @@
+#include "SelfTest.h"
+#include "core/ThreadPool.h"
+#include "rendering/RenderQueue.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <vector>
+
+namespace
+{
+    // how the keys of one queue are drawn, each leaves a different set of
+    // digits shared by every key so Sort skips different passes
+    enum class KeyShape
+    {
+        Random,     // all 64 bits random, no pass is skipped
+        FewValues,  // a handful of distinct keys, lots of ties to keep in order
+        Frame,      // MakeKey over a frame's worth of ids, the top digits shared
+        SharedMask, // random with alternating digits fixed, skipped passes in between sorted ones
+        Same,       // every key equal, every pass skipped
+        Descending, // random keys handed in back to front
+    };
+
+    uint64_t Random64(SelfTest::Random &random)
+    {
+        return (uint64_t(random.Next()) << 32) | random.Next();
+    }
+
+    std::vector<uint64_t> MakeKeys(KeyShape shape, size_t count, SelfTest::Random &random)
+    {
+        constexpr uint64_t SHARED_MASK = 0xFF00FF0000FF00FFull;
+        const uint64_t shared = Random64(random);
+        std::vector<uint64_t> keys(count);
+        for (uint64_t &key : keys)
+        {
+            switch (shape)
+            {
+            case KeyShape::Random:
+            case KeyShape::Descending:
+                key = Random64(random);
+                break;
+            case KeyShape::FewValues:
+                key = (uint64_t(random.Below(5)) << 40) | random.Below(3);
+                break;
+            case KeyShape::Frame:
+                key = RenderQueue::MakeKey(RenderQueue::PASS_GEOMETRY, random.Below(2), random.Below(60), random.Below(400),
+                                           random.Below(5), random.Float());
+                break;
+            case KeyShape::SharedMask:
+                key = (Random64(random) & ~SHARED_MASK) | (shared & SHARED_MASK);
+                break;
+            case KeyShape::Same:
+                key = shared;
+                break;
+            }
+        }
+        if (shape == KeyShape::Descending)
+            std::sort(keys.begin(), keys.end(), [](uint64_t a, uint64_t b) { return a > b; });
+        return keys;
+    }
+}
+
+namespace SelfTest
+{
+    bool TestRenderQueueSort()
+    {
+        bool ok = true;
+        Random random(41);
+        // a fixed worker count, so the chunked parallel passes run on any machine
+        ThreadPool pool(3);
+        RenderQueue queue;
+        const KeyShape shapes[] = {KeyShape::Random, KeyShape::FewValues, KeyShape::Frame,
+                                   KeyShape::SharedMask, KeyShape::Same, KeyShape::Descending};
+        // either side of the size where the sort goes parallel
+        const size_t sizes[] = {0, 1, 2, 255, 5000, 16383, 16384, 100000};
+
+        size_t sorts = 0, mismatches = 0;
+        for (KeyShape shape : shapes)
+        {
+            for (size_t count : sizes)
+            {
+                const std::vector<uint64_t> keys = MakeKeys(shape, count, random);
+                std::vector<RenderQueue::Entry> expected(count);
+                for (size_t i = 0; i < count; ++i)
+                    expected[i] = {keys[i], uint32_t(i)};
+                std::stable_sort(expected.begin(), expected.end(),
+                                 [](const RenderQueue::Entry &a, const RenderQueue::Entry &b) { return a.key < b.key; });
+
+                // the same queue is refilled every time, so stale scratch would show
+                for (ThreadPool *sortPool : {static_cast<ThreadPool *>(nullptr), &pool})
+                {
+                    queue.Clear();
+                    for (size_t i = 0; i < count; ++i)
+                        queue.Add(keys[i], uint32_t(i));
+                    queue.Sort(sortPool);
+
+                    bool same = queue.Size() == count;
+                    for (size_t i = 0; i < count && same; ++i)
+                        same = queue[i].key == expected[i].key && queue[i].item == expected[i].item;
+                    mismatches += same ? 0 : 1;
+                    ++sorts;
+                }
+            }
+        }
+        ok &= SELF_CHECK(mismatches == 0);
+
+        // fields land in key order, so sorting by key sorts by pass, then material and so on
+        ok &= SELF_CHECK(RenderQueue::MakeKey(0, 1, 0, 0, 0, 0.0f) < RenderQueue::MakeKey(1, 0, 0, 0, 0, 0.0f));
+        ok &= SELF_CHECK(RenderQueue::MakeKey(0, 0, 1, 0, 0, 0.0f) < RenderQueue::MakeKey(0, 0, 2, 0, 0, 0.0f));
+        ok &= SELF_CHECK(RenderQueue::MakeKey(0, 0, 1, 5, 2, 0.1f) < RenderQueue::MakeKey(0, 0, 1, 5, 2, 0.9f));
+        ok &= SELF_CHECK(RenderQueue::MakeKey(7, 1, ~0u, ~0u, 7, 2.0f) == ~uint64_t(0));
+
+        std::printf("  %zu sorts over %zu key shapes matched std::stable_sort, %zu didn't\n",
+                    sorts, std::size(shapes), mismatches);
+        return ok;
+    }
+}
@@ -0,0 +1,572 @@
+#include "SelfTest.h"
+#include "assets/BlockCompression.h"
+#include "assets/MipGenerator.h"
+#include "assets/MipStreamer.h"
+#include "core/ThreadPool.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+namespace
+{
+    const char *RoleName(TextureRole role)
+    {
+        switch (role)
+        {
+        case TextureRole::Albedo:
+            return "albedo";
+        case TextureRole::Normal:
+            return "normal";
+        default:
+            return "orm";
+        }
+    }
+
+    // reference decoders written from the format descriptions rather than
+    // from the encoder, so they don't share its mistakes
+
+    void DecodeBC1(const unsigned char *block, unsigned char *tile)
+    {
+        const uint16_t c0 = uint16_t(block[0] | block[1] << 8), c1 = uint16_t(block[2] | block[3] << 8);
+        int palette[4][3];
+        for (int e = 0; e < 2; ++e)
+        {
+            const uint16_t c = e ? c1 : c0;
+            const int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+            palette[e][0] = (r << 3) | (r >> 2);
+            palette[e][1] = (g << 2) | (g >> 4);
+            palette[e][2] = (b << 3) | (b >> 2);
+        }
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = c0 > c1 ? (2 * palette[0][c] + palette[1][c]) / 3 : (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = c0 > c1 ? (palette[0][c] + 2 * palette[1][c]) / 3 : 0;
+        }
+        for (int i = 0; i < 16; ++i)
+        {
+            const int index = (block[4 + i / 4] >> (2 * (i % 4))) & 3;
+            for (int c = 0; c < 3; ++c)
+                tile[i * 4 + c] = static_cast<unsigned char>(palette[index][c]);
+            tile[i * 4 + 3] = 255;
+        }
+    }
+
+    void DecodeBC4(const unsigned char *block, int channel, unsigned char *tile)
+    {
+        const int r0 = block[0], r1 = block[1];
+        int palette[8] = {r0, r1};
+        for (int i = 1; i < 7; ++i)
+        {
+            if (r0 > r1)
+                palette[i + 1] = ((7 - i) * r0 + i * r1) / 7;
+            else if (i < 5)
+                palette[i + 1] = ((5 - i) * r0 + i * r1) / 5;
+        }
+        if (r0 <= r1)
+        {
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+        uint64_t bits = 0;
+        for (int b = 0; b < 6; ++b)
+            bits |= uint64_t(block[2 + b]) << (8 * b);
+        for (int i = 0; i < 16; ++i)
+            tile[i * 4 + channel] = static_cast<unsigned char>(palette[(bits >> (3 * i)) & 7]);
+    }
+
+    class BitReader
+    {
+    public:
+        explicit BitReader(const unsigned char *block) : m_Block(block) {}
+
+        int Read(int bits)
+        {
+            int value = 0;
+            for (int b = 0; b < bits; ++b, ++m_Position)
+                value |= ((m_Block[m_Position >> 3] >> (m_Position & 7)) & 1) << b;
+            return value;
+        }
+
+    private:
+        const unsigned char *m_Block;
+        int m_Position = 0;
+    };
+
+    int Interpolate(int e0, int e1, int weight)
+    {
+        return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+    }
+
+    // only modes 5 and 6, the two the encoder writes. false for anything else
+    bool DecodeBC7(const unsigned char *block, unsigned char *tile)
+    {
+        static constexpr int WEIGHTS2[4] = {0, 21, 43, 64};
+        static constexpr int WEIGHTS4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+        BitReader reader(block);
+        int mode = 0;
+        while (mode < 8 && reader.Read(1) == 0)
+            ++mode;
+
+        int endpoints[2][4];
+        if (mode == 6)
+        {
+            for (int c = 0; c < 4; ++c)
+                for (int e = 0; e < 2; ++e)
+                    endpoints[e][c] = reader.Read(7) << 1;
+            for (int e = 0; e < 2; ++e)
+            {
+                const int pbit = reader.Read(1);
+                for (int c = 0; c < 4; ++c)
+                    endpoints[e][c] |= pbit;
+            }
+            for (int i = 0; i < 16; ++i)
+            {
+                const int weight = WEIGHTS4[reader.Read(i == 0 ? 3 : 4)];
+                for (int c = 0; c < 4; ++c)
+                    tile[i * 4 + c] = static_cast<unsigned char>(Interpolate(endpoints[0][c], endpoints[1][c], weight));
+            }
+            return true;
+        }
+        if (mode == 5)
+        {
+            const int rotation = reader.Read(2);
+            for (int c = 0; c < 3; ++c)
+            {
+                for (int e = 0; e < 2; ++e)
+                {
+                    const int v = reader.Read(7);
+                    endpoints[e][c] = (v << 1) | (v >> 6);
+                }
+            }
+            endpoints[0][3] = reader.Read(8);
+            endpoints[1][3] = reader.Read(8);
+            int colorWeights[16];
+            for (int i = 0; i < 16; ++i)
+                colorWeights[i] = WEIGHTS2[reader.Read(i == 0 ? 1 : 2)];
+            for (int i = 0; i < 16; ++i)
+            {
+                const int alphaWeight = WEIGHTS2[reader.Read(i == 0 ? 1 : 2)];
+                unsigned char *texel = tile + i * 4;
+                for (int c = 0; c < 3; ++c)
+                    texel[c] = static_cast<unsigned char>(Interpolate(endpoints[0][c], endpoints[1][c], colorWeights[i]));
+                texel[3] = static_cast<unsigned char>(Interpolate(endpoints[0][3], endpoints[1][3], alphaWeight));
+                if (rotation > 0)
+                    std::swap(texel[3], texel[rotation - 1]);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // decodes a whole encoded image back to rgba8 (width * height * 4 bytes in out),
+    // channels the format doesn't store come back as 0
+    bool DecodeImage(const std::vector<unsigned char> &blocks, TextureFormat format, int width, int height, std::vector<unsigned char> &out)
+    {
+        const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+        const size_t blockBytes = BlockCompression::BlockBytes(format);
+        bool ok = blocks.size() == size_t(blocksX) * blocksY * blockBytes;
+        for (int by = 0; ok && by < blocksY; ++by)
+        {
+            for (int bx = 0; bx < blocksX; ++bx)
+            {
+                const unsigned char *block = blocks.data() + (size_t(by) * blocksX + bx) * blockBytes;
+                unsigned char tile[64] = {};
+                switch (format)
+                {
+                case TextureFormat::BC1:
+                    DecodeBC1(block, tile);
+                    break;
+                case TextureFormat::BC4:
+                    DecodeBC4(block, 0, tile);
+                    break;
+                case TextureFormat::BC5:
+                    DecodeBC4(block, 0, tile);
+                    DecodeBC4(block + 8, 1, tile);
+                    break;
+                default:
+                    ok &= DecodeBC7(block, tile);
+                    break;
+                }
+                for (int y = 0; y < 4 && by * 4 + y < height; ++y)
+                    for (int x = 0; x < 4 && bx * 4 + x < width; ++x)
+                        std::memcpy(out.data() + ((size_t(by) * 4 + y) * width + bx * 4 + x) * 4, tile + (y * 4 + x) * 4, 4);
+            }
+        }
+        return ok;
+    }
+
+    double Psnr(const std::vector<unsigned char> &a, const std::vector<unsigned char> &b, int channels)
+    {
+        double sum = 0.0;
+        size_t count = 0;
+        for (size_t i = 0; i < a.size(); i += 4)
+        {
+            for (int c = 0; c < channels; ++c, ++count)
+            {
+                const double d = double(a[i + c]) - double(b[i + c]);
+                sum += d * d;
+            }
+        }
+        const double mse = sum / double(count);
+        return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+    }
+
+    size_t FirstDifference(const std::vector<unsigned char> &a, const std::vector<unsigned char> &b)
+    {
+        if (a.size() != b.size())
+            return 0;
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (a[i] != b[i])
+                return i;
+        }
+        return a.size();
+    }
+
+    // a row of 256x256 bc1 textures 4 units wide along x, seen by a camera
+    // at cameraX looking down +x, so whatever is ahead of it is on screen
+    constexpr int STREAM_SIZE = 256, STREAM_LEVELS = 9;
+    constexpr float STREAM_POSITIONS[] = {0.0f, 30.0f, 60.0f, 90.0f};
+    constexpr uint32_t STREAM_COUNT = uint32_t(std::size(STREAM_POSITIONS));
+
+    std::vector<uint64_t> StreamLevelBytes()
+    {
+        std::vector<uint64_t> bytes(STREAM_LEVELS);
+        for (int l = 0; l < STREAM_LEVELS; ++l)
+        {
+            const int size = MipGenerator::LevelSize(STREAM_SIZE, l);
+            bytes[l] = BlockCompression::LevelBytes(TextureFormat::BC1, size, size);
+        }
+        return bytes;
+    }
+
+    uint64_t BytesFrom(const std::vector<uint64_t> &levelBytes, int mip)
+    {
+        uint64_t bytes = 0;
+        for (size_t l = size_t(mip); l < levelBytes.size(); ++l)
+            bytes += levelBytes[l];
+        return bytes;
+    }
+
+    // what the geometry pass asks for, -1 once the texture is behind the camera
+    int StreamRequest(float x, float cameraX)
+    {
+        if (x < cameraX)
+            return -1;
+        const float distance = x - cameraX + 2.0f;
+        return MipStreamer::RequiredMip(float(STREAM_SIZE) / 4.0f, 900.0f / distance, STREAM_LEVELS);
+    }
+}
+
+namespace SelfTest
+{
+    bool TestMipGenerator()
+    {
+        bool ok = true;
+        ThreadPool pool(3);
+
+        // odd sizes reach the scalar tails of every row loop, 1 pixel wide
+        // levels never enter the simd loops at all
+        const int sizes[][2] = {{256, 256}, {257, 130}, {1, 37}, {64, 3}, {6, 6}};
+        for (const auto &size : sizes)
+        {
+            const std::vector<unsigned char> image = MakeImage(size[0], size[1], uint32_t(size[0] * 1000 + size[1]));
+            for (TextureRole role : {TextureRole::Albedo, TextureRole::Normal, TextureRole::ORM})
+            {
+                for (MipGenerator::Filter filter : {MipGenerator::Filter::Box, MipGenerator::Filter::Kaiser})
+                {
+                    std::vector<unsigned char> simd, scalar, pooled;
+                    MipGenerator::Generate(image.data(), size[0], size[1], role, filter, simd);
+                    MipGenerator::GenerateScalar(image.data(), size[0], size[1], role, filter, scalar);
+                    MipGenerator::Generate(image.data(), size[0], size[1], role, filter, pooled, &pool);
+
+                    // bit exact, not just close
+                    const size_t difference = FirstDifference(simd, scalar);
+                    if (!SELF_CHECK(difference == simd.size() && simd.size() == scalar.size()))
+                    {
+                        std::printf("  %dx%d %s %s: byte %zu is %d, scalar %d\n", size[0], size[1], RoleName(role),
+                                    filter == MipGenerator::Filter::Box ? "box" : "kaiser", difference,
+                                    difference < simd.size() ? simd[difference] : -1, difference < scalar.size() ? scalar[difference] : -1);
+                        ok = false;
+                    }
+                    ok &= SELF_CHECK(pooled == simd);
+                }
+            }
+        }
+        return ok;
+    }
+
+    bool TestBlockCompression()
+    {
+        // smallest psnr each encoder must reach on the generated image, over
+        // the channels its format stores
+        struct Case
+        {
+            TextureFormat format;
+            const char *name;
+            int channels;
+            double minPsnr;
+        };
+        const Case cases[] = {
+            {TextureFormat::BC1, "bc1", 3, 36.0},
+            {TextureFormat::BC4, "bc4", 1, 48.0},
+            {TextureFormat::BC5, "bc5", 2, 48.0},
+            {TextureFormat::BC7, "bc7", 4, 38.0},
+        };
+
+        bool ok = true;
+        // not a multiple of 4, so the repeated edge texels are covered too
+        const int width = 510, height = 254;
+        const std::vector<unsigned char> image = MakeImage(width, height, 9);
+        const double megabytes = double(image.size()) / (1024.0 * 1024.0);
+        ThreadPool pool;
+        for (const Case &c : cases)
+        {
+            std::vector<unsigned char> blocks, pooled;
+            const double ms = BestMilliseconds([&] { blocks.clear(); BlockCompression::EncodeImage(image.data(), width, height, c.format, blocks); });
+            const double pooledMs = BestMilliseconds([&] { pooled.clear(); BlockCompression::EncodeImage(image.data(), width, height, c.format, pooled, &pool); });
+            ok &= SELF_CHECK(pooled == blocks);
+
+            std::vector<unsigned char> decoded(image.size());
+            ok &= SELF_CHECK(DecodeImage(blocks, c.format, width, height, decoded));
+            const double psnr = Psnr(image, decoded, c.channels);
+            ok &= SELF_CHECK(psnr >= c.minPsnr);
+            std::printf("  %s: %.2f db (at least %.1f), %.1f MB/s, %.1f MB/s on %zu threads\n", c.name, psnr, c.minPsnr,
+                        megabytes / (ms / 1000.0), megabytes / (pooledMs / 1000.0), pool.GetThreadCount());
+        }
+        return ok;
+    }
+
+    bool TestMipStreamer()
+    {
+        bool ok = true;
+        const std::vector<uint64_t> levelBytes = StreamLevelBytes();
+        const int coarsest = MipStreamer::CoarsestTopMip(TextureFormat::BC1, STREAM_SIZE, STREAM_SIZE, STREAM_LEVELS);
+        const int start = MipStreamer::StartMip(TextureFormat::BC1, STREAM_SIZE, STREAM_SIZE, STREAM_LEVELS, 64);
+        ok &= SELF_CHECK(coarsest == 6 && start == 2);
+
+        MipStreamer streamer;
+        std::vector<MipStreamer::Transition> transitions;
+        std::vector<int> wanted(STREAM_COUNT), pending(STREAM_COUNT, -1);
+        auto reset = [&](uint64_t budget)
+        {
+            streamer = MipStreamer(budget);
+            for (uint32_t key = 0; key < STREAM_COUNT; ++key)
+                streamer.Add(key, levelBytes, start, coarsest);
+            std::fill(pending.begin(), pending.end(), -1);
+        };
+        // one frame the way AssetManager runs it: the geometry pass requests,
+        // last frame's loads land, then the update starts the next ones
+        auto frame = [&](float cameraX, uint64_t uploadBytes)
+        {
+            for (uint32_t key = 0; key < STREAM_COUNT; ++key)
+            {
+                wanted[key] = StreamRequest(STREAM_POSITIONS[key], cameraX);
+                if (wanted[key] >= 0)
+                    streamer.Request(key, wanted[key]);
+                else
+                    wanted[key] = coarsest;
+                if (pending[key] >= 0)
+                    streamer.Complete(key, true);
+                pending[key] = -1;
+            }
+            transitions.clear();
+            streamer.Update(uploadBytes, transitions);
+            for (const MipStreamer::Transition &t : transitions)
+            {
+                if (t.toMip < t.fromMip)
+                    pending[t.key] = t.toMip;
+            }
+        };
+        // resident levels plus the loads in flight, which the budget counts
+        auto accounted = [&]
+        {
+            uint64_t bytes = 0;
+            for (uint32_t key = 0; key < STREAM_COUNT; ++key)
+                bytes += BytesFrom(levelBytes, streamer.GetResidentMip(key)) + (pending[key] >= 0 ? levelBytes[pending[key]] : 0);
+            return bytes;
+        };
+        auto mips = [&](int a, int b, int c, int d)
+        {
+            return streamer.GetResidentMip(0) == a && streamer.GetResidentMip(1) == b &&
+                   streamer.GetResidentMip(2) == c && streamer.GetResidentMip(3) == d;
+        };
+
+        // no budget and no upload cap: each texture the camera closes in on
+        // gets one level finer per frame until it has what it asks for, and
+        // nothing is ever dropped. checked against that rule every frame
+        reset(0);
+        std::vector<int> expected(STREAM_COUNT, start);
+        size_t mismatches = 0;
+        for (int x = -40; x <= 100; ++x)
+        {
+            frame(float(x), UINT64_MAX);
+            size_t loads = 0;
+            for (uint32_t key = 0; key < STREAM_COUNT; ++key)
+            {
+                mismatches += streamer.GetResidentMip(key) != expected[key] ? 1 : 0;
+                if (wanted[key] < expected[key])
+                {
+                    mismatches += pending[key] != expected[key] - 1 ? 1 : 0;
+                    expected[key] = expected[key] - 1;
+                    ++loads;
+                }
+            }
+            mismatches += transitions.size() != loads ? 1 : 0;
+            mismatches += streamer.GetResidentBytes() != accounted() ? 1 : 0;
+        }
+        ok &= SELF_CHECK(mismatches == 0);
+        // every texture was passed close up
+        frame(100.0f, UINT64_MAX);
+        ok &= SELF_CHECK(mips(0, 0, 0, 0) && streamer.GetPendingCount() == 0);
+
+        // a budget that holds one texture at full detail and a couple at the
+        // next level, and a cap of a quarter of a top level per frame
+        const uint64_t budget = 60000, upload = levelBytes[0] / 4;
+        reset(budget);
+        size_t overBudget = 0, overCap = 0, wrongSteps = 0, visibleDropped = 0, wrongBytes = 0;
+        auto checkFrame = [&]
+        {
+            uint64_t uploaded = 0;
+            size_t loads = 0;
+            for (const MipStreamer::Transition &t : transitions)
+            {
+                if (t.toMip < t.fromMip)
+                {
+                    wrongSteps += t.toMip != t.fromMip - 1 ? 1 : 0;
+                    uploaded += levelBytes[t.toMip];
+                    ++loads;
+                }
+                else if (wanted[t.key] != coarsest)
+                {
+                    // something on screen keeps at least the level it asked for
+                    visibleDropped += t.toMip >= wanted[t.key] ? 1 : 0;
+                }
+            }
+            overCap += loads > 1 && uploaded > upload ? 1 : 0;
+            overBudget += streamer.GetResidentBytes() > budget ? 1 : 0;
+            wrongBytes += streamer.GetResidentBytes() != accounted() ? 1 : 0;
+        };
+        for (int x = -40; x <= 50; ++x)
+        {
+            frame(float(x), upload);
+            checkFrame();
+        }
+        // holding still at 50: texture 2 is 12 units off and wants mip 0,
+        // texture 3 at 42 wants mip 1, the two behind make room for them
+        for (int f = 0; f < 20; ++f)
+        {
+            frame(50.0f, upload);
+            checkFrame();
+        }
+        ok &= SELF_CHECK(overBudget == 0 && overCap == 0 && wrongSteps == 0 && visibleDropped == 0 && wrongBytes == 0);
+        ok &= SELF_CHECK(wanted[2] == 0 && wanted[3] == 1);
+        ok &= SELF_CHECK(streamer.GetResidentMip(2) == 0 && streamer.GetResidentMip(3) == 1);
+        ok &= SELF_CHECK(streamer.GetResidentMip(0) >= 2 && streamer.GetResidentMip(1) >= 2);
+        ok &= SELF_CHECK(streamer.GetPendingCount() == 0 && transitions.empty());
+
+        // four textures wanting their top level and a cap of two and a half
+        // next levels: two loads a frame, ties to the lower key. a cap smaller than any
+        // level still lets one load through
+        reset(0);
+        for (uint32_t f = 0; f < 3; ++f)
+        {
+            for (uint32_t key = 0; key < STREAM_COUNT; ++key)
+                streamer.Request(key, 0);
+            transitions.clear();
+            streamer.Update(2 * levelBytes[1] + levelBytes[1] / 2, transitions);
+            if (f < 2)
+                ok &= SELF_CHECK(transitions.size() == 2 && transitions[0].key == 2 * f && transitions[1].key == 2 * f + 1 &&
+                                 transitions[0].toMip == 1 && transitions[1].toMip == 1);
+            else
+                ok &= SELF_CHECK(transitions.empty() && streamer.GetPendingCount() == STREAM_COUNT);
+        }
+        for (uint32_t key = 0; key < STREAM_COUNT; ++key)
+        {
+            streamer.Complete(key, true);
+            streamer.Request(key, 0);
+        }
+        transitions.clear();
+        streamer.Update(1, transitions);
+        ok &= SELF_CHECK(transitions.size() == 1 && transitions[0].toMip == 0);
+
+        // the budget shrinks under what is loaded: the texture out of view
+        // longest gives up levels first, one at a time, then the next
+        reset(0);
+        for (int f = 0; f < 10; ++f)
+            frame(-12.0f, upload);
+        ok &= SELF_CHECK(mips(0, 1, 2, 2));
+        frame(2.0f, upload);
+        for (int f = 0; f < 10; ++f)
+            frame(45.0f, upload);
+        ok &= SELF_CHECK(mips(0, 1, 0, 1) && streamer.GetResidentBytes() == 2 * BytesFrom(levelBytes, 0) + 2 * BytesFrom(levelBytes, 1));
+        streamer.SetBudget(100000);
+        frame(45.0f, upload);
+        ok &= SELF_CHECK(mips(1, 1, 0, 1) && streamer.GetResidentBytes() <= 100000);
+        streamer.SetBudget(budget);
+        frame(45.0f, upload);
+        ok &= SELF_CHECK(mips(coarsest, 2, 0, 1) && streamer.GetResidentBytes() <= budget);
+        ok &= SELF_CHECK(streamer.GetResidentBytes() == accounted());
+        // and stays there, nothing flips back and forth
+        size_t churn = 0;
+        for (int f = 0; f < 10; ++f)
+        {
+            frame(45.0f, upload);
+            churn += transitions.size();
+        }
+        ok &= SELF_CHECK(churn == 0 && mips(coarsest, 2, 0, 1));
+
+        // moving on to 80 leaves texture 2 behind, it and texture 1 make way
+        // for texture 3's top level. that load fails, the level before stays
+        frame(80.0f, upload);
+        ok &= SELF_CHECK(wanted[3] == 0 && pending[3] == 0 && mips(coarsest, coarsest, coarsest, 1));
+        streamer.Complete(3, false);
+        pending[3] = -1;
+        ok &= SELF_CHECK(streamer.GetResidentMip(3) == 1 && streamer.GetPendingCount() == 0);
+        ok &= SELF_CHECK(streamer.GetResidentBytes() == accounted());
+        // the next frame tries again
+        frame(80.0f, upload);
+        frame(80.0f, upload);
+        ok &= SELF_CHECK(mips(coarsest, coarsest, coarsest, 0) && streamer.GetResidentBytes() <= budget);
+
+        // removing a texture mid load gives back its levels and the load
+        frame(-40.0f, upload);
+        const size_t inFlight = streamer.GetPendingCount();
+        streamer.Remove(0);
+        pending[0] = -1;
+        ok &= SELF_CHECK(inFlight > 0 && streamer.GetPendingCount() < inFlight);
+        uint64_t remaining = 0;
+        for (uint32_t key = 1; key < STREAM_COUNT; ++key)
+            remaining += BytesFrom(levelBytes, streamer.GetResidentMip(key)) + (pending[key] >= 0 ? levelBytes[pending[key]] : 0);
+        ok &= SELF_CHECK(streamer.GetResidentBytes() == remaining);
+        return ok;
+    }
+
+    bool BenchMipGenerator()
+    {
+        bool ok = true;
+        const int size = 2048;
+        const std::vector<unsigned char> image = MakeImage(size, size, 3);
+        const double megabytes = double(image.size()) / (1024.0 * 1024.0);
+        ThreadPool pool;
+
+        for (TextureRole role : {TextureRole::Albedo, TextureRole::Normal, TextureRole::ORM})
+        {
+            for (MipGenerator::Filter filter : {MipGenerator::Filter::Box, MipGenerator::Filter::Kaiser})
+            {
+                std::vector<unsigned char> simd, scalar, pooled;
+                const double scalarMs = BestMilliseconds([&] { MipGenerator::GenerateScalar(image.data(), size, size, role, filter, scalar); });
+                const double ms = BestMilliseconds([&] { MipGenerator::Generate(image.data(), size, size, role, filter, simd); });
+                const double pooledMs = BestMilliseconds([&] { MipGenerator::Generate(image.data(), size, size, role, filter, pooled, &pool); });
+                ok &= SELF_CHECK(simd == scalar && pooled == simd);
+                std::printf("  %s %s: scalar %.1f ms, Generate %.1f ms (%.0f MB/s), %.2fx, %.1f ms on %zu threads\n",
+                            RoleName(role), filter == MipGenerator::Filter::Box ? "box" : "kaiser", scalarMs, ms,
+                            megabytes / (ms / 1000.0), scalarMs / std::max(ms, 1e-6), pooledMs, pool.GetThreadCount());
+            }
+        }
+        return ok;
+    }
+}
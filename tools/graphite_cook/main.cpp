@@ -0,0 +1,743 @@
+#include "assets/AssetCache.h"
+#include "assets/AssetDecoder.h"
+#include "assets/CookedTexture.h"
+#include "assets/MeshCodec.h"
+#include "assets/MipGenerator.h"
+#include "assets/PngDecoder.h"
+#include "core/ThreadPool.h"
+#include "platform/MappedFile.h"
+#include "rendering/ObjectCulling.h"
+#include "SelfTest.h"
+#include "utils/Logger.h"
+#include "cfg/Config.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <stb_image.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+// offline cooker: walks an asset root and fills Config::AssetCooking::CACHE_DIR
+// with everything whose source bytes or import settings changed since the last run.
+// --compare-import imports one model with assimp's post processes and with
+// ours (MeshProcessing) and reports timings and how far the results differ.
+// --bench-load times loading one model the way LoadModel did before cooking
+// (assimp with its own post processes) against mapping its cooked .gmesh.
+// --bench-png decodes every png under a directory with stb_image and with
+// PngDecoder and checks both give the same pixels.
+// --bench-meshes re-encodes every .gmesh under a directory with MeshCodec and
+// reports sizes and decode speed, serial and on the pool.
+// --bench-textures loads every .gtex under a directory the way the runtime did
+// (read into a buffer) and the way it does now (mapped) and reports bytes per
+// second until the levels sit in a staging copy, standing in for the upload
+// --bench-culling frustum culls a million (or count) random bounding spheres
+// one at a time and 8 at a time with ObjectCulling, the geometry pass's test
+// --test runs the self checks in SelfTest.cpp, or those whose name starts with filter
+// --bench runs the timings listed there the same way, on generated input
+//
+//   graphite_cook <asset root> [--force]
+//   graphite_cook --compare-import <model>
+//   graphite_cook --bench-load <model>
+//   graphite_cook --bench-png <dir>
+//   graphite_cook --bench-meshes <dir>
+//   graphite_cook --bench-textures <dir>
+//   graphite_cook --bench-culling [count]
+//   graphite_cook --test [filter]
+//   graphite_cook --bench [filter]
+
+namespace
+{
+    // logging cfg
+    static constexpr const char LOG_FILE_PATH[] = "logs/graphite_cook.log";
+    static constexpr LogLevel DEFAULT_LOG_LEVEL = LogLevel::INFO;
+
+    struct Source
+    {
+        AssetID path;
+        AssetCache::Kind kind;
+        TextureRole role;
+    };
+
+    std::string Lower(std::string s)
+    {
+        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+        return s;
+    }
+
+    // the runtime gets the role from the material, here only the name is known
+    TextureRole GuessRole(const AssetID &path)
+    {
+        const std::string name = Lower(path.stem().string());
+        if (name.find("normal") != std::string::npos)
+            return TextureRole::Normal;
+        if (name.find("orm") != std::string::npos || name.find("rough") != std::string::npos ||
+            name.find("metal") != std::string::npos)
+            return TextureRole::ORM;
+        return TextureRole::Albedo;
+    }
+
+    bool Classify(const AssetID &path, Source &out)
+    {
+        const std::string ext = Lower(path.extension().string());
+        out.path = path;
+        if (ext == ".gltf" || ext == ".glb" || ext == ".obj" || ext == ".fbx")
+        {
+            out.kind = AssetCache::Kind::Model;
+            out.role = TextureRole::Albedo;
+            return true;
+        }
+        if (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".tga" || ext == ".bmp")
+        {
+            out.kind = AssetCache::Kind::Texture;
+            out.role = GuessRole(path);
+            return true;
+        }
+        return false;
+    }
+
+    bool Cook(const Source &source, uint64_t key, ThreadPool *pool)
+    {
+        if (source.kind == AssetCache::Kind::Model)
+            return AssetDecoder::CookModel(source.path, key, pool);
+        return AssetDecoder::CookTexture(source.path, source.role, key, pool);
+    }
+
+    double Milliseconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    float AngleDegrees(const glm::vec3 &a, const glm::vec3 &b)
+    {
+        const float la = glm::length(a), lb = glm::length(b);
+        if (la == 0.0f || lb == 0.0f)
+            return la == lb ? 0.0f : 180.0f;
+        return glm::degrees(std::acos(std::clamp(glm::dot(a, b) / (la * lb), -1.0f, 1.0f)));
+    }
+
+    struct AngleStats
+    {
+        std::vector<float> angles;
+
+        void Print(const char *name)
+        {
+            if (angles.empty())
+                return;
+            double sum = 0.0;
+            for (float a : angles)
+                sum += a;
+            auto p99 = angles.begin() + static_cast<std::ptrdiff_t>(angles.size() * 99 / 100);
+            std::nth_element(angles.begin(), p99, angles.end());
+            std::printf("%-9s mean %7.3f deg, p99 %7.3f deg, max %7.3f deg\n", name,
+                        sum / angles.size(), *p99, *std::max_element(angles.begin(), angles.end()));
+        }
+    };
+
+    int CompareImport(const AssetID &path)
+    {
+        namespace MI = Config::MeshImport;
+        constexpr uint32_t ALL_STAGES = MI::WELD | MI::NORMALS | MI::TANGENTS;
+        ThreadPool pool;
+
+        std::vector<CookedMesh::SubmeshData> reference, serial, parallel;
+        auto start = std::chrono::steady_clock::now();
+        if (!AssetDecoder::ImportMeshes(path, 0, reference))
+            return EXIT_FAILURE;
+        const double assimpMs = Milliseconds(start);
+
+        start = std::chrono::steady_clock::now();
+        if (!AssetDecoder::ImportMeshes(path, ALL_STAGES, serial))
+            return EXIT_FAILURE;
+        const double serialMs = Milliseconds(start);
+
+        start = std::chrono::steady_clock::now();
+        if (!AssetDecoder::ImportMeshes(path, ALL_STAGES, parallel, &pool))
+            return EXIT_FAILURE;
+        const double parallelMs = Milliseconds(start);
+
+        if (reference.size() != parallel.size())
+        {
+            std::fprintf(stderr, "submesh count differs: assimp %zu, ours %zu\n", reference.size(), parallel.size());
+            return EXIT_FAILURE;
+        }
+
+        // the pool must not change a single bit
+        bool deterministic = true;
+        for (size_t i = 0; i < parallel.size(); ++i)
+        {
+            const auto &a = serial[i], &b = parallel[i];
+            deterministic = deterministic && a.vertices.size() == b.vertices.size() && a.indices == b.indices &&
+                            std::memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(Vertex)) == 0;
+        }
+
+        // positions and uvs pass through both sides untouched, so vertices are
+        // matched on those. hard edges give several candidates, the closest counts
+        AngleStats normals, tangents;
+        size_t assimpVertices = 0, ourVertices = 0, unmatched = 0;
+        auto key = [](const Vertex &v)
+        { return std::make_tuple(v.Position.x, v.Position.y, v.Position.z, v.TexCoord.x, v.TexCoord.y); };
+        for (size_t i = 0; i < parallel.size(); ++i)
+        {
+            const auto &ref = reference[i].vertices;
+            const auto &ours = parallel[i].vertices;
+            assimpVertices += ref.size();
+            ourVertices += ours.size();
+
+            std::vector<std::pair<decltype(key(ref[0])), uint32_t>> sorted(ref.size());
+            for (uint32_t v = 0; v < sorted.size(); ++v)
+                sorted[v] = {key(ref[v]), v};
+            std::sort(sorted.begin(), sorted.end());
+
+            for (const Vertex &v : ours)
+            {
+                const auto k = key(v);
+                auto first = std::lower_bound(sorted.begin(), sorted.end(), k, [](const auto &e, const auto &k)
+                                              { return e.first < k; });
+                auto last = std::upper_bound(first, sorted.end(), k, [](const auto &k, const auto &e)
+                                             { return k < e.first; });
+                if (first == last)
+                {
+                    ++unmatched;
+                    continue;
+                }
+                float normal = 180.0f, tangent = 180.0f;
+                for (auto it = first; it != last; ++it)
+                {
+                    const float n = AngleDegrees(v.Normal, ref[it->second].Normal);
+                    if (n < normal)
+                    {
+                        normal = n;
+                        tangent = AngleDegrees(v.Tangent, ref[it->second].Tangent);
+                    }
+                }
+                normals.angles.push_back(normal);
+                tangents.angles.push_back(tangent);
+            }
+        }
+
+        std::printf("%s: %zu submeshes\n", path.string().c_str(), parallel.size());
+        std::printf("assimp post process:         %9.1f ms, %zu vertices\n", assimpMs, assimpVertices);
+        std::printf("ours, 1 thread:              %9.1f ms\n", serialMs);
+        std::printf("ours, %2zu threads:            %9.1f ms, %zu vertices%s\n", pool.GetThreadCount() + 1, parallelMs,
+                    ourVertices, deterministic ? "" : " (differs from 1 thread!)");
+        if (unmatched)
+            std::printf("%zu vertices have no assimp vertex at the same position and uv\n", unmatched);
+        normals.Print("normals");
+        tangents.Print("tangents");
+        return deterministic ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // best of a few runs, the first one also pays for page faults
+    template <typename Fn>
+    double BestMilliseconds(Fn &&fn)
+    {
+        double best = 0.0;
+        for (int run = 0; run < 3; ++run)
+        {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            const double ms = Milliseconds(start);
+            best = run == 0 ? ms : std::min(best, ms);
+        }
+        return best;
+    }
+
+    int BenchPng(const std::filesystem::path &root)
+    {
+        size_t files = 0, handled = 0, mismatches = 0;
+        double decodedMB = 0.0, stbMs = 0.0, oursMs = 0.0;
+        std::error_code ec;
+        for (auto it = std::filesystem::recursive_directory_iterator(root, ec);
+             !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+        {
+            if (!it->is_regular_file(ec) || Lower(it->path().extension().string()) != ".png")
+                continue;
+
+            std::ifstream in(it->path(), std::ios::binary);
+            std::vector<unsigned char> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            ++files;
+
+            int w = 0, h = 0, c = 0;
+            unsigned char *reference = nullptr;
+            const double stb = BestMilliseconds([&]
+                                                {
+                stbi_image_free(reference);
+                reference = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &w, &h, &c, 4); });
+            PngDecoder::Info info;
+            if (!reference || !PngDecoder::ReadInfo(file.data(), file.size(), info))
+            {
+                std::printf("%-60s stb_image only\n", it->path().string().c_str());
+                stbi_image_free(reference);
+                continue;
+            }
+
+            std::vector<unsigned char> pixels(size_t(w) * h * 4);
+            bool ok = false;
+            const double ours = BestMilliseconds([&]
+                                                 { ok = PngDecoder::Decode(file.data(), file.size(), info, pixels.data(), size_t(w) * 4); });
+            const bool same = ok && std::memcmp(pixels.data(), reference, pixels.size()) == 0;
+            stbi_image_free(reference);
+
+            const double mb = pixels.size() / (1024.0 * 1024.0);
+            std::printf("%-60s %5dx%-5d %dx%2d bit  stb %7.1f ms  ours %7.1f ms  %4.1fx%s\n", it->path().string().c_str(),
+                        w, h, info.channels, info.bitDepth, stb, ours, stb / ours, same ? "" : "  PIXELS DIFFER");
+            ++handled;
+            mismatches += same ? 0 : 1;
+            decodedMB += mb;
+            stbMs += stb;
+            oursMs += ours;
+        }
+
+        std::printf("%zu pngs, %zu decoded by both\n", files, handled);
+        if (handled)
+            std::printf("stb_image %.0f MB/s, PngDecoder %.0f MB/s (rgba8 output), %.2fx\n",
+                        decodedMB / (stbMs / 1000.0), decodedMB / (oursMs / 1000.0), stbMs / oursMs);
+        return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // the index codec may rotate a triangle, so compare each one starting
+    // from its smallest index
+    bool SameTriangles(const uint32_t *a, const uint32_t *b, size_t count)
+    {
+        auto canonical = [](const uint32_t *t)
+        {
+            const int first = t[0] <= t[1] && t[0] <= t[2] ? 0 : (t[1] <= t[2] ? 1 : 2);
+            return std::make_tuple(t[first], t[(first + 1) % 3], t[(first + 2) % 3]);
+        };
+        for (size_t i = 0; i < count; i += 3)
+        {
+            if (canonical(a + i) != canonical(b + i))
+                return false;
+        }
+        return true;
+    }
+
+    int BenchLoad(const AssetID &path)
+    {
+        // stages 0 leaves every post process to assimp, the ProcessAssimpMesh
+        // path LoadModel ran on every start before .gmesh existed
+        std::vector<CookedMesh::SubmeshData> imported;
+        bool ok = true;
+        const double importMs = BestMilliseconds([&]
+                                                 {
+            imported.clear();
+            ok = AssetDecoder::ImportMeshes(path, 0, imported) && ok; });
+        if (!ok)
+            return EXIT_FAILURE;
+
+        const std::filesystem::path cooked = std::filesystem::temp_directory_path() / (path.stem().string() + CookedMesh::EXTENSION);
+        if (!CookedMesh::Write(cooked, imported))
+        {
+            std::fprintf(stderr, "failed to write %s\n", cooked.string().c_str());
+            return EXIT_FAILURE;
+        }
+
+        // map and validate, then copy every stream once the way the driver
+        // copies initial data, so untouched pages of the mapping are paid for too
+        size_t bytes = 0;
+        for (const auto &sm : imported)
+            bytes += sm.vertices.size() * sizeof(Vertex) + sm.indices.size() * sizeof(uint32_t);
+        std::vector<unsigned char> staging(bytes);
+        bool same = true;
+        const double mapMs = BestMilliseconds([&]
+                                              {
+            MappedFile file;
+            std::vector<CookedMesh::SubmeshView> views;
+            std::vector<CookedMesh::SubmeshData> decoded;
+            ok = file.Open(cooked) && CookedMesh::Read(file.GetData(), file.GetSize(), views, decoded) && ok;
+            same = ok && views.size() == imported.size();
+            size_t offset = 0;
+            for (size_t i = 0; same && i < views.size(); ++i)
+            {
+                const auto &view = views[i];
+                const auto &sm = imported[i];
+                same = view.vertexCount == sm.vertices.size() && view.indexCount == sm.indices.size();
+                if (!same)
+                    break;
+                std::memcpy(staging.data() + offset, view.vertices, view.vertexCount * sizeof(Vertex));
+                same = std::memcmp(staging.data() + offset, sm.vertices.data(), view.vertexCount * sizeof(Vertex)) == 0 &&
+                       SameTriangles(view.indices, sm.indices.data(), sm.indices.size());
+                offset += view.vertexCount * sizeof(Vertex);
+                std::memcpy(staging.data() + offset, view.indices, sm.indices.size() * sizeof(uint32_t));
+                offset += sm.indices.size() * sizeof(uint32_t);
+            } });
+
+        std::error_code ec;
+        std::filesystem::remove(cooked, ec);
+
+        std::printf("%s: %zu submeshes, %.1f MB of vertices and indices\n", path.string().c_str(), imported.size(), bytes / 1e6);
+        std::printf("assimp import (old path): %9.1f ms\n", importMs);
+        std::printf("mapped .gmesh:            %9.1f ms, %.1fx%s\n", mapMs, importMs / std::max(mapMs, 1e-3),
+                    same ? "" : "  GEOMETRY DIFFERS");
+        return same ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    int BenchMeshes(const std::filesystem::path &root)
+    {
+        ThreadPool pool;
+        size_t files = 0, failures = 0;
+        double rawBytes = 0.0, encodedBytes = 0.0, serialMs = 0.0, parallelMs = 0.0;
+        std::error_code ec;
+        for (auto it = std::filesystem::recursive_directory_iterator(root, ec);
+             !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+        {
+            if (!it->is_regular_file(ec) || Lower(it->path().extension().string()) != ".gmesh")
+                continue;
+
+            std::ifstream in(it->path(), std::ios::binary);
+            std::vector<unsigned char> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            std::vector<CookedMesh::SubmeshView> views;
+            std::vector<CookedMesh::SubmeshData> decoded;
+            if (!CookedMesh::Read(file.data(), file.size(), views, decoded, &pool))
+            {
+                std::printf("%-60s unreadable or out of date\n", it->path().string().c_str());
+                continue;
+            }
+            ++files;
+
+            size_t raw = 0, encoded = 0;
+            double serial = 0.0, parallel = 0.0;
+            bool same = true;
+            for (const auto &view : views)
+            {
+                std::vector<unsigned char> vertexStream, indexStream;
+                if (!MeshCodec::EncodeVertices(view.vertices, view.vertexCount, sizeof(Vertex), vertexStream, &pool) ||
+                    !MeshCodec::EncodeIndices(view.indices, view.indexCount, indexStream, &pool))
+                {
+                    same = false;
+                    continue;
+                }
+
+                std::vector<Vertex> vertices(view.vertexCount);
+                std::vector<uint32_t> indices(view.indexCount);
+                bool ok = true;
+                auto decode = [&](ThreadPool *p)
+                {
+                    ok = MeshCodec::DecodeVertices(vertexStream.data(), vertexStream.size(), vertices.data(),
+                                                   view.vertexCount, sizeof(Vertex), p) &&
+                         MeshCodec::DecodeIndices(indexStream.data(), indexStream.size(), indices.data(),
+                                                  view.indexCount, view.vertexCount, p) &&
+                         ok;
+                };
+                serial += BestMilliseconds([&]
+                                           { decode(nullptr); });
+                parallel += BestMilliseconds([&]
+                                             { decode(&pool); });
+                same = same && ok &&
+                       std::memcmp(vertices.data(), view.vertices, sizeof(Vertex) * view.vertexCount) == 0 &&
+                       SameTriangles(indices.data(), view.indices, view.indexCount);
+
+                raw += sizeof(Vertex) * view.vertexCount + sizeof(uint32_t) * view.indexCount;
+                encoded += vertexStream.size() + indexStream.size();
+            }
+
+            std::printf("%-60s %8.2f MB -> %7.2f MB  serial %6.2f GB/s  pool %6.2f GB/s%s\n", it->path().string().c_str(),
+                        raw / 1e6, encoded / 1e6, raw / 1e6 / std::max(serial, 1e-3), raw / 1e6 / std::max(parallel, 1e-3),
+                        same ? "" : "  ROUND TRIP FAILED");
+            failures += same ? 0 : 1;
+            rawBytes += double(raw);
+            encodedBytes += double(encoded);
+            serialMs += serial;
+            parallelMs += parallel;
+        }
+
+        std::printf("%zu meshes\n", files);
+        if (files && encodedBytes > 0.0)
+            std::printf("%.1f MB -> %.1f MB (%.2fx), decode %.2f GB/s serial, %.2f GB/s on %zu workers\n",
+                        rawBytes / 1e6, encodedBytes / 1e6, rawBytes / encodedBytes,
+                        rawBytes / 1e6 / std::max(serialMs, 1e-3), rawBytes / 1e6 / std::max(parallelMs, 1e-3),
+                        pool.GetThreadCount());
+        return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    size_t LevelBytes(const CookedTexture::TextureData &info, int level)
+    {
+        return size_t(BlockCompression::LevelBytes(info.format, MipGenerator::LevelSize(info.width, level),
+                                                   MipGenerator::LevelSize(info.height, level)));
+    }
+
+    // copies every level into staging the way the driver copies initial
+    // data, so both paths are timed until the bytes have been read once
+    void Stage(const CookedTexture::TextureData &info, const std::vector<const unsigned char *> &levels, std::vector<unsigned char> &staging)
+    {
+        size_t offset = 0;
+        for (int l = 0; l < info.mipLevels; ++l)
+        {
+            std::memcpy(staging.data() + offset, levels[l], LevelBytes(info, l));
+            offset += LevelBytes(info, l);
+        }
+    }
+
+    int BenchTextures(const std::filesystem::path &root)
+    {
+        size_t files = 0, failures = 0;
+        double totalMB = 0.0, readMs = 0.0, mapMs = 0.0;
+        std::error_code ec;
+        for (auto it = std::filesystem::recursive_directory_iterator(root, ec);
+             !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+        {
+            if (!it->is_regular_file(ec) || Lower(it->path().extension().string()) != CookedTexture::EXTENSION)
+                continue;
+
+            CookedTexture::TextureData info;
+            if (!CookedTexture::ReadInfo(it->path(), info))
+            {
+                std::printf("%-60s unreadable or out of date\n", it->path().string().c_str());
+                continue;
+            }
+            ++files;
+
+            std::vector<unsigned char> staging(std::filesystem::file_size(it->path(), ec));
+            bool ok = true;
+            const double read = BestMilliseconds([&]
+                                                 {
+                CookedTexture::TextureData data;
+                ok = CookedTexture::Read(it->path(), data) && ok;
+                std::vector<const unsigned char *> levels(data.mipLevels);
+                size_t offset = 0;
+                for (int l = 0; l < data.mipLevels && ok; ++l)
+                {
+                    levels[l] = data.levels.data() + offset;
+                    offset += LevelBytes(data, l);
+                }
+                if (ok)
+                    Stage(data, levels, staging); });
+            std::vector<unsigned char> reference(staging);
+            const double map = BestMilliseconds([&]
+                                                {
+                MappedFile file;
+                CookedTexture::TextureData data;
+                std::vector<const unsigned char *> levels;
+                ok = CookedTexture::Map(it->path(), file, data, levels) && ok;
+                if (ok)
+                    Stage(data, levels, staging); });
+            const bool same = ok && staging == reference;
+
+            size_t bytes = 0;
+            for (int l = 0; l < info.mipLevels; ++l)
+                bytes += LevelBytes(info, l);
+            const double mb = bytes / (1024.0 * 1024.0);
+            std::printf("%-60s %5dx%-5d %2d levels %7.2f MB  read %7.0f MB/s  mapped %7.0f MB/s%s\n",
+                        it->path().string().c_str(), info.width, info.height, info.mipLevels, mb,
+                        mb / std::max(read / 1000.0, 1e-6), mb / std::max(map / 1000.0, 1e-6), same ? "" : "  LEVELS DIFFER");
+            failures += same ? 0 : 1;
+            totalMB += mb;
+            readMs += read;
+            mapMs += map;
+        }
+
+        // best of three, so these are page cache numbers rather than cold disk ones
+        std::printf("%zu textures, %.1f MB\n", files, totalMB);
+        if (files)
+            std::printf("read %.0f MB/s, mapped %.0f MB/s, %.2fx\n", totalMB / std::max(readMs / 1000.0, 1e-6),
+                        totalMB / std::max(mapMs / 1000.0, 1e-6), readMs / std::max(mapMs, 1e-6));
+        return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    int BenchCulling(size_t count)
+    {
+        // spheres scattered through a cube around a camera looking down -z,
+        // roughly the share of a large scene a 60 degree frustum keeps
+        ObjectBounds bounds;
+        uint32_t state = 0x9e3779b9u;
+        auto random = [&state]
+        {
+            state = state * 1664525u + 1013904223u;
+            return float(state >> 8) / float(1u << 24);
+        };
+        for (size_t i = 0; i < count; ++i)
+            bounds.Add(glm::vec3(random() - 0.5f, random() - 0.5f, random() - 0.5f) * 2000.0f, 0.5f + random() * 10.0f);
+
+        const glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+        const Frustum frustum = Frustum::FromMatrix(projection * view);
+
+        std::vector<uint32_t> scalar(count), simd(count);
+        size_t scalarVisible = 0, simdVisible = 0;
+        const double scalarMs = BestMilliseconds([&]
+                                                 { scalarVisible = ObjectCulling::CullScalar(bounds, frustum, scalar.data()); });
+        const double simdMs = BestMilliseconds([&]
+                                               { simdVisible = ObjectCulling::Cull(bounds, frustum, simd.data()); });
+        const bool same = scalarVisible == simdVisible && std::equal(scalar.begin(), scalar.begin() + scalarVisible, simd.begin());
+
+        std::printf("%zu objects, %zu visible\n", count, scalarVisible);
+        std::printf("scalar %.2f ms, batched %.2f ms, %.2fx%s\n", scalarMs, simdMs,
+                    scalarMs / std::max(simdMs, 1e-6), same ? "" : "  RESULTS DIFFER");
+        return same ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s <asset root> [--force]\n       %s --compare-import <model>\n       %s --bench-load <model>\n       %s --bench-png <dir>\n       %s --bench-meshes <dir>\n       %s --bench-textures <dir>\n       %s --bench-culling [count]\n       %s --test [filter]\n       %s --bench [filter]\n",
+                     argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (std::strcmp(argv[1], "--compare-import") == 0)
+    {
+        if (argc < 3)
+            return EXIT_FAILURE;
+        Logger::Init(DEFAULT_LOG_LEVEL, LOG_FILE_PATH);
+        const int result = CompareImport(argv[2]);
+        Logger::Shutdown();
+        return result;
+    }
+
+    if (std::strcmp(argv[1], "--bench-load") == 0)
+    {
+        if (argc < 3)
+            return EXIT_FAILURE;
+        Logger::Init(DEFAULT_LOG_LEVEL, LOG_FILE_PATH);
+        const int result = BenchLoad(argv[2]);
+        Logger::Shutdown();
+        return result;
+    }
+
+    if (std::strcmp(argv[1], "--bench-png") == 0)
+    {
+        if (argc < 3)
+            return EXIT_FAILURE;
+        return BenchPng(argv[2]);
+    }
+
+    if (std::strcmp(argv[1], "--bench-meshes") == 0)
+    {
+        if (argc < 3)
+            return EXIT_FAILURE;
+        return BenchMeshes(argv[2]);
+    }
+
+    if (std::strcmp(argv[1], "--bench-textures") == 0)
+    {
+        if (argc < 3)
+            return EXIT_FAILURE;
+        return BenchTextures(argv[2]);
+    }
+
+    if (std::strcmp(argv[1], "--bench-culling") == 0)
+        return BenchCulling(argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000);
+
+    if (std::strcmp(argv[1], "--test") == 0)
+    {
+        Logger::Init(DEFAULT_LOG_LEVEL, LOG_FILE_PATH);
+        const int result = SelfTest::RunTests(argc > 2 ? argv[2] : "");
+        Logger::Shutdown();
+        return result;
+    }
+
+    if (std::strcmp(argv[1], "--bench") == 0)
+    {
+        Logger::Init(DEFAULT_LOG_LEVEL, LOG_FILE_PATH);
+        const int result = SelfTest::RunBenches(argc > 2 ? argv[2] : "");
+        Logger::Shutdown();
+        return result;
+    }
+
+    const std::filesystem::path root = argv[1];
+    const bool force = argc > 2 && std::strcmp(argv[2], "--force") == 0;
+
+    Logger::Init(DEFAULT_LOG_LEVEL, LOG_FILE_PATH);
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<Source> sources;
+    std::error_code ec;
+    for (auto it = std::filesystem::recursive_directory_iterator(root, ec);
+         !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+    {
+        Source source;
+        if (it->is_regular_file(ec) && Classify(it->path().lexically_normal(), source))
+            sources.push_back(std::move(source));
+    }
+    if (ec)
+    {
+        std::fprintf(stderr, "failed to walk %s: %s\n", root.string().c_str(), ec.message().c_str());
+        Logger::Shutdown();
+        return EXIT_FAILURE;
+    }
+
+    // sources that hash to the same key are cooked once, the rest only get
+    // recorded against the shared output
+    size_t upToDate = 0, failed = 0;
+    std::vector<uint64_t> keys;
+    std::unordered_map<uint64_t, std::vector<size_t>> groups;
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        const Source &s = sources[i];
+        uint64_t key = 0;
+        if (!force && !AssetCache::Find(s.path, s.kind, s.role, &key).empty())
+        {
+            ++upToDate;
+            continue;
+        }
+        if (force && !AssetCache::ComputeKey(s.path, s.kind, s.role, key))
+            key = 0;
+        if (key == 0)
+        {
+            LOG_ERROR("Failed to hash {}", s.path.string());
+            ++failed;
+            continue;
+        }
+
+        auto &group = groups[key];
+        if (group.empty())
+            keys.push_back(key);
+        group.push_back(i);
+    }
+
+    // one asset per task. decoders also spread their own work over the pool,
+    // which is fine since ParallelFor lets the calling task help out
+    ThreadPool pool;
+    std::atomic<size_t> cooked{0}, deduplicated{0}, cookFailed{0};
+    auto run = [&](size_t begin, size_t end)
+    {
+        for (size_t k = begin; k < end; ++k)
+        {
+            const auto &group = groups.at(keys[k]);
+            const Source &first = sources[group[0]];
+            if (!Cook(first, keys[k], &pool))
+            {
+                LOG_ERROR("Failed to cook {}", first.path.string());
+                cookFailed += group.size();
+                continue;
+            }
+
+            ++cooked;
+            for (size_t g = 1; g < group.size(); ++g)
+            {
+                const Source &s = sources[group[g]];
+                AssetCache::Record(s.path, s.kind, s.role, keys[k]);
+                ++deduplicated;
+            }
+        }
+    };
+    pool.ParallelFor(keys.size(), 1, run);
+
+    AssetCache::CompactManifest();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    failed += cookFailed;
+    std::printf("%zu sources: %zu cooked, %zu deduplicated, %zu up to date, %zu failed in %.2f s\n",
+                sources.size(), cooked.load(), deduplicated.load(), upToDate, failed, seconds);
+    LOG_INFO("Cook finished: {} cooked, {} deduplicated, {} up to date, {} failed in {:.2f} s",
+             cooked.load(), deduplicated.load(), upToDate, failed, seconds);
+
+    Logger::Shutdown();
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// streaming xxh64 (yann collet), used for content addressed caching.
+// not cryptographic, only meant to tell asset contents apart
+class Hash64
+{
+public:
+    explicit Hash64(uint64_t seed = 0)
+    {
+        m_Lanes[0] = seed + PRIME1 + PRIME2;
+        m_Lanes[1] = seed + PRIME2;
+        m_Lanes[2] = seed;
+        m_Lanes[3] = seed - PRIME1;
+        m_Seed = seed;
+    }
+
+    void Update(const void *data, size_t size)
+    {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        m_Total += size;
+
+        // top up a partial stripe first
+        if (m_Buffered > 0)
+        {
+            size_t take = size < 32 - m_Buffered ? size : 32 - m_Buffered;
+            std::memcpy(m_Buffer + m_Buffered, p, take);
+            m_Buffered += take;
+            p += take;
+            size -= take;
+            if (m_Buffered < 32)
+                return;
+            Stripe(m_Buffer);
+            m_Buffered = 0;
+        }
+
+        for (; size >= 32; p += 32, size -= 32)
+            Stripe(p);
+
+        std::memcpy(m_Buffer, p, size);
+        m_Buffered = size;
+    }
+
+    template <typename T>
+    void UpdateValue(const T &value)
+    {
+        Update(&value, sizeof(T));
+    }
+
+    uint64_t Finish() const
+    {
+        uint64_t h;
+        if (m_Total >= 32)
+        {
+            h = Rotl(m_Lanes[0], 1) + Rotl(m_Lanes[1], 7) + Rotl(m_Lanes[2], 12) + Rotl(m_Lanes[3], 18);
+            for (uint64_t lane : m_Lanes)
+                h = (h ^ Round(0, lane)) * PRIME1 + PRIME4;
+        }
+        else
+        {
+            h = m_Seed + PRIME5;
+        }
+        h += m_Total;
+
+        const unsigned char *p = m_Buffer;
+        size_t left = m_Buffered;
+        for (; left >= 8; p += 8, left -= 8)
+            h = Rotl(h ^ Round(0, Read64(p)), 27) * PRIME1 + PRIME4;
+        if (left >= 4)
+        {
+            h = Rotl(h ^ (uint64_t(Read32(p)) * PRIME1), 23) * PRIME2 + PRIME3;
+            p += 4;
+            left -= 4;
+        }
+        for (; left > 0; ++p, --left)
+            h = Rotl(h ^ (*p * PRIME5), 11) * PRIME1;
+
+        h ^= h >> 33;
+        h *= PRIME2;
+        h ^= h >> 29;
+        h *= PRIME3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    static constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+    static constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+    static constexpr uint64_t PRIME3 = 0x165667B19E3779F9ull;
+    static constexpr uint64_t PRIME4 = 0x85EBCA77C2B2AE63ull;
+    static constexpr uint64_t PRIME5 = 0x27D4EB2F165667C5ull;
+
+    static uint64_t Rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    static uint64_t Round(uint64_t acc, uint64_t input)
+    {
+        return Rotl(acc + input * PRIME2, 31) * PRIME1;
+    }
+
+    static uint64_t Read64(const unsigned char *p)
+    {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        return v;
+    }
+
+    static uint32_t Read32(const unsigned char *p)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, 4);
+        return v;
+    }
+
+    void Stripe(const unsigned char *p)
+    {
+        for (int i = 0; i < 4; ++i)
+            m_Lanes[i] = Round(m_Lanes[i], Read64(p + i * 8));
+    }
+
+    uint64_t m_Lanes[4];
+    uint64_t m_Seed;
+    uint64_t m_Total = 0;
+    unsigned char m_Buffer[32];
+    size_t m_Buffered = 0;
+};
@@ -0,0 +1,490 @@
+#include "Inflate.h"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+    // huffman codes are looked up by their first bits, longer codes continue
+    // in a subtable (the scheme zlib uses)
+    constexpr unsigned LITLEN_BITS = 10;
+    constexpr unsigned DIST_BITS = 8;
+    constexpr unsigned CODELEN_BITS = 7; // code length codes are at most 7 bits, no subtables
+
+    constexpr unsigned MAX_CODE_LENGTH = 15;
+    constexpr unsigned LITLEN_SYMBOLS = 288;
+    constexpr unsigned DIST_SYMBOLS = 32;
+    constexpr unsigned CODELEN_SYMBOLS = 19;
+
+    // matches are copied 8 bytes at a time while the output has room past them
+    constexpr size_t WILD_COPY = 8;
+
+    constexpr uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                          35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    constexpr uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                          3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    constexpr uint16_t DIST_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    constexpr uint8_t DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+    constexpr uint8_t CODELEN_ORDER[CODELEN_SYMBOLS] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+    enum Kind : uint8_t
+    {
+        LITERAL = 0x00,      // value is the byte, or the code length symbol
+        BASE = 0x10,         // length or distance base in value, extra bit count in the low bits
+        END_OF_BLOCK = 0x20,
+        SUBTABLE = 0x40,     // value is where the subtable starts, bits its index width
+        INVALID = 0x80,
+    };
+
+    struct Entry
+    {
+        uint16_t value;
+        uint8_t bits; // bits the code takes, past the primary bits inside subtables
+        uint8_t kind;
+    };
+
+    // a primary table and room for every subtable a code can need
+    constexpr size_t TableCapacity(unsigned symbols, unsigned primary)
+    {
+        return (size_t(1) << primary) + (primary < MAX_CODE_LENGTH ? symbols << (MAX_CODE_LENGTH - primary) : 0);
+    }
+
+    struct Tables
+    {
+        Entry litlen[TableCapacity(LITLEN_SYMBOLS, LITLEN_BITS)];
+        Entry dist[TableCapacity(DIST_SYMBOLS, DIST_BITS)];
+    };
+
+    unsigned Reverse(unsigned code, unsigned length)
+    {
+        unsigned reversed = 0;
+        for (unsigned i = 0; i < length; ++i, code >>= 1)
+            reversed = (reversed << 1) | (code & 1);
+        return reversed;
+    }
+
+    Entry LitLenEntry(unsigned symbol)
+    {
+        if (symbol < 256)
+            return {static_cast<uint16_t>(symbol), 0, LITERAL};
+        if (symbol == 256)
+            return {0, 0, END_OF_BLOCK};
+        if (symbol < 257 + 29)
+            return {LENGTH_BASE[symbol - 257], 0, static_cast<uint8_t>(BASE | LENGTH_EXTRA[symbol - 257])};
+        return {0, 0, INVALID};
+    }
+
+    Entry DistEntry(unsigned symbol)
+    {
+        if (symbol < 30)
+            return {DIST_BASE[symbol], 0, static_cast<uint8_t>(BASE | DIST_EXTRA[symbol])};
+        return {0, 0, INVALID};
+    }
+
+    Entry CodeLengthEntry(unsigned symbol)
+    {
+        return {static_cast<uint16_t>(symbol), 0, LITERAL};
+    }
+
+    // canonical huffman code from code lengths (rfc 1951 3.2.2). codes that
+    // aren't assigned stay INVALID, an over subscribed set of lengths fails
+    bool BuildTable(const uint8_t *lengths, unsigned count, unsigned primary, Entry *table, size_t capacity,
+                    Entry (*makeEntry)(unsigned))
+    {
+        unsigned remaining[MAX_CODE_LENGTH + 1] = {};
+        for (unsigned s = 0; s < count; ++s)
+            remaining[lengths[s]]++;
+        remaining[0] = 0;
+
+        int left = 1;
+        unsigned maxLength = 0;
+        for (unsigned length = 1; length <= MAX_CODE_LENGTH; ++length)
+        {
+            left = (left << 1) - int(remaining[length]);
+            if (left < 0)
+                return false;
+            if (remaining[length])
+                maxLength = length;
+        }
+
+        // symbols in canonical order, by length then value
+        unsigned offsets[MAX_CODE_LENGTH + 2] = {};
+        for (unsigned length = 1; length <= MAX_CODE_LENGTH; ++length)
+            offsets[length + 1] = offsets[length] + remaining[length];
+        uint16_t sorted[LITLEN_SYMBOLS];
+        for (unsigned s = 0; s < count; ++s)
+        {
+            if (lengths[s])
+                sorted[offsets[lengths[s]]++] = static_cast<uint16_t>(s);
+        }
+        const unsigned codeCount = offsets[MAX_CODE_LENGTH];
+
+        const size_t primarySize = size_t(1) << primary;
+        for (size_t i = 0; i < primarySize; ++i)
+            table[i] = {0, 0, INVALID};
+        size_t used = primarySize;
+
+        unsigned code = 0, previousLength = 0, subtablePrefix = ~0u;
+        size_t subtable = 0, subtableSize = 0;
+        for (unsigned i = 0; i < codeCount; ++i)
+        {
+            const unsigned symbol = sorted[i];
+            const unsigned length = lengths[symbol];
+            code <<= length - previousLength;
+            previousLength = length;
+
+            Entry entry = makeEntry(symbol);
+            if (length <= primary)
+            {
+                // every index whose low bits are the (bit reversed) code
+                entry.bits = static_cast<uint8_t>(length);
+                for (size_t r = Reverse(code, length); r < primarySize; r += size_t(1) << length)
+                    table[r] = entry;
+            }
+            else
+            {
+                const unsigned prefix = code >> (length - primary);
+                if (prefix != subtablePrefix)
+                {
+                    // codes sharing a prefix are consecutive, size the subtable
+                    // for the ones still to come like zlib does
+                    unsigned bits = length - primary;
+                    int room = 1 << bits;
+                    while (bits + primary < maxLength)
+                    {
+                        room -= int(remaining[bits + primary]);
+                        if (room <= 0)
+                            break;
+                        ++bits;
+                        room <<= 1;
+                    }
+
+                    subtableSize = size_t(1) << bits;
+                    if (used + subtableSize > capacity)
+                        return false;
+                    subtable = used;
+                    used += subtableSize;
+                    subtablePrefix = prefix;
+                    for (size_t k = 0; k < subtableSize; ++k)
+                        table[subtable + k] = {0, 0, INVALID};
+                    table[Reverse(prefix, primary)] = {static_cast<uint16_t>(subtable), static_cast<uint8_t>(bits), SUBTABLE};
+                }
+
+                const unsigned tailLength = length - primary;
+                entry.bits = static_cast<uint8_t>(tailLength);
+                const unsigned tail = code & ((1u << tailLength) - 1);
+                for (size_t r = Reverse(tail, tailLength); r < subtableSize; r += size_t(1) << tailLength)
+                    table[subtable + r] = entry;
+            }
+
+            remaining[length]--;
+            ++code;
+        }
+        return true;
+    }
+
+    // the fixed codes of block type 1, built once
+    const Tables &FixedTables()
+    {
+        static const std::unique_ptr<Tables> tables = []
+        {
+            auto t = std::make_unique<Tables>();
+            uint8_t lengths[LITLEN_SYMBOLS];
+            std::memset(lengths, 8, 144);
+            std::memset(lengths + 144, 9, 112);
+            std::memset(lengths + 256, 7, 24);
+            std::memset(lengths + 280, 8, 8);
+            BuildTable(lengths, LITLEN_SYMBOLS, LITLEN_BITS, t->litlen, TableCapacity(LITLEN_SYMBOLS, LITLEN_BITS), LitLenEntry);
+            std::memset(lengths, 5, DIST_SYMBOLS);
+            BuildTable(lengths, DIST_SYMBOLS, DIST_BITS, t->dist, TableCapacity(DIST_SYMBOLS, DIST_BITS), DistEntry);
+            return t;
+        }();
+        return *tables;
+    }
+
+    class Inflater
+    {
+    public:
+        Inflater(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize)
+            : m_In(src), m_InEnd(src + srcSize), m_OutBegin(dst), m_Out(dst), m_OutEnd(dst + dstSize)
+        {
+        }
+
+        bool Run()
+        {
+            auto dynamic = std::make_unique<Tables>();
+            bool last;
+            do
+            {
+                Refill();
+                last = Take(1) != 0;
+                const unsigned type = Take(2);
+                bool ok;
+                if (type == 0)
+                    ok = StoredBlock();
+                else if (type == 1)
+                    ok = HuffmanBlock(FixedTables());
+                else if (type == 2)
+                    ok = ReadDynamicTables(*dynamic) && HuffmanBlock(*dynamic);
+                else
+                    ok = false;
+                if (!ok)
+                    return false;
+            } while (!last);
+
+            // the zero bytes fed past the end of the input must not have been used
+            return m_Out == m_OutEnd && m_Count >= m_Overrun * 8;
+        }
+
+    private:
+        // at least 56 bits buffered afterwards. whole words are read while 8
+        // bytes remain, past the end of the input zeros are shifted in
+        void Refill()
+        {
+            if (m_InEnd - m_In >= 8)
+            {
+                // bits already buffered past m_Count came from the same bytes,
+                // so or-ing them in again leaves them unchanged
+                uint64_t word;
+                std::memcpy(&word, m_In, sizeof(word)); // deflate is little endian, as are our targets
+                m_Bits |= word << m_Count;
+                m_In += (63 - m_Count) >> 3;
+                m_Count |= 56;
+                return;
+            }
+            while (m_Count <= 56)
+            {
+                uint64_t byte = 0;
+                if (m_In < m_InEnd)
+                    byte = *m_In++;
+                else
+                    ++m_Overrun;
+                m_Bits |= byte << m_Count;
+                m_Count += 8;
+            }
+        }
+
+        void Consume(unsigned n)
+        {
+            m_Bits >>= n;
+            m_Count -= n;
+        }
+
+        unsigned Take(unsigned n)
+        {
+            const unsigned v = static_cast<unsigned>(m_Bits & ((uint64_t(1) << n) - 1));
+            Consume(n);
+            return v;
+        }
+
+        Entry Decode(const Entry *table, unsigned primary)
+        {
+            Entry e = table[m_Bits & ((1u << primary) - 1)];
+            if (e.kind == SUBTABLE)
+            {
+                Consume(primary);
+                e = table[e.value + (m_Bits & ((1u << e.bits) - 1))];
+            }
+            Consume(e.bits);
+            return e;
+        }
+
+        bool StoredBlock()
+        {
+            // drop to the byte boundary and hand buffered bytes back to the input
+            Consume(m_Count & 7);
+            const size_t buffered = m_Count >> 3;
+            if (buffered < m_Overrun)
+                return false;
+            m_In -= buffered - m_Overrun;
+            m_Overrun = 0;
+            m_Bits = 0;
+            m_Count = 0;
+
+            if (m_InEnd - m_In < 4)
+                return false;
+            const size_t length = size_t(m_In[0]) | (size_t(m_In[1]) << 8);
+            const size_t inverse = size_t(m_In[2]) | (size_t(m_In[3]) << 8);
+            m_In += 4;
+            if ((length ^ 0xFFFF) != inverse || size_t(m_InEnd - m_In) < length || size_t(m_OutEnd - m_Out) < length)
+                return false;
+
+            if (length != 0)
+                std::memcpy(m_Out, m_In, length);
+            m_Out += length;
+            m_In += length;
+            return true;
+        }
+
+        bool ReadDynamicTables(Tables &tables)
+        {
+            Refill();
+            const unsigned litlenCount = Take(5) + 257;
+            const unsigned distCount = Take(5) + 1;
+            const unsigned codelenCount = Take(4) + 4;
+            if (litlenCount > 286 || distCount > 30)
+                return false;
+
+            uint8_t codelenLengths[CODELEN_SYMBOLS] = {};
+            for (unsigned i = 0; i < codelenCount; ++i)
+            {
+                Refill();
+                codelenLengths[CODELEN_ORDER[i]] = static_cast<uint8_t>(Take(3));
+            }
+            Entry codelen[TableCapacity(CODELEN_SYMBOLS, CODELEN_BITS)];
+            if (!BuildTable(codelenLengths, CODELEN_SYMBOLS, CODELEN_BITS, codelen, TableCapacity(CODELEN_SYMBOLS, CODELEN_BITS), CodeLengthEntry))
+                return false;
+
+            // both code lengths come as one sequence, repeats may cross between them
+            uint8_t lengths[286 + 30];
+            const unsigned total = litlenCount + distCount;
+            for (unsigned i = 0; i < total;)
+            {
+                Refill();
+                const Entry e = Decode(codelen, CODELEN_BITS);
+                if (e.kind != LITERAL)
+                    return false;
+                if (e.value < 16)
+                {
+                    lengths[i++] = static_cast<uint8_t>(e.value);
+                    continue;
+                }
+
+                uint8_t value = 0;
+                unsigned repeat;
+                if (e.value == 16)
+                {
+                    if (i == 0)
+                        return false;
+                    value = lengths[i - 1];
+                    repeat = 3 + Take(2);
+                }
+                else if (e.value == 17)
+                {
+                    repeat = 3 + Take(3);
+                }
+                else
+                {
+                    repeat = 11 + Take(7);
+                }
+                if (i + repeat > total)
+                    return false;
+                std::memset(lengths + i, value, repeat);
+                i += repeat;
+            }
+
+            if (lengths[256] == 0)
+                return false; // the block could never end
+            return BuildTable(lengths, litlenCount, LITLEN_BITS, tables.litlen, TableCapacity(LITLEN_SYMBOLS, LITLEN_BITS), LitLenEntry) &&
+                   BuildTable(lengths + litlenCount, distCount, DIST_BITS, tables.dist, TableCapacity(DIST_SYMBOLS, DIST_BITS), DistEntry);
+        }
+
+        bool HuffmanBlock(const Tables &tables)
+        {
+            for (;;)
+            {
+                // a refill covers two literals, or a length code, its extra
+                // bits and the distance code (15 + 5 + 15 bits)
+                Refill();
+                Entry e = Decode(tables.litlen, LITLEN_BITS);
+                if (e.kind == LITERAL)
+                {
+                    if (m_Out == m_OutEnd)
+                        return false;
+                    *m_Out++ = static_cast<uint8_t>(e.value);
+
+                    e = Decode(tables.litlen, LITLEN_BITS);
+                    if (e.kind == LITERAL)
+                    {
+                        if (m_Out == m_OutEnd)
+                            return false;
+                        *m_Out++ = static_cast<uint8_t>(e.value);
+                        continue;
+                    }
+                    Refill();
+                }
+                if (e.kind == END_OF_BLOCK)
+                    return true;
+                if ((e.kind & 0xF0) != BASE)
+                    return false;
+
+                const size_t length = e.value + Take(e.kind & 0x0F);
+                const Entry d = Decode(tables.dist, DIST_BITS);
+                if ((d.kind & 0xF0) != BASE)
+                    return false;
+                // distance extra bits can take 13 more
+                Refill();
+                const size_t distance = d.value + Take(d.kind & 0x0F);
+                if (distance > size_t(m_Out - m_OutBegin) || length > size_t(m_OutEnd - m_Out))
+                    return false;
+                CopyMatch(distance, length);
+            }
+        }
+
+        void CopyMatch(size_t distance, size_t length)
+        {
+            uint8_t *out = m_Out;
+            const uint8_t *match = out - distance;
+            m_Out += length;
+
+            if (distance >= WILD_COPY && size_t(m_OutEnd - out) >= length + WILD_COPY)
+            {
+                // never reads bytes this copy hasn't written yet
+                uint8_t *const end = out + length;
+                do
+                {
+                    std::memcpy(out, match, WILD_COPY);
+                    out += WILD_COPY;
+                    match += WILD_COPY;
+                } while (out < end);
+            }
+            else if (distance == 1)
+            {
+                std::memset(out, *match, length);
+            }
+            else if (distance >= length)
+            {
+                std::memcpy(out, match, length);
+            }
+            else
+            {
+                // short repeating patterns, pixels of filtered image rows mostly
+                for (size_t i = 0; i < length; ++i)
+                    out[i] = match[i];
+            }
+        }
+
+        const uint8_t *m_In;
+        const uint8_t *m_InEnd;
+        uint8_t *m_OutBegin;
+        uint8_t *m_Out;
+        uint8_t *m_OutEnd;
+        uint64_t m_Bits = 0;
+        unsigned m_Count = 0;
+        size_t m_Overrun = 0; // zero bytes shifted in past the end of the input
+    };
+}
+
+namespace Inflate
+{
+    bool DecompressZlib(const void *src, size_t srcSize, void *dst, size_t dstSize)
+    {
+        const uint8_t *p = static_cast<const uint8_t *>(src);
+        if (srcSize < 2)
+            return false;
+
+        // deflate with a window of at most 32 KB and no preset dictionary
+        const unsigned cmf = p[0], flg = p[1];
+        if ((cmf & 0x0F) != 8 || (cmf >> 4) > 7 || ((cmf << 8) | flg) % 31 != 0 || (flg & 0x20))
+            return false;
+        return Decompress(p + 2, srcSize - 2, dst, dstSize);
+    }
+
+    bool Decompress(const void *src, size_t srcSize, void *dst, size_t dstSize)
+    {
+        Inflater inflater(static_cast<const uint8_t *>(src), srcSize, static_cast<uint8_t *>(dst), dstSize);
+        return inflater.Run();
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+
+// deflate (rfc 1951) decoder for inputs whose decompressed size is known up
+// front, like png image data. the output buffer doubles as the window and
+// huffman codes are decoded through lookup tables, so it runs several times
+// faster than stb_image's inflate. checksums are not verified
+namespace Inflate
+{
+    // src is a zlib stream (rfc 1950 header, deflate data, adler32). false for
+    // malformed input or when the output isn't exactly dstSize bytes
+    bool DecompressZlib(const void *src, size_t srcSize, void *dst, size_t dstSize);
+
+    // raw deflate data without the zlib wrapper
+    bool Decompress(const void *src, size_t srcSize, void *dst, size_t dstSize);
+}
@@ -0,0 +1,255 @@
+#include "Lz.h"
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+    constexpr int HASH_BITS = 14;
+    constexpr size_t MIN_MATCH = 4;
+    constexpr size_t LAST_LITERALS = 5; // the format ends every block with literals
+    constexpr size_t MATCH_LIMIT = 12;  // and no match starts closer to the end than this
+    constexpr size_t MAX_OFFSET = 65535;
+    constexpr size_t WILD_COPY = 16;
+
+    uint32_t Read32(const uint8_t *p)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    uint32_t HashOf(uint32_t sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    uint8_t *WriteLength(uint8_t *op, size_t length)
+    {
+        for (; length >= 255; length -= 255)
+            *op++ = 255;
+        *op++ = static_cast<uint8_t>(length);
+        return op;
+    }
+
+    bool ReadLength(const uint8_t *&ip, const uint8_t *end, size_t &length)
+    {
+        uint8_t b;
+        do
+        {
+            if (ip >= end)
+                return false;
+            b = *ip++;
+            length += b;
+        } while (b == 255);
+        return true;
+    }
+
+    // copies length bytes rounded up to 16, so up to 15 bytes past the end
+    // are written. the caller makes sure there is room, and what lands
+    // there is overwritten by the next sequence
+    void WildCopy(uint8_t *op, const uint8_t *ip, size_t length)
+    {
+        for (size_t i = 0; i < length; i += WILD_COPY)
+            std::memcpy(op + i, ip + i, WILD_COPY);
+    }
+
+    // a match closer than 16 bytes overlaps its own output, so it repeats
+    // its first offset bytes. they are built up into one 16 byte block off
+    // to the side, each copy's bytes past offset overwritten by the next,
+    // then the block is stored every largest multiple of offset that fits
+    // in it. no copy waits on the one before. writes up to 15 bytes past the
+    // match and reads up to 15 past the offset bytes, inside that same room
+    void CopyOverlapping(uint8_t *op, size_t offset, size_t length)
+    {
+        const uint8_t *match = op - offset;
+        uint8_t pattern[2 * WILD_COPY];
+        for (size_t k = 0; k < WILD_COPY; k += offset)
+            std::memcpy(pattern + k, match, WILD_COPY);
+
+        const size_t stride = offset * (WILD_COPY / offset);
+        for (size_t i = 0; i < length; i += stride)
+            std::memcpy(op + i, pattern, WILD_COPY);
+    }
+
+    // token, extended literal length, literals, offset and extended match length
+    size_t SequenceBound(size_t literals, size_t matchLength)
+    {
+        return 1 + literals / 255 + 1 + literals + 2 + matchLength / 255 + 1;
+    }
+
+    uint8_t *WriteSequence(uint8_t *op, const uint8_t *literals, size_t literalCount, size_t offset, size_t matchLength)
+    {
+        uint8_t *token = op++;
+        *token = static_cast<uint8_t>((literalCount >= 15 ? 15 : literalCount) << 4);
+        if (literalCount >= 15)
+            op = WriteLength(op, literalCount - 15);
+        std::memcpy(op, literals, literalCount);
+        op += literalCount;
+
+        if (offset == 0)
+            return op; // the closing literals have no match
+
+        *op++ = static_cast<uint8_t>(offset);
+        *op++ = static_cast<uint8_t>(offset >> 8);
+        *token |= static_cast<uint8_t>(matchLength >= 15 ? 15 : matchLength);
+        if (matchLength >= 15)
+            op = WriteLength(op, matchLength - 15);
+        return op;
+    }
+}
+
+namespace Lz
+{
+    size_t Compress(const void *src, size_t size, void *dst, size_t capacity)
+    {
+        const uint8_t *const base = static_cast<const uint8_t *>(src);
+        const uint8_t *const end = base + size;
+        const uint8_t *ip = base;
+        const uint8_t *anchor = base;
+        uint8_t *op = static_cast<uint8_t *>(dst);
+        uint8_t *const opEnd = op + capacity;
+
+        if (size > MATCH_LIMIT)
+        {
+            // positions are relative to base, a stale or empty slot is caught
+            // by comparing the bytes
+            uint32_t table[1 << HASH_BITS] = {};
+            const uint8_t *const matchStartLimit = end - MATCH_LIMIT;
+            const uint8_t *const matchEndLimit = end - LAST_LITERALS;
+
+            // step faster through data that doesn't match, like lz4 does
+            size_t misses = 0;
+            while (ip <= matchStartLimit)
+            {
+                const uint32_t sequence = Read32(ip);
+                uint32_t &slot = table[HashOf(sequence)];
+                const uint8_t *ref = base + slot;
+                slot = static_cast<uint32_t>(ip - base);
+
+                if (ref >= ip || size_t(ip - ref) > MAX_OFFSET || Read32(ref) != sequence)
+                {
+                    ip += 1 + (misses++ >> 6);
+                    continue;
+                }
+                misses = 0;
+
+                while (ip > anchor && ref > base && ip[-1] == ref[-1])
+                    --ip, --ref;
+
+                const uint8_t *matchEnd = ip + MIN_MATCH;
+                const uint8_t *refEnd = ref + MIN_MATCH;
+                while (matchEnd < matchEndLimit && *matchEnd == *refEnd)
+                    ++matchEnd, ++refEnd;
+
+                const size_t literals = size_t(ip - anchor);
+                const size_t matchLength = size_t(matchEnd - ip) - MIN_MATCH;
+                if (size_t(opEnd - op) < SequenceBound(literals, matchLength))
+                    return 0;
+                op = WriteSequence(op, anchor, literals, size_t(ip - ref), matchLength);
+
+                ip = anchor = matchEnd;
+                if (ip <= matchStartLimit)
+                    table[HashOf(Read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - base);
+            }
+        }
+
+        const size_t literals = size_t(end - anchor);
+        if (size_t(opEnd - op) < SequenceBound(literals, 0))
+            return 0;
+        op = WriteSequence(op, anchor, literals, 0, 0);
+        return size_t(op - static_cast<uint8_t *>(dst));
+    }
+
+    bool Decompress(const void *src, size_t srcSize, void *dst, size_t dstSize)
+    {
+        const uint8_t *ip = static_cast<const uint8_t *>(src);
+        const uint8_t *const ipEnd = ip + srcSize;
+        uint8_t *const base = static_cast<uint8_t *>(dst);
+        uint8_t *op = base;
+        uint8_t *const opEnd = base + dstSize;
+
+        while (ip < ipEnd)
+        {
+            const uint8_t token = *ip++;
+
+            // most sequences are short: up to 14 literals go as one 16 byte
+            // copy when both buffers have room for it and the match after.
+            // such a run can't be the closing one, that ends the input
+            size_t literals = token >> 4;
+            if (literals < 15 && size_t(ipEnd - ip) >= WILD_COPY + 2 && size_t(opEnd - op) >= 2 * WILD_COPY + 2)
+            {
+                std::memcpy(op, ip, WILD_COPY);
+                op += literals;
+                ip += literals;
+            }
+            else
+            {
+                if (literals == 15 && !ReadLength(ip, ipEnd, literals))
+                    return false;
+                if (size_t(ipEnd - ip) < literals || size_t(opEnd - op) < literals)
+                    return false;
+
+                // longer runs 16 bytes at a time while there is room past
+                // them, long runs of incompressible data go to memcpy
+                if (literals <= 4 * WILD_COPY && size_t(ipEnd - ip) >= literals + WILD_COPY && size_t(opEnd - op) >= literals + WILD_COPY)
+                    WildCopy(op, ip, literals);
+                else
+                    std::memcpy(op, ip, literals);
+                op += literals;
+                ip += literals;
+
+                if (ip == ipEnd)
+                    break; // closing literals
+                if (ipEnd - ip < 2)
+                    return false;
+            }
+
+            const size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+            ip += 2;
+            if (offset == 0 || offset > size_t(op - base))
+                return false;
+
+            // likewise a match of up to 18 bytes from at least 8 back is
+            // three fixed copies, each reading only bytes already written
+            size_t matchLength = token & 15;
+            const uint8_t *match = op - offset;
+            if (matchLength < 15 && offset >= 8 && size_t(opEnd - op) >= 18)
+            {
+                std::memcpy(op, match, 8);
+                std::memcpy(op + 8, match + 8, 8);
+                std::memcpy(op + 16, match + 16, 2);
+                op += matchLength + MIN_MATCH;
+                continue;
+            }
+
+            if (matchLength == 15 && !ReadLength(ip, ipEnd, matchLength))
+                return false;
+            matchLength += MIN_MATCH;
+            if (size_t(opEnd - op) < matchLength)
+                return false;
+
+            // overlapping matches repeat the last offset bytes. with room to
+            // spare they are copied in whole words, near the end of the
+            // block byte by byte
+            if (size_t(opEnd - op) >= matchLength + WILD_COPY)
+            {
+                if (offset >= WILD_COPY)
+                    WildCopy(op, match, matchLength);
+                else
+                    CopyOverlapping(op, offset, matchLength);
+            }
+            else if (offset >= matchLength)
+            {
+                std::memcpy(op, match, matchLength);
+            }
+            else
+            {
+                for (size_t i = 0; i < matchLength; ++i)
+                    op[i] = match[i];
+            }
+            op += matchLength;
+        }
+
+        return op == opEnd;
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+// lz77 block codec in the lz4 block format: a token with literal and match
+// lengths, the literals, then a 16 bit offset. greedy single probe matching,
+// so it compresses at a few hundred MB/s and decodes several times faster.
+// blocks are independent, callers keep them small (asset packs use 64 KB)
+namespace Lz
+{
+    // largest possible output of Compress for size input bytes
+    constexpr size_t CompressBound(size_t size) { return size + size / 255 + 16; }
+
+    // returns the compressed size, 0 when it doesn't fit in capacity
+    size_t Compress(const void *src, size_t size, void *dst, size_t capacity);
+
+    // false for malformed input or when the output isn't exactly dstSize bytes
+    bool Decompress(const void *src, size_t srcSize, void *dst, size_t dstSize);
+}
@@ -7,7 +7,8 @@ bool CompileShaderFromFile(
     const std::wstring &filename,
     const std::string &entryPoint,
     const std::string &target,
-    Microsoft::WRL::ComPtr<ID3DBlob> &outBlob)
+    Microsoft::WRL::ComPtr<ID3DBlob> &outBlob,
+    const D3D_SHADER_MACRO *defines)
 {
     DWORD compileFlags = D3DCOMPILE_ENABLE_STRICTNESS;
 #if defined(_DEBUG)
@@ -18,7 +19,7 @@ bool CompileShaderFromFile(
     Microsoft::WRL::ComPtr<ID3DBlob> errorBlob;
     HRESULT hr = D3DCompileFromFile(
         filename.c_str(),
-        nullptr,
+        defines,
         D3D_COMPILE_STANDARD_FILE_INCLUDE,
         entryPoint.c_str(),
         target.c_str(),
@@ -9,4 +9,5 @@ bool CompileShaderFromFile(
     const std::wstring &filename,
     const std::string &entryPoint,
     const std::string &target,
-    Microsoft::WRL::ComPtr<ID3DBlob> &outBlob);
+    Microsoft::WRL::ComPtr<ID3DBlob> &outBlob,
+    const D3D_SHADER_MACRO *defines = nullptr);
@@ -0,0 +1,38 @@
+#pragma once
+
+// compile-time simd feature detection
+// msvc only reports __AVX__/__AVX2__ (set by /arch), which imply sse4.1 and f16c there
+#if defined(__AVX2__)
+#define GRAPHITE_AVX2 1
+#endif
+
+#if defined(__SSE4_1__) || defined(__AVX__) || defined(__AVX2__)
+#define GRAPHITE_SSE41 1
+#endif
+
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define GRAPHITE_F16C 1
+#endif
+
+#if defined(GRAPHITE_SSE41) || defined(GRAPHITE_AVX2) || defined(GRAPHITE_F16C)
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Simd
+{
+    // index of the lowest set bit, mask must not be zero
+    inline unsigned CountTrailingZeros(unsigned mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+    }
+}